@@ -0,0 +1,120 @@
+#include "benchmark/benchmark.h"
+
+#include "app_config.h"
+#include "devices/cesar_protocol.h"
+#include "devices/framer.h"
+#include "devices/kjl_protocol.h"
+#include "devices/protocol.h"
+#include "devices/simulation/cesar_simulator.h"
+#include "devices/simulation/kjl_simulator.h"
+
+#include <algorithm>
+#include <string>
+
+// Devices
+// The replies are made by the simulators, so the benchmarks see the same bytes the drivers get from the hardware, and are
+// decoded with the protocol tables of the drivers.
+
+namespace {
+    // Number of telemetry bursts received in one go in the bursty case
+    constexpr int BURSTS = 16;
+
+    // The replies to BURSTS telemetry bursts of a Cesar generator running at 300 W
+    std::string cesar_replies() {
+        simulation::CesarSimulator simulator;
+        simulator.receive(framing::CesarFramer::make_packet(1, {"\x08\x2C\x01", 3}));
+        simulator.receive(framing::CesarFramer::make_packet(1, "\x02"));
+
+        std::string replies;
+        for (int i = 0; i < BURSTS; i++) {
+            for (const char *command : {"\xA5", "\xA6", "\xA8", "\xAF"}) {
+                replies += simulator.receive(framing::CesarFramer::make_packet(1, command));
+            }
+        }
+        return replies;
+    }
+
+    // The replies to BURSTS telemetry bursts of a KJL generator running at 300 W
+    std::string kjl_replies() {
+        simulation::KJLSimulator simulator;
+        simulator.receive("300.0 W\rG\r");
+
+        std::string replies;
+        for (int i = 0; i < BURSTS; i++) {
+            replies += simulator.receive("Q\r0?\rLPS\rTPS\r");
+        }
+        return replies;
+    }
+
+    // Feeds data to reader in chunks of chunk_size bytes (all at once for 0) and handles every complete frame with func
+    template <typename Reader, typename F>
+    void receive(Reader &reader, const std::string &data, size_t chunk_size, F &&func) {
+        if (chunk_size == 0) {
+            chunk_size = data.size();
+        }
+
+        for (size_t offset = 0; offset < data.size(); offset += chunk_size) {
+            reader.push(data.data() + offset, std::min(chunk_size, data.size() - offset));
+            reader.for_each_frame(func);
+        }
+    }
+}  // namespace
+
+// Builds a Cesar packet like CesarGenerator::queue_command, with the data length in the header and in an extra byte
+static void BM_CesarMakePacket(benchmark::State &state) {
+    const std::string command = state.range(0) > 6 ? std::string("\x70" "1234567") : std::string("\x08\x2C\x01", 3);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(framing::CesarFramer::make_packet(1, command));
+    }
+}
+BENCHMARK(BM_CesarMakePacket)->Arg(3)->Arg(8);
+
+// Splits the replies into packets, checks them and decodes the report packets like CesarGenerator::handle_data_received.
+// The argument is the number of bytes received at a time, 0 receives all bursts at once.
+static void BM_CesarReceive(benchmark::State &state) {
+    const auto replies = cesar_replies();
+    framing::FrameReader<framing::CesarFramer> reader(DEVICE_RECEIVE_BUFFER_SIZE);
+    RFParameters parameters;
+
+    for (auto _ : state) {
+        receive(reader, replies, static_cast<size_t>(state.range(0)), [&](std::string_view frame, bool valid) {
+            if (frame.size() == 1 || !valid) {
+                return;
+            }
+
+            if (const auto *command = protocol::cesar::command_table().find(static_cast<uint8_t>(frame[1]))) {
+                const size_t offset = framing::CesarFramer::data_offset(frame[0]);
+                protocol::decode(*command, frame.substr(offset, frame.size() - offset - 1), parameters);
+            }
+        });
+        benchmark::DoNotOptimize(parameters);
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * replies.size()));
+}
+BENCHMARK(BM_CesarReceive)->Arg(1)->Arg(7)->Arg(64)->Arg(0);
+
+// Splits the echo replies into packets, finds the command by its echo and decodes the answer like
+// KJLGenerator::handle_reply. The argument is the number of bytes received at a time, 0 receives all bursts at once.
+static void BM_KJLReceive(benchmark::State &state) {
+    const auto replies = kjl_replies();
+    framing::FrameReader<framing::DelimitedFramer> reader(DEVICE_RECEIVE_BUFFER_SIZE, framing::DelimitedFramer('\r', 2));
+    RFParameters parameters;
+
+    for (auto _ : state) {
+        receive(reader, replies, static_cast<size_t>(state.range(0)), [&](std::string_view frame, bool) {
+            const auto first_index = frame.find('\r');
+            const auto echo = frame.substr(0, first_index);
+            const auto answer = frame.substr(first_index + 1, frame.size() - first_index - 2);
+
+            if (const auto *command = protocol::kjl::command_table().find(echo); command && command->has_reply()) {
+                protocol::decode(*command, answer, parameters);
+            }
+        });
+        benchmark::DoNotOptimize(parameters);
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * replies.size()));
+}
+BENCHMARK(BM_KJLReceive)->Arg(1)->Arg(7)->Arg(64)->Arg(0);
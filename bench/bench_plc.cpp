@@ -0,0 +1,73 @@
+#include "benchmark/benchmark.h"
+
+#include "devices/plc/bit_diff.h"
+#include "devices/plc/bit_image.h"
+#include "util/byteswap.h"
+
+#include <cstdint>
+#include <vector>
+
+// PLC
+
+// Loads a flag area of state.range(0) bytes, with a tag on every bit, from two process images that differ in every
+// state.range(1)-th byte, and reports the changed tags like S7::poll does after every read
+static void BM_BitImageLoadAndDiff(benchmark::State &state) {
+    const auto bytes = static_cast<int>(state.range(0));
+    const auto stride = static_cast<size_t>(state.range(1));
+
+    PLC::BitImage image;
+    image.add_range(0, bytes);
+
+    PLC::BitDiff diff;
+    for (int bit = 0; bit < bytes * 8; bit++) {
+        diff.add(static_cast<size_t>(bit), static_cast<uint16_t>(bit));
+    }
+    diff.build();
+
+    std::vector<std::vector<uint8_t>> process_images(2, std::vector<uint8_t>(static_cast<size_t>(bytes)));
+    for (size_t i = 0; i < process_images[1].size(); i += stride) {
+        process_images[1][i] = 0x81;
+    }
+
+    size_t changed = 0;
+    size_t poll = 0;
+    for (auto _ : state) {
+        image.load(process_images[poll++ % 2].data());
+        diff.diff(image.previous_words().data(), image.words().data(), image.word_count(),
+                  [&](uint16_t, bool) { changed++; });
+    }
+    benchmark::DoNotOptimize(changed);
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+}
+BENCHMARK(BM_BitImageLoadAndDiff)->Args({64, 64})->Args({64, 1})->Args({1024, 256})->Args({1024, 1});
+
+// Converts the big endian words of a data block read from the S7 to the host byte order
+static void BM_LoadBigEndian16(benchmark::State &state) {
+    const auto count = static_cast<size_t>(state.range(0));
+    std::vector<uint8_t> src(count * 2 + 1, 0x5A);
+    std::vector<uint16_t> dst(count);
+
+    for (auto _ : state) {
+        // Data blocks are not aligned in the process image
+        util::load_big_endian(dst.data(), src.data() + 1, count);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * count * 2));
+}
+BENCHMARK(BM_LoadBigEndian16)->Arg(7)->Arg(64)->Arg(1024);
+
+static void BM_LoadBigEndian32(benchmark::State &state) {
+    const auto count = static_cast<size_t>(state.range(0));
+    std::vector<uint8_t> src(count * 4 + 1, 0x5A);
+    std::vector<uint32_t> dst(count);
+
+    for (auto _ : state) {
+        util::load_big_endian(dst.data(), src.data() + 1, count);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * count * 4));
+}
+BENCHMARK(BM_LoadBigEndian32)->Arg(7)->Arg(64)->Arg(1024);
@@ -0,0 +1,67 @@
+#include "benchmark/benchmark.h"
+
+#include "config/segment.h"
+#include "util/util.h"
+
+#include <memory>
+#include <string>
+
+// Config
+// segment.h
+
+namespace {
+    // A device segment like the ones in config.cfg
+    std::shared_ptr<config::Segment> device_segment() {
+        auto segment = std::make_shared<config::Segment>("cesar");
+        segment->set("type", "cesar"s);
+        segment->set("address", 1);
+        segment->set("telemetryrate", 20);
+        segment->set("controlrate", 20);
+        segment->set("kp", 0.5);
+        segment->set("ki", 0.1);
+        segment->set("connector.type", "serial"s);
+        segment->set("connector.port", "COM3"s);
+        segment->set("connector.baud", 9600);
+
+        return segment;
+    }
+}  // namespace
+
+static void BM_SegmentGet(benchmark::State &state) {
+    const std::shared_ptr<const config::Segment> segment = device_segment();
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(segment->get<int>("telemetryrate"));
+        benchmark::DoNotOptimize(segment->get<double>("kp"));
+        benchmark::DoNotOptimize(segment->get<std::string>("type"));
+    }
+}
+BENCHMARK(BM_SegmentGet);
+
+// Keys with a dot look up the sub segment first
+static void BM_SegmentGetNested(benchmark::State &state) {
+    const std::shared_ptr<const config::Segment> segment = device_segment();
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(segment->get<int>("connector.baud"));
+    }
+}
+BENCHMARK(BM_SegmentGetNested);
+
+// Strings
+// util_strings.h
+
+// Splits a list of state.range(0) byte ranges, like the lists read by BitImage::parse_ranges
+static void BM_Split(benchmark::State &state) {
+    std::string list;
+    for (int i = 0; i < state.range(0); i++) {
+        list += (i ? ", " : "") + std::to_string(i * 8) + "-" + std::to_string(i * 8 + 5);
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(util::split(list, ','));
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * list.size()));
+}
+BENCHMARK(BM_Split)->Arg(4)->Arg(64);
@@ -0,0 +1,34 @@
+#include "benchmark/benchmark.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Unless --benchmark_out is given, the results are written to benchmark_results.json next to the console output, so every
+// run leaves a file that can be compared with the one of another commit (e.g. with tools/compare.py of Google Benchmark).
+int main(int argc, char *argv[]) {
+    std::vector<char *> args(argv, argv + argc);
+
+    std::string out = "--benchmark_out=benchmark_results.json";
+    std::string format = "--benchmark_out_format=json";
+
+    bool has_out = false;
+    for (int i = 1; i < argc; i++) {
+        has_out = has_out || std::string_view(argv[i]).substr(0, 16) == "--benchmark_out=";
+    }
+    if (!has_out) {
+        args.push_back(out.data());
+        args.push_back(format.data());
+    }
+
+    int count = static_cast<int>(args.size());
+    benchmark::Initialize(&count, args.data());
+    if (benchmark::ReportUnrecognizedArguments(count, args.data())) {
+        return 1;
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    return 0;
+}
@@ -15,5 +15,103 @@ constexpr const auto CONFIG_SPACES_PER_INDENT_LEVEL = 4;
 // Maximum number of retries to send commands to a device
 constexpr const auto MAX_SEND_RETRIES = 10;
 
+// Capacity in bytes of the buffer for data received from serial devices. It has to hold at least one complete packet.
+constexpr const auto DEVICE_RECEIVE_BUFFER_SIZE = 1024;
+
+// Number of received chunks and of outgoing commands the queues between a connector and its device can hold. The I/O thread
+// drops (and logs) data if the device does not keep up.
+constexpr const auto CONNECTOR_QUEUE_SIZE = 256;
+
+// Time in ms the Cesar generator has to acknowledge a command before it is sent again
+constexpr const auto CESAR_ACK_TIMEOUT = 250;
+// Time in ms the Cesar generator has to answer a query after acknowledging it
+constexpr const auto CESAR_REPLY_TIMEOUT = 1000;
+// Default number of commands sent to the Cesar generator before the first one was acknowledged
+constexpr const auto CESAR_DEFAULT_WINDOW = 1;
+
+// Default maximum number of parameter updates per second an RF generator reports to the user interface
+constexpr const auto TELEMETRY_DEFAULT_MAX_RATE = 10;
+// Default number of telemetry query bursts per second sent to an RF generator. The rate is lowered automatically if the
+// generator takes longer to answer a burst.
+constexpr const auto TELEMETRY_DEFAULT_SAMPLE_RATE = 5;
+// Time in ms after which missing replies to a burst of telemetry queries are considered lost
+constexpr const auto TELEMETRY_REPLY_TIMEOUT = 1000;
+
+// Default rate in Hz of the power control steps of an RF generator, see PowerController
+constexpr const auto POWER_CONTROL_DEFAULT_RATE = 20;
+// Default rate of linear power ramps in W/s
+constexpr const auto POWER_CONTROL_DEFAULT_RAMP_RATE = 50;
+// Default time constant of exponential power ramps in ms
+constexpr const auto POWER_CONTROL_DEFAULT_RAMP_TIME = 1000;
+// Default maximum power setpoint in W
+constexpr const auto POWER_CONTROL_DEFAULT_MAX_POWER = 600;
+// Default time in ms the reflected power may exceed its limit before the power control trips
+constexpr const auto POWER_CONTROL_DEFAULT_TRIP_TIME = 200;
+
+// Default time in ms the capacitors of a matching network need to settle after moving before the reflected power is measured
+constexpr const auto MATCH_SETTLE_TIME = 300;
+// Power in W the best capacitor positions are cached for are grouped in steps of this size, see MatchCache
+constexpr const auto MATCH_CACHE_POWER_STEP = 10;
+
+// File the devices are loaded from, see Watchtower::load_devices
+constexpr const auto DEVICES_CONFIG_FILE = "devices.cfg";
+// Default time in ms the startup waits for a device to connect. Devices that are not connected by then keep trying in the
+// background.
+constexpr const auto DEVICE_DEFAULT_CONNECT_TIMEOUT = 5000;
+
+// Default cycle time of the controller in ms
+constexpr const auto CONTROLLER_DEFAULT_PERIOD = 10;
+// Default time in us a device may spend in update per cycle before it is reported
+constexpr const auto CONTROLLER_DEFAULT_BUDGET = 1000;
+// Time in us before the start of a cycle the controller stops sleeping and waits actively, since the sleep of the operating
+// system is only accurate to a few ms
+constexpr const auto CONTROLLER_SPIN_TIME = 1000;
+
 // Default maximum wait time for ethernet connections in ms
 constexpr const auto MAX_ETHERNET_CONNECT_WAIT = 3000;
+
+// Delay in ms before the first retry of a failed connection attempt. It is doubled after every failed attempt up to the
+// maximum delay.
+constexpr const auto CONNECT_RETRY_MIN_DELAY = 500;
+constexpr const auto CONNECT_RETRY_MAX_DELAY = 30000;
+
+// Maximum number of variables in a single S7 read request. The CPUs we use accept up to 20 items per request.
+constexpr const auto S7_MAX_READ_ITEMS = 20;
+// PDU size assumed when the PLC did not report one during connection setup
+constexpr const auto S7_DEFAULT_PDU_SIZE = 240;
+// Maximum number of variables in a single S7 write request
+constexpr const auto S7_MAX_WRITE_ITEMS = 20;
+// Default time in ms S7 writes are collected before they are sent to the PLC in a single request
+constexpr const auto S7_DEFAULT_WRITE_WINDOW = 5;
+// Maximum number of S7 snapshots kept for reuse. More are only allocated if readers hold on to older snapshots.
+constexpr const auto S7_SNAPSHOT_POOL_SIZE = 4;
+
+// Default directory the historian writes its segment files to
+constexpr const auto HISTORIAN_DEFAULT_PATH = "./history/";
+// Maximum size of a chunk of a tag in bytes. A full chunk is written to the segment and a new one is started.
+constexpr const auto HISTORIAN_CHUNK_SIZE = 4096;
+// Default size in MB after which a segment is closed and the run continues in a new one
+constexpr const auto HISTORIAN_DEFAULT_SEGMENT_SIZE = 256;
+// Segment files are grown in steps of this many bytes, so the file is not remapped for every chunk
+constexpr const auto HISTORIAN_FILE_GROWTH = 4 * 1024 * 1024;
+// Default time in ms after which chunks are written to the segment even if they are not full
+constexpr const auto HISTORIAN_DEFAULT_FLUSH_INTERVAL = 10000;
+
+// Default size in MB of the capture file of a connector (see capture::CaptureRing). Once it is full the oldest frames are
+// overwritten.
+constexpr const auto CAPTURE_DEFAULT_SIZE = 16;
+
+// Log messages are written to the sinks by a background thread. The queue of the thread holds this many messages and is
+// allocated once; when it is full the oldest messages are dropped, so logging never blocks a device.
+constexpr const auto LOG_ASYNC = true;
+constexpr const auto LOG_QUEUE_SIZE = 8192;
+// File the log is written to besides the console. It is rotated once it reaches LOG_MAX_FILE_SIZE bytes, the last
+// LOG_MAX_FILES files are kept.
+constexpr const auto LOG_FILE = "./logs/sputterautomation.log";
+constexpr const auto LOG_MAX_FILE_SIZE = 10 * 1024 * 1024;
+constexpr const auto LOG_MAX_FILES = 5;
+// Time in s after which the log file is flushed at the latest, warnings and errors are flushed right away
+constexpr const auto LOG_FLUSH_INTERVAL = 2;
+// Level of the main logger unless the main config (config.cfg) sets logging.level to one of trace, debug, info, warn,
+// error, critical or off. Devices log every packet with trace and debug.
+constexpr const auto LOG_DEFAULT_LEVEL = "info";
@@ -14,12 +14,12 @@ namespace config {
     void save(const std::string &filename, const std::string &identifier, bool overwrite = false) {
         auto conf = get_config(identifier);
         if (!conf) {
-            logging::get_log("main")->warn("Config::save: unknown config '{0}'", identifier);
+            logging::main_log()->warn("Config::save: unknown config '{0}'", identifier);
             return;
         }
 
         if (std::filesystem::exists(filename) && !overwrite) {
-            logging::get_log("main")->warn("Config::save: config file '{0}' already exists, aborting", filename);
+            logging::main_log()->warn("Config::save: config file '{0}' already exists, aborting", filename);
             return;
         }
 
@@ -32,7 +32,7 @@ namespace config {
     // Tries to load the main config file (config.cfg). On failure default values are loaded and saved to the file.
     void init() {
         if (!load("config.cfg", "main")) {
-            logging::get_log("main")->info("Main config file (config.cfg) not found, loading default settings");
+            logging::main_log()->info("Main config file (config.cfg) not found, loading default settings");
 
             load_defaults();
             save("config.cfg", "main");
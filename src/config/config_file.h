@@ -14,7 +14,7 @@ namespace config {
         friend class ConfigManager;
 
     public:
-        ConfigFile() noexcept : m_root{std::make_shared<Segment>()}, m_log{logging::get_log("main")} {}
+        ConfigFile() noexcept : m_root{std::make_shared<Segment>()}, m_log{logging::main_log()} {}
         ConfigFile(const std::string &path) noexcept : ConfigFile::ConfigFile() { m_path = path; }
 
         ConfigFile(const ConfigFile &) = delete;
@@ -8,7 +8,7 @@
 namespace config {
     class ConfigManager {
     private:
-        ConfigManager() noexcept : m_log{logging::get_log("main")} {}
+        ConfigManager() noexcept : m_log{logging::main_log()} {}
 
         ConfigManager(const ConfigManager &) = delete;
         ConfigManager &operator=(const ConfigManager &) = delete;
@@ -11,7 +11,7 @@ namespace config {
 
         auto tokens = util::split(name, '.', false);
         if (!tokens) {
-            logging::get_log("main")->error("Segment::get_segment(): encountered empty segment name in '{0}'", name);
+            logging::main_log()->error("Segment::get_segment(): encountered empty segment name in '{0}'", name);
             return nullptr;
         }
 
@@ -36,7 +36,7 @@ namespace config {
 
         auto tokens = util::split(name, '.', false);
         if (!tokens) {
-            logging::get_log("main")->error("Segment::get_segment(): encountered empty segment name in '{0}'", name);
+            logging::main_log()->error("Segment::get_segment(): encountered empty segment name in '{0}'", name);
             return nullptr;
         }
 
@@ -141,7 +141,7 @@ namespace config {
 
             // We handle additional cases like strings
             default:
-                logging::get_log("main")->warn(
+                logging::main_log()->warn(
                     "Segment::serialize(): encountered setting with unknown serialization, defaulting to string");
                 s += "\"" + setting.second.value + "\"\n";
                 break;
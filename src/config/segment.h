@@ -45,7 +45,7 @@ namespace config {
         template <typename T>
         std::optional<T> get(const std::string &key) const {
             if (key.empty()) {
-                logging::get_log("main")->warn("Segment::set(): key is empty");
+                logging::main_log()->warn("Segment::set(): key is empty");
                 return std::nullopt;
             }
 
@@ -53,7 +53,7 @@ namespace config {
             if (auto lastpos = key.find_last_of('.'); lastpos != std::string::npos) {
                 auto nkey = key.substr(lastpos + 1);
                 if (nkey.empty()) {
-                    logging::get_log("main")->warn("Segment::set(): last key in chain is empty, got '{0}'", key);
+                    logging::main_log()->warn("Segment::set(): last key in chain is empty, got '{0}'", key);
                     return std::nullopt;
                 }
 
@@ -69,14 +69,14 @@ namespace config {
         template <typename T>
         void set(const std::string &key, const T &value, std::optional<std::string> comment = std::nullopt) {
             if (key.empty()) {
-                logging::get_log("main")->warn("Segment::set(): key is empty");
+                logging::main_log()->warn("Segment::set(): key is empty");
                 return;
             }
 
             auto value_str = util::to_string(value);
             if (!value_str) {
                 // We cant output the value here since the conversion to string is what failed in the first place
-                logging::get_log("main")->warn("Segment::set(): unable to convert value to string for key '{0}'", key);
+                logging::main_log()->warn("Segment::set(): unable to convert value to string for key '{0}'", key);
                 return;
             }
 
@@ -84,7 +84,7 @@ namespace config {
             if (auto lastpos = key.find_last_of('.'); lastpos != std::string::npos) {
                 auto nkey = key.substr(lastpos + 1);
                 if (nkey.empty()) {
-                    logging::get_log("main")->warn("Segment::set(): last key in chain is empty, got '{0}'", key);
+                    logging::main_log()->warn("Segment::set(): last key in chain is empty, got '{0}'", key);
                     return;
                 }
 
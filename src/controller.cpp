@@ -0,0 +1,196 @@
+#include "controller.h"
+
+#include <thread>
+
+#include <QCoreApplication>
+
+#include "logging/logging.h"
+
+Controller::Controller() { qRegisterMetaType<device_id>("device_id"); }
+
+Controller::~Controller() { stop(); }
+
+void Controller::init(std::shared_ptr<config::Segment> settings) {
+    if (!settings) {
+        return;
+    }
+
+    if (auto period = settings->get<int>("period")) {
+        if (*period < 1) {
+            logging::main_log()->warn("Controller: ignoring invalid period of {0}ms", *period);
+        } else {
+            std::scoped_lock<std::mutex> lock(m_scheduler_mutex);
+            m_scheduler.set_period(std::chrono::milliseconds(*period));
+        }
+    }
+
+    if (auto spin_time = settings->get<int>("spintime")) {
+        m_spin_time = std::chrono::microseconds(std::max(*spin_time, 0));
+    }
+}
+
+void Controller::add_device(Device *device, std::chrono::microseconds budget) {
+    if (m_running) {
+        logging::main_log()->error("Controller: devices can not be added while the controller is running");
+        return;
+    }
+
+    if (!device) {
+        return;
+    }
+
+    m_slots.push_back({device, budget});
+}
+
+void Controller::clear_devices() {
+    if (m_running) {
+        logging::main_log()->error("Controller: devices can not be removed while the controller is running");
+        return;
+    }
+
+    m_slots.clear();
+}
+
+void Controller::add_task(Task task) {
+    if (m_running) {
+        logging::main_log()->error("Controller: tasks can not be added while the controller is running");
+        return;
+    }
+
+    if (task) {
+        m_tasks.push_back(std::move(task));
+    }
+}
+
+void Controller::clear_tasks() {
+    if (m_running) {
+        logging::main_log()->error("Controller: tasks can not be removed while the controller is running");
+        return;
+    }
+
+    m_tasks.clear();
+}
+
+void Controller::start() {
+    if (m_running) {
+        return;
+    }
+
+    m_stop = false;
+    m_owner_thread = QThread::currentThread();
+    m_thread.reset(QThread::create([this]() { run(); }));
+    m_thread->setObjectName("controller");
+
+    // From now on the devices live in the cycle thread, so their events are handled at the start of each cycle
+    for (auto &slot : m_slots) {
+        slot.device->moveToThread(m_thread.get());
+    }
+
+    m_running = true;
+    m_thread->start(QThread::TimeCriticalPriority);
+
+    logging::main_log()->debug("Controller: started with {0} device(s), period {1}ms", m_slots.size(),
+                               std::chrono::duration_cast<std::chrono::milliseconds>(m_scheduler.get_period()).count());
+}
+
+void Controller::stop() {
+    if (!m_running) {
+        return;
+    }
+
+    m_stop = true;
+    m_thread->wait();
+    m_thread.reset();
+    m_running = false;
+
+    const auto statistics = get_statistics();
+    logging::main_log()->debug(
+        "Controller: stopped after {0} cycles, {1} overrun(s), {2} skipped, jitter min/mean/max {3}/{4}/{5}us",
+        statistics.cycles, statistics.overruns, statistics.skipped,
+        std::chrono::duration_cast<std::chrono::microseconds>(statistics.min_jitter).count(),
+        std::chrono::duration_cast<std::chrono::microseconds>(statistics.mean_jitter()).count(),
+        std::chrono::duration_cast<std::chrono::microseconds>(statistics.max_jitter).count());
+}
+
+CycleScheduler::Statistics Controller::get_statistics() {
+    std::scoped_lock<std::mutex> lock(m_scheduler_mutex);
+    return m_scheduler.statistics();
+}
+
+void Controller::run() {
+    using Clock = CycleScheduler::Clock;
+
+    {
+        std::scoped_lock<std::mutex> lock(m_scheduler_mutex);
+        m_scheduler.start(Clock::now());
+    }
+
+    bool overrunning = false;
+
+    while (!m_stop) {
+        Clock::time_point next_start;
+        {
+            std::scoped_lock<std::mutex> lock(m_scheduler_mutex);
+            next_start = m_scheduler.next_start();
+        }
+        wait_until(next_start);
+
+        {
+            std::scoped_lock<std::mutex> lock(m_scheduler_mutex);
+            m_scheduler.begin_cycle(Clock::now());
+        }
+
+        // Inputs: everything that arrived for the devices since the last cycle
+        QCoreApplication::processEvents();
+
+        for (auto &slot : m_slots) {
+            const auto update_start = Clock::now();
+            slot.device->update();
+            const auto execution = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - update_start);
+
+            if (execution > slot.budget) {
+                // Only the first one is logged, a device that is always too slow would flood the log otherwise
+                if (slot.budget_exceeded++ == 0) {
+                    logging::main_log()->warn("Controller: device #{0} took {1}us in update, its budget is {2}us",
+                                              slot.device->get_id(), execution.count(), slot.budget.count());
+                }
+                emit budget_exceeded(slot.device->get_id(), execution.count());
+            }
+        }
+
+        const auto tasks_start = Clock::now();
+        for (auto &task : m_tasks) {
+            task(tasks_start);
+        }
+
+        const auto now = Clock::now();
+        bool in_time = true;
+        {
+            std::scoped_lock<std::mutex> lock(m_scheduler_mutex);
+            in_time = m_scheduler.end_cycle(now);
+        }
+
+        if (!in_time) {
+            const auto execution = std::chrono::duration_cast<std::chrono::microseconds>(now - next_start);
+            // Log the start of a series of overruns only, all of them are counted in the statistics
+            if (!overrunning) {
+                logging::main_log()->warn("Controller: cycle overrun, took {0}us", execution.count());
+            }
+            emit cycle_overrun(execution.count());
+        }
+        overrunning = !in_time;
+    }
+
+    // Hand the devices back, so they can be used (and destroyed) without the controller
+    for (auto &slot : m_slots) {
+        slot.device->moveToThread(m_owner_thread);
+    }
+}
+
+void Controller::wait_until(CycleScheduler::Clock::time_point time) const {
+    std::this_thread::sleep_until(time - m_spin_time);
+
+    while (CycleScheduler::Clock::now() < time) {
+        std::this_thread::yield();
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <QObject>
+#include <QThread>
+
+#include "cycle_scheduler.h"
+#include "devices/device.h"
+
+// The Controller runs the cycle all devices are driven by. Every cycle it first handles the events that arrived for the
+// devices since the last cycle (received data, timers, queued calls) and then calls update of every device in the order they
+// were added, like the scan of a PLC. The cycle runs in a thread of its own, which all devices are moved to while the
+// controller is running, so device logic never runs concurrently with the cycle.
+//
+// The start of the cycles is drift corrected (see CycleScheduler) and measured; cycles that overrun their period and devices
+// that exceed their time budget in update are reported.
+class Controller : public QObject {
+    Q_OBJECT
+public:
+    Controller();
+    ~Controller();
+
+    Controller(const Controller &) = delete;
+    Controller &operator=(const Controller &) = delete;
+
+    // Reads the period ("period" in ms) and the spin time ("spintime" in us) of the cycle
+    void init(std::shared_ptr<config::Segment> settings);
+
+    // Adds a device, budget is the time it may spend in update per cycle. Devices can only be added while the controller is
+    // stopped.
+    void add_device(Device *device, std::chrono::microseconds budget = std::chrono::microseconds(CONTROLLER_DEFAULT_BUDGET));
+    void clear_devices();
+
+    using Task = std::function<void(CycleScheduler::Clock::time_point now)>;
+
+    // Adds a task that runs every cycle after the devices were updated, e.g. the recipe runner. Like devices, tasks can only
+    // be added while the controller is stopped.
+    void add_task(Task task);
+    void clear_tasks();
+
+    void start();
+    void stop();
+    bool is_running() const { return m_running; }
+
+    // Returns a copy of the cycle statistics
+    CycleScheduler::Statistics get_statistics();
+
+signals:
+    // Emitted when a cycle took longer than the period, execution is the time from its scheduled start until it was done
+    void cycle_overrun(qint64 execution_us);
+
+    // Emitted when a device spent more than its budget in update
+    void budget_exceeded(device_id id, qint64 execution_us);
+
+private:
+    // The cycle loop, runs in m_thread until stop is called
+    void run();
+
+    // Waits until the given time, sleeping first and spinning for the last m_spin_time
+    void wait_until(CycleScheduler::Clock::time_point time) const;
+
+    struct Slot {
+        Device *device = nullptr;
+        std::chrono::microseconds budget;
+        uint64_t budget_exceeded = 0;
+    };
+    std::vector<Slot> m_slots;
+    std::vector<Task> m_tasks;
+
+    std::mutex m_scheduler_mutex;
+    CycleScheduler m_scheduler{std::chrono::milliseconds(CONTROLLER_DEFAULT_PERIOD)};
+
+    std::chrono::microseconds m_spin_time{CONTROLLER_SPIN_TIME};
+
+    std::unique_ptr<QThread> m_thread;
+    // The thread the devices are moved back to when the controller stops
+    QThread *m_owner_thread = nullptr;
+
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_stop{false};
+};
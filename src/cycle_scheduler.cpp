@@ -0,0 +1,32 @@
+#include "cycle_scheduler.h"
+
+#include <algorithm>
+
+void CycleScheduler::start(Clock::time_point now) { m_next_start = now; }
+
+void CycleScheduler::begin_cycle(Clock::time_point now) {
+    // Waking up early (the sleep of some systems is not accurate) counts as no jitter
+    const auto jitter = std::max(now - m_next_start, Clock::duration::zero());
+
+    m_statistics.cycles++;
+    m_statistics.min_jitter = std::min(m_statistics.min_jitter, jitter);
+    m_statistics.max_jitter = std::max(m_statistics.max_jitter, jitter);
+    m_statistics.total_jitter += jitter;
+}
+
+bool CycleScheduler::end_cycle(Clock::time_point now) {
+    m_statistics.max_execution = std::max(m_statistics.max_execution, now - m_next_start);
+
+    m_next_start += m_period;
+    if (now <= m_next_start) {
+        return true;
+    }
+
+    // Skip all cycles whose start already passed, the next one starts at the next multiple of the period
+    const auto missed = (now - m_next_start) / m_period + 1;
+    m_next_start += missed * m_period;
+
+    m_statistics.overruns++;
+    m_statistics.skipped += static_cast<uint64_t>(missed);
+    return false;
+}
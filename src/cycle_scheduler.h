@@ -0,0 +1,63 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+// CycleScheduler computes the start times of a fixed period cycle and measures how well they were met. The start of cycle n
+// is always start + n * period, so a late cycle does not shift the ones after it (no drift accumulates, unlike a timer that is
+// restarted after every cycle). If a cycle takes so long that the next start times already passed, those cycles are skipped
+// instead of being run back to back, keeping the phase of the cycle.
+//
+// Like TransactionEngine it does not do any waiting on its own and is not thread safe.
+class CycleScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Statistics {
+        uint64_t cycles = 0;
+        // Cycles whose work did not finish before the next cycle was due
+        uint64_t overruns = 0;
+        // Cycles that were not run at all because of an overrun
+        uint64_t skipped = 0;
+
+        // Time between the scheduled and the actual start of the cycles
+        Clock::duration min_jitter = Clock::duration::max();
+        Clock::duration max_jitter{};
+        Clock::duration total_jitter{};
+
+        // Time from the scheduled start of a cycle until its work was done
+        Clock::duration max_execution{};
+
+        Clock::duration mean_jitter() const {
+            return cycles == 0 ? Clock::duration::zero() : total_jitter / static_cast<Clock::rep>(cycles);
+        }
+    };
+
+    explicit CycleScheduler(Clock::duration period) : m_period(period) {}
+
+    void set_period(Clock::duration period) { m_period = period; }
+    Clock::duration get_period() const { return m_period; }
+
+    // Starts scheduling, the first cycle is due at now
+    void start(Clock::time_point now);
+
+    // Scheduled start of the next cycle
+    Clock::time_point next_start() const { return m_next_start; }
+
+    // To be called when a cycle starts, records the jitter
+    void begin_cycle(Clock::time_point now);
+
+    // To be called when the work of a cycle is done, schedules the next cycle. Returns false if the cycle overran.
+    bool end_cycle(Clock::time_point now);
+
+    const Statistics &statistics() const { return m_statistics; }
+    void reset_statistics() { m_statistics = Statistics{}; }
+
+private:
+    Clock::duration m_period;
+
+    // Scheduled start of the running (or next) cycle
+    Clock::time_point m_next_start;
+
+    Statistics m_statistics;
+};
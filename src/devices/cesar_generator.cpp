@@ -2,29 +2,37 @@
 
 #include "app_config.h"
 
-CesarGenerator::CesarGenerator(std::unique_ptr<BaseConnector> &&connector) : RFGenerator(std::move(connector)) {
-    if (m_connector) {
-        QObject::connect(m_connector.get(), &BaseConnector::data_received, this, &CesarGenerator::handle_data_received);
-    }
+#include <algorithm>
+#include <chrono>
 
-    logging::get_log("main")->debug("CesarGenerator: device #{0}", m_id);
-}
+CesarGenerator::CesarGenerator() { init_engine(); }
 
-void CesarGenerator::set_connector(std::unique_ptr<BaseConnector> &&connector) {
-    Device::set_connector(std::move(connector));
+CesarGenerator::CesarGenerator(std::unique_ptr<BaseConnector> &&connector) : RFGenerator(std::move(connector)) {
+    init_engine();
 
-    if (m_connector) {
-        QObject::connect(m_connector.get(), &BaseConnector::data_received, this, &CesarGenerator::handle_data_received);
-    }
+    logging::main_log()->debug("CesarGenerator: device #{0}", m_id);
 }
 
 void CesarGenerator::init(std::shared_ptr<config::Segment> settings) {
-    logging::get_log("main")->debug("CesarGenerator is Device #{0}", m_id);
+    logging::main_log()->debug("CesarGenerator is Device #{0}", m_id);
+
+    init_telemetry(*settings);
+    init_power_control(*settings);
+    init_match_tuning(*settings);
 
     if (auto address = settings->get<int>("address")) {
         m_address = *address;
     }
 
+    // Number of commands sent before the first one was acknowledged. Only raise it for generators that buffer commands.
+    if (auto window = settings->get<int>("window")) {
+        if (*window < 1) {
+            logging::main_log()->warn("CesarGenerator: ignoring invalid window {0}", *window);
+        } else {
+            m_engine.set_window(*window);
+        }
+    }
+
     auto conn_seg = settings->get_segment("connector");
     if (!conn_seg) {
         return;
@@ -34,14 +42,14 @@ void CesarGenerator::init(std::shared_ptr<config::Segment> settings) {
         // Connector not yet loaded, try to create it from the settings
         auto conn_type = conn_seg->get<std::string>("type");
         if (!conn_type) {
-            logging::get_log("main")->warn(
-                "KJLGenerator: init called but connector was not set up, unable to create one from the settings provided");
+            logging::main_log()->warn(
+                "CesarGenerator: init called but connector was not set up, unable to create one from the settings provided");
             return;
         }
         auto conn = make_connector(*conn_type);
 
         if (!conn) {
-            logging::get_log("main")->warn(
+            logging::main_log()->warn(
                 "CesarGenerator: init called but connector was not set up, unable to create one from the settings provided");
             return;
         }
@@ -51,28 +59,6 @@ void CesarGenerator::init(std::shared_ptr<config::Segment> settings) {
 
     // connector was set up, init it
     m_connector->init(conn_seg);
-
-    // try to connect to it
-    if (!m_connector->connect()) {
-        logging::get_log("main")->error(
-            "CesarGenerator: an error occured while trying to connect to the generator. Connector info:\n  {0}",
-            m_connector->info());
-    } else {
-        logging::get_log("main")->debug("CesarGenerator: connected. Connector info:\n  {0}", m_connector->info());
-    }
-}
-
-void CesarGenerator::update() {
-    if (m_generator_parameters.external_feedback != -1 && m_generator_parameters.forward_power != -1
-        && m_generator_parameters.reflected_power != -1 && m_generator_parameters.setpoint != -1
-        && m_generator_parameters.load_cap_position != -1 && m_generator_parameters.tune_cap_position != -1) {
-        std::scoped_lock<std::mutex> lock(m_parameter_mutex);
-
-        emit update_parameters(m_id);
-
-        // Reset all parameters to indicate we still need to save them
-        m_generator_parameters = {-1, -1, -1, -1, -1, -1};
-    }
 }
 
 void CesarGenerator::set_control_mode(ControlMode mode) {
@@ -82,47 +68,47 @@ void CesarGenerator::set_control_mode(ControlMode mode) {
     } else if (mode == ControlMode::Remote) {
         mode_id = 2;
     } else {
-        logging::get_log("main")->debug("CesarGenerator: ignoring unsupported control mode {0:#b}", static_cast<uint8_t>(mode));
+        logging::main_log()->debug("CesarGenerator: ignoring unsupported control mode {0:#b}", static_cast<uint8_t>(mode));
         return;
     }
 
-    queue_command(Commands::SelectActiveControlMode, mode_id);
+    queue_command(make_command(protocol::id(Commands::SelectActiveControlMode), mode_id));
 }
 
 void CesarGenerator::output_on() { queue_command(Commands::OutputOn); }
 
-void CesarGenerator::output_off() { queue_command(Commands::OutputOff); }
+void CesarGenerator::output_off() { queue_priority_command(Commands::OutputOff); }
 
 void CesarGenerator::set_target_power(int power) {
     if (power < 0) {
-        logging::get_log("main")->warn("CesarGenerator: set_target_power called with negative power value of {0}", power);
+        logging::main_log()->warn("CesarGenerator: set_target_power called with negative power value of {0}", power);
         return;
     }
     // TODO: test for maximum power
 
-    queue_command(Commands::SetPowerSetPoint, power & 0xFF, (power >> 8) & 0xFF);
+    queue_command(make_command(protocol::id(Commands::SetPowerSetPoint), power));
 }
 
 void CesarGenerator::set_load_capacitor_position(int position) {
     // Note: Values taken from cesar hardware manual, page 4-70
     if (position < 40 || position > 960) {
-        logging::get_log("main")->warn(
-            "KJLGenerator: set_load_capacitor_position called with position outside the range [40, 960], got {0}", position);
+        logging::main_log()->warn(
+            "CesarGenerator: set_load_capacitor_position called with position outside the range [40, 960], got {0}", position);
         return;
     }
 
-    queue_command(Commands::MoveLoadCapPosition, position & 0xFF, (position >> 8) & 0xFF);
+    queue_command(make_command(protocol::id(Commands::MoveLoadCapPosition), position));
 }
 
 void CesarGenerator::set_tune_capacitor_position(int position) {
     // Note: Values taken from cesar hardware manual, page 4-71
     if (position < 40 || position > 960) {
-        logging::get_log("main")->warn(
-            "KJLGenerator: set_tune_capacitor_position called with position outside the range [40, 960], got {0}", position);
+        logging::main_log()->warn(
+            "CesarGenerator: set_tune_capacitor_position called with position outside the range [40, 960], got {0}", position);
         return;
     }
 
-    queue_command(Commands::MoveTuneCapPosition, position & 0xFF, (position >> 8) & 0xFF);
+    queue_command(make_command(protocol::id(Commands::MoveTuneCapPosition), position));
 }
 
 void CesarGenerator::set_matchnetwork_mode(MatchnetworkMode mode) {
@@ -132,11 +118,11 @@ void CesarGenerator::set_matchnetwork_mode(MatchnetworkMode mode) {
     } else if (mode == MatchnetworkMode::Manual) {
         mode_id = 0;
     } else {
-        logging::get_log("main")->debug("CesarGenerator: ignoring unknown match control mode id {0}", static_cast<int>(mode));
+        logging::main_log()->debug("CesarGenerator: ignoring unknown match control mode id {0}", static_cast<int>(mode));
         return;
     }
 
-    queue_command(Commands::SetMatchNetworkControl, mode_id);
+    queue_command(make_command(protocol::id(Commands::SetMatchNetworkControl), mode_id));
 }
 
 void CesarGenerator::query_capacitor_positions() { queue_command(Commands::ReportCapacitorPositions); }
@@ -147,279 +133,161 @@ void CesarGenerator::query_forward_power() { queue_command(Commands::ReportForwa
 
 void CesarGenerator::query_reflected_power() { queue_command(Commands::ReportReflectedPower); }
 
-void CesarGenerator::queue_command(QByteArray command) {
+void CesarGenerator::init_engine() {
+    m_engine.set_send_function(
+        [this](const std::string &frame) { send(QByteArray(frame.data(), static_cast<int>(frame.size()))); });
+    m_engine.set_fail_function([this](const TransactionEngine::Transaction &transaction, const char *reason) {
+        logging::main_log()->warn("CesarGenerator: giving up command {0} after {1} attempts ({2})", transaction.command,
+                                  transaction.attempts, reason);
+        // Also covers queries the generator kept rejecting (NACK), their replies will never arrive
+        telemetry_failed(transaction.command);
+    });
+
+    m_expire_timer.setSingleShot(true);
+    QObject::connect(&m_expire_timer, &QTimer::timeout, this, [this]() {
+        m_engine.expire(TransactionEngine::Clock::now());
+        schedule_expire();
+    });
+}
+
+void CesarGenerator::queue_command(const QByteArray &command, TransactionEngine::Priority priority) {
     if (!m_connector) {
-        logging::get_log("main")->warn("CesarGenerator: queue_command was called but no connector was set up, command was '{0}'",
-                                       command.toHex().toStdString());
+        logging::main_log()->warn("CesarGenerator: queue_command was called but no connector was set up, command was '{0}'",
+                                  logging::hex(command));
         return;
     }
 
-    std::scoped_lock<std::mutex> lock(m_command_mutex);
-
-    // Build the outgoing packet
-    int data_len = command.length();
-
-    if (data_len > 6) {
-        command.insert(1, static_cast<char>(data_len));
-        data_len = 7;
-    }
-    command.prepend((m_address << 3) & 0xF8 | static_cast<char>(data_len));
-    command.append('\0');
-
-    // Checksum
-    command.append(command[0]);
-    data_len = command.length();
-    for (int i = 1; i < data_len - 1; i++) {
-        command[data_len - 1] = command[data_len - 1] ^ command[i];
+    // The engine is driven by the replies, which are handled in the thread of the device
+    if (!in_device_thread()) {
+        QMetaObject::invokeMethod(this, [this, command, priority]() { queue_command(command, priority); },
+                                  Qt::QueuedConnection);
+        return;
     }
 
-    if (m_command_queue.empty()) {
-        send(command);
-    }
+    const uint8_t command_id = static_cast<uint8_t>(command[0]);
+    auto packet = framing::CesarFramer::make_packet(m_address, std::string_view(command.constData(), command.size()));
 
-    m_command_queue.push_back(command);
+    // Report commands (128 and above) are answered with a packet containing the requested data
+    m_engine.submit(command_id, std::move(packet), command_id >= 128, priority, TransactionEngine::Clock::now());
+    command_sent(command_id);
+    schedule_expire();
 }
 
-bool CesarGenerator::write_command() {
-    if (!m_command_queue.empty()) {
-        send(m_command_queue.front());
-        return true;
+void CesarGenerator::schedule_expire() {
+    auto deadline = m_engine.next_deadline();
+    if (!deadline) {
+        m_expire_timer.stop();
+        return;
     }
-    return false;
+
+    auto delay = std::chrono::ceil<std::chrono::milliseconds>(*deadline - TransactionEngine::Clock::now());
+    m_expire_timer.start(std::max(0, static_cast<int>(delay.count())));
 }
 
 void CesarGenerator::handle_data_received(const QByteArray &data) {
-    // A buffer for incoming messages so we don't keep the mutex locked for actual handling of the packets
-    std::vector<Packet> packets;
-
-    logging::get_log("main")->debug("CesarGenerator: handle_data_received got {0} (hex)", data.toHex().toStdString());
-
-    {
-        std::scoped_lock<std::mutex> data_lock(m_data_mutex);
+    logging::main_log()->debug("CesarGenerator: handle_data_received got {0} (hex)", logging::hex(data));
 
-        // Since we can only ever send one command at once we have to keep track of when we send one
-        bool command_sent = false;
+    const auto now = TransactionEngine::Clock::now();
 
-        m_in_buffer.append(data);
+    if (!m_reader.push(data.constData(), data.size())) {
+        // Only happens if the generator sends garbage without ever completing a packet
+        logging::main_log()->warn("CesarGenerator: receive buffer overflow, discarded buffered data");
+    }
 
-        // Process incoming and buffered data
-        int i = 0;
-        for (; i < m_in_buffer.length(); i++) {
-            const uint8_t header = m_in_buffer[i];
+    m_reader.for_each_frame([&](std::string_view frame, bool valid) {
+        const uint8_t header = frame[0];
 
+        if (frame.size() == 1) {
+            // ACK: command successfully sent, the engine sends the next one (if available)
+            // NACK: the engine resends the packet or throws it away if we tried too many times already
             if (header == ACK) {
-                // ACK: command successfully sent, delete it from the queue
-                std::scoped_lock<std::mutex> command_lock(m_command_mutex);
-                if (!m_command_queue.empty()) {
-                    m_command_queue.pop_front();
-                }
-                m_send_retries = 0;
-
-                // If no command was sent yet send the next one (if available)
-                if (!command_sent) {
-                    command_sent = write_command();
-                }
-
-                // There may be more data (for example an answer to a request) so keep iterating
-                continue;
-            } else if (header == NACK) {
-                // NACK: resend the packet or throw it away if we tried too many times already
-                if (m_send_retries >= MAX_SEND_RETRIES) {
-                    std::scoped_lock<std::mutex> command_lock(m_command_mutex);
-                    if (!m_command_queue.empty()) {
-                        logging::get_log("main")->warn("CesarGenerator: sending of command '{0}' unsuccessul after {1} attempts",
-                                                       m_command_queue.front().toStdString(), MAX_SEND_RETRIES);
-
-                        m_command_queue.pop_front();
-                    } else {
-                        logging::get_log("main")->warn(
-                            "CesarGenerator: sending of command unsuccessful after {0} attempts, command queue is empty",
-                            MAX_SEND_RETRIES);
-                    }
-                    m_send_retries = 0;
-                }
-
-                m_send_retries++;
-                if (!command_sent) {
-                    command_sent = write_command();
-                } else {
-                    // NACK received after ACK, or multiple NACKs received. This shouldn't happen.
-                    logging::get_log("main")->warn("CesarGenerator: multiple NACKs or ACK + NACK received");
-                }
-
-                m_in_buffer.clear();
-
-                // Stop iterating since we cleared the buffer
-                break;
-            }
-
-            // Length of data is the last three bits of the header byte, or an optional byte with offset 2 if the length
-            // is greater than 6
-            int datalength = header & 0b111;
-            int offset = 2;
-            if (datalength == 7) {
-                if (i + 2 >= m_in_buffer.length()) {
-                    break;
-                }
-
-                datalength = m_in_buffer[i + 2];
-                offset = 3;
-            }
-
-            // Check if we have enough data buffered (+1 for the checksum byte)
-            if (m_in_buffer.length() < i + offset + datalength + 1) {
-                break;
-            }
-
-            // Compare the checksum
-            char checksum = 0;
-            for (int j = i; j < i + offset + datalength + 1; j++) {
-                checksum ^= m_in_buffer[j];
-            }
-
-            if (checksum == 0) {
-                send(QByteArray(1, ACK));
-                packets.push_back({header, m_in_buffer.mid(i + offset - 1, datalength + 1)});
+                m_engine.acknowledge(now);
             } else {
-                send(QByteArray(1, NACK));
-                logging::get_log("main")->warn("CesarGenerator: received corrupted packet with content\n\t{0} (hex)",
-                                               m_in_buffer.mid(i, datalength + 1).toHex().toStdString());
-            }
-
-            i += offset + datalength;
-        }
-
-        if (!m_in_buffer.isEmpty()) {
-            // Clear processed data from the buffer
-            if (i == m_in_buffer.length()) {
-                m_in_buffer.clear();
-            } else {
-                m_in_buffer = m_in_buffer.mid(i);
+                m_engine.reject(now);
             }
+            return;
         }
-    }  // scoped_lock
 
-    // Process received packets
-    for (const auto &p : packets) {
-        handle_reply(p);
-    }
-}
-
-void CesarGenerator::handle_reply(const Packet &packet) {
-    switch (static_cast<Commands>(packet.command)) {
-    // case Commands::ReportPowerSupplyType:
-    //    break;
-    // case Commands::ReportMatchNetworkMotorMovement:
-    //    break;
-    // case Commands::ReportReflectedPowerParameters:
-    //    break;
-    // case Commands::ReportRegulationMode:
-    //    break;
-    // case Commands::ReportActiveControlMode:
-    //    break;
-    // case Commands::ReportProcessStatus:
-    //    break;
-    // case Commands::ReportMatchNetworkControlMode:
-    //    break;
-    case Commands::ReportSetPointAndRegulationMode: {
-        if (packet.data.length() < 2) {
-            logging::get_log("main")->warn(
-                "CesarGenerator: not enough data in the reply to ReportSetPointAndRegulationMode, got '{0}'",
-                packet.data.toHex().toStdString());
+        if (!valid) {
+            send(QByteArray(1, NACK));
+            logging::main_log()->warn("CesarGenerator: received corrupted packet with content\n\t{0} (hex)", logging::hex(frame));
             return;
         }
 
-        std::scoped_lock<std::mutex> lock(m_parameter_mutex);
-        m_generator_parameters.setpoint = (packet.data[1] << 8) | packet.data[0];
+        send(QByteArray(1, ACK));
 
-        logging::get_log("main")->debug("CesarGenerator: ReportSetPointAndRegulationMode returned {0}",
-                                        m_generator_parameters.setpoint);
-        break;
-    }
-    case Commands::ReportForwardPower: {
-        if (packet.data.length() < 2) {
-            logging::get_log("main")->warn("CesarGenerator: not enough data in the reply to ReportForwardPower, got '{0}'",
-                                           packet.data.toHex().toStdString());
-            return;
-        }
+        // Data is everything between the command (or the optional length byte) and the checksum
+        const uint8_t command = frame[1];
+        const size_t offset = framing::CesarFramer::data_offset(header);
+        m_engine.correlate(command);
+        handle_reply({command, QByteArray(frame.data() + offset, static_cast<int>(frame.size() - offset - 1))});
+    });
 
-        std::scoped_lock<std::mutex> lock(m_parameter_mutex);
-        m_generator_parameters.forward_power = (packet.data[1] << 8) | packet.data[0];
+    schedule_expire();
+}
 
-        logging::get_log("main")->debug("CesarGenerator: ReportForwardPower returned {0}", m_generator_parameters.forward_power);
-        break;
-    }
-    case Commands::ReportReflectedPower: {
-        if (packet.data.length() < 2) {
-            logging::get_log("main")->warn("CesarGenerator: not enough data in the reply to ReportReflectedPower, got '{0}'",
-                                           packet.data.toHex().toStdString());
-            return;
-        }
+const protocol::Command<RFGenerator::Parameters> *CesarGenerator::find_command(uint8_t id) {
+    return protocol::cesar::command_table().find(id);
+}
 
-        std::scoped_lock<std::mutex> lock(m_parameter_mutex);
-        m_generator_parameters.reflected_power = (packet.data[1] << 8) | packet.data[0];
+QByteArray CesarGenerator::make_command(uint8_t id, int value) {
+    QByteArray command(1, static_cast<char>(id));
 
-        logging::get_log("main")->debug("CesarGenerator: ReportReflectedPower returned {0}",
-                                        m_generator_parameters.reflected_power);
-        break;
+    if (const auto *descriptor = find_command(id)) {
+        protocol::encode(*descriptor, value, command);
     }
-    // case Commands::ReportDeliveredPower:
-    //    break;
-    case Commands::ReportExternalFeedback: {
-        if (packet.data.length() < 2) {
-            logging::get_log("main")->warn("CesarGenerator: not enough data in the reply to ReportExternalFeedback, got '{0}'",
-                                           packet.data.toHex().toStdString());
-            return;
-        }
 
-        std::scoped_lock<std::mutex> lock(m_parameter_mutex);
-        m_generator_parameters.external_feedback = (packet.data[1] << 8) | packet.data[0];
+    return command;
+}
 
-        logging::get_log("main")->debug("CesarGenerator: ReportExternalFeedback returned {0}",
-                                        m_generator_parameters.external_feedback);
-        break;
+void CesarGenerator::handle_reply(const Packet &packet) {
+    const auto *command = find_command(packet.command);
+    if (!command) {
+        logging::main_log()->warn("CesarGenerator: received unknown reply command {0}", packet.command);
+        telemetry_failed(std::nullopt);
+        return;
     }
-    // case Commands::ReportForwardPowerLimit:
-    //    break;
-    // case Commands::ReportReflectedPowerLimit:
-    //    break;
-    case Commands::ReportCapacitorPositions: {
-        if (packet.data.length() < 4) {
-            logging::get_log("main")->warn("CesarGenerator: not enough data in the reply to ReportCapacitorPositions, got '{0}'",
-                                           packet.data.toHex().toStdString());
-            return;
-        }
-
-        std::scoped_lock<std::mutex> lock(m_parameter_mutex);
-        m_generator_parameters.load_cap_position = ((packet.data[1] << 8) | packet.data[0]) / 10;
-        m_generator_parameters.tune_cap_position = ((packet.data[3] << 8) | packet.data[2]) / 10;
 
-        logging::get_log("main")->debug("CesarGenerator: ReportCapacitorPositions returned {0} (load cap) and {1} (tune cap)",
-                                        m_generator_parameters.load_cap_position, m_generator_parameters.tune_cap_position);
-        break;
+    if (packet.command == protocol::id(Commands::ErrorMatchingNetworkNotConnected)) {
+        // No matching network connected, sent instead of the reply to the query
+        logging::main_log()->warn("CesarGenerator: no matching network connected");
+        telemetry_failed(std::nullopt);
+        return;
     }
-    // case Commands::ReportUnitRunTime:
-    //    break;
-    case Commands::ReportFaultStatusRegister: {
-        if (packet.data.length() < 2) {
-            logging::get_log("main")->warn("CesarGenerator: not enough data in the reply to ReportFaultStatusRegister, got '{0}'",
-                                           packet.data.toHex().toStdString());
-            return;
-        }
 
-        int faultstatus = (packet.data[1] << 8) | packet.data[0];
+    if (!command->has_reply()) {
+        // Set commands are answered with a command status response (CSR), 0 means the command was accepted
+        if (!packet.data.isEmpty() && packet.data[0] != 0) {
+            logging::main_log()->warn("CesarGenerator: {0} was rejected with CSR {1}", command->name,
+                                      static_cast<uint8_t>(packet.data[0]));
+        }
+        return;
+    }
 
-        logging::get_log("main")->debug("CesarGenerator: ReportFaultStatusRegister returned {0}", faultstatus);
-        break;
+    Parameters parameters;
+    if (!protocol::decode(*command, std::string_view(packet.data.constData(), packet.data.size()), parameters)) {
+        logging::main_log()->warn("CesarGenerator: not enough data in the reply to {0}, got '{1}'", command->name,
+                                  logging::hex(packet.data));
+        telemetry_failed(packet.command);
+        return;
     }
 
-    case Commands::ErrorMatchingNetworkNotConnected: {
-        // No matching network connected
-        logging::get_log("main")->warn("CesarGenerator: no matching network connected");
-        break;
+    for (const auto &field : command->reply) {
+        if (field.target) {
+            report_parameter(field.target, parameters.*field.target);
+        }
     }
 
-    default:
-        logging::get_log("main")->warn("CesarGenerator: received unknown reply command {0}", packet.command);
+    // Replies arrive with every telemetry sample, only format the values when they are logged
+    if (logging::main_log()->should_log(spdlog::level::debug)) {
+        std::string values;
+        for (const auto &field : command->reply) {
+            if (field.target) {
+                values += fmt::format(" {0}", parameters.*field.target);
+            }
+        }
+        logging::main_log()->debug("CesarGenerator: {0} returned{1}", command->name, values);
     }
+
+    telemetry_received(packet.command);
 }
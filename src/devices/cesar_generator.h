@@ -1,17 +1,20 @@
 #pragma once
 
+#include "cesar_protocol.h"
 #include "device.h"
+#include "framer.h"
+#include "protocol.h"
 #include "rf_generator.h"
+#include "transaction_engine.h"
 
-#include <list>
-#include <mutex>
+#include <QTimer>
 
 #include "util/util.h"
 
 class CesarGenerator : public RFGenerator {
     Q_OBJECT
 public:
-    CesarGenerator() = default;
+    CesarGenerator();
     CesarGenerator(std::unique_ptr<BaseConnector> &&connector);
     ~CesarGenerator() = default;
 
@@ -19,9 +22,7 @@ public:
     CesarGenerator &operator=(const CesarGenerator &) = delete;
 
     // overrides from Device
-    void set_connector(std::unique_ptr<BaseConnector> &&connector) override;
     void init(std::shared_ptr<config::Segment> settings) override;
-    void update() override;
     virtual void set_control_mode(ControlMode mode) override;
 
     // overrides from RFGenerator
@@ -32,17 +33,24 @@ public:
     void set_tune_capacitor_position(int position) override;
 
     void set_matchnetwork_mode(MatchnetworkMode mode) override;
+    // Note: Values taken from cesar hardware manual, page 4-70. Positions are reported in %, but set in 0.1% steps.
+    CapacitorRange get_capacitor_range() const override { return {40, 960, 10}; }
 
     void query_capacitor_positions() override;
     void query_external_feedback() override;
     void query_forward_power() override;
     void query_reflected_power() override;
 
+protected:
+    // overrides from Device
+    void handle_data_received(const QByteArray &data) override;
+
 private:
-    // Queue a command to be sent to the device. If no other commands are queued it will be sent immediately. Otherwise
-    // the next command is sent when a valid reply was received.
-    void queue_command(QByteArray command);
-    
+    // Queue a command to be sent to the device. It is sent as soon as the previous commands were acknowledged (see
+    // TransactionEngine). Commands with high priority are sent before all queued commands with normal priority. Calls from
+    // other threads are queued to the thread of the generator.
+    void queue_command(const QByteArray &command, TransactionEngine::Priority priority = TransactionEngine::Priority::Normal);
+
     // Since QByteArray does not provide a constructor taking an initializer_list, we use this little templated
     // queue_command to simplify the construction of packages.
     // This overload takes any number of parameters and packs them in one QByteArray, which is passed on to queue_command.
@@ -54,13 +62,18 @@ private:
         queue_command(util::make_byte_array(args...));
     }
 
-    // Send the first command in the queue to the device. Returns true when a command was sent and false otherwise (i.e.
-    // when the queue is empty).
-    bool write_command();
+    // Same as queue_command, but the command is sent before all commands queued with normal priority. Use it for commands
+    // that must not wait behind queries, e.g. turning the output off.
+    template <typename... Ts>
+    void queue_priority_command(const Ts... args) {
+        queue_command(util::make_byte_array(args...), TransactionEngine::Priority::High);
+    }
+
+    // Connect the transaction engine to the connector and the expire timer, called by the constructors
+    void init_engine();
 
-    // Handle new data received via the connector. If not enough data is received it will be buffered and handled once
-    // the full package arrived.
-    void handle_data_received(const QByteArray &data);
+    // (Re)start the timer for the next deadline of the transaction engine
+    void schedule_expire();
 
     // Packet is used to save the decoded command number and additional data of a received command reply.
     struct Packet {
@@ -71,57 +84,24 @@ private:
     // Handle a received reply, i.e. notify the correct places about the data received.
     void handle_reply(const Packet &packet);
 
-    // Saves the received parameters from the generator. When all were received successfully, they are reported to the controller
-    // and set to -1 again.
-    struct {
-        int external_feedback = -1;
-        int forward_power = -1;
-        int reflected_power = -1;
-        int setpoint = -1;
-        int load_cap_position = -1;
-        int tune_cap_position = -1;
-    } m_generator_parameters;
-    std::mutex m_parameter_mutex;
-
-    std::mutex m_data_mutex;
-    QByteArray m_in_buffer;
+    // Returns the protocol descriptor of a command (see protocol::cesar::command_table), nullptr for unknown commands
+    static const protocol::Command<Parameters> *find_command(uint8_t id);
+
+    // Builds a command with its payload for value as described by the protocol table
+    static QByteArray make_command(uint8_t id, int value = 0);
 
     // Address of the generator (called "busaddress" in the old software)
     int m_address = 0;
 
-    int m_send_retries = 0;
-    std::mutex m_command_mutex;
-    std::list<QByteArray> m_command_queue;
-
-    // clang-format off
-    enum class Commands : uint8_t {
-        OutputOff = 1,
-        OutputOn = 2,
-        SetPowerSetPoint = 8,                    // 0x8
-        SetMatchNetworkControl = 13,             // 0xD
-        SelectActiveControlMode = 14,            // 0xE
-        SetReflectedPowerParameters = 33,        // 0x21
-        ErrorMatchingNetworkNotConnected = 53,   // Listed as command to use it in the switch statement
-        MoveLoadCapPosition = 112,               // 0x70
-        MoveTuneCapPosition = 122,               // 0x7A
-        //ReportPowerSupplyType = 128,           // 0x80, not sent
-        //ReportMatchNetworkMotorMovement = 131, // 0x83, not sent
-        //ReportReflectedPowerParameters = 152,  // 0x98, not sent
-        //ReportRegulationMode = 154,            // 0x9A, not sent
-        //ReportActiveControlMode = 155,         // 0x9B, not sent
-        //ReportProcessStatus = 162,             // 0xA2, not sent
-        ReportSetPointAndRegulationMode = 164,   // 0xA4
-        ReportForwardPower = 165,                // 0xA5
-        ReportReflectedPower = 166,              // 0xA6
-        //ReportDeliveredPower = 167,            // 0xA7, not sent
-        ReportExternalFeedback = 168,            // 0xA8
-        //ReportForwardPowerLimit = 169,         // 0xA9, not sent
-        //ReportReflectedPowerLimit = 170,       // 0xAA, not sent
-        ReportCapacitorPositions = 175,          // 0xAF
-        //ReportUnitRunTime = 205,               // 0xCD, not sent
-        ReportFaultStatusRegister = 223,         // 0xDF
-    };
-    // clang-format on
-    const static uint8_t ACK = 0x6;
-    const static uint8_t NACK = 0x15;
+    TransactionEngine m_engine{CESAR_DEFAULT_WINDOW, std::chrono::milliseconds(CESAR_ACK_TIMEOUT),
+                               std::chrono::milliseconds(CESAR_REPLY_TIMEOUT), MAX_SEND_RETRIES};
+    framing::FrameReader<framing::CesarFramer> m_reader{DEVICE_RECEIVE_BUFFER_SIZE};
+
+    // Fires at the next deadline of m_engine, i.e. when a command has to be resent or a reply is overdue
+    QTimer m_expire_timer{this};
+
+    using Commands = protocol::cesar::Commands;
+
+    const static uint8_t ACK = framing::CesarFramer::ACK;
+    const static uint8_t NACK = framing::CesarFramer::NACK;
 };
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "protocol.h"
+#include "rf_parameters.h"
+
+// The protocol of Advanced Energy Cesar generators: the commands sent by CesarGenerator and the layout of their replies. It
+// does not depend on Qt, so the benchmarks decode replies with the same table as the driver.
+namespace protocol::cesar {
+    // clang-format off
+    // The layout of requests and replies is described in command_table
+    enum class Commands : uint8_t {
+        OutputOff = 1,
+        OutputOn = 2,
+        SetPowerSetPoint = 8,                    // 0x8
+        SetMatchNetworkControl = 13,             // 0xD
+        SelectActiveControlMode = 14,            // 0xE
+        SetReflectedPowerParameters = 33,        // 0x21
+        ErrorMatchingNetworkNotConnected = 53,   // Listed as command to use it in the switch statement
+        MoveLoadCapPosition = 112,               // 0x70
+        MoveTuneCapPosition = 122,               // 0x7A
+        //ReportPowerSupplyType = 128,           // 0x80, not sent
+        //ReportMatchNetworkMotorMovement = 131, // 0x83, not sent
+        //ReportReflectedPowerParameters = 152,  // 0x98, not sent
+        //ReportRegulationMode = 154,            // 0x9A, not sent
+        //ReportActiveControlMode = 155,         // 0x9B, not sent
+        //ReportProcessStatus = 162,             // 0xA2, not sent
+        ReportSetPointAndRegulationMode = 164,   // 0xA4
+        ReportForwardPower = 165,                // 0xA5
+        ReportReflectedPower = 166,              // 0xA6
+        //ReportDeliveredPower = 167,            // 0xA7, not sent
+        ReportExternalFeedback = 168,            // 0xA8
+        //ReportForwardPowerLimit = 169,         // 0xA9, not sent
+        //ReportReflectedPowerLimit = 170,       // 0xAA, not sent
+        ReportCapacitorPositions = 175,          // 0xAF
+        //ReportUnitRunTime = 205,               // 0xCD, not sent
+        ReportFaultStatusRegister = 223,         // 0xDF
+    };
+    // clang-format on
+
+    // The descriptors of the commands, see protocol::Table
+    inline const auto &command_table() {
+        using Command = protocol::Command<RFParameters>;
+
+        // clang-format off
+        static constexpr protocol::Table table{std::array<Command, 15>{{
+            // Set commands, answered with a command status response (CSR)
+            {protocol::id(Commands::OutputOff), "OutputOff"},
+            {protocol::id(Commands::OutputOn), "OutputOn"},
+            {protocol::id(Commands::SetPowerSetPoint), "SetPowerSetPoint", Encoding::UInt16LE},
+            {protocol::id(Commands::SetMatchNetworkControl), "SetMatchNetworkControl", Encoding::UInt8},
+            {protocol::id(Commands::SelectActiveControlMode), "SelectActiveControlMode", Encoding::UInt8},
+            {protocol::id(Commands::SetReflectedPowerParameters), "SetReflectedPowerParameters"},  // not sent
+            {protocol::id(Commands::ErrorMatchingNetworkNotConnected), "ErrorMatchingNetworkNotConnected"},
+            {protocol::id(Commands::MoveLoadCapPosition), "MoveLoadCapPosition", Encoding::UInt16LE},
+            {protocol::id(Commands::MoveTuneCapPosition), "MoveTuneCapPosition", Encoding::UInt16LE},
+
+            // Report commands, the positions of the capacitors are reported in 0.1% steps
+            {protocol::id(Commands::ReportSetPointAndRegulationMode), "ReportSetPointAndRegulationMode", Encoding::None, "",
+                {{{Encoding::UInt16LE, 0, 1, &RFParameters::setpoint}}}},
+            {protocol::id(Commands::ReportForwardPower), "ReportForwardPower", Encoding::None, "",
+                {{{Encoding::UInt16LE, 0, 1, &RFParameters::forward_power}}}},
+            {protocol::id(Commands::ReportReflectedPower), "ReportReflectedPower", Encoding::None, "",
+                {{{Encoding::UInt16LE, 0, 1, &RFParameters::reflected_power}}}},
+            {protocol::id(Commands::ReportExternalFeedback), "ReportExternalFeedback", Encoding::None, "",
+                {{{Encoding::UInt16LE, 0, 1, &RFParameters::external_feedback}}}},
+            {protocol::id(Commands::ReportCapacitorPositions), "ReportCapacitorPositions", Encoding::None, "",
+                {{{Encoding::UInt16LE, 0, 10, &RFParameters::load_cap_position},
+                  {Encoding::UInt16LE, 2, 10, &RFParameters::tune_cap_position}}}},
+            {protocol::id(Commands::ReportFaultStatusRegister), "ReportFaultStatusRegister", Encoding::None, "",
+                {{{Encoding::UInt16LE, 0, 1, &RFParameters::fault_status}}}},
+        }}};
+        // clang-format on
+
+        return table;
+    }
+}  // namespace protocol::cesar
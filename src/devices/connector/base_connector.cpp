@@ -0,0 +1,205 @@
+#include "base_connector.h"
+
+#include "logging/logging.h"
+
+#include <algorithm>
+
+BaseConnector::BaseConnector(const std::string &type) noexcept : m_type{type} {
+    qRegisterMetaType<BaseConnector::ConnectionState>("BaseConnector::ConnectionState");
+
+    m_retry_timer.setSingleShot(true);
+    QObject::connect(&m_retry_timer, &QTimer::timeout, this, [this]() {
+        set_state(ConnectionState::Connecting);
+        start_connect();
+    });
+
+    m_io_thread.setObjectName(QString::fromStdString(m_type + " connector"));
+}
+
+BaseConnector::~BaseConnector() {
+    // Derived classes already stopped the thread, this only makes sure it is never destroyed while running
+    m_io_thread.quit();
+    m_io_thread.wait();
+}
+
+bool BaseConnector::connect() {
+    start_io_thread();
+
+    bool connected = false;
+    run_in_io_thread([this, &connected]() { connected = open_connection(); });
+    return connected;
+}
+
+void BaseConnector::disconnect() {
+    run_in_io_thread([this]() { close_connection(); });
+}
+
+void BaseConnector::connect_async() {
+    start_io_thread();
+
+    QMetaObject::invokeMethod(this, [this]() {
+        if (m_state == ConnectionState::Connecting || m_state == ConnectionState::Connected) {
+            return;
+        }
+
+        m_reconnect = true;
+        m_retry_delay = CONNECT_RETRY_MIN_DELAY;
+        m_retry_timer.stop();
+
+        set_state(ConnectionState::Connecting);
+        start_connect();
+    });
+}
+
+void BaseConnector::write(const QByteArray &data) {
+    if (data.isEmpty()) {
+        return;
+    }
+
+    if (!m_outbound.try_push(data)) {
+        logging::main_log()->warn("BaseConnector ({0}): send queue full, dropping {1} (hex)", m_type, logging::hex(data));
+        return;
+    }
+
+    if (!m_flush_pending.exchange(true)) {
+        QMetaObject::invokeMethod(this, &BaseConnector::flush, Qt::QueuedConnection);
+    }
+}
+
+void BaseConnector::read_all(const std::function<void(const QByteArray &)> &func) {
+    // Reset the flag before looking at the queue: data pushed after the last chunk was popped emits data_ready again
+    m_data_ready_pending = false;
+
+    QByteArray data;
+    while (m_inbound.try_pop(data)) {
+        func(data);
+    }
+}
+
+void BaseConnector::connection_established() {
+    m_retry_delay = CONNECT_RETRY_MIN_DELAY;
+    m_retry_timer.stop();
+
+    set_state(ConnectionState::Connected);
+}
+
+void BaseConnector::connection_failed(const std::string &reason) {
+    if (!m_reconnect) {
+        set_state(ConnectionState::Disconnected);
+        return;
+    }
+
+    logging::main_log()->warn("BaseConnector ({0}): {1}, retrying in {2}ms", m_type, reason, m_retry_delay);
+
+    set_state(ConnectionState::WaitingForRetry);
+    m_retry_timer.start(m_retry_delay);
+
+    m_retry_delay = std::min(m_retry_delay * 2, CONNECT_RETRY_MAX_DELAY);
+}
+
+void BaseConnector::connection_closed() {
+    m_reconnect = false;
+    m_retry_timer.stop();
+
+    set_state(ConnectionState::Disconnected);
+}
+
+bool BaseConnector::data_received(QByteArray data) {
+    if (m_capture) {
+        m_capture->record(capture::Direction::Inbound, data);
+    }
+
+    if (!m_inbound.try_push(std::move(data))) {
+        logging::main_log()->warn("BaseConnector ({0}): receive queue full, the device does not keep up", m_type);
+        return false;
+    }
+
+    if (!m_data_ready_pending.exchange(true)) {
+        emit data_ready();
+    }
+    return true;
+}
+
+void BaseConnector::init_capture(const config::Segment &settings) {
+    auto path = settings.get<std::string>("capture");
+    if (!path) {
+        m_capture.reset();
+        return;
+    }
+
+    const auto size = settings.get<int>("capturesize").value_or(CAPTURE_DEFAULT_SIZE);
+    if (size <= 0) {
+        logging::main_log()->error("BaseConnector ({0}): invalid capture size of {1}MB", m_type, size);
+        return;
+    }
+
+    auto capture = std::make_unique<capture::CaptureFile>();
+    if (!capture->open(*path, static_cast<uint64_t>(size) * 1024 * 1024, m_type)) {
+        return;
+    }
+
+    logging::main_log()->info("BaseConnector ({0}): capturing to '{1}'", m_type, *path);
+    m_capture = std::move(capture);
+}
+
+void BaseConnector::stop_io_thread() {
+    if (!m_io_thread.isRunning()) {
+        close_connection();
+        return;
+    }
+
+    // The connection has to be closed (and its notifiers destroyed) by the thread that owns it
+    QThread *target = QThread::currentThread();
+    run_in_io_thread([this, target]() {
+        close_connection();
+        move_to_thread(target);
+        moveToThread(target);
+    });
+
+    m_io_thread.quit();
+    m_io_thread.wait();
+}
+
+void BaseConnector::start_io_thread() {
+    if (!m_io_thread_enabled || m_io_thread.isRunning()) {
+        return;
+    }
+
+    // The timers are children of the connector and move along with it
+    moveToThread(&m_io_thread);
+    move_to_thread(&m_io_thread);
+    m_io_thread.start();
+}
+
+void BaseConnector::run_in_io_thread(const std::function<void()> &func) {
+    QThread *owner = thread();
+    if (!owner || owner == QThread::currentThread() || !owner->isRunning()) {
+        func();
+        return;
+    }
+
+    QMetaObject::invokeMethod(this, func, Qt::BlockingQueuedConnection);
+}
+
+void BaseConnector::flush() {
+    m_flush_pending = false;
+
+    QByteArray data;
+    while (m_outbound.try_pop(data)) {
+        if (m_capture) {
+            m_capture->record(capture::Direction::Outbound, data);
+        }
+        write_data(data);
+    }
+}
+
+void BaseConnector::set_state(ConnectionState state) {
+    m_connected = state == ConnectionState::Connected;
+
+    if (state == m_state) {
+        return;
+    }
+
+    m_state = state;
+    emit connection_state_changed(state);
+}
@@ -1,30 +1,64 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <memory>
 #include <string>
 
+#include "app_config.h"
+#include "capture_file.h"
 #include "config/segment.h"
+#include "util/spsc_queue.h"
 
 #include <QObject>
 #include <QByteArray>
+#include <QThread>
+#include <QTimer>
 
+// Connectors run in an I/O thread of their own that owns the socket or serial port, so reading and writing never waits for
+// (or blocks) the thread of the device. Received data and outgoing data cross between the threads over lock-free single
+// producer/single consumer queues: the I/O thread pushes received chunks and signals data_ready, the device drains them with
+// read_all. write queues the data and the I/O thread writes it.
+//
+// Exactly one thread (the one of the device) may call read_all and write. The I/O thread is started by the first call to
+// connect or connect_async.
 class BaseConnector : public QObject {
     Q_OBJECT
 public:
-    BaseConnector(const std::string &type = "") noexcept : m_type{type} {};
-    virtual ~BaseConnector() = default;
+    enum class ConnectionState : uint8_t {
+        Disconnected,     // not connected and not trying to connect
+        Connecting,       // a connection attempt is running
+        Connected,        // connection established
+        WaitingForRetry,  // the last attempt failed or the connection was lost, the next attempt is scheduled
+    };
+    Q_ENUM(ConnectionState)
+
+    BaseConnector(const std::string &type = "") noexcept;
+    virtual ~BaseConnector();
 
     BaseConnector(const BaseConnector &) = delete;
     BaseConnector &operator=(const BaseConnector &) = delete;
 
     virtual void init(std::shared_ptr<config::Segment> settings){};
 
-    // Try to establish a connection. Returns true on success and false otherwise.
-    virtual bool connect() = 0;
-    virtual void disconnect() = 0;
+    // Try to establish a connection. Returns true on success and false otherwise. Blocks until the I/O thread finished the
+    // attempt.
+    bool connect();
+    void disconnect();
     bool is_connected() noexcept { return m_connected; }
 
-    // Writes the given data to the connection, discarding it silently when the connection has not been established yet.
-    virtual void write(const QByteArray &data) = 0;
+    // Try to establish a connection without blocking. The outcome is reported via connection_state_changed. Failed
+    // attempts and lost connections are retried with exponential backoff until disconnect is called.
+    void connect_async();
+
+    ConnectionState get_state() const noexcept { return m_state; }
+
+    // Queues the given data to be written by the I/O thread, which discards it silently when the connection has not been
+    // established yet.
+    void write(const QByteArray &data);
+
+    // Calls func(data) for every chunk of data received since the last call, to be called when data_ready was emitted
+    void read_all(const std::function<void(const QByteArray &)> &func);
 
     // Returns general information about the connector, i.e. connection status, all settings, etc.
     virtual std::string info() = 0;
@@ -32,15 +66,90 @@ public:
     // Move the underlying connection to the given thread (if applicable)
     virtual void move_to_thread(QThread * /*thread*/){};
 
+    // Connectors whose connection is used directly by another thread (e.g. the socket the S7 hands to libnodave) can opt out
+    // of the I/O thread. They then live in the thread that created them until they are moved. Call it before connecting.
+    void set_io_thread_enabled(bool enabled) { m_io_thread_enabled = enabled; }
+
 signals:
-    // This signal gets emitted when data has been successfully received by the connector
-    void data_received(QByteArray data);
+    // This signal gets emitted when received data is waiting to be read with read_all. It is not emitted again until
+    // read_all was called.
+    void data_ready();
+
+    // This signal gets emitted whenever the connection state changes
+    void connection_state_changed(BaseConnector::ConnectionState state);
 
 protected:
-    bool m_connected = false;
+    // The connection specific implementations of connect, disconnect and write, called in the I/O thread
+    virtual bool open_connection() = 0;
+    virtual void close_connection() = 0;
+    virtual void write_data(const QByteArray &data) = 0;
+
+    // Starts a single connection attempt for connect_async. It must not block; the outcome is reported by calling
+    // connection_established or connection_failed.
+    virtual void start_connect() = 0;
+
+    // To be called by derived classes when a connection was established
+    void connection_established();
+
+    // To be called by derived classes when a connection attempt failed or an established connection was lost. If
+    // connect_async was used, the next attempt is scheduled.
+    void connection_failed(const std::string &reason);
+
+    // To be called by derived classes in close_connection, stops all further connection attempts
+    void connection_closed();
+
+    // To be called by derived classes with data received from the connection. Returns false if the data was dropped
+    // because the device does not keep up.
+    bool data_received(QByteArray data);
+
+    // Starts recording all frames into the capture file given by "capture" (with the size in MB given by "capturesize"),
+    // if any. To be called by derived classes in init, before connecting.
+    void init_capture(const config::Segment &settings);
+
+    // Closes the connection and stops the I/O thread, the connector is moved back to the calling thread. Derived classes
+    // call it in their destructor, while their connection still exists.
+    void stop_io_thread();
+
+    std::atomic<bool> m_connected{false};
 
     // Describes the type of the connector, for example "serial" for a connector that transfers data via a serial
     // connection and "ethernet" for a connector transferring data via ethernet. This is needed to allow devices to
     // implement different protocols for different types of connectors.
     std::string m_type;
+
+private:
+    void set_state(ConnectionState state);
+
+    void start_io_thread();
+
+    // Runs func in the I/O thread and waits for it to finish, or runs it right away if the connector has no running thread
+    // (or it is called from the I/O thread)
+    void run_in_io_thread(const std::function<void()> &func);
+
+    // Writes the queued data, runs in the I/O thread
+    void flush();
+
+    std::atomic<ConnectionState> m_state{ConnectionState::Disconnected};
+
+    // True after connect_async was called until disconnect is called
+    bool m_reconnect = false;
+
+    // Delay until the next connection attempt, doubled after every failed attempt
+    int m_retry_delay = CONNECT_RETRY_MIN_DELAY;
+    QTimer m_retry_timer{this};
+
+    bool m_io_thread_enabled = true;
+    QThread m_io_thread;
+
+    // Received data, pushed by the I/O thread and popped by read_all
+    util::SPSCQueue<QByteArray> m_inbound{CONNECTOR_QUEUE_SIZE};
+    // Data to be written, pushed by write and popped by flush
+    util::SPSCQueue<QByteArray> m_outbound{CONNECTOR_QUEUE_SIZE};
+
+    // Set while a data_ready signal (or a flush) is pending, so a burst of chunks is handled with a single one
+    std::atomic<bool> m_data_ready_pending{false};
+    std::atomic<bool> m_flush_pending{false};
+
+    // Records the frames passing the I/O thread, if a capture was configured
+    std::unique_ptr<capture::CaptureFile> m_capture;
 };
@@ -0,0 +1,162 @@
+#include "capture.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace capture {
+    namespace {
+        constexpr char MAGIC[8] = "WTCAP1";
+        constexpr uint32_t VERSION = 1;
+
+        struct RecordHeader {
+            uint32_t size;
+            uint8_t direction;
+            uint8_t reserved[3];
+            int64_t time;
+        };
+        static_assert(sizeof(RecordHeader) == 16, "a record header takes 16 bytes");
+
+        // Marks the end of the records before the ring continues at its start
+        constexpr uint8_t WRAP = 0xFF;
+
+        constexpr uint64_t padded(uint64_t size) { return (size + 7) & ~uint64_t{7}; }
+        constexpr uint64_t record_size(uint64_t size) { return padded(sizeof(RecordHeader) + size); }
+
+        // The offsets in the header are 32 bits
+        constexpr uint64_t MAX_CAPACITY = uint64_t{UINT32_MAX} & ~uint64_t{7};
+    }  // namespace
+
+    bool CaptureRing::create(uint8_t *data, size_t size, std::string_view type, int64_t start_time) {
+        if (!data || size < HEADER_SIZE + record_size(0)) {
+            return false;
+        }
+
+        m_data = data;
+        m_ring = data + HEADER_SIZE;
+
+        m_header = {};
+        std::memcpy(m_header.magic, MAGIC, sizeof(MAGIC));
+        m_header.version = VERSION;
+        std::memcpy(m_header.type, type.data(), std::min(type.size(), sizeof(m_header.type)));
+        m_header.start_time = start_time;
+        // Records start at multiples of 8
+        m_header.capacity = static_cast<uint32_t>(std::min<uint64_t>(size - HEADER_SIZE, MAX_CAPACITY) & ~uint64_t{7});
+
+        write_header();
+        return true;
+    }
+
+    bool CaptureRing::open(uint8_t *data, size_t size) {
+        if (!data || size < HEADER_SIZE) {
+            return false;
+        }
+
+        Header header;
+        std::memcpy(&header, data, sizeof(header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION
+            || header.capacity < record_size(0) || header.capacity > size - HEADER_SIZE || header.head > header.capacity
+            || header.tail >= header.capacity) {
+            return false;
+        }
+
+        m_data = data;
+        m_ring = data + HEADER_SIZE;
+        m_header = header;
+        return true;
+    }
+
+    bool CaptureRing::append(Direction direction, int64_t time, const char *data, size_t size) {
+        if (!m_data || record_size(size) > m_header.capacity) {
+            return false;
+        }
+        const auto length = static_cast<uint32_t>(record_size(size));
+
+        if (uint64_t{m_header.head} + length > m_header.capacity) {
+            // The frame does not fit before the end, the rest of the ring is skipped
+            evict(m_header.head, m_header.capacity);
+            if (m_header.capacity - m_header.head >= sizeof(RecordHeader)) {
+                const RecordHeader wrap{0, WRAP, {}, 0};
+                std::memcpy(m_ring + m_header.head, &wrap, sizeof(wrap));
+            }
+            m_header.head = 0;
+        }
+
+        evict(m_header.head, m_header.head + length);
+        if (m_header.count == 0) {
+            m_header.tail = m_header.head;
+        }
+        // The records that are about to be overwritten are gone, even if we do not get to finish the new one
+        write_header();
+
+        const RecordHeader record{static_cast<uint32_t>(size), static_cast<uint8_t>(direction), {}, time};
+        std::memcpy(m_ring + m_header.head, &record, sizeof(record));
+        std::memcpy(m_ring + m_header.head + sizeof(record), data, size);
+
+        m_header.head += length;
+        m_header.count++;
+        m_header.total++;
+        write_header();
+
+        return true;
+    }
+
+    std::string CaptureRing::get_type() const {
+        return std::string(m_header.type, strnlen(m_header.type, sizeof(m_header.type)));
+    }
+
+    uint32_t CaptureRing::record_start(uint32_t offset) const {
+        if (uint64_t{offset} + sizeof(RecordHeader) > m_header.capacity) {
+            return 0;
+        }
+
+        RecordHeader record;
+        std::memcpy(&record, m_ring + offset, sizeof(record));
+        return record.direction == WRAP ? 0 : offset;
+    }
+
+    bool CaptureRing::read(uint32_t &offset, Frame &frame) const {
+        offset = record_start(offset);
+
+        RecordHeader record;
+        std::memcpy(&record, m_ring + offset, sizeof(record));
+        if (offset + record_size(record.size) > m_header.capacity
+            || record.direction > static_cast<uint8_t>(Direction::Outbound)) {
+            return false;
+        }
+
+        frame.direction = static_cast<Direction>(record.direction);
+        frame.time = record.time;
+        frame.data = std::string_view(reinterpret_cast<const char *>(m_ring + offset + sizeof(record)), record.size);
+
+        offset += static_cast<uint32_t>(record_size(record.size));
+        return true;
+    }
+
+    void CaptureRing::evict(uint32_t from, uint32_t to) {
+        while (m_header.count > 0 && m_header.tail >= from && m_header.tail < to) {
+            RecordHeader record;
+            std::memcpy(&record, m_ring + m_header.tail, sizeof(record));
+
+            m_header.tail = record_start(m_header.tail + static_cast<uint32_t>(record_size(record.size)));
+            m_header.count--;
+        }
+    }
+
+    void CaptureRing::write_header() { std::memcpy(m_data, &m_header, sizeof(m_header)); }
+
+    bool CaptureReader::open(const std::string &path) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) {
+            return false;
+        }
+
+        m_data.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        if (!file.read(reinterpret_cast<char *>(m_data.data()), static_cast<std::streamsize>(m_data.size()))) {
+            return false;
+        }
+
+        return m_ring.open(m_data.data(), m_data.size());
+    }
+}  // namespace capture
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A capture records the frames a connector sent and received with the time they passed, so protocol problems can be looked
+// at (and replayed, see ReplayConnector) after the fact. Captures are fixed size ring files: a header of 64 bytes with the
+// magic "WTCAP1", the version, the type of the connector, the start time in us since the epoch and the state of the ring,
+// followed by the ring of records. Each record starts at a multiple of 8 with a header of 16 bytes (size, direction and
+// time in ns since the start, taken from the steady clock) and holds one frame. Once the ring is full the oldest records are
+// overwritten.
+namespace capture {
+    enum class Direction : uint8_t { Inbound = 0, Outbound = 1 };
+
+    struct Frame {
+        Direction direction = Direction::Inbound;
+        // ns since the start of the capture
+        int64_t time = 0;
+        std::string_view data;
+    };
+
+    // CaptureRing reads and writes a capture in memory it does not own, e.g. a mapped file. It is not thread safe.
+    class CaptureRing {
+    public:
+        static constexpr size_t HEADER_SIZE = 64;
+
+        // Formats an empty capture into size bytes at data, the header included. Captures hold up to 4 GB.
+        bool create(uint8_t *data, size_t size, std::string_view type, int64_t start_time);
+        // Uses the capture at data, returns false if it is not a valid capture of size bytes
+        bool open(uint8_t *data, size_t size);
+
+        // Appends a frame, overwriting the oldest ones if the ring is full. Returns false if the frame does not fit into
+        // the ring at all.
+        bool append(Direction direction, int64_t time, const char *data, size_t size);
+
+        // Calls func(frame) for every frame, the oldest first. The frames point into the capture.
+        template <typename F>
+        void for_each(F &&func) const {
+            uint32_t offset = m_header.tail;
+            Frame frame;
+            for (uint64_t i = 0; i < m_header.count && read(offset, frame); i++) {
+                func(frame);
+            }
+        }
+
+        std::string get_type() const;
+        int64_t get_start_time() const { return m_header.start_time; }
+        uint64_t get_count() const { return m_header.count; }
+        // Number of frames appended since the capture was created, including the overwritten ones
+        uint64_t get_total() const { return m_header.total; }
+
+    private:
+        struct Header {
+            char magic[8];
+            uint32_t version;
+            char type[12];
+            int64_t start_time;
+            // Size of the ring, offset of the next record and of the oldest one
+            uint32_t capacity;
+            uint32_t head;
+            uint32_t tail;
+            uint32_t reserved;
+            uint64_t count;
+            uint64_t total;
+        };
+        static_assert(sizeof(Header) == HEADER_SIZE, "the header of a capture takes 64 bytes");
+
+        // Offset of the record at offset, 0 if the ring continues at its start from there
+        uint32_t record_start(uint32_t offset) const;
+        // Reads the record at offset and moves offset to the next one, returns false if it is corrupted
+        bool read(uint32_t &offset, Frame &frame) const;
+        // Drops the oldest records while they start in [from, to)
+        void evict(uint32_t from, uint32_t to);
+
+        void write_header();
+
+        uint8_t *m_data = nullptr;
+        uint8_t *m_ring = nullptr;
+        Header m_header{};
+    };
+
+    // Loads a capture file into memory, e.g. to replay it
+    class CaptureReader {
+    public:
+        bool open(const std::string &path);
+
+        const CaptureRing &get_ring() const { return m_ring; }
+
+    private:
+        std::vector<uint8_t> m_data;
+        CaptureRing m_ring;
+    };
+}  // namespace capture
@@ -0,0 +1,39 @@
+#include "capture_file.h"
+
+#include "logging/logging.h"
+
+namespace capture {
+    bool CaptureFile::open(const std::string &path, uint64_t size, std::string_view type) {
+        close();
+
+        m_file.setFileName(QString::fromStdString(path));
+
+        if (!m_file.open(QIODevice::ReadWrite | QIODevice::Truncate) || !m_file.resize(static_cast<qint64>(size))
+            || !(m_map = m_file.map(0, static_cast<qint64>(size)))) {
+            logging::main_log()->error("CaptureFile: unable to create the capture '{0}' of {1} bytes: {2}", path, size,
+                                       m_file.errorString().toStdString());
+            m_file.close();
+            return false;
+        }
+
+        const auto start_time = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch());
+        m_start = Clock::now();
+
+        if (!m_ring.create(m_map, static_cast<size_t>(size), type, start_time.count())) {
+            logging::main_log()->error("CaptureFile: capture '{0}' is too small", path);
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void CaptureFile::close() {
+        if (m_map) {
+            m_file.unmap(m_map);
+            m_map = nullptr;
+        }
+        m_file.close();
+    }
+}  // namespace capture
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <string_view>
+
+#include <QByteArray>
+#include <QFile>
+
+#include "capture.h"
+
+namespace capture {
+    // CaptureFile records frames into a capture file (see CaptureRing). The file is created with its full size and mapped
+    // into memory, so recording a frame is a copy into the mapping. Not thread safe, BaseConnector records from its I/O
+    // thread only.
+    class CaptureFile {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        CaptureFile() = default;
+        CaptureFile(const CaptureFile &) = delete;
+        CaptureFile &operator=(const CaptureFile &) = delete;
+        ~CaptureFile() { close(); }
+
+        // Creates the capture file with size bytes, overwriting an existing one
+        bool open(const std::string &path, uint64_t size, std::string_view type);
+        void close();
+
+        bool is_open() const { return m_map != nullptr; }
+
+        void record(Direction direction, const QByteArray &data) {
+            if (m_map) {
+                const auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_start).count();
+                m_ring.append(direction, time, data.constData(), static_cast<size_t>(data.size()));
+            }
+        }
+
+    private:
+        QFile m_file;
+        uchar *m_map = nullptr;
+        CaptureRing m_ring;
+        Clock::time_point m_start;
+    };
+}  // namespace capture
@@ -2,6 +2,8 @@
 
 #include "serial_connector.h"
 #include "ethernet_connector.h"
+#include "loopback_connector.h"
+#include "replay_connector.h"
 
 #include "app_config.h"
 
@@ -10,9 +12,13 @@ inline std::unique_ptr<BaseConnector> make_connector(std::string_view type) {
         return std::make_unique<SerialConnector>();
     } else if (type == "ethernet"sv) {
         return std::make_unique<EthernetConnector>();
+    } else if (type == "loopback"sv) {
+        return std::make_unique<LoopbackConnector>();
+    } else if (type == "replay"sv) {
+        return std::make_unique<ReplayConnector>();
     }
 
-    logging::get_log("main")->warn("make_connector: unknown type '{0}'", type);
+    logging::main_log()->warn("make_connector: unknown type '{0}'", type);
 
     return nullptr;
 }
\ No newline at end of file
@@ -2,16 +2,28 @@
 
 EthernetConnector::EthernetConnector() noexcept : BaseConnector("ethernet") {
     QObject::connect(&m_socket, &QTcpSocket::readyRead, this, &EthernetConnector::handle_ready_read);
+    QObject::connect(&m_socket, &QTcpSocket::connected, this, &EthernetConnector::handle_connected);
+    QObject::connect(&m_socket, &QTcpSocket::disconnected, this, &EthernetConnector::handle_disconnected);
+    QObject::connect(&m_socket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::error), this,
+                     &EthernetConnector::handle_error);
+
+    m_connect_timer.setSingleShot(true);
+    QObject::connect(&m_connect_timer, &QTimer::timeout, this, [this]() {
+        connection_failed(fmt::format("no connection to {0}:{1} within {2}ms", m_ip_address, m_port, m_max_connect_wait));
+        m_socket.abort();
+    });
 }
 
-EthernetConnector::~EthernetConnector() { disconnect(); }
+EthernetConnector::~EthernetConnector() { stop_io_thread(); }
 
 void EthernetConnector::init(std::shared_ptr<config::Segment> settings) noexcept {
     if (!settings) {
-        logging::get_log("main")->error("EthernetConnector: init called with nullptr");
+        logging::main_log()->error("EthernetConnector: init called with nullptr");
         return;
     }
 
+    init_capture(*settings);
+
     if (auto address = settings->get<std::string>("address")) {
         m_ip_address = *address;
     }
@@ -25,29 +37,37 @@ void EthernetConnector::init(std::shared_ptr<config::Segment> settings) noexcept
     }
 }
 
-bool EthernetConnector::connect() {
+bool EthernetConnector::open_connection() {
     m_socket.connectToHost(QString::fromStdString(m_ip_address), m_port);
 
     if (!m_socket.waitForConnected(m_max_connect_wait)) {
-        logging::get_log("main")->error("EthernetConnector: connection error: {0}", m_socket.errorString().toStdString());
+        logging::main_log()->error("EthernetConnector: connection error: {0}", m_socket.errorString().toStdString());
 
-        m_connected = false;
+        connection_closed();
         return false;
     }
 
-    m_connected = true;
+    connection_established();
     return true;
 }
 
-void EthernetConnector::disconnect() {
-    m_connected = false;
+void EthernetConnector::close_connection() {
+    // Update the state first, so closing the socket is not taken for a lost connection
+    connection_closed();
+    m_connect_timer.stop();
 
     m_socket.close();
 }
 
-void EthernetConnector::write(const QByteArray &data) {
-    if (data.length() == 0) return;
+void EthernetConnector::start_connect() {
+    // Reset the socket in case a previous attempt is still pending
+    m_socket.abort();
 
+    m_connect_timer.start(m_max_connect_wait);
+    m_socket.connectToHost(QString::fromStdString(m_ip_address), m_port);
+}
+
+void EthernetConnector::write_data(const QByteArray &data) {
     if (!is_connected()) return;
 
     // TODO: handle the return value
@@ -63,8 +83,31 @@ void EthernetConnector::move_to_thread(QThread *thread) { m_socket.moveToThread(
 
 int EthernetConnector::get_descriptor() { return static_cast<int>(m_socket.socketDescriptor()); }
 
-void EthernetConnector::handle_ready_read() {
-    QByteArray data = m_socket.readAll();
+void EthernetConnector::handle_connected() {
+    m_connect_timer.stop();
 
-    emit data_received(data);
+    connection_established();
+}
+
+void EthernetConnector::handle_disconnected() {
+    if (get_state() == ConnectionState::Connected) {
+        connection_failed("connection lost");
+    }
+}
+
+void EthernetConnector::handle_error(QAbstractSocket::SocketError /*error*/) {
+    // Errors are only of interest while connecting or connected, closing the socket ourselves reports one as well
+    if (get_state() != ConnectionState::Connecting && get_state() != ConnectionState::Connected) {
+        return;
+    }
+
+    m_connect_timer.stop();
+
+    // Update the state before aborting, so the disconnected signal emitted by abort is ignored
+    connection_failed(m_socket.errorString().toStdString());
+    m_socket.abort();
+}
+
+void EthernetConnector::handle_ready_read() {
+    data_received(m_socket.readAll());
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "base_connector.h"
 
 #include <QTcpSocket>
+#include <QTimer>
 
 class EthernetConnector : public BaseConnector {
     Q_OBJECT
@@ -16,13 +17,6 @@ public:
 
     void init(std::shared_ptr<config::Segment> settings) noexcept override;
 
-    // Try to establish a connection. Returns true on success and false otherwise.
-    bool connect() override;
-    void disconnect() override;
-
-    // Writes the given data to the connection, discarding it silently when the connection has not been established yet.
-    void write(const QByteArray &data) override;
-
     // Returns general information about the connector, i.e. connection status, all settings, etc.
     std::string info() override;
 
@@ -32,12 +26,24 @@ public:
     // Returns the descriptor of the underlying socket.
     int get_descriptor();
 
+protected:
+    bool open_connection() override;
+    void close_connection() override;
+    void write_data(const QByteArray &data) override;
+    void start_connect() override;
+
 private:
     void handle_ready_read();
+    void handle_connected();
+    void handle_disconnected();
+    void handle_error(QAbstractSocket::SocketError error);
 
     std::string m_ip_address;
     int m_port = 0;
     int m_max_connect_wait = MAX_ETHERNET_CONNECT_WAIT;
 
     QTcpSocket m_socket;
+
+    // Aborts asynchronous connection attempts after m_max_connect_wait
+    QTimer m_connect_timer{this};
 };
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include "loopback_connector.h"
+
+#include "logging/logging.h"
+
+LoopbackConnector::LoopbackConnector() noexcept : BaseConnector("loopback") {
+    m_delivery_timer.setSingleShot(true);
+    m_delivery_timer.setTimerType(Qt::PreciseTimer);
+    QObject::connect(&m_delivery_timer, &QTimer::timeout, this, &LoopbackConnector::deliver);
+}
+
+LoopbackConnector::~LoopbackConnector() { stop_io_thread(); }
+
+void LoopbackConnector::init(std::shared_ptr<config::Segment> settings) {
+    if (!settings) {
+        logging::main_log()->error("LoopbackConnector: init called with nullptr");
+        return;
+    }
+
+    init_capture(*settings);
+
+    auto type = settings->get<std::string>("simulator");
+    if (!type) {
+        logging::main_log()->error("LoopbackConnector: no simulator given");
+        return;
+    }
+
+    auto simulator = simulation::make_simulator(*type);
+    if (!simulator) {
+        logging::main_log()->error("LoopbackConnector: unknown simulator '{0}'", *type);
+        return;
+    }
+
+    m_simulator_type = *type;
+    set_simulator(std::move(simulator), simulation::LinkSettings::from(*settings));
+}
+
+void LoopbackConnector::set_simulator(std::unique_ptr<simulation::Simulator> simulator, const simulation::LinkSettings &link) {
+    m_simulator = std::move(simulator);
+    m_link = simulation::Link(link);
+
+    if (m_simulator) {
+        m_simulator->set_nack_rate(link.nack_rate, link.seed);
+    }
+}
+
+std::string LoopbackConnector::info() {
+    const auto &link = m_link.get_settings();
+
+    return fmt::format("LoopbackConnector:\n\tsimulator: '{0}'\n\tlatency: {1}us\n\tjitter: {2}us\n\tcorruption rate: {3}"
+                       "\n\tnack rate: {4}\n\tseed: {5}",
+                       m_simulator_type, link.latency.count(), link.jitter.count(), link.corruption_rate, link.nack_rate,
+                       link.seed);
+}
+
+bool LoopbackConnector::open_connection() {
+    if (!m_simulator) {
+        logging::main_log()->error("LoopbackConnector: unable to connect without a simulator");
+
+        connection_closed();
+        return false;
+    }
+
+    m_simulator->reset();
+    connection_established();
+    return true;
+}
+
+void LoopbackConnector::close_connection() {
+    connection_closed();
+
+    m_link.clear();
+    m_delivery_timer.stop();
+}
+
+void LoopbackConnector::start_connect() {
+    if (!m_simulator) {
+        connection_failed("no simulator");
+        return;
+    }
+
+    m_simulator->reset();
+    connection_established();
+}
+
+void LoopbackConnector::write_data(const QByteArray &data) {
+    if (!is_connected()) return;
+
+    const auto now = simulation::Link::Clock::now();
+    m_link.send(m_simulator->receive(std::string_view(data.constData(), data.size())), now);
+
+    if (!m_delivery_timer.isActive()) {
+        deliver();
+    }
+}
+
+void LoopbackConnector::deliver() {
+    m_link.deliver(simulation::Link::Clock::now(),
+                   [this](const std::string &reply) { data_received(QByteArray::fromStdString(reply)); });
+
+    auto interval = m_link.timer_interval(simulation::Link::Clock::now());
+    if (interval) {
+        m_delivery_timer.start(*interval);
+    }
+}
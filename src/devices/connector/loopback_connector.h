@@ -0,0 +1,47 @@
+#pragma once
+
+#include "base_connector.h"
+
+#include "devices/simulation/simulator.h"
+
+#include <QTimer>
+
+// LoopbackConnector connects a device to a simulator (see simulation::Simulator) in the same process instead of hardware.
+// Replies travel over a simulated link with configurable latency, jitter and corruption, so the drivers can be measured and
+// tested without the hardware and with reproducible faults.
+class LoopbackConnector : public BaseConnector {
+    Q_OBJECT
+public:
+    LoopbackConnector() noexcept;
+    ~LoopbackConnector();
+
+    LoopbackConnector(const LoopbackConnector &) = delete;
+    LoopbackConnector &operator=(const LoopbackConnector &) = delete;
+
+    // Creates the simulator given by "simulator" (see simulation::make_simulator) and reads the link settings (see
+    // simulation::LinkSettings)
+    void init(std::shared_ptr<config::Segment> settings) override;
+
+    // Uses the given simulator, e.g. in benchmarks. Call it before connecting.
+    void set_simulator(std::unique_ptr<simulation::Simulator> simulator, const simulation::LinkSettings &link = {});
+
+    // Returns general information about the connector, i.e. connection status, all settings, etc.
+    std::string info() override;
+
+protected:
+    bool open_connection() override;
+    void close_connection() override;
+    void write_data(const QByteArray &data) override;
+    void start_connect() override;
+
+private:
+    // Hands the replies that arrived to the device and restarts the timer for the next one
+    void deliver();
+
+    std::string m_simulator_type;
+    std::unique_ptr<simulation::Simulator> m_simulator;
+    simulation::Link m_link;
+
+    // Fires when the next reply arrives
+    QTimer m_delivery_timer{this};
+};
@@ -0,0 +1,147 @@
+#include "replay_connector.h"
+
+#include "capture.h"
+#include "logging/logging.h"
+
+#include <algorithm>
+
+namespace {
+    // Frames handed to the device at once when replaying as fast as possible, so the receive queue does not overflow
+    constexpr size_t BATCH_SIZE = CONNECTOR_QUEUE_SIZE / 2;
+}  // namespace
+
+ReplayConnector::ReplayConnector() noexcept : BaseConnector("replay") {
+    m_delivery_timer.setSingleShot(true);
+    m_delivery_timer.setTimerType(Qt::PreciseTimer);
+    QObject::connect(&m_delivery_timer, &QTimer::timeout, this, &ReplayConnector::deliver);
+}
+
+ReplayConnector::~ReplayConnector() { stop_io_thread(); }
+
+void ReplayConnector::init(std::shared_ptr<config::Segment> settings) {
+    if (!settings) {
+        logging::main_log()->error("ReplayConnector: init called with nullptr");
+        return;
+    }
+
+    if (auto speed = settings->get<double>("speed")) {
+        if (*speed < 0) {
+            logging::main_log()->warn("ReplayConnector: ignoring invalid speed {0}", *speed);
+        } else {
+            m_speed = *speed;
+        }
+    }
+
+    if (auto file = settings->get<std::string>("file")) {
+        load(*file);
+    }
+}
+
+bool ReplayConnector::load(const std::string &path) {
+    capture::CaptureReader reader;
+    if (!reader.open(path)) {
+        logging::main_log()->error("ReplayConnector: '{0}' is not a valid capture", path);
+        return false;
+    }
+
+    m_file = path;
+    m_frames.clear();
+    m_times.clear();
+
+    reader.get_ring().for_each([this](const capture::Frame &frame) {
+        if (frame.direction == capture::Direction::Inbound) {
+            m_frames.push_back(QByteArray(frame.data.data(), static_cast<int>(frame.data.size())));
+            m_times.push_back(frame.time);
+        }
+    });
+
+    // The oldest frames of a full capture were overwritten, the replay starts with the first one that was kept
+    if (!m_times.empty()) {
+        const int64_t first = m_times.front();
+        for (auto &time : m_times) {
+            time -= first;
+        }
+    }
+
+    logging::main_log()->info("ReplayConnector: loaded {0} inbound frames of the {1} capture '{2}'", m_frames.size(),
+                              reader.get_ring().get_type(), path);
+    return true;
+}
+
+std::string ReplayConnector::info() {
+    return fmt::format("ReplayConnector:\n\tfile: '{0}'\n\tframes: {1}\n\tspeed: {2}", m_file, m_frames.size(), m_speed);
+}
+
+bool ReplayConnector::open_connection() {
+    if (m_frames.empty()) {
+        logging::main_log()->error("ReplayConnector: unable to connect without a capture");
+
+        connection_closed();
+        return false;
+    }
+
+    connection_established();
+    start_replay();
+    return true;
+}
+
+void ReplayConnector::close_connection() {
+    connection_closed();
+
+    m_delivery_timer.stop();
+}
+
+void ReplayConnector::start_connect() {
+    if (m_frames.empty()) {
+        connection_failed("no capture");
+        return;
+    }
+
+    connection_established();
+    start_replay();
+}
+
+void ReplayConnector::write_data(const QByteArray & /*data*/) {}
+
+void ReplayConnector::start_replay() {
+    m_replayed = 0;
+    m_replayed_bytes = 0;
+    m_started = Clock::now();
+
+    deliver();
+}
+
+void ReplayConnector::deliver() {
+    if (!is_connected()) {
+        return;
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_started).count();
+
+    const size_t end = std::min(m_frames.size(), m_replayed + BATCH_SIZE);
+    while (m_replayed < end && (m_speed == 0 || m_times[m_replayed] <= elapsed * m_speed)) {
+        if (!data_received(m_frames[m_replayed])) {
+            // The device does not keep up, try again once it had time to read
+            m_delivery_timer.start(1);
+            return;
+        }
+
+        m_replayed_bytes += static_cast<size_t>(m_frames[m_replayed].size());
+        m_replayed++;
+    }
+
+    if (m_replayed == m_frames.size()) {
+        emit replay_finished();
+        return;
+    }
+
+    if (m_speed == 0) {
+        // Let the event loop run between the batches
+        m_delivery_timer.start(0);
+        return;
+    }
+
+    const auto due = std::chrono::nanoseconds(static_cast<int64_t>(m_times[m_replayed] / m_speed));
+    const auto delay = std::chrono::ceil<std::chrono::milliseconds>(m_started + due - Clock::now());
+    m_delivery_timer.start(std::max(0, static_cast<int>(delay.count())));
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "base_connector.h"
+
+#include <chrono>
+#include <vector>
+
+#include <QTimer>
+
+// ReplayConnector feeds the frames a device received in a capture (see capture::CaptureRing) back to the device, at the
+// pace they were captured or as fast as the device takes them. Outgoing data is discarded. Use it to reproduce problems seen
+// with the hardware and to measure the parsers on real traffic (see run_replay).
+class ReplayConnector : public BaseConnector {
+    Q_OBJECT
+public:
+    using Clock = std::chrono::steady_clock;
+
+    ReplayConnector() noexcept;
+    ~ReplayConnector();
+
+    ReplayConnector(const ReplayConnector &) = delete;
+    ReplayConnector &operator=(const ReplayConnector &) = delete;
+
+    // Loads the capture given by "file" and reads "speed", a factor applied to the pace of the capture (1 replays the frames
+    // as they were captured, 0 as fast as possible)
+    void init(std::shared_ptr<config::Segment> settings) override;
+
+    // Loads the inbound frames of the capture at path, returns false if it is not a valid capture. Call it before connecting.
+    bool load(const std::string &path);
+    void set_speed(double speed) { m_speed = speed; }
+
+    // Number of frames and bytes handed to the device since the last connect
+    size_t get_replayed() const { return m_replayed; }
+    size_t get_replayed_bytes() const { return m_replayed_bytes; }
+    size_t get_frame_count() const { return m_frames.size(); }
+
+    // Returns general information about the connector, i.e. connection status, all settings, etc.
+    std::string info() override;
+
+signals:
+    // Emitted (by the I/O thread) when all frames were handed to the device
+    void replay_finished();
+
+protected:
+    bool open_connection() override;
+    void close_connection() override;
+    void write_data(const QByteArray &data) override;
+    void start_connect() override;
+
+private:
+    // Starts the replay from the first frame
+    void start_replay();
+
+    // Hands the frames that are due to the device and restarts the timer for the next one
+    void deliver();
+
+    std::string m_file;
+    double m_speed = 1.0;
+
+    // The inbound frames of the capture and the time they were received in ns, relative to the first one
+    std::vector<QByteArray> m_frames;
+    std::vector<int64_t> m_times;
+
+    size_t m_replayed = 0;
+    size_t m_replayed_bytes = 0;
+    Clock::time_point m_started;
+
+    // Fires when the next frame is due
+    QTimer m_delivery_timer{this};
+};
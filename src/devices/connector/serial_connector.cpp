@@ -6,23 +6,26 @@
 
 SerialConnector::SerialConnector() noexcept : BaseConnector("serial") {
     QObject::connect(&m_serial_port, &QSerialPort::readyRead, this, &SerialConnector::handle_ready_read);
+    QObject::connect(&m_serial_port, &QSerialPort::errorOccurred, this, &SerialConnector::handle_error);
 }
 
-SerialConnector::~SerialConnector() { disconnect(); }
+SerialConnector::~SerialConnector() { stop_io_thread(); }
 
 void SerialConnector::init(std::shared_ptr<config::Segment> settings) {
     // Keep track if we were able to successfully change all settings (used in printing info about the connector)
     bool all_set = true;
 
     if (!settings) {
-        logging::get_log("main")->error("SerialConnector: init called with nullptr");
+        logging::main_log()->error("SerialConnector: init called with nullptr");
         all_set = false;
         return;
     }
 
+    init_capture(*settings);
+
     if (auto baudrate = settings->get<int>("baudrate")) {
         if (!m_serial_port.setBaudRate(*baudrate)) {
-            logging::get_log("main")->warn("SerialConnector: setBaudRate failed for value {0}", *baudrate);
+            logging::main_log()->warn("SerialConnector: setBaudRate failed for value {0}", *baudrate);
             all_set = false;
         } else {
             m_settings.baudrate = *baudrate;
@@ -31,7 +34,7 @@ void SerialConnector::init(std::shared_ptr<config::Segment> settings) {
 
     if (auto databits = settings->get<QSerialPort::DataBits>("databits")) {
         if (!m_serial_port.setDataBits(*databits)) {
-            logging::get_log("main")->warn("SerialConnector: setDataBits failed for value {0}", *databits);
+            logging::main_log()->warn("SerialConnector: setDataBits failed for value {0}", *databits);
             all_set = false;
         } else {
             m_settings.databits = *databits;
@@ -40,7 +43,7 @@ void SerialConnector::init(std::shared_ptr<config::Segment> settings) {
 
     if (auto parity = settings->get<QSerialPort::Parity>("parity")) {
         if (!m_serial_port.setParity(*parity)) {
-            logging::get_log("main")->warn("SerialConnector: setParity failed for value {0}", *parity);
+            logging::main_log()->warn("SerialConnector: setParity failed for value {0}", *parity);
             all_set = false;
         } else {
             m_settings.parity = *parity;
@@ -49,7 +52,7 @@ void SerialConnector::init(std::shared_ptr<config::Segment> settings) {
 
     if (auto stopbits = settings->get<QSerialPort::StopBits>("stopbits")) {
         if (!m_serial_port.setStopBits(*stopbits)) {
-            logging::get_log("main")->warn("SerialConnector: setStopBits failed for value {0}", *stopbits);
+            logging::main_log()->warn("SerialConnector: setStopBits failed for value {0}", *stopbits);
             all_set = false;
         } else {
             m_settings.stopbits = *stopbits;
@@ -58,7 +61,7 @@ void SerialConnector::init(std::shared_ptr<config::Segment> settings) {
 
     if (auto flowcontrol = settings->get<QSerialPort::FlowControl>("flowcontrol")) {
         if (!m_serial_port.setFlowControl(*flowcontrol)) {
-            logging::get_log("main")->warn("SerialConnector: setFlowControl failed for value {0}", *flowcontrol);
+            logging::main_log()->warn("SerialConnector: setFlowControl failed for value {0}", *flowcontrol);
             all_set = false;
         } else {
             m_settings.flowcontrol = *flowcontrol;
@@ -67,39 +70,49 @@ void SerialConnector::init(std::shared_ptr<config::Segment> settings) {
 
     if (auto portname = settings->get<std::string>("portname")) {
         m_serial_port.setPortName(QString::fromStdString(*portname));
-        all_set = false;
-    } else {
         m_settings.portname = *portname;
+    } else {
+        logging::main_log()->warn("SerialConnector: no portname given");
+        all_set = false;
     }
 
     m_settings.all_set = all_set;
 }
 
-bool SerialConnector::connect() {
+bool SerialConnector::open_connection() {
     if (!m_serial_port.open(QIODevice::ReadWrite)) {
         std::string error_string{""};
 
         if (m_serial_port.error() != QSerialPort::NoError) error_string = m_serial_port.errorString().toStdString();
 
-        logging::get_log("main")->error("SerialPort: QSerialPort::open failed with error '{0}'", error_string);
+        logging::main_log()->error("SerialPort: QSerialPort::open failed with error '{0}'", error_string);
 
-        m_connected = false;
+        connection_closed();
         return false;
     }
 
-    m_connected = true;
+    connection_established();
     return true;
 }
 
-void SerialConnector::disconnect() {
-    m_connected = false;
+void SerialConnector::close_connection() {
+    connection_closed();
 
     m_serial_port.close();
 }
 
-void SerialConnector::write(const QByteArray &data) {
-    if (data.length() == 0) return;
+void SerialConnector::start_connect() {
+    // Opening a serial port does not block, so the attempt finishes right away
+    if (!m_serial_port.open(QIODevice::ReadWrite)) {
+        connection_failed(fmt::format("opening '{0}' failed: {1}", m_serial_port.portName().toStdString(),
+                                      m_serial_port.errorString().toStdString()));
+        return;
+    }
 
+    connection_established();
+}
+
+void SerialConnector::write_data(const QByteArray &data) {
     if (!is_connected()) return;
 
     // TODO: handle the return value
@@ -126,8 +139,16 @@ std::string SerialConnector::info() {
 
 void SerialConnector::move_to_thread(QThread *thread) { m_serial_port.moveToThread(thread); }
 
-void SerialConnector::handle_ready_read() {
-    QByteArray data = m_serial_port.readAll();
+void SerialConnector::handle_error(QSerialPort::SerialPortError error) {
+    // A resource error means the port is gone, e.g. an USB adapter was unplugged
+    if (error != QSerialPort::ResourceError || get_state() != ConnectionState::Connected) {
+        return;
+    }
 
-    emit data_received(data);
+    connection_failed(m_serial_port.errorString().toStdString());
+    m_serial_port.close();
+}
+
+void SerialConnector::handle_ready_read() {
+    data_received(m_serial_port.readAll());
 }
\ No newline at end of file
@@ -18,21 +18,21 @@ public:
 
     void init(std::shared_ptr<config::Segment> settings) override;
 
-    // Try to establish a connection. Returns true on success and false otherwise.
-    bool connect() override;
-    void disconnect() override;
-
-    // Writes the given data to the connection, discarding it silently when the connection has not been established yet.
-    void write(const QByteArray &data) override;
-
     // Returns general information about the connector, i.e. connection status, all settings, etc.
     std::string info() override;
 
     // Move the underlying connection to the given thread.
     void move_to_thread(QThread *thread) override;
 
+protected:
+    bool open_connection() override;
+    void close_connection() override;
+    void write_data(const QByteArray &data) override;
+    void start_connect() override;
+
 private:
     void handle_ready_read();
+    void handle_error(QSerialPort::SerialPortError error);
 
     // This struct saves all settings so we can print them in debug messages. The default values were chosen
     // arbitrarily, so we track a successful setting of all settings with all_set. If it is false, at least one value
@@ -1,20 +1,23 @@
 #include "device.h"
 
-Device::Device() noexcept : m_id{get_id()} {};
+Device::Device() noexcept : m_id{next_id()} {};
 
-Device::Device(std::unique_ptr<BaseConnector> &&connector) : m_connector{std::move(connector)}, m_id{get_id()} {};
+Device::Device(std::unique_ptr<BaseConnector> &&connector) : m_connector{std::move(connector)}, m_id{next_id()} {
+    connect_connector_signals();
+};
 
 void Device::set_connector(std::unique_ptr<BaseConnector> &&connector) {
     if (m_connector != nullptr) {
-        logging::get_log("main")->warn("Device: overwriting connector {0}", m_connector->info());
+        logging::main_log()->warn("Device: overwriting connector {0}", m_connector->info());
     }
 
     m_connector = std::move(connector);
+    connect_connector_signals();
 }
 
 bool Device::is_connected() {
     if (!m_connector) {
-        logging::get_log("main")->error("Device: is_connected was called but not connector was set up");
+        logging::main_log()->error("Device: is_connected was called but not connector was set up");
         return false;
     }
 
@@ -23,7 +26,7 @@ bool Device::is_connected() {
 
 bool Device::connect() {
     if (!m_connector) {
-        logging::get_log("main")->error("Device: connect was called but not connector was set up");
+        logging::main_log()->error("Device: connect was called but not connector was set up");
         return false;
     }
 
@@ -32,24 +35,74 @@ bool Device::connect() {
 
 void Device::disconnect() {
     if (!m_connector) {
-        logging::get_log("main")->error("Device: disconnect was called but not connector was set up");
+        logging::main_log()->error("Device: disconnect was called but not connector was set up");
         return;
     }
 
     m_connector->disconnect();
 }
 
+void Device::connect_async() {
+    if (!m_connector) {
+        logging::main_log()->error("Device: connect_async was called but not connector was set up");
+        return;
+    }
+
+    m_connector->connect_async();
+}
+
+BaseConnector::ConnectionState Device::get_connection_state() {
+    if (!m_connector) {
+        return BaseConnector::ConnectionState::Disconnected;
+    }
+
+    return m_connector->get_state();
+}
+
 void Device::send(const QByteArray &data) {
     if (!m_connector) {
-        logging::get_log("main")->error("Device: send was called but not connector was set up; data to be sent is {0} (hex)",
-                                        data.toHex().toStdString());
+        logging::main_log()->error("Device: send was called but not connector was set up; data to be sent is {0} (hex)",
+                                   logging::hex(data));
+        return;
+    }
+
+    if (!in_device_thread()) {
+        QMetaObject::invokeMethod(this, [this, data]() { send(data); }, Qt::QueuedConnection);
         return;
     }
 
     m_connector->write(data);
 }
 
-device_id Device::get_id() {
+void Device::handle_connection_state_changed(BaseConnector::ConnectionState state) {
+    switch (state) {
+    case BaseConnector::ConnectionState::Connected:
+        logging::main_log()->debug("Device #{0}: connected. Connector info:\n  {1}", m_id, m_connector->info());
+        handle_connected();
+        break;
+    case BaseConnector::ConnectionState::WaitingForRetry:
+        logging::main_log()->warn("Device #{0}: not connected. Connector info:\n  {1}", m_id, m_connector->info());
+        break;
+    default:
+        break;
+    }
+
+    emit connection_status_changed(m_id);
+}
+
+void Device::handle_data_ready() {
+    m_connector->read_all([this](const QByteArray &data) { handle_data_received(data); });
+}
+
+void Device::connect_connector_signals() {
+    if (m_connector) {
+        QObject::connect(m_connector.get(), &BaseConnector::connection_state_changed, this,
+                         &Device::handle_connection_state_changed);
+        QObject::connect(m_connector.get(), &BaseConnector::data_ready, this, &Device::handle_data_ready);
+    }
+}
+
+device_id Device::next_id() {
     static std::atomic<device_id> id{0};
     return ++id;
 }
\ No newline at end of file
@@ -20,9 +20,15 @@ public:
 
     virtual void set_connector(std::unique_ptr<BaseConnector> &&connector);
 
+    // Applies the settings and sets up the connector. It does not connect; that is left to the owner of the device (see
+    // Watchtower), so all devices can be connected at once.
     virtual void init(std::shared_ptr<config::Segment> settings){};
 
-    // This function is called periodically by the controller. Use it for example to update internal state machines.
+    device_id get_id() const { return m_id; }
+
+    // This function is called once per cycle by the controller (see Controller), in the thread the device lives in while the
+    // controller runs. Use it for example to update internal state machines. It has to return within the time budget of the
+    // device.
     virtual void update(){};
 
     // connection control
@@ -30,7 +36,15 @@ public:
     bool connect();
     void disconnect();
 
+    // Start connecting without blocking, see BaseConnector::connect_async. Changes of the connection state are reported via
+    // connection_status_changed.
+    void connect_async();
+    BaseConnector::ConnectionState get_connection_state();
+
     // connector control
+
+    // Writes data to the connector. It may be called from any thread, calls from other threads than the one of the device are
+    // queued to it, so the connector only ever has one writer.
     void send(const QByteArray &data);
 
     template <typename... Ts>
@@ -56,11 +70,31 @@ signals:
 protected:
     BaseConnector *get_connector() { return m_connector.get(); }
 
+    // True if called from the thread the device lives in. Public functions that touch state of the receive path (e.g. a
+    // TransactionEngine) are called by the user interface and the controller as well; they queue themselves to the thread
+    // of the device when this is false.
+    bool in_device_thread() const { return QThread::currentThread() == thread(); }
+
+    // Called whenever the connection to the device was (re)established, e.g. to query its current state
+    virtual void handle_connected(){};
+
+    // Called with every chunk of data received from the device. It runs in the thread of the device (the data is handed over
+    // by the I/O thread of the connector), so implementations don't need to guard their receive state.
+    virtual void handle_data_received(const QByteArray & /*data*/){};
+
     const device_id m_id;
 
     std::unique_ptr<BaseConnector> m_connector;
 
 private:
-    static device_id get_id();
+    void handle_connection_state_changed(BaseConnector::ConnectionState state);
+
+    // Reads the data queued by the connector and passes it on to handle_data_received
+    void handle_data_ready();
+
+    // Forward state changes of the connector to connection_status_changed and received data to handle_data_received
+    void connect_connector_signals();
+
+    static device_id next_id();
 };
 
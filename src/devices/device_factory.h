@@ -0,0 +1,22 @@
+#pragma once
+
+#include "cesar_generator.h"
+#include "hofi_switch.h"
+#include "kjl_generator.h"
+
+#include "app_config.h"
+
+// Creates a device of the type used in the device manifest (see Watchtower::load_devices), nullptr for unknown types
+inline std::unique_ptr<Device> make_device(std::string_view type) {
+    if (type == "cesar"sv) {
+        return std::make_unique<CesarGenerator>();
+    } else if (type == "kjl"sv) {
+        return std::make_unique<KJLGenerator>();
+    } else if (type == "hofi"sv) {
+        return std::make_unique<HofiSwitch>();
+    }
+
+    logging::main_log()->warn("make_device: unknown type '{0}'", type);
+
+    return nullptr;
+}
@@ -0,0 +1,85 @@
+#include "framer.h"
+
+namespace framing {
+    Frame CesarFramer::next(const util::RingBuffer &buffer) {
+        if (buffer.empty()) {
+            return {};
+        }
+
+        const uint8_t header = buffer[0];
+        if (header == ACK || header == NACK) {
+            return {FrameStatus::Valid, 1};
+        }
+
+        size_t length = header & 0b111;
+        const size_t offset = data_offset(header);
+        if (offset == 3) {
+            if (buffer.size() < 3) {
+                return {};
+            }
+
+            length = static_cast<uint8_t>(buffer[2]);
+        }
+
+        // +1 for the checksum byte
+        const size_t frame_length = offset + length + 1;
+        if (buffer.size() < frame_length) {
+            return {};
+        }
+
+        char checksum = 0;
+        for (size_t i = 0; i < frame_length; i++) {
+            checksum ^= buffer[i];
+        }
+
+        return {checksum == 0 ? FrameStatus::Valid : FrameStatus::Invalid, frame_length};
+    }
+
+    std::string CesarFramer::make_packet(int address, std::string_view command) {
+        std::string packet;
+        if (command.empty()) {
+            return packet;
+        }
+        packet.reserve(command.size() + 4);
+
+        const size_t length = command.size();
+        packet += static_cast<char>(((address << 3) & 0xF8) | (length > 6 ? 7 : length));
+        packet += command[0];
+        if (length > 6) {
+            packet += static_cast<char>(length);
+        }
+        packet += command.substr(1);
+        packet += '\0';
+
+        char checksum = 0;
+        for (char c : packet) {
+            checksum ^= c;
+        }
+        packet += checksum;
+
+        return packet;
+    }
+
+    Frame DelimitedFramer::next(const util::RingBuffer &buffer) {
+        for (; m_scanned < buffer.size(); m_scanned++) {
+            if (buffer[m_scanned] == m_delimiter && ++m_found == m_count) {
+                return {FrameStatus::Valid, m_scanned + 1};
+            }
+        }
+
+        return {};
+    }
+
+    void DelimitedFramer::reset() {
+        m_scanned = 0;
+        m_found = 0;
+    }
+
+    Frame FixedLengthFramer::next(const util::RingBuffer &buffer) const {
+        if (m_length == 0 || buffer.size() < m_length) {
+            return {};
+        }
+
+        return {FrameStatus::Valid, m_length};
+    }
+}  // namespace framing
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "util/ring_buffer.h"
+
+// Framers split the byte stream received from a device into packets. A framer only looks at the buffered data and reports
+// the length of the next packet; FrameReader does the buffering and hands out the packets as views into its ring buffer, so
+// no packet is ever copied (except for the rare one that wraps around the end of the buffer).
+namespace framing {
+    enum class FrameStatus : uint8_t {
+        Incomplete,  // more data is needed
+        Valid,
+        Invalid  // a complete packet that failed validation, e.g. a checksum mismatch
+    };
+
+    struct Frame {
+        FrameStatus status = FrameStatus::Incomplete;
+        size_t length = 0;
+    };
+
+    // Cesar packets: header byte with the address and the data length (the lower three bits, 7 means the length is sent in
+    // an extra byte after the command), command, data and an XOR checksum over all bytes. ACK and NACK are sent as single
+    // bytes.
+    class CesarFramer {
+    public:
+        Frame next(const util::RingBuffer &buffer);
+        void reset() {}
+
+        static constexpr uint8_t ACK = 0x6;
+        static constexpr uint8_t NACK = 0x15;
+
+        // Offset of the data in a packet with the given header byte
+        static size_t data_offset(uint8_t header) { return (header & 0b111) == 7 ? 3 : 2; }
+
+        // Builds the packet for command (the command byte followed by its data) to the device at address. The data length in
+        // the header counts the command byte, so a zero byte is sent before the checksum.
+        static std::string make_packet(int address, std::string_view command);
+    };
+
+    // Packets that end with the count-th occurrence of delimiter, e.g. the "<command><cr><answer><cr>" replies of devices in
+    // echo mode. The framer remembers how far it already searched, so every byte is only looked at once.
+    class DelimitedFramer {
+    public:
+        DelimitedFramer(char delimiter, size_t count) : m_delimiter(delimiter), m_count(count) {}
+
+        Frame next(const util::RingBuffer &buffer);
+        void reset();
+
+    private:
+        char m_delimiter;
+        size_t m_count;
+
+        size_t m_scanned = 0;
+        size_t m_found = 0;
+    };
+
+    // Packets with a fixed length
+    class FixedLengthFramer {
+    public:
+        explicit FixedLengthFramer(size_t length) : m_length(length) {}
+
+        Frame next(const util::RingBuffer &buffer) const;
+        void reset() {}
+
+    private:
+        size_t m_length;
+    };
+
+    // FrameReader buffers received data in a fixed capacity ring buffer and splits it into packets with the given framer
+    template <typename Framer>
+    class FrameReader {
+    public:
+        FrameReader(size_t capacity, Framer framer = Framer{}) : m_buffer(capacity), m_framer(std::move(framer)) {}
+
+        // Appends received data. If it does not fit (i.e. the device keeps sending data that never completes a packet) all
+        // buffered data is discarded first and false is returned.
+        bool push(const char *data, size_t length) {
+            if (m_buffer.push(data, length)) {
+                return true;
+            }
+
+            clear();
+            m_buffer.push(data, std::min(length, m_buffer.capacity()));
+            return false;
+        }
+
+        // Calls func(frame, valid) for every complete packet and removes it from the buffer. frame is only valid during the
+        // call.
+        template <typename F>
+        void for_each_frame(F &&func) {
+            for (;;) {
+                const auto frame = m_framer.next(m_buffer);
+                if (frame.status == FrameStatus::Incomplete) {
+                    break;
+                }
+
+                func(m_buffer.view(frame.length), frame.status == FrameStatus::Valid);
+
+                m_buffer.consume(frame.length);
+                m_framer.reset();
+            }
+        }
+
+        void clear() {
+            m_buffer.clear();
+            m_framer.reset();
+        }
+
+        size_t size() const { return m_buffer.size(); }
+
+    private:
+        util::RingBuffer m_buffer;
+        Framer m_framer;
+    };
+}  // namespace framing
@@ -2,19 +2,7 @@
 
 #include "logging/logging.h"
 
-HofiSwitch::HofiSwitch(std::unique_ptr<BaseConnector> &&connector) : RFSwitch(std::move(connector)) {
-    if (m_connector) {
-        QObject::connect(get_connector(), &BaseConnector::data_received, this, &HofiSwitch::handle_data_received);
-    }
-}
-
-void HofiSwitch::set_connector(std::unique_ptr<BaseConnector> &&connector) {
-    Device::set_connector(std::move(connector));
-
-    if (m_connector) {
-        QObject::connect(get_connector(), &BaseConnector::data_received, this, &HofiSwitch::handle_data_received);
-    }
-}
+HofiSwitch::HofiSwitch(std::unique_ptr<BaseConnector> &&connector) : RFSwitch(std::move(connector)) {}
 
 void HofiSwitch::init(std::shared_ptr<config::Segment> settings) {
     auto conn_seg = settings->get_segment("connector");
@@ -26,14 +14,14 @@ void HofiSwitch::init(std::shared_ptr<config::Segment> settings) {
         // Connector not yet loaded, try to create it from the settings
         auto conn_type = conn_seg->get<std::string>("type");
         if (!conn_type) {
-            logging::get_log("main")->warn(
+            logging::main_log()->warn(
                 "HofiSwitch: init called but connector was not set up, unable to create one from the settings provided");
             return;
         }
         auto conn = make_connector(*conn_type);
 
         if (!conn) {
-            logging::get_log("main")->warn(
+            logging::main_log()->warn(
                 "HofiSwitch: init called but connector was not set up, unable to create one from the settings provided");
             return;
         }
@@ -42,31 +30,27 @@ void HofiSwitch::init(std::shared_ptr<config::Segment> settings) {
     }
 
     if (!m_connector) {
-        logging::get_log("main")->warn(
+        logging::main_log()->warn(
             "HofiSwitch: init called but no connector was set up. Call set_connector with a valid connector first.");
         return;
     }
 
-    m_connector->init(settings);
-    if (!m_connector->connect()) {
-        logging::get_log("main")->error(
-            "HofiSwitch: an error occured while trying to connect to the switch. Connector info:\n  {0}", m_connector->info());
-    } else {
-        logging::get_log("main")->debug("HofiSwitch: connected. Connector info:\n  {0}", m_connector->info());
+    m_connector->init(conn_seg);
+}
 
-        // query current status
-        m_connector->write(QByteArray("HOFISTATU"));
-    }
+void HofiSwitch::handle_connected() {
+    // query current status
+    m_connector->write(QByteArray("HOFISTATU"));
 }
 
 void HofiSwitch::set_port(int8_t port) {
     if (port < 1 || port > 5) {
-        logging::get_log("main")->error("HofiSwitch: port outside range [1, 5], got {0}", port);
+        logging::main_log()->error("HofiSwitch: port outside range [1, 5], got {0}", port);
         return;
     }
 
     if (!m_connector) {
-        logging::get_log("main")->warn(
+        logging::main_log()->warn(
             "HofiSwitch: set_port called but no connector was set up. Call set_connector with a valid connector first.");
         return;
     }
@@ -79,25 +63,21 @@ void HofiSwitch::set_port(int8_t port) {
 int8_t HofiSwitch::get_port() { return m_current_port; }
 
 void HofiSwitch::handle_data_received(const QByteArray &data) {
-    std::scoped_lock<std::mutex> lock(m_data_mutex);
-
-    logging::get_log("main")->debug("HofiSwitch: received '{0}'", data.toHex().toStdString());
+    logging::main_log()->debug("HofiSwitch: received '{0}'", logging::hex(data));
 
-    m_in_buffer.append(data);
-
-    // No manual currently available, so we just check the last byte received, disregarding possible previous messages
-    // and errors
+    if (!m_reader.push(data.constData(), data.size())) {
+        logging::main_log()->warn("HofiSwitch: receive buffer overflow, discarded buffered data");
+    }
 
-    if (m_in_buffer.length() > 3) {
-        const int8_t port = m_in_buffer.back();
+    // No manual currently available, so we just check the last byte of each reply, disregarding possible errors
+    m_reader.for_each_frame([this](std::string_view frame, bool) {
+        const int8_t port = frame.back();
         if (port > 0 && port < 6 || port == 0xa) {
             m_current_port = port;
 
             emit port_changed(port);
         } else {
-            logging::get_log("main")->warn("HofiSwitch: unrecognized reply from switch, got '{0}'", m_in_buffer.toStdString());
+            logging::main_log()->warn("HofiSwitch: unrecognized reply from switch, got '{0}'", std::string(frame));
         }
-
-        m_in_buffer.clear();
-    }
-}
\ No newline at end of file
+    });
+}
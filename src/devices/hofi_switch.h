@@ -1,6 +1,7 @@
 #pragma once
 
 #include "device.h"
+#include "framer.h"
 #include "rf_switch.h"
 
 class HofiSwitch : public RFSwitch {
@@ -14,17 +15,22 @@ public:
     HofiSwitch &operator=(const HofiSwitch &) = delete;
 
     // overrides from Device
-    void set_connector(std::unique_ptr<BaseConnector> &&connector) override;
     void init(std::shared_ptr<config::Segment> settings) override;
 
     // overrides from RFSwitch
     void set_port(int8_t port) override;
     int8_t get_port() override;
 
-private:
-    void handle_data_received(const QByteArray &data);
+protected:
+    // overrides from Device
+    void handle_connected() override;
+    void handle_data_received(const QByteArray &data) override;
 
+private:
     int8_t m_current_port = -1;
-    QByteArray m_in_buffer;
-    std::mutex m_data_mutex;
+
+    // Length of a status reply of the switch, the port is sent in the last byte
+    static constexpr size_t REPLY_LENGTH = 4;
+    framing::FrameReader<framing::FixedLengthFramer> m_reader{DEVICE_RECEIVE_BUFFER_SIZE,
+                                                              framing::FixedLengthFramer(REPLY_LENGTH)};
 };
\ No newline at end of file
@@ -1,23 +1,15 @@
 #include "kjl_generator.h"
 
 KJLGenerator::KJLGenerator(std::unique_ptr<BaseConnector> &&connector) : RFGenerator(std::move(connector)) {
-    if (m_connector) {
-        QObject::connect(m_connector.get(), &BaseConnector::data_received, this, &KJLGenerator::handle_data_received);
-    }
-
-    logging::get_log("main")->debug("KJLGenerator: device #{0}", m_id);
-}
-
-void KJLGenerator::set_connector(std::unique_ptr<BaseConnector> &&connector) {
-    Device::set_connector(std::move(connector));
-
-    if (m_connector) {
-        QObject::connect(m_connector.get(), &BaseConnector::data_received, this, &KJLGenerator::handle_data_received);
-    }
+    logging::main_log()->debug("KJLGenerator: device #{0}", m_id);
 }
 
 void KJLGenerator::init(std::shared_ptr<config::Segment> settings) {
-    logging::get_log("main")->debug("KJLGenerator is Device #{0}", m_id);
+    logging::main_log()->debug("KJLGenerator is Device #{0}", m_id);
+
+    init_telemetry(*settings);
+    init_power_control(*settings);
+    init_match_tuning(*settings);
 
     auto conn_seg = settings->get_segment("connector");
     if (!conn_seg) {
@@ -28,14 +20,14 @@ void KJLGenerator::init(std::shared_ptr<config::Segment> settings) {
         // Connector not yet loaded, try to create it from the settings
         auto conn_type = conn_seg->get<std::string>("type");
         if (!conn_type) {
-            logging::get_log("main")->warn(
+            logging::main_log()->warn(
                 "KJLGenerator: init called but connector was not set up, unable to create one from the settings provided");
             return;
         }
         auto conn = make_connector(*conn_type);
 
         if (!conn) {
-            logging::get_log("main")->warn(
+            logging::main_log()->warn(
                 "KJLGenerator: init called but connector was not set up, unable to create one from the settings provided");
             return;
         }
@@ -44,225 +36,166 @@ void KJLGenerator::init(std::shared_ptr<config::Segment> settings) {
     }
 
     if (!m_connector) {
-        logging::get_log("main")->warn(
+        logging::main_log()->warn(
             "KJLGenerator: init called but no connector was set up. Call set_connector with a valid connector first.");
         return;
     }
     
-    m_connector->init(settings);
-    if (!m_connector->connect()) {
-        logging::get_log("main")->error(
-            "KJLGenerator: an error occured while trying to connect to the generator. Connector info:\n  {0}",
-            m_connector->info());
-    } else {
-        logging::get_log("main")->debug("KJLGenerator: connected. Connector info:\n  {0}", m_connector->info());
-    }
-}
-
-void KJLGenerator::update() {
-    // See if we have captured all parameters
-    if (m_generator_parameters.external_feedback != -1 && m_generator_parameters.forward_power != -1
-        && m_generator_parameters.reflected_power != -1 && m_generator_parameters.setpoint != -1
-        && m_generator_parameters.load_cap_position != -1 && m_generator_parameters.tune_cap_position != -1) {
-        std::scoped_lock<std::mutex> lock(m_parameter_mutex);
-
-        emit update_parameters(m_id);
-
-        // Reset all parameters to indicate we still need to save them
-        m_generator_parameters = {-1, -1, -1, -1, -1, -1};
-    }
+    m_connector->init(conn_seg);
 }
 
-void KJLGenerator::output_on() { send('G', '\r'); }
+void KJLGenerator::output_on() { send_command(Commands::OutputOn); }
 
-void KJLGenerator::output_off() { send('S', '\r'); }
+void KJLGenerator::output_off() { send_command(Commands::OutputOff); }
 
 void KJLGenerator::set_target_power(int power) {
     if (power < 0) {
-        logging::get_log("main")->warn("KJLGenerator: set_target_power called with negative power value of {0}", power);
+        logging::main_log()->warn("KJLGenerator: set_target_power called with negative power value of {0}", power);
         return;
     }
     // TODO: test for maximum power
 
-    send(QByteArray::fromStdString(fmt::format("{0}.0 W\r", power)));
+    send_command(Commands::SetPower, power);
 }
 
 void KJLGenerator::set_load_capacitor_position(int position) {
     if (position < 0 || position > 100) {
-        logging::get_log("main")->warn(
+        logging::main_log()->warn(
             "KJLGenerator: set_load_capacitor_position called with position outside the range [0, 100], got {0}", position);
         return;
     }
 
-    send(QByteArray::fromStdString(fmt::format("{0} MPL\r", position)));
+    send_command(Commands::SetLoadCapPosition, position);
 }
 
 void KJLGenerator::set_tune_capacitor_position(int position) {
     if (position < 0 || position > 100) {
-        logging::get_log("main")->warn(
+        logging::main_log()->warn(
             "KJLGenerator: set_tune_capacitor_position called with position outside the range [0, 100], got {0}", position);
         return;
     }
 
-    send(QByteArray::fromStdString(fmt::format("{0} MPT\r", position)));
+    send_command(Commands::SetTuneCapPosition, position);
 }
 
 void KJLGenerator::query_capacitor_positions() {
-    send(QByteArray::fromStdString("LPS\r"));  // load capacitor
-    send(QByteArray::fromStdString("TPS\r"));  // tune capacitor
+    send_command(Commands::QueryLoadCapPosition);
+    send_command(Commands::QueryTuneCapPosition);
 }
 
-void KJLGenerator::query_external_feedback() { send('0', '?', '\r'); }
+void KJLGenerator::query_external_feedback() { send_command(Commands::QueryExternalFeedback); }
 
-void KJLGenerator::query_forward_power() { send('W', '?', '\r'); }
+void KJLGenerator::query_forward_power() { send_command(Commands::QueryForwardPower); }
 
-void KJLGenerator::query_reflected_power() { send('R', '?', '\r'); }
+void KJLGenerator::query_reflected_power() { send_command(Commands::QueryReflectedPower); }
 
-void KJLGenerator::query_status() { send('Q', '\r'); }
+void KJLGenerator::query_status() { send_command(Commands::QueryStatus); }
 
-void KJLGenerator::handle_data_received(const QByteArray &data) {
-    // A buffer for incoming messages so we don't keep the mutex locked for actual handling of the packets
-    std::vector<QByteArray> replies;
+std::vector<RFGenerator::TelemetryQuery> KJLGenerator::telemetry_queries() {
+    // The status query returns the setpoint, forward and reflected power at once, which saves two round trips per burst
+    return {
+        {[this]() { query_status(); }, 1, true},
+        {[this]() { query_capacitor_positions(); }, 2, false},  // load and tune capacitor are queried separately
+        {[this]() { query_external_feedback(); }, 1, false},
+    };
+}
 
-    logging::get_log("main")->debug("KJLGenerator: handle_data_received got '{0}'", data.toStdString());
+void KJLGenerator::handle_data_received(const QByteArray &data) {
+    logging::main_log()->debug("KJLGenerator: handle_data_received got '{0}' (hex)", logging::hex(data));
 
     // TODO: keep track of sent commands to identify lost packets
 
-    {
-        std::scoped_lock<std::mutex> lock(m_data_mutex);
-
-        m_in_buffer.append(data);
-
-        // We are in echo mode, so the reply is "<command><cr><answer><cr>", where <answer> may be "N" for NACK
-        while (m_in_buffer.count('\r') >= 2) {
-            int first_index = m_in_buffer.indexOf('\r');
-            int end_index = m_in_buffer.indexOf('\r', first_index + 1);
-
-            replies.push_back(m_in_buffer.left(end_index + 1));
-            m_in_buffer = m_in_buffer.right(m_in_buffer.length() - end_index - 1);
-        }
-    }  // scoped_lock
-
-    // Process received replies
-    for (const auto &r : replies) {
-        handle_reply(r);
+    if (!m_reader.push(data.constData(), data.size())) {
+        logging::main_log()->warn("KJLGenerator: receive buffer overflow, discarded buffered data");
     }
+
+    // We are in echo mode, so the reply is "<command><cr><answer><cr>", where <answer> may be "N" for NACK. The replies are
+    // handled in place (handle_reply does not touch the buffer), so they don't have to be copied out of it.
+    m_reader.for_each_frame([this](std::string_view frame, bool) {
+        handle_reply(QByteArray::fromRawData(frame.data(), static_cast<int>(frame.size())));
+    });
 }
 
-void KJLGenerator::handle_reply(const QByteArray &data) {
-    int first_index = data.indexOf('\r');
-    if (first_index == -1) {
-        logging::get_log("main")->warn("KJLGenerator: no <cr> in reply, got '{0}' (hex)", data.toHex().toStdString());
+void KJLGenerator::send_command(Commands command, int value) {
+    // Sent commands are tracked for the telemetry sampler, which lives in the thread of the generator
+    if (!in_device_thread()) {
+        QMetaObject::invokeMethod(this, [this, command, value]() { send_command(command, value); }, Qt::QueuedConnection);
         return;
     }
 
-    int second_index = data.indexOf('\r', first_index + 1);
-    if (second_index == -1) {
-        logging::get_log("main")->warn("KJLGenerator: missing second <cr> in reply, got '{0}' (hex)", data.toHex().toStdString());
+    const auto *descriptor = protocol::kjl::command_table().find(protocol::id(command));
+    if (!descriptor) {
         return;
     }
 
-    // There should be at least a second <cr> if the command was accepted
-    if (data.length() < first_index + 1) {
-        logging::get_log("main")->warn("KJLGenerator: missing data in reply, got '{0}' (hex)", data.toHex().toStdString());
+    send(QByteArray::fromStdString(fmt::format(descriptor->text, value) + '\r'));
+    command_sent(descriptor->id);
+}
+
+void KJLGenerator::handle_reply(const QByteArray &data) {
+    const std::string_view reply(data.constData(), data.size());
+
+    const auto first_index = reply.find('\r');
+    if (first_index == std::string_view::npos) {
+        logging::main_log()->warn("KJLGenerator: no <cr> in reply, got '{0}' (hex)", logging::hex(data));
+        telemetry_failed(std::nullopt);
         return;
     }
 
-    if (auto ack = data[first_index + 1]; ack == 'N') {
-        // Command not accepted
-        logging::get_log("main")->warn("KJLGenerator: command '{0}' was rejected by the generator", data.left(first_index + 1));
+    const auto second_index = reply.find('\r', first_index + 1);
+    if (second_index == std::string_view::npos) {
+        logging::main_log()->warn("KJLGenerator: missing second <cr> in reply, got '{0}' (hex)", logging::hex(data));
+        telemetry_failed(std::nullopt);
         return;
     }
 
-    char cmd = data[0];
-    switch (cmd) {
-    case '0':  // 0x30, external feedback (dc bias voltage)
-    {
-        if (data[1] != '?') {
-            logging::get_log("main")->warn("KJLGenerator: received unknown reply command, got '{0}' (hex)",
-                                           data.toHex().toStdString());
-            return;
-        }
+    // The reply is the echo of the command followed by the answer
+    const auto echo = reply.substr(0, first_index);
+    const auto answer = reply.substr(first_index + 1, second_index - first_index - 1);
 
-        std::scoped_lock<std::mutex> lock(m_parameter_mutex);
-        m_generator_parameters.external_feedback = data.mid(3, second_index - 3).toInt();
+    const auto *command = protocol::kjl::command_table().find(echo);
 
-        logging::get_log("main")->debug("KJLGenerator: external feedback returned {0}", m_generator_parameters.external_feedback);
-        break;
-    }
-    case 'L':  // load capacitor position
-    {
-        std::scoped_lock<std::mutex> lock(m_parameter_mutex);
-        m_generator_parameters.load_cap_position = data.mid(2, second_index - first_index - 1).toInt();
-
-        logging::get_log("main")->debug("KJLGenerator: load capacitor position power returned {0}",
-                                        m_generator_parameters.load_cap_position);
-        break;
+    if (!answer.empty() && answer[0] == 'N') {
+        // Command not accepted
+        logging::main_log()->warn("KJLGenerator: command '{0}' was rejected by the generator", std::string(echo));
+        telemetry_failed(command ? std::optional<uint8_t>(command->id) : std::nullopt);
+        return;
     }
-    case 'T':  // tune capacitor position
-    {
-        std::scoped_lock<std::mutex> lock(m_parameter_mutex);
-        m_generator_parameters.load_cap_position = data.mid(2, second_index - first_index - 1).toInt();
-
-        logging::get_log("main")->debug("KJLGenerator: tune capacitor position power returned {0}",
-                                        m_generator_parameters.load_cap_position);
-        break;
+
+    if (!command) {
+        logging::main_log()->warn("KJLGenerator: received unknown reply command, got {0} (hex)", logging::hex(data));
+        telemetry_failed(std::nullopt);
+        return;
     }
-    case 'Q':  // 0x51
-    {
-        // Q returns "Q<cr>XXXXXXX aaaa bbbb ccc dddd", where
-        //     a is setpoint in Watts
-        //     b is forward power in Watts
-        //     c is reflected power in Watts
-        //     d is maximum power in Watts
-        //     X holds additional information
-        auto tokens = util::split(data.mid(2, second_index - first_index - 1).toStdString(), ' ');
-        if (!tokens) {
-            logging::get_log("main")->warn("KJLGenerator: received corrupted reply to 'Q' (QueryStatus) command, got '{0}' (hex)",
-                                           data.toHex().toStdString());
-            return;
-        }
 
-        if (tokens->empty()) {
-            logging::get_log("main")->warn("KJLGenerator: received corrupted reply to 'Q' (QueryStatus) command, got '{0}' (hex)",
-                                           data.toHex().toStdString());
-            return;
-        }
+    if (!command->has_reply()) {
+        return;
+    }
 
-        std::scoped_lock<std::mutex> lock(m_parameter_mutex);
+    Parameters parameters;
+    if (!protocol::decode(*command, answer, parameters)) {
+        logging::main_log()->warn("KJLGenerator: received corrupted reply to {0}, got '{1}' (hex)", command->name,
+                                  logging::hex(data));
+        telemetry_failed(command->id);
+        return;
+    }
 
-        if (auto setpoint = util::to_type<int>((*tokens)[1])) {
-            m_generator_parameters.setpoint = *setpoint;
-        }
-        if (auto forward_power = util::to_type<int>((*tokens)[2])) {
-            m_generator_parameters.forward_power = *forward_power;
+    for (const auto &field : command->reply) {
+        if (field.target) {
+            report_parameter(field.target, parameters.*field.target);
         }
-        if (auto reflected_power = util::to_type<int>((*tokens)[3])) {
-            m_generator_parameters.reflected_power = *reflected_power;
-        }
-
-        logging::get_log("main")->debug(
-            "KJLGenerator: reflected power returned {0} (setpoint), {1} (forward power}, {2} (reflected power)",
-            m_generator_parameters.setpoint, m_generator_parameters.forward_power, m_generator_parameters.reflected_power);
-        break;
     }
-    case 'R':  // 0x52, reflected power
-    {
-        std::scoped_lock<std::mutex> lock(m_parameter_mutex);
-        m_generator_parameters.reflected_power = data.mid(3, 4).toInt();
 
-        logging::get_log("main")->debug("KJLGenerator: reflected power returned {0}", m_generator_parameters.reflected_power);
-        break;
+    // Replies arrive with every telemetry sample, only format the values when they are logged
+    if (logging::main_log()->should_log(spdlog::level::debug)) {
+        std::string values;
+        for (const auto &field : command->reply) {
+            if (field.target) {
+                values += fmt::format(" {0}", parameters.*field.target);
+            }
+        }
+        logging::main_log()->debug("KJLGenerator: {0} returned{1}", command->name, values);
     }
-    case 'W':  // 0x57, forward power
-    {
-        std::scoped_lock<std::mutex> lock(m_parameter_mutex);
-        m_generator_parameters.forward_power = data.mid(3, 4).toInt();
 
-        logging::get_log("main")->debug("KJLGenerator: forward power returned {0}", m_generator_parameters.forward_power);
-        break;
-    }
-    default:
-        logging::get_log("main")->warn("KJLGenerator: received unknown reply command, got {0} (hex)", data.toHex().toStdString());
-    }
-}
\ No newline at end of file
+    telemetry_received(command->id);
+}
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "device.h"
+#include "framer.h"
+#include "kjl_protocol.h"
+#include "protocol.h"
 #include "rf_generator.h"
 
 class KJLGenerator : public RFGenerator {
@@ -14,9 +17,7 @@ public:
     KJLGenerator &operator=(const KJLGenerator &) = delete;
 
     // overrides from Device
-    void set_connector(std::unique_ptr<BaseConnector> &&connector) override;
     void init(std::shared_ptr<config::Segment> settings) override;
-    void update() override;
 
     // overrides from RFGenerator
     void output_on() override;
@@ -33,25 +34,21 @@ public:
     // Query the setpoint, forward power, reflected power, maximum power and additional status information from the generator
     void query_status();
 
+protected:
+    // overrides from Device
+    void handle_data_received(const QByteArray &data) override;
+
+    // overrides from RFGenerator
+    std::vector<TelemetryQuery> telemetry_queries() override;
+
 private:
-    void handle_data_received(const QByteArray &data);
     void handle_reply(const QByteArray &data);
 
-    // Saves the received parameters from the generator. When all were received successfully, they are reported to the controller
-    // and set to -1 again.
-    struct {
-        int external_feedback = -1;
-        int forward_power = -1;
-        int reflected_power = -1;
-        int setpoint = -1;
-        int load_cap_position = -1;
-        int tune_cap_position = -1;
-    } m_generator_parameters;
-    std::mutex m_parameter_mutex;
-
-    QByteArray m_in_buffer;
-    std::mutex m_data_mutex;
-
-    std::mutex m_command_mutex;
-    std::list<QByteArray> m_command_queue;
+    using Commands = protocol::kjl::Commands;
+
+    // Send a command, "{0}" in its text is replaced by value
+    void send_command(Commands command, int value = 0);
+
+    // Replies are "<command><cr><answer><cr>" since the generator is in echo mode
+    framing::FrameReader<framing::DelimitedFramer> m_reader{DEVICE_RECEIVE_BUFFER_SIZE, framing::DelimitedFramer('\r', 2)};
 };
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "protocol.h"
+#include "rf_parameters.h"
+
+// The protocol of KJL generators: the commands sent by KJLGenerator and the layout of their replies. It does not depend on
+// Qt, so the benchmarks decode replies with the same table as the driver.
+namespace protocol::kjl {
+    // The commands understood by the generator. The ids are only used to look up the protocol descriptors (see
+    // command_table), the generator is controlled with the ASCII text of the commands.
+    enum class Commands : uint8_t {
+        OutputOn,
+        OutputOff,
+        SetPower,
+        SetLoadCapPosition,
+        SetTuneCapPosition,
+        QueryLoadCapPosition,
+        QueryTuneCapPosition,
+        QueryExternalFeedback,
+        QueryForwardPower,
+        QueryReflectedPower,
+        QueryStatus,
+    };
+
+    // The descriptors of the commands, see protocol::Table
+    inline const auto &command_table() {
+        using Command = protocol::Command<RFParameters>;
+
+        // clang-format off
+        static constexpr protocol::Table table{std::array<Command, 11>{{
+            {protocol::id(Commands::OutputOn), "OutputOn", Encoding::None, "G"},
+            {protocol::id(Commands::OutputOff), "OutputOff", Encoding::None, "S"},
+            {protocol::id(Commands::SetPower), "SetPower", Encoding::Decimal, "{0}.0 W"},
+            {protocol::id(Commands::SetLoadCapPosition), "SetLoadCapPosition", Encoding::Decimal, "{0} MPL"},
+            {protocol::id(Commands::SetTuneCapPosition), "SetTuneCapPosition", Encoding::Decimal, "{0} MPT"},
+            {protocol::id(Commands::QueryLoadCapPosition), "QueryLoadCapPosition", Encoding::None, "LPS",
+                {{{Encoding::Decimal, 0, 1, &RFParameters::load_cap_position}}}},
+            {protocol::id(Commands::QueryTuneCapPosition), "QueryTuneCapPosition", Encoding::None, "TPS",
+                {{{Encoding::Decimal, 0, 1, &RFParameters::tune_cap_position}}}},
+            // External feedback is the dc bias voltage
+            {protocol::id(Commands::QueryExternalFeedback), "QueryExternalFeedback", Encoding::None, "0?",
+                {{{Encoding::Decimal, 0, 1, &RFParameters::external_feedback}}}},
+            {protocol::id(Commands::QueryForwardPower), "QueryForwardPower", Encoding::None, "W?",
+                {{{Encoding::Decimal, 0, 1, &RFParameters::forward_power}}}},
+            {protocol::id(Commands::QueryReflectedPower), "QueryReflectedPower", Encoding::None, "R?",
+                {{{Encoding::Decimal, 0, 1, &RFParameters::reflected_power}}}},
+            // Q returns "XXXXXXX aaaa bbbb ccc dddd", where a is the setpoint, b the forward power, c the reflected power and d
+            // the maximum power in Watts and X holds additional information
+            {protocol::id(Commands::QueryStatus), "QueryStatus", Encoding::None, "Q",
+                {{{Encoding::Decimal, 1, 1, &RFParameters::setpoint},
+                  {Encoding::Decimal, 2, 1, &RFParameters::forward_power},
+                  {Encoding::Decimal, 3, 1, &RFParameters::reflected_power}}}},
+        }}};
+        // clang-format on
+
+        return table;
+    }
+}  // namespace protocol::kjl
@@ -0,0 +1,167 @@
+#include "match_tuner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iterator>
+
+void MatchTuner::start(Position seed, bool warm) {
+    const int step = std::max(warm ? m_settings.warm_step : m_settings.initial_step, m_settings.min_step);
+
+    const auto first = clamp({static_cast<double>(seed.load), static_cast<double>(seed.tune)});
+    // Step away from the end of the range the seed is closer to, so the simplex does not collapse at the border
+    const double load_step = first.load + step <= m_settings.max_position ? step : -step;
+    const double tune_step = first.tune + step <= m_settings.max_position ? step : -step;
+
+    m_simplex[0] = first;
+    m_simplex[1] = clamp({first.load + load_step, first.tune});
+    m_simplex[2] = clamp({first.load, first.tune + tune_step});
+
+    m_phase = Phase::Init;
+    m_vertex = 0;
+    m_candidate = m_simplex[0];
+    m_evaluations = 0;
+    m_running = true;
+}
+
+void MatchTuner::report(double reflected) {
+    if (!m_running) {
+        return;
+    }
+
+    m_evaluations++;
+    m_candidate.value = reflected;
+
+    switch (m_phase) {
+    case Phase::Init:
+    case Phase::Shrink:
+        m_simplex[m_vertex] = m_candidate;
+        if (++m_vertex < m_simplex.size()) {
+            m_candidate = m_simplex[m_vertex];
+        } else {
+            next_iteration();
+        }
+        break;
+
+    case Phase::Reflect:
+        m_reflected = m_candidate;
+        if (reflected < m_simplex[0].value) {
+            // Better than the best vertex, see if going further in that direction is even better
+            m_phase = Phase::Expand;
+            set_candidate(m_reflected, 2.0);
+        } else if (reflected < m_simplex[1].value) {
+            m_simplex[2] = m_reflected;
+            next_iteration();
+        } else if (reflected < m_simplex[2].value) {
+            m_phase = Phase::ContractOutside;
+            set_candidate(m_reflected, 0.5);
+        } else {
+            m_phase = Phase::ContractInside;
+            set_candidate(m_simplex[2], 0.5);
+        }
+        break;
+
+    case Phase::Expand:
+        m_simplex[2] = reflected < m_reflected.value ? m_candidate : m_reflected;
+        next_iteration();
+        break;
+
+    case Phase::ContractOutside:
+        if (reflected <= m_reflected.value) {
+            m_simplex[2] = m_candidate;
+            next_iteration();
+        } else {
+            shrink();
+        }
+        break;
+
+    case Phase::ContractInside:
+        if (reflected < m_simplex[2].value) {
+            m_simplex[2] = m_candidate;
+            next_iteration();
+        } else {
+            shrink();
+        }
+        break;
+    }
+}
+
+void MatchTuner::next_iteration() {
+    std::sort(m_simplex.begin(), m_simplex.end(), [](const Vertex &a, const Vertex &b) { return a.value < b.value; });
+
+    double size = 0;
+    for (size_t i = 1; i < m_simplex.size(); i++) {
+        size = std::max(
+            {size, std::abs(m_simplex[i].load - m_simplex[0].load), std::abs(m_simplex[i].tune - m_simplex[0].tune)});
+    }
+
+    // On whole steps the simplex can not get smaller than one step, so it is done once it spans min_step. The evaluations are
+    // only checked here, so a run may take up to two more than max_evaluations to finish a shrink.
+    if (m_simplex[0].value <= m_settings.target_reflected || size <= m_settings.min_step
+        || m_evaluations >= m_settings.max_evaluations) {
+        m_running = false;
+        m_candidate = m_simplex[0];
+        return;
+    }
+
+    m_centroid.load = (m_simplex[0].load + m_simplex[1].load) / 2;
+    m_centroid.tune = (m_simplex[0].tune + m_simplex[1].tune) / 2;
+
+    // Reflect the worst vertex at the centroid of the other two
+    m_phase = Phase::Reflect;
+    set_candidate(m_simplex[2], -1.0);
+}
+
+void MatchTuner::shrink() {
+    for (size_t i = 1; i < m_simplex.size(); i++) {
+        m_simplex[i] = clamp({(m_simplex[0].load + m_simplex[i].load) / 2, (m_simplex[0].tune + m_simplex[i].tune) / 2});
+    }
+
+    m_phase = Phase::Shrink;
+    m_vertex = 1;
+    m_candidate = m_simplex[1];
+}
+
+void MatchTuner::set_candidate(const Vertex &point, double factor) {
+    m_candidate = clamp({m_centroid.load + factor * (point.load - m_centroid.load),
+                         m_centroid.tune + factor * (point.tune - m_centroid.tune)});
+}
+
+MatchTuner::Vertex MatchTuner::clamp(Vertex vertex) const {
+    // Vertices are kept on whole steps, so they are exactly the positions that were measured
+    const auto to_range = [this](double position) {
+        return std::clamp(std::round(position), static_cast<double>(m_settings.min_position),
+                          static_cast<double>(m_settings.max_position));
+    };
+
+    vertex.load = to_range(vertex.load);
+    vertex.tune = to_range(vertex.tune);
+    return vertex;
+}
+
+MatchTuner::Position MatchTuner::round(const Vertex &vertex) const {
+    return {static_cast<int>(std::lround(vertex.load)), static_cast<int>(std::lround(vertex.tune))};
+}
+
+void MatchCache::store(int port, int power, MatchTuner::Position position) {
+    m_entries[{port, (std::max(power, 0) + m_power_step / 2) / m_power_step}] = position;
+}
+
+std::optional<MatchTuner::Position> MatchCache::lookup(int port, int power) const {
+    const int step = (std::max(power, 0) + m_power_step / 2) / m_power_step;
+
+    // The nearest power of the port, entries are ordered by port and power
+    auto after = m_entries.lower_bound({port, step});
+    auto before = after == m_entries.begin() ? m_entries.end() : std::prev(after);
+
+    const bool after_valid = after != m_entries.end() && after->first.first == port;
+    const bool before_valid = before != m_entries.end() && before->first.first == port;
+
+    if (after_valid && (!before_valid || after->first.second - step <= step - before->first.second)) {
+        return after->second;
+    }
+    if (before_valid) {
+        return before->second;
+    }
+    return std::nullopt;
+}
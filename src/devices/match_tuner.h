@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <map>
+#include <optional>
+#include <utility>
+
+// MatchTuner searches the load and tune capacitor positions of a matching network with the least reflected power, using the
+// Nelder-Mead simplex method. Moving the capacitors and measuring the reflected power takes a while, so the tuner is driven
+// from outside: get_position returns the positions to measure next and report takes the reflected power measured there,
+// until is_running returns false.
+//
+// The search works on positions clamped to the range of the capacitors and rounded to whole steps. It ends once the simplex
+// spans no more than min_step, the reflected power is at or below target_reflected or max_evaluations were measured.
+//
+// Like TelemetrySampler it does not do any I/O or timing on its own and is not thread safe.
+class MatchTuner {
+public:
+    struct Position {
+        int load = 0;
+        int tune = 0;
+    };
+
+    struct Settings {
+        // Range of both capacitors
+        int min_position = 0;
+        int max_position = 100;
+        // Size of the initial simplex for a cold start and for a start from a cached position
+        int initial_step = 10;
+        int warm_step = 3;
+        int min_step = 1;
+        double target_reflected = 0;
+        int max_evaluations = 60;
+    };
+
+    void set_settings(const Settings &settings) { m_settings = settings; }
+    const Settings &get_settings() const { return m_settings; }
+
+    // Starts a search around seed, warm if the seed is a position that matched before
+    void start(Position seed, bool warm);
+    void stop() { m_running = false; }
+    bool is_running() const { return m_running; }
+
+    // The positions to measure next
+    Position get_position() const { return round(m_candidate); }
+
+    // Reports the reflected power measured at get_position
+    void report(double reflected);
+
+    // The best positions measured so far
+    Position get_best() const { return round(m_simplex[0]); }
+    double get_best_reflected() const { return m_simplex[0].value; }
+    int get_evaluations() const { return m_evaluations; }
+
+private:
+    struct Vertex {
+        double load = 0;
+        double tune = 0;
+        double value = 0;
+    };
+
+    // What the measurement of the candidate is used for
+    enum class Phase { Init, Reflect, Expand, ContractOutside, ContractInside, Shrink };
+
+    // Sorts the simplex and starts the next iteration with a reflection, or ends the search
+    void next_iteration();
+    // Shrinks the simplex towards the best vertex and measures the other two again
+    void shrink();
+
+    // Moves the candidate to centroid + factor * (point - centroid)
+    void set_candidate(const Vertex &point, double factor);
+
+    Vertex clamp(Vertex vertex) const;
+    Position round(const Vertex &vertex) const;
+
+    Settings m_settings;
+    bool m_running = false;
+
+    // Sorted by value after every iteration, the best vertex first
+    std::array<Vertex, 3> m_simplex{};
+    Vertex m_centroid;
+    Vertex m_candidate;
+    Vertex m_reflected;
+
+    Phase m_phase = Phase::Init;
+    // Vertex measured in the Init and Shrink phases
+    size_t m_vertex = 0;
+    int m_evaluations = 0;
+};
+
+// MatchCache keeps the best capacitor positions found per port of the RF switch (i.e. target) and power, so the next tuning
+// run for the same setup starts close to the match. Powers are grouped into steps of power_step W; a lookup without an entry
+// for the power falls back to the nearest power of the same port.
+class MatchCache {
+public:
+    MatchCache(int power_step = 10) : m_power_step(power_step > 0 ? power_step : 1) {}
+
+    // Stores the result of a run, it replaces older ones since the conditions drift (e.g. with the erosion of the target)
+    void store(int port, int power, MatchTuner::Position position);
+    std::optional<MatchTuner::Position> lookup(int port, int power) const;
+
+    void clear() { m_entries.clear(); }
+    size_t size() const { return m_entries.size(); }
+
+private:
+    int m_power_step;
+    // (port, power step) -> positions
+    std::map<std::pair<int, int>, MatchTuner::Position> m_entries;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "tag_index.h"
+
+#include "util/bits.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace PLC {
+    // BitDiff finds the tags of a digital area (flags, inputs or outputs) whose state changed between two polls. The old and
+    // new image are XORed word by word and only the set bits of the result are visited, so the cost depends on the number of
+    // changed bits instead of the number of configured tags.
+    class BitDiff {
+    public:
+        // Removes all subscriptions
+        void clear() { m_index.clear(); }
+
+        // Subscribes tag to bit. A bit may have more than one tag. Call build() after all tags are added.
+        void add(size_t bit, uint16_t tag) { m_index.add(bit, tag); }
+
+        // Builds the bit to tag table from all added subscriptions
+        void build() { m_index.build(); }
+
+        // Number of bits covered by the table (highest subscribed bit + 1)
+        size_t bit_count() const noexcept { return m_index.size(); }
+
+        // Compares word_count words of previous and current and calls func(tag, state) for every tag whose bit changed
+        template <typename F>
+        void diff(const uint64_t *previous, const uint64_t *current, size_t word_count, F &&func) const {
+            for (size_t word = 0; word < word_count; word++) {
+                const uint64_t changed = previous[word] ^ current[word];
+                if (!changed) {
+                    continue;
+                }
+
+                util::for_each_set_bit(changed, [&](int bit_in_word) {
+                    const bool state = current[word] & (uint64_t{1} << bit_in_word);
+                    m_index.for_each(word * 64 + bit_in_word, [&](uint16_t tag) { func(tag, state); });
+                });
+            }
+        }
+
+    private:
+        TagIndex m_index;
+    };
+}  // namespace PLC
@@ -0,0 +1,100 @@
+#include "bit_image.h"
+
+#include "util/type_conversion.h"
+#include "util/util_strings.h"
+
+#include <cstring>
+
+namespace PLC {
+    void BitImage::clear() {
+        m_ranges.clear();
+        m_words.clear();
+        m_previous_words.clear();
+    }
+
+    bool BitImage::add_range(int start, int length) {
+        if (start < 0 || length <= 0) {
+            return false;
+        }
+
+        for (const auto &range : m_ranges) {
+            if (start < range.start + range.length && range.start < start + length) {
+                return false;
+            }
+        }
+
+        ByteRange range;
+        range.start = start;
+        range.length = length;
+        range.first_bit = m_words.size() * 64;
+        m_ranges.push_back(range);
+
+        // Every range gets its own words, rounded up to full words
+        const size_t words = (static_cast<size_t>(length) + 7) / 8;
+        m_words.resize(m_words.size() + words, 0);
+        m_previous_words.resize(m_words.size(), 0);
+
+        return true;
+    }
+
+    std::optional<std::vector<std::pair<int, int>>> BitImage::parse_ranges(const std::string &ranges) {
+        auto tokens = util::split(ranges, ',', false);
+        if (!tokens) {
+            return std::nullopt;
+        }
+
+        std::vector<std::pair<int, int>> result;
+        for (auto token : *tokens) {
+            util::trim_both(token);
+
+            auto bounds = util::split(token, '-', false);
+            if (!bounds || bounds->empty() || bounds->size() > 2) {
+                return std::nullopt;
+            }
+
+            auto first = util::to_type<int>((*bounds)[0]);
+            auto last = util::to_type<int>(bounds->back());
+            if (!first || !last || *last < *first) {
+                return std::nullopt;
+            }
+
+            result.emplace_back(*first, *last - *first + 1);
+        }
+
+        return result;
+    }
+
+    std::optional<size_t> BitImage::find_range(int address) const {
+        if (address < 0) {
+            return std::nullopt;
+        }
+
+        const int byte = address / 8;
+        for (size_t i = 0; i < m_ranges.size(); i++) {
+            if (byte >= m_ranges[i].start && byte < m_ranges[i].start + m_ranges[i].length) {
+                return i;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    std::optional<size_t> BitImage::find_bit(int address) const {
+        auto range = find_range(address);
+        if (!range) {
+            return std::nullopt;
+        }
+
+        return m_ranges[*range].first_bit + static_cast<size_t>(address - m_ranges[*range].start * 8);
+    }
+
+    void BitImage::load(const uint8_t *process_image) {
+        m_previous_words.swap(m_words);
+
+        // Byte n of a range holds bits n * 8 to n * 8 + 7, which matches a little endian word
+        for (const auto &range : m_ranges) {
+            std::memcpy(reinterpret_cast<uint8_t *>(m_words.data() + range.first_bit / 64), process_image + range.offset,
+                        range.length);
+        }
+    }
+}  // namespace PLC
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace PLC {
+    // ByteRange is a contiguous range of bytes of a digital area (flags, inputs or outputs) that is read in every poll cycle
+    struct ByteRange {
+        int start = 0;   // first byte
+        int length = 0;  // number of bytes
+
+        size_t first_bit = 0;  // position of the first bit of the range in the bit image, always a multiple of 64
+        size_t offset = 0;     // offset of the data in the process image buffer of the S7
+
+        size_t scan_class = 0;  // scan class the range is polled in
+    };
+
+    // BitImage holds the state of all bits of a digital area that are covered by its byte ranges. The ranges may be
+    // disjoint; every range starts at a 64 bit word of the image, so the data of a range is copied with a single memcpy
+    // and changes can be detected a word at a time (see BitDiff). The image of the previous poll is kept as well.
+    class BitImage {
+    public:
+        // Removes all ranges
+        void clear();
+
+        // Adds the bytes [start, start + length) to the image. Returns false if the range is empty, negative or overlaps
+        // one of the existing ranges.
+        bool add_range(int start, int length);
+
+        // Parses a comma separated list of byte ranges (e.g. "0-5, 20-27, 30"), both ends are included. Returns the ranges
+        // as (start, length) or std::nullopt if the list is malformed.
+        static std::optional<std::vector<std::pair<int, int>>> parse_ranges(const std::string &ranges);
+
+        // Returns the index of the range covering the bit with the given address (byte * 8 + bit), std::nullopt if the
+        // address is not covered by any range
+        std::optional<size_t> find_range(int address) const;
+
+        // Returns the position in the image of the bit with the given address (byte * 8 + bit), std::nullopt if the
+        // address is not covered by any range
+        std::optional<size_t> find_bit(int address) const;
+
+        std::vector<ByteRange> &ranges() noexcept { return m_ranges; }
+        const std::vector<ByteRange> &ranges() const noexcept { return m_ranges; }
+
+        // Keeps the current state as the previous one and copies the data of all ranges from the process image
+        void load(const uint8_t *process_image);
+
+        const std::vector<uint64_t> &words() const noexcept { return m_words; }
+        const std::vector<uint64_t> &previous_words() const noexcept { return m_previous_words; }
+
+        size_t word_count() const noexcept { return m_words.size(); }
+
+    private:
+        std::vector<ByteRange> m_ranges;
+
+        std::vector<uint64_t> m_words;
+        std::vector<uint64_t> m_previous_words;
+    };
+
+    // Returns the state of the bit at the given position of a bit image
+    inline bool test_bit(const std::vector<uint64_t> &words, size_t bit) {
+        return bit / 64 < words.size() && (words[bit / 64] & (uint64_t{1} << (bit % 64)));
+    }
+}  // namespace PLC
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "tag_index.h"
+
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -8,11 +10,27 @@ namespace PLC {
     // DB: Data Block
     template <typename T>
     struct DB {
+        // Last value reported to listeners. Changes within the deadband are not reported.
         T data = 0;
+        T deadband = 0;
 
         std::string name;
         int address_db;
         int address_data;
+
+        // Index of the DBVector holding the data of this value
+        size_t index = 0;
+
+        // Takes value as the last reported one if it differs by more than the deadband from it, returns true if the change
+        // has to be reported
+        bool update(T value) {
+            const T delta = static_cast<T>(value > data ? value - data : data - value);
+            if (delta <= deadband) {
+                return false;
+            }
+            data = value;
+            return true;
+        }
     };
 
     using DBword = DB<uint16_t>;
@@ -22,13 +40,24 @@ namespace PLC {
     // This holds the data of multiple data blocks.
     template <typename T>
     struct DBVector {
-        DBVector(int addr, int len) : data(len), length{len}, address{addr} {}
+        DBVector(int addr, int len) : data(len), previous(len), length{len}, address{addr} {}
         DBVector() {}
 
         std::vector<T> data;
+        // Data of the previous poll. It is swapped with data in every poll, so polling does not allocate.
+        std::vector<T> previous;
 
         int length;
         int address;
+
+        // Offset of the raw data in the process image buffer of the S7
+        size_t offset = 0;
+
+        // Scan class the data block is polled in
+        size_t scan_class = 0;
+
+        // Maps the index of a value in data (address_data / sizeof(T)) to the tags located there
+        TagIndex tags;
     };
 
     using DBDataword = DBVector<uint16_t>;
@@ -0,0 +1,89 @@
+#include "poll_planner.h"
+
+#include <algorithm>
+
+namespace PLC {
+    void PollPlanner::clear() {
+        m_items.clear();
+        m_requests.clear();
+        m_image_size = 0;
+    }
+
+    size_t PollPlanner::add(int area, int db, int start, int length, size_t group) {
+        size_t offset = m_image_size;
+
+        m_items.push_back({area, db, start, length, offset, group});
+
+        // Keep every area aligned to 2 bytes so words can be read directly from the buffer
+        m_image_size += length + (length & 1);
+
+        return offset;
+    }
+
+    const std::vector<ReadRequest> &PollPlanner::requests(size_t group) const {
+        static const std::vector<ReadRequest> empty;
+
+        return group < m_requests.size() ? m_requests[group] : empty;
+    }
+
+    bool PollPlanner::plan(int pdu_size, int max_items) {
+        m_requests.clear();
+
+        // Maximum amount of data a single item may carry. Use an even number so chunks of word areas stay aligned.
+        const int max_chunk = (pdu_size - RESPONSE_HEADER_SIZE - RESPONSE_ITEM_SIZE) & ~1;
+        if (max_chunk <= 0 || pdu_size < REQUEST_HEADER_SIZE + REQUEST_ITEM_SIZE || max_items < 1) {
+            return false;
+        }
+
+        size_t groups = 0;
+        for (const auto &item : m_items) {
+            groups = std::max(groups, item.group + 1);
+        }
+        m_requests.resize(groups);
+
+        for (size_t group = 0; group < groups; group++) {
+            auto &requests = m_requests[group];
+
+            int request_size = REQUEST_HEADER_SIZE;
+            int response_size = RESPONSE_HEADER_SIZE;
+
+            requests.emplace_back();
+
+            for (const auto &item : m_items) {
+                if (item.group != group) {
+                    continue;
+                }
+
+                // Split areas that do not fit into a single reply into multiple chunks
+                for (int done = 0; done < item.length;) {
+                    const int length = std::min(item.length - done, max_chunk);
+
+                    // Data of all items but the last one is padded to an even length
+                    const int item_response_size = RESPONSE_ITEM_SIZE + length + (length & 1);
+
+                    auto &current = requests.back();
+                    if (!current.items.empty()
+                        && (static_cast<int>(current.items.size()) >= max_items || request_size + REQUEST_ITEM_SIZE > pdu_size
+                            || response_size + item_response_size > pdu_size)) {
+                        requests.emplace_back();
+                        request_size = REQUEST_HEADER_SIZE;
+                        response_size = RESPONSE_HEADER_SIZE;
+                    }
+
+                    requests.back().items.push_back(
+                        {item.area, item.db, item.start + done, length, item.offset + done, item.group});
+                    request_size += REQUEST_ITEM_SIZE;
+                    response_size += item_response_size;
+
+                    done += length;
+                }
+            }
+
+            if (requests.back().items.empty()) {
+                requests.pop_back();
+            }
+        }
+
+        return true;
+    }
+}  // namespace PLC
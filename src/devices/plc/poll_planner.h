@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace PLC {
+    // ReadItem describes one contiguous memory area of the PLC that is read in a poll cycle. The data is copied to the
+    // process image buffer at the given offset.
+    struct ReadItem {
+        int area = 0;    // daveFlags, daveInputs, daveOutputs or daveDB
+        int db = 0;      // number of the data block, 0 for all other areas
+        int start = 0;   // first byte to read
+        int length = 0;  // number of bytes to read
+
+        size_t offset = 0;  // offset of the data in the process image buffer
+
+        size_t group = 0;  // items of different groups are never read in the same request
+    };
+
+    // ReadRequest is a group of items that is transferred in a single multi-variable read request (i.e. one round trip).
+    struct ReadRequest {
+        std::vector<ReadItem> items;
+    };
+
+    // The PollPlanner collects all memory areas that have to be read in a poll cycle and packs them into as few read requests
+    // as possible. A request is only split when the request or its reply would not fit into the negotiated PDU size or the
+    // maximum number of items per request is reached. Areas that are larger than a single PDU are read in chunks.
+    //
+    // Areas can be assigned to groups (e.g. scan classes that are polled at different rates). Every group is planned
+    // separately, so the requests of one group can be executed without reading the areas of the others.
+    class PollPlanner {
+    public:
+        // Removes all areas and requests
+        void clear();
+
+        // Adds a memory area to the plan. Returns the offset of the area in the process image buffer.
+        size_t add(int area, int db, int start, int length, size_t group = 0);
+
+        // Groups all added areas into read requests for the given PDU size (as negotiated with the PLC) and maximum
+        // number of items per request. Returns false if the PDU size is too small to hold even a single item.
+        bool plan(int pdu_size, int max_items);
+
+        // Requests of the given group
+        const std::vector<ReadRequest> &requests(size_t group = 0) const;
+
+        // Number of groups (highest group an area was added to + 1)
+        size_t group_count() const noexcept { return m_requests.size(); }
+
+        // Size of the buffer that is needed to hold the data of all areas
+        size_t image_size() const noexcept { return m_image_size; }
+
+        // Sizes of the different parts of S7 read requests and replies in bytes, used to calculate how many items fit into
+        // a single PDU
+        static constexpr int REQUEST_HEADER_SIZE = 12;   // header (10) + function code and item count (2)
+        static constexpr int REQUEST_ITEM_SIZE = 12;     // address specification per item
+        static constexpr int RESPONSE_HEADER_SIZE = 14;  // header (12) + function code and item count (2)
+        static constexpr int RESPONSE_ITEM_SIZE = 4;     // return code, transport size and length per item
+
+    private:
+        std::vector<ReadItem> m_items;
+        std::vector<std::vector<ReadRequest>> m_requests;  // per group
+
+        size_t m_image_size = 0;
+    };
+}  // namespace PLC
@@ -1,8 +1,12 @@
 #include "s7.h"
 
 #include "stacktrace.h"
+#include "util/byteswap.h"
 #include "util/util.h"
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
 #include <unordered_map>
 
 namespace PLC {
@@ -37,14 +41,35 @@ namespace PLC {
 
     S7::S7() {
         m_connector = std::make_unique<EthernetConnector>();
+        // libnodave talks to the socket directly from the poll thread (see start), so it must not be owned by an I/O thread
+        m_connector->set_io_thread_enabled(false);
 
         // Default poll intervall of 1000ms
         m_poll_timer.setInterval(1000);
 
         QObject::connect(&m_poll_timer, &QTimer::timeout, this, &S7::poll);
+
+        // Our signals are emitted on the poll thread, so they are delivered via queued connections
+        qRegisterMetaType<std::string>("std::string");
+        qRegisterMetaType<uint16_t>("uint16_t");
+        qRegisterMetaType<uint32_t>("uint32_t");
+
+        m_poll_thread.setObjectName("S7 poll thread");
+
+        std::atomic_store(&m_snapshot, std::shared_ptr<const Snapshot>(std::make_shared<Snapshot>()));
     }
 
-    S7::~S7() { disconnect(); }
+    S7::~S7() {
+        if (m_poll_thread.isRunning()) {
+            // The timer lives on the poll thread and has to be stopped there
+            QMetaObject::invokeMethod(&m_poll_timer, &QTimer::stop, Qt::BlockingQueuedConnection);
+
+            m_poll_thread.quit();
+            m_poll_thread.wait();
+        }
+
+        disconnect();
+    }
 
     void S7::init(std::shared_ptr<config::Segment> settings) {
         // Let the connector load its settings
@@ -65,153 +90,303 @@ namespace PLC {
             m_plc_settings.interface = *interface;
         }
 
+        // The default scan class uses the poll interval, further classes are set up in the scanclasses segment
+        m_scan_classes.clear();
+        m_scan_classes.emplace_back();
+        m_scan_classes[0].name = "default";
         if (auto pollinterval = settings->get<int>("pollinterval")) {
-            m_poll_timer.setInterval(*pollinterval);
+            m_scan_classes[0].interval = *pollinterval;
         }
 
-        // Load flags
-        auto flags = settings->get_all("flags");
-        for (const auto &flag : flags) {
-            auto tokens = util::split(flag.second, '.', false);
-            if (!tokens || tokens->size() != 2) {
-                logging::get_log("main")->warn("S7: wrong flag address format encountered, got '{0}'", flag.second);
+        for (const auto &entry : settings->get_all("scanclasses")) {
+            auto interval = util::to_type<int>(entry.second);
+            if (!interval || *interval <= 0) {
+                logging::main_log()->warn("S7: invalid interval '{0}' for scan class '{1}'", entry.second, entry.first);
                 continue;
             }
 
-            auto addr_high = util::to_type<int>((*tokens)[0]);
-            auto addr_low = util::to_type<int>((*tokens)[1]);
-            if (!addr_high || !addr_low) {
-                logging::get_log("main")->warn("S7: non-integer flag address part encountered, got '{0}' for flag '{1}'",
-                                               flag.second, flag.first);
-                continue;
-            }
+            ScanClass scan_class;
+            scan_class.name = entry.first;
+            scan_class.interval = *interval;
+            m_scan_classes.push_back(std::move(scan_class));
+        }
 
-            m_flag_map[flag.first].address = *addr_high * 8 + *addr_low;
+        // The timer runs at the fastest interval, slower classes are only read in some of the cycles
+        int interval = m_scan_classes[0].interval;
+        for (const auto &scan_class : m_scan_classes) {
+            interval = std::min(interval, scan_class.interval);
         }
+        m_poll_timer.setInterval(interval);
 
-        // Load inputs
-        auto inputs = settings->get_all("inputs");
-        for (const auto &input : inputs) {
-            auto tokens = util::split(input.second, '.', false);
-            if (!tokens || tokens->size() != 2) {
-                logging::get_log("main")->warn("S7: wrong input address format encountered, got '{0}'", input.second);
-                continue;
+        if (auto writewindow = settings->get<int>("writewindow")) {
+            m_write_window = *writewindow;
+        }
+
+        // Load tags
+        load_states(settings, "flags", "flagranges", Area::Flag, m_flag_tags, m_flag_diff, m_flag_image);
+        load_states(settings, "inputs", "inputranges", Area::Input, m_input_tags, m_input_diff, m_input_image);
+        load_states(settings, "outputs", "outputranges", Area::Output, m_output_tags, m_output_diff, m_output_image);
+        load_db_tags(settings, "dbwords", Area::DBword, m_dbword_tags, m_db_datawords);
+        load_db_tags(settings, "dbdwords", Area::DBdword, m_dbdword_tags, m_db_datadwords);
+
+        build_poll_plan();
+
+        // Publish an empty snapshot with the final layout so readers never see missing data blocks
+        publish_snapshot();
+    }
+
+    std::optional<TagSettings> S7::parse_tag(const std::string &name, const std::string &value, Area area) const {
+        auto fields = util::split(value, ',', true);
+        if (!fields || fields->empty() || fields->size() > 3) {
+            logging::main_log()->warn("S7: wrong {0} format encountered, got '{1}' for {0} '{2}'", get_name(area), value, name);
+            return std::nullopt;
+        }
+
+        for (auto &field : *fields) {
+            util::trim_both(field);
+        }
+
+        auto tokens = util::split((*fields)[0], '.', false);
+        if (!tokens || tokens->size() != 2) {
+            logging::main_log()->warn("S7: wrong {0} address format encountered, got '{1}'", get_name(area), (*fields)[0]);
+            return std::nullopt;
+        }
+
+        auto addr_high = util::to_type<int>((*tokens)[0]);
+        auto addr_low = util::to_type<int>((*tokens)[1]);
+        if (!addr_high || !addr_low) {
+            logging::main_log()->warn("S7: non-integer {0} address part encountered, got '{1}' for {0} '{2}'",
+                                      get_name(area), (*fields)[0], name);
+            return std::nullopt;
+        }
+
+        TagSettings tag;
+        tag.address = std::make_pair(*addr_high, *addr_low);
+
+        // Optional scan class, the default class is used if it is empty or unknown
+        if (fields->size() > 1 && !(*fields)[1].empty()) {
+            auto it = std::find_if(m_scan_classes.begin(), m_scan_classes.end(),
+                                   [&](const ScanClass &scan_class) { return scan_class.name == (*fields)[1]; });
+            if (it == m_scan_classes.end()) {
+                logging::main_log()->warn("S7: unknown scan class '{0}' for {1} '{2}', using the default class",
+                                          (*fields)[1], get_name(area), name);
+            } else {
+                tag.scan_class = static_cast<size_t>(it - m_scan_classes.begin());
             }
+        }
 
-            auto addr_high = util::to_type<int>((*tokens)[0]);
-            auto addr_low = util::to_type<int>((*tokens)[1]);
-            if (!addr_high || !addr_low) {
-                logging::get_log("main")->warn("S7: non-integer input address part encountered, got '{0}' for input '{1}'",
-                                               input.second, input.first);
-                continue;
+        // Optional deadband, only data block values have one
+        if (fields->size() > 2 && !(*fields)[2].empty()) {
+            auto deadband = util::to_type<long>((*fields)[2]);
+            if (area != Area::DBword && area != Area::DBdword) {
+                logging::main_log()->warn("S7: deadband of {0} '{1}' ignored, only data block values have one",
+                                          get_name(area), name);
+            } else if (!deadband || *deadband < 0) {
+                logging::main_log()->warn("S7: invalid deadband '{0}' for {1} '{2}' ignored", (*fields)[2], get_name(area), name);
+            } else {
+                tag.deadband = static_cast<uint32_t>(*deadband);
             }
+        }
+
+        return tag;
+    }
 
-            m_input_map[input.first].address = *addr_high * 8 + *addr_low;
+    size_t S7::faster_scan_class(size_t a, size_t b) const {
+        return m_scan_classes[b].interval < m_scan_classes[a].interval ? b : a;
+    }
+
+    bool S7::add_tag_name(const std::string &name, Area area, size_t index) {
+        if (index > std::numeric_limits<uint16_t>::max()) {
+            logging::main_log()->warn("S7: too many {0}s, ignoring '{1}'", get_name(area), name);
+            return false;
+        }
+
+        if (!m_tag_index[static_cast<size_t>(area)].emplace(name, static_cast<uint16_t>(index)).second) {
+            logging::main_log()->warn("S7: duplicate {0} '{1}' ignored", get_name(area), name);
+            return false;
         }
 
-        // Load outputs
-        auto outputs = settings->get_all("outputs");
-        for (const auto &output : outputs) {
-            auto tokens = util::split(output.second, '.', false);
-            if (!tokens || tokens->size() != 2) {
-                logging::get_log("main")->warn("S7: wrong flag address format encountered, got '{0}'", output.second);
+        return true;
+    }
+
+    void S7::load_states(std::shared_ptr<config::Segment> settings, const std::string &key, const std::string &ranges_key,
+                         Area area, std::vector<State> &tags, BitDiff &diff, BitImage &image) {
+        // Parse all addresses first, the image might have to cover them
+        struct Entry {
+            std::string name;
+            int address;
+            size_t scan_class;
+        };
+        std::vector<Entry> addresses;
+        int highest_byte = -1;
+
+        for (const auto &entry : settings->get_all(key)) {
+            auto tag = parse_tag(entry.first, entry.second, area);
+            if (!tag) {
                 continue;
             }
 
-            auto addr_high = util::to_type<int>((*tokens)[0]);
-            auto addr_low = util::to_type<int>((*tokens)[1]);
-            if (!addr_high || !addr_low) {
-                logging::get_log("main")->warn("S7: non-integer output address part encountered, got '{0}' for output '{1}'",
-                                               output.second, output.first);
+            const int bit = tag->address.first * 8 + tag->address.second;
+            if (bit < 0) {
+                logging::main_log()->warn("S7: negative {0} address encountered, got '{1}' for {0} '{2}'", get_name(area),
+                                          entry.second, entry.first);
                 continue;
             }
 
-            m_output_map[output.first].address = *addr_high * 8 + *addr_low;
+            addresses.push_back({entry.first, bit, tag->scan_class});
+            highest_byte = std::max(highest_byte, bit / 8);
         }
 
-        // Load dbwords
-        // We also need to find the highest length (address_data/2 + 1) for all address_db's. We do this by using a map that maps
-        // the address_db to the address_data.
-        std::unordered_map<int, int> addresses;
+        image.clear();
+        if (auto ranges = settings->get<std::string>(ranges_key)) {
+            auto parsed = BitImage::parse_ranges(*ranges);
+            if (!parsed) {
+                logging::main_log()->warn("S7: wrong {0} range format encountered, got '{1}'", get_name(area), *ranges);
+            } else {
+                for (const auto &range : *parsed) {
+                    if (!image.add_range(range.first, range.second)) {
+                        logging::main_log()->warn("S7: {0} range {1}-{2} is invalid or overlaps another range",
+                                                  get_name(area), range.first, range.first + range.second - 1);
+                    }
+                }
+            }
+        } else if (highest_byte >= 0) {
+            // Without explicit ranges we read everything up to the highest configured address
+            image.add_range(0, highest_byte + 1);
+        }
 
-        auto dbwords = settings->get_all("dbwords");
-        for (const auto &dbword : dbwords) {
-            auto tokens = util::split(dbword.second, '.', false);
-            if (!!tokens || tokens->size() != 2) {
-                logging::get_log("main")->warn("S7: wrong dbword address format encountered, got '{0}'", dbword.second);
+        // Every range is polled in the fastest scan class of its tags
+        std::vector<std::optional<size_t>> range_classes(image.ranges().size());
+
+        for (const auto &address : addresses) {
+            auto range = image.find_range(address.address);
+            if (!range) {
+                logging::main_log()->warn("S7: {0} '{1}' (address {2}.{3}) is not covered by the configured ranges",
+                                          get_name(area), address.name, address.address / 8, address.address % 8);
                 continue;
             }
 
-            auto addr_db = util::to_type<int>((*tokens)[0]);
-            auto addr_data = util::to_type<int>((*tokens)[1]);
-            if (!addr_db || !addr_data) {
-                logging::get_log("main")->warn("S7: non-integer dbword address part encountered, got '{0}' for dbword '{1}'",
-                                               dbword.second, dbword.first);
+            if (!add_tag_name(address.name, area, tags.size())) {
                 continue;
             }
 
-            m_dbword_map[dbword.first].address_db = *addr_db;
-            m_dbword_map[dbword.first].address_data = *addr_data;
+            const size_t bit = *image.find_bit(address.address);
+            diff.add(bit, static_cast<uint16_t>(tags.size()));
+            tags.push_back({address.address, false, address.name, bit});
 
-            if (addresses.count(*addr_db) == 0) {
-                addresses[*addr_db] = *addr_data;
-            } else if (addresses[*addr_db] < *addr_data) {
-                addresses[*addr_db] = *addr_data;
-            }
+            auto &range_class = range_classes[*range];
+            range_class = range_class ? faster_scan_class(*range_class, address.scan_class) : address.scan_class;
         }
 
-        for (const auto &entry : addresses) {
-            m_db_datawords.push_back(DBDataword(entry.first, entry.second / 2 + 1));
+        diff.build();
+
+        for (size_t i = 0; i < range_classes.size(); i++) {
+            image.ranges()[i].scan_class = range_classes[i].value_or(0);
         }
-        addresses.clear();
+    }
+
+    template <typename T>
+    void S7::load_db_tags(std::shared_ptr<config::Segment> settings, const std::string &key, Area area,
+                          std::vector<DB<T>> &tags, std::vector<DBVector<T>> &dbs) {
+        // We also need to find the highest length (address_data/sizeof(T) + 1) for all address_db's. We do this by using a
+        // map that maps the address_db to the address_data.
+        std::unordered_map<int, int> addresses;
+
+        // Scan class of every tag, needed for the scan class of the data blocks
+        std::vector<size_t> tag_classes;
 
-        // Load dbdwords
-        // Same as above
-        auto dbdwords = settings->get_all("dbdwords");
-        for (const auto &dbdword : dbdwords) {
-            auto tokens = util::split(dbdword.second, '.', false);
-            if (!tokens || tokens->size() != 2) {
-                logging::get_log("main")->warn("S7: wrong dbdword address format encountered, got '{0}'", dbdword.second);
+        for (const auto &entry : settings->get_all(key)) {
+            auto tag_settings = parse_tag(entry.first, entry.second, area);
+            if (!tag_settings || !add_tag_name(entry.first, area, tags.size())) {
                 continue;
             }
 
-            auto addr_db = util::to_type<int>((*tokens)[0]);
-            auto addr_data = util::to_type<int>((*tokens)[1]);
-            if (!addr_db || !addr_data) {
-                logging::get_log("main")->warn("S7: non-integer dbdword address part encountered, got '{0}' for dbdword '{1}'",
-                                               dbdword.second, dbdword.first);
-                continue;
+            DB<T> tag;
+            tag.name = entry.first;
+            tag.address_db = tag_settings->address.first;
+            tag.address_data = tag_settings->address.second;
+            tag.deadband = static_cast<T>(std::min<uint32_t>(tag_settings->deadband, std::numeric_limits<T>::max()));
+            tags.push_back(tag);
+            tag_classes.push_back(tag_settings->scan_class);
+
+            auto it = addresses.find(tag.address_db);
+            if (it == addresses.end()) {
+                addresses.emplace(tag.address_db, tag.address_data);
+            } else if (it->second < tag.address_data) {
+                it->second = tag.address_data;
             }
+        }
 
-            m_dbdword_map[dbdword.first].address_db = *addr_db;
-            m_dbdword_map[dbdword.first].address_data = *addr_data;
+        for (const auto &entry : addresses) {
+            dbs.push_back(DBVector<T>(entry.first, entry.second / static_cast<int>(sizeof(T)) + 1));
+        }
+
+        // Every data block is polled in the fastest scan class of its tags
+        std::vector<std::optional<size_t>> db_classes(dbs.size());
+
+        for (size_t index = 0; index < tags.size(); index++) {
+            auto &tag = tags[index];
 
-            if (addresses.count(*addr_db) == 0) {
-                addresses[*addr_db] = *addr_data;
-            } else if (addresses[*addr_db] < *addr_data) {
-                addresses[*addr_db] = *addr_data;
+            for (size_t i = 0; i < dbs.size(); i++) {
+                if (dbs[i].address == tag.address_db) {
+                    tag.index = i;
+                    dbs[i].tags.add(tag.address_data / sizeof(T), static_cast<uint16_t>(index));
+
+                    db_classes[i] = db_classes[i] ? faster_scan_class(*db_classes[i], tag_classes[index]) : tag_classes[index];
+                    break;
+                }
             }
         }
 
-        for (const auto &entry : addresses) {
-            m_db_datadwords.push_back(DBDatadword(entry.first, entry.second / 4 + 1));
+        for (size_t i = 0; i < dbs.size(); i++) {
+            dbs[i].scan_class = db_classes[i].value_or(0);
+        }
+
+        for (auto &db : dbs) {
+            db.tags.build();
         }
     }
 
+    void S7::build_poll_plan() {
+        m_poll_planner.clear();
+
+        for (auto &range : m_flag_image.ranges()) {
+            range.offset = m_poll_planner.add(daveFlags, 0, range.start, range.length, range.scan_class);
+        }
+
+        for (auto &range : m_input_image.ranges()) {
+            range.offset = m_poll_planner.add(daveInputs, 0, range.start, range.length, range.scan_class);
+        }
+
+        for (auto &range : m_output_image.ranges()) {
+            range.offset = m_poll_planner.add(daveOutputs, 0, range.start, range.length, range.scan_class);
+        }
+
+        for (auto &db : m_db_datawords) {
+            db.offset = m_poll_planner.add(daveDB, db.address, 0, db.length * 2, db.scan_class);
+        }
+
+        for (auto &db : m_db_datadwords) {
+            db.offset = m_poll_planner.add(daveDB, db.address, 0, db.length * 4, db.scan_class);
+        }
+
+        m_process_image.assign(m_poll_planner.image_size(), 0);
+    }
+
     bool S7::connect() {
         if (m_plc_settings.protocol == Nodave::protocol::undefined || m_plc_settings.speed == Nodave::speed::undefined
             || m_plc_settings.interface.empty()) {
-            logging::get_log("main")->error(
+            logging::main_log()->error(
                 "S7: not all settings were set up. Current values:\n\tprotocol: {0}\n\tspeed: {1}\n\tinterface: '{2}'",
                 m_plc_settings.protocol, m_plc_settings.speed, m_plc_settings.interface);
             return false;
         }
 
         if (!m_connector->connect()) {
-            logging::get_log("main")->error("S7: unable to connect to the PLC. Connector info:\n  {0}", m_connector->info());
+            logging::main_log()->error("S7: unable to connect to the PLC. Connector info:\n  {0}", m_connector->info());
             return false;
         } else {
-            logging::get_log("main")->debug("S7: connected. Connector info:\n  {0}", m_connector->info());
+            logging::main_log()->debug("S7: connected. Connector info:\n  {0}", m_connector->info());
         }
 
         int tcp_descriptor = m_connector->get_descriptor();
@@ -224,7 +399,7 @@ namespace PLC {
 
         // Currently daveNewInterface fails only if calloc fails
         if (!m_plc_interface) {
-            logging::get_log("main")->error("S7: interface generation failed");
+            logging::main_log()->error("S7: interface generation failed");
             return false;
         }
 
@@ -232,13 +407,30 @@ namespace PLC {
         m_plc_connection = daveNewConnection(m_plc_interface, 0, 0, 0);
 
         if (int ret = daveConnectPLC(m_plc_connection); ret != daveResOK) {
-            logging::get_log("main")->error("S7: connection to PCL failed: {0}", std::string(daveStrerror(ret)));
+            logging::main_log()->error("S7: connection to PCL failed: {0}", std::string(daveStrerror(ret)));
+            return false;
+        }
+
+        // Now that the PDU size is negotiated we can group the poll areas into read requests
+        int pdu_size = daveGetMaxPDULen(m_plc_connection);
+        if (pdu_size <= 0) {
+            pdu_size = S7_DEFAULT_PDU_SIZE;
+        }
+
+        if (!m_poll_planner.plan(pdu_size, S7_MAX_READ_ITEMS)) {
+            logging::main_log()->error("S7: unable to plan poll requests for a PDU size of {0}", pdu_size);
             return false;
         }
 
+        m_pdu_size = pdu_size;
         m_plc_connected = true;
 
-        logging::get_log("main")->debug("S7: connection successful");
+        size_t requests = 0;
+        for (size_t i = 0; i < m_poll_planner.group_count(); i++) {
+            requests += m_poll_planner.requests(i).size();
+        }
+        logging::main_log()->debug("S7: connection successful, PDU size {0}, {1} read request(s) for {2} scan class(es)",
+                                   pdu_size, requests, m_scan_classes.size());
         return true;
     }
 
@@ -260,401 +452,597 @@ namespace PLC {
 
     void S7::start() {
         if (!m_plc_connected) {
-            logging::get_log("main")->error("S7: unable to start: not connected to the S7");
+            logging::main_log()->error("S7: unable to start: not connected to the S7");
             return;
         }
 
-        m_poll_timer.start();
+        if (!m_poll_thread.isRunning()) {
+            // From now on everything that talks to the PLC lives on the poll thread
+            m_connector->moveToThread(&m_poll_thread);
+            m_connector->move_to_thread(&m_poll_thread);
+            m_poll_timer.moveToThread(&m_poll_thread);
+            moveToThread(&m_poll_thread);
 
-        logging::get_log("main")->debug("S7 timer started");
+            m_poll_thread.start();
+        }
+
+        QMetaObject::invokeMethod(&m_poll_timer, qOverload<>(&QTimer::start), Qt::QueuedConnection);
+
+        logging::main_log()->debug("S7 timer started");
     }
 
-    void S7::stop() { m_poll_timer.stop(); }
+    void S7::stop() { QMetaObject::invokeMethod(&m_poll_timer, &QTimer::stop, Qt::QueuedConnection); }
 
-    void S7::set_dbword(std::string name, uint16_t data) {
-        if (!m_plc_connected) {
-            logging::get_log("main")->error("S7: unable to set db-value {0}: not connected to the S7", name);
-            return;
+    std::shared_ptr<const Snapshot> S7::get_snapshot() const { return std::atomic_load(&m_snapshot); }
+
+    std::optional<Tag> S7::find_tag(Area area, const std::string &name) const {
+        const auto &index = m_tag_index[static_cast<size_t>(area)];
+
+        auto it = index.find(name);
+        if (it == index.end()) {
+            return std::nullopt;
         }
 
-        if (m_dbword_map.count(name) == 0) {
-            logging::get_log("main")->error("S7: unknown DBword {0}", name);
-            return;
+        return Tag{area, it->second};
+    }
+
+    size_t S7::tag_count(Area area) const {
+        switch (area) {
+        case Area::Flag:
+            return m_flag_tags.size();
+        case Area::Input:
+            return m_input_tags.size();
+        case Area::Output:
+            return m_output_tags.size();
+        case Area::DBword:
+            return m_dbword_tags.size();
+        case Area::DBdword:
+            return m_dbdword_tags.size();
+        }
+
+        return 0;
+    }
+
+    bool S7::check_tag(Tag tag, Area area) const {
+        if (tag.area != area || tag.index >= tag_count(area)) {
+            logging::main_log()->error("S7: invalid {0} tag (area: {1}, index: {2})", get_name(area), get_name(tag.area),
+                                       tag.index);
+            return false;
         }
 
-        DBword db = m_dbword_map[name];
-        data = util::convert_endian(data);
+        return true;
+    }
 
-        if (int ret = daveWriteBytes(m_plc_connection, daveDB, db.address_db, db.address_data, 2, &data); ret != daveResOK) {
-            logging::get_log("main")->error(
-                "S7: writing DBword failed:\n\tname: {0}\n\tDB address: {1}\n\tvalue address: {2}\n\terror: {3}", name,
-                db.address_db, db.address_data, std::string(daveStrerror(ret)));
+    std::future<bool> S7::set_dbword(const std::string &name, uint16_t data) {
+        if (auto tag = find_tag(Area::DBword, name)) {
+            return set_dbword(*tag, data);
         }
+
+        logging::main_log()->error("S7: unknown DBword {0}", name);
+        return make_ready_future(false);
     }
 
-    void S7::set_dbdword(std::string name, uint32_t data) {
+    std::future<bool> S7::set_dbword(Tag tag, uint16_t data) {
+        if (!check_tag(tag, Area::DBword)) {
+            return make_ready_future(false);
+        }
+
+        const auto &dbword = m_dbword_tags[tag.index];
         if (!m_plc_connected) {
-            logging::get_log("main")->error("S7: unable to set db-value {0}: not connected to the S7", name);
-            return;
+            logging::main_log()->error("S7: unable to set db-value {0}: not connected to the S7", dbword.name);
+            return make_ready_future(false);
         }
 
-        if (m_dbdword_map.count(name) == 0) {
-            logging::get_log("main")->error("S7: unknown DBword {0}", name);
-            return;
+        auto future = m_write_queue.write_bytes(daveDB, dbword.address_db, dbword.address_data,
+                                                {static_cast<uint8_t>(data >> 8), static_cast<uint8_t>(data)});
+        if (!future) {
+            logging::main_log()->error("S7: unable to set db-value {0}: it overlaps another queued write", dbword.name);
+            return make_ready_future(false);
         }
+        schedule_write_flush();
 
-        DBdword db = m_dbdword_map[name];
-        data = util::convert_endian(data);
+        return std::move(*future);
+    }
 
-        if (int ret = daveWriteBytes(m_plc_connection, daveDB, db.address_db, db.address_data, 4, &data); ret != daveResOK) {
-            logging::get_log("main")->error(
-                "S7: writing DBdword failed:\n\tname: {0}\n\tDB address: {1}\n\tvalue address: {2}\n\terror: {3}", name,
-                db.address_db, db.address_data, std::string(daveStrerror(ret)));
+    std::future<bool> S7::set_dbdword(const std::string &name, uint32_t data) {
+        if (auto tag = find_tag(Area::DBdword, name)) {
+            return set_dbdword(*tag, data);
         }
+
+        logging::main_log()->error("S7: unknown DBdword {0}", name);
+        return make_ready_future(false);
     }
 
-    uint16_t S7::get_dbword(std::string name) {
+    std::future<bool> S7::set_dbdword(Tag tag, uint32_t data) {
+        if (!check_tag(tag, Area::DBdword)) {
+            return make_ready_future(false);
+        }
+
+        const auto &dbdword = m_dbdword_tags[tag.index];
         if (!m_plc_connected) {
-            logging::get_log("main")->error("S7: unable to get db-value {0}: not connected to the S7", name);
-            return 0;
+            logging::main_log()->error("S7: unable to set db-value {0}: not connected to the S7", dbdword.name);
+            return make_ready_future(false);
         }
 
-        if (m_dbword_map.count(name) == 0) {
-            logging::get_log("main")->error("S7: unknown DBword {0}", name);
-            return 0;
+        auto future = m_write_queue.write_bytes(daveDB, dbdword.address_db, dbdword.address_data,
+                                                {static_cast<uint8_t>(data >> 24), static_cast<uint8_t>(data >> 16),
+                                                 static_cast<uint8_t>(data >> 8), static_cast<uint8_t>(data)});
+        if (!future) {
+            logging::main_log()->error("S7: unable to set db-value {0}: it overlaps another queued write", dbdword.name);
+            return make_ready_future(false);
         }
+        schedule_write_flush();
 
-        return m_dbword_map[name].data;
+        return std::move(*future);
     }
 
-    uint32_t S7::get_dbdword(std::string name) {
-        if (!m_plc_connected) {
-            logging::get_log("main")->error("S7: unable to get db-value {0}: not connected to the S7", name);
+    uint16_t S7::get_dbword(const std::string &name) {
+        if (auto tag = find_tag(Area::DBword, name)) {
+            return get_dbword(*tag);
+        }
+
+        logging::main_log()->error("S7: unknown DBword {0}", name);
+        return 0;
+    }
+
+    uint16_t S7::get_dbword(Tag tag) {
+        if (!check_tag(tag, Area::DBword)) {
             return 0;
         }
 
-        if (m_dbdword_map.count(name) == 0) {
-            logging::get_log("main")->error("S7: unknown DBdword {0}", name);
+        const auto &dbword = m_dbword_tags[tag.index];
+        if (!m_plc_connected) {
+            logging::main_log()->error("S7: unable to get db-value {0}: not connected to the S7", dbword.name);
             return 0;
         }
 
-        return m_dbdword_map[name].data;
+        return get_snapshot()->datawords[dbword.index][dbword.address_data / 2];
     }
 
-    void S7::set_flag(std::string name, bool state) {
-        if (!m_plc_connected) {
-            logging::get_log("main")->error("S7: unable to set flag {0}: not connected to the S7", name);
-            return;
+    uint32_t S7::get_dbdword(const std::string &name) {
+        if (auto tag = find_tag(Area::DBdword, name)) {
+            return get_dbdword(*tag);
         }
 
-        if (m_flag_map.count(name) == 0) {
-            logging::get_log("main")->error("S7: unknown flag {0}", name);
-            return;
-        }
+        logging::main_log()->error("S7: unknown DBdword {0}", name);
+        return 0;
+    }
 
-        if (!poll_flags()) {
-            logging::get_log("main")->warn("S7: unable to set flag {0}: unable to poll flags", name);
-            return;
+    uint32_t S7::get_dbdword(Tag tag) {
+        if (!check_tag(tag, Area::DBdword)) {
+            return 0;
         }
 
-        uint64_t states = m_flags;
-        if (state) {
-            states |= 1i64 << m_flag_map[name].address;
-        } else {
-            states &= ~(1i64 << m_flag_map[name].address);
+        const auto &dbdword = m_dbdword_tags[tag.index];
+        if (!m_plc_connected) {
+            logging::main_log()->error("S7: unable to get db-value {0}: not connected to the S7", dbdword.name);
+            return 0;
         }
-        if (int ret = daveWriteBytes(m_plc_connection, daveFlags, 0, 0, 6, &states); ret != daveResOK) {
-            logging::get_log("main")->error("S7: writing flag failed:\n\tname: {0}\n\taddress: {1}\n\terror: {2}", name,
-                                            m_flag_map[name].address, std::string(daveStrerror(ret)));
+
+        return get_snapshot()->datadwords[dbdword.index][dbdword.address_data / 4];
+    }
+
+    std::future<bool> S7::set_flag(const std::string &name, bool state) {
+        if (auto tag = find_tag(Area::Flag, name)) {
+            return set_flag(*tag, state);
         }
+
+        logging::main_log()->error("S7: unknown flag {0}", name);
+        return make_ready_future(false);
     }
 
-    void S7::set_output(std::string name, bool state) {
+    std::future<bool> S7::set_flag(Tag tag, bool state) {
+        if (!check_tag(tag, Area::Flag)) {
+            return make_ready_future(false);
+        }
+
+        const auto &flag = m_flag_tags[tag.index];
         if (!m_plc_connected) {
-            logging::get_log("main")->error("S7: unable to set output {0}: not connected to the S7", name);
-            return;
+            logging::main_log()->error("S7: unable to set flag {0}: not connected to the S7", flag.name);
+            return make_ready_future(false);
         }
 
-        if (m_output_map.count(name) == 0) {
-            logging::get_log("main")->error("S7: unknown output {0}", name);
-            return;
+        // Bits are written directly, so there is no need to read the other flags first
+        auto future = m_write_queue.write_bit(daveFlags, flag.address, state);
+        schedule_write_flush();
+
+        return future;
+    }
+
+    std::future<bool> S7::set_output(const std::string &name, bool state) {
+        if (auto tag = find_tag(Area::Output, name)) {
+            return set_output(*tag, state);
         }
 
-        if (!poll_outputs()) {
-            logging::get_log("main")->warn("S7: unable to set output {0}: unable to poll outputs", name);
-            return;
+        logging::main_log()->error("S7: unknown output {0}", name);
+        return make_ready_future(false);
+    }
+
+    std::future<bool> S7::set_output(Tag tag, bool state) {
+        if (!check_tag(tag, Area::Output)) {
+            return make_ready_future(false);
         }
 
-        uint64_t states = m_outputs;
-        if (state) {
-            states |= 1i64 << m_output_map[name].address;
-        } else {
-            states &= ~(1i64 << m_output_map[name].address);
+        const auto &output = m_output_tags[tag.index];
+        if (!m_plc_connected) {
+            logging::main_log()->error("S7: unable to set output {0}: not connected to the S7", output.name);
+            return make_ready_future(false);
         }
-        if (int ret = daveWriteBytes(m_plc_connection, daveOutputs, 0, 0, 6, &states); ret != daveResOK) {
-            logging::get_log("main")->error("S7: writing output failed:\n\tname: {0}\n\taddress: {1}\n\terror: {2}", name,
-                                            m_flag_map[name].address, std::string(daveStrerror(ret)));
+
+        auto future = m_write_queue.write_bit(daveOutputs, output.address, state);
+        schedule_write_flush();
+
+        return future;
+    }
+
+    bool S7::get_flag(const std::string &name) {
+        if (auto tag = find_tag(Area::Flag, name)) {
+            return get_flag(*tag);
         }
+
+        logging::main_log()->error("S7: unknown flag {0}", name);
+        return false;
     }
 
-    bool S7::get_flag(std::string name) {
-        if (!m_plc_connected) {
-            logging::get_log("main")->error("S7: unable to get flag {0}: not connected to the S7", name);
+    bool S7::get_flag(Tag tag) {
+        if (!check_tag(tag, Area::Flag)) {
             return false;
         }
 
-        if (m_flag_map.count(name) == 0) {
-            logging::get_log("main")->error("S7: unknown flag {0}", name);
+        const auto &flag = m_flag_tags[tag.index];
+        if (!m_plc_connected) {
+            logging::main_log()->error("S7: unable to get flag {0}: not connected to the S7", flag.name);
             return false;
         }
 
-        return m_flag_map[name].state;
+        return test_bit(get_snapshot()->flags, flag.bit);
     }
 
-    bool S7::get_input(std::string name) {
-        if (!m_plc_connected) {
-            logging::get_log("main")->error("S7: unable to get input {0}: not connected to the S7", name);
+    bool S7::get_input(const std::string &name) {
+        if (auto tag = find_tag(Area::Input, name)) {
+            return get_input(*tag);
+        }
+
+        logging::main_log()->error("S7: unknown input {0}", name);
+        return false;
+    }
+
+    bool S7::get_input(Tag tag) {
+        if (!check_tag(tag, Area::Input)) {
             return false;
         }
 
-        if (m_input_map.count(name) == 0) {
-            logging::get_log("main")->error("S7: unknown input {0}", name);
+        const auto &input = m_input_tags[tag.index];
+        if (!m_plc_connected) {
+            logging::main_log()->error("S7: unable to get input {0}: not connected to the S7", input.name);
             return false;
         }
 
-        return m_input_map[name].state;
+        return test_bit(get_snapshot()->inputs, input.bit);
     }
 
-    bool S7::get_output(std::string name) {
-        if (!m_plc_connected) {
-            logging::get_log("main")->error("S7: unable to get output {0}: not connected to the S7", name);
+    bool S7::get_output(const std::string &name) {
+        if (auto tag = find_tag(Area::Output, name)) {
+            return get_output(*tag);
+        }
+
+        logging::main_log()->error("S7: unknown output {0}", name);
+        return false;
+    }
+
+    bool S7::get_output(Tag tag) {
+        if (!check_tag(tag, Area::Output)) {
             return false;
         }
 
-        if (m_output_map.count(name) == 0) {
-            logging::get_log("main")->error("S7: unknown output {0}", name);
+        const auto &output = m_output_tags[tag.index];
+        if (!m_plc_connected) {
+            logging::main_log()->error("S7: unable to get output {0}: not connected to the S7", output.name);
             return false;
         }
 
-        return m_output_map[name].state;
+        return test_bit(get_snapshot()->outputs, output.bit);
     }
 
     // clang-format off
     [[deprecated("This is only kept for direct translation of the old version, replace it with set_flag/_output")]]
-    void S7::set_io(std::string name, bool state) {
+    void S7::set_io(const std::string &name, bool state) {
         if (!m_plc_connected) {
-            logging::get_log("main")->error("S7: unable to set io {0}: not connected to the S7", name);
+            logging::main_log()->error("S7: unable to set io {0}: not connected to the S7", name);
             return;
         }
 
-        if (m_output_map.count(name) != 0) {
-            set_output(name, state);
+        if (auto tag = find_tag(Area::Output, name)) {
+            set_output(*tag, state);
             return;
         }
 
-        if (m_flag_map.count(name) != 0) {
-            set_flag(name, state);
+        if (auto tag = find_tag(Area::Flag, name)) {
+            set_flag(*tag, state);
             return;
         }
 
-        logging::get_log("main")->error("S7: unknown flag or output {0}", name);
+        logging::main_log()->error("S7: unknown flag or output {0}", name);
     }
     
     [[deprecated("This is only kept for direct translation of the old version, replace it with get_input/_flag/_output")]]
-    bool S7::get_io(std::string name) {
+    bool S7::get_io(const std::string &name) {
         bool state = false;
 
         if (!m_plc_connected) {
-            logging::get_log("main")->error("S7: unable to get io {0}: not connected to the S7", name);
+            logging::main_log()->error("S7: unable to get io {0}: not connected to the S7", name);
             return false;
         }
 
-        if (m_flag_map.count(name) != 0) {
-            state = get_flag(name);
-        } else if (m_input_map.count(name) != 0) {
-            state = get_input(name);
-        } else if (m_output_map.count(name) != 0) {
-            state = get_output(name);
+        if (auto tag = find_tag(Area::Flag, name)) {
+            state = get_flag(*tag);
+        } else if (auto tag = find_tag(Area::Input, name)) {
+            state = get_input(*tag);
+        } else if (auto tag = find_tag(Area::Output, name)) {
+            state = get_output(*tag);
         }
 
         return state;
     }
     // clang-format on
 
-    bool S7::poll_flags() {
-        if (!m_plc_connected) {
-            logging::get_log("main")->error("S7: unable to poll flags: not connected to the S7");
-            return false;
-        }
+    void S7::update_states(const BitImage &image, const BitDiff &diff, std::vector<State> &tags,
+                           void (S7::*changed)(std::string, bool)) {
+        // Only the tags of changed bits are visited
+        diff.diff(image.previous_words().data(), image.words().data(), image.word_count(),
+                  [this, &tags, changed](uint16_t index, bool state) {
+                      auto &tag = tags[index];
+                      tag.state = state;
+                      emit(this->*changed)(tag.name, state);
+                  });
+    }
 
-        uint64_t flags = 0;
-        if (int ret = daveReadBytes(m_plc_connection, daveFlags, 0, 0, 6, &flags); ret != daveResOK) {
-            logging::get_log("main")->error("S7: polling flags failed with error {0}", std::string(daveStrerror(ret)));
-            return false;
+    template <typename T>
+    void S7::update_db(DBVector<T> &db, const uint8_t *data, std::vector<DB<T>> &tags, void (S7::*changed)(std::string, T)) {
+        db.previous.swap(db.data);
+        util::load_big_endian(db.data.data(), data, db.data.size());
+
+        // Most of the time nothing changed at all
+        if (std::memcmp(db.data.data(), db.previous.data(), db.data.size() * sizeof(T)) == 0) {
+            return;
         }
 
-        if (flags != m_flags) {
-            m_flags = flags;
+        for (size_t i = 0; i < db.data.size(); i++) {
+            if (db.data[i] == db.previous[i]) {
+                continue;
+            }
 
-            // Iterate over all flags and see if they have changed..
-            for (auto &flag : m_flag_map) {
-                bool new_state = flags & (1i64 << flag.second.address);
-                if (flag.second.state != new_state) {
-                    flag.second.state = new_state;
-                    // ..and if they did, notify listeners
-                    emit flag_changed(flag.first, new_state);
+            // Notify listeners about the tags located at the changed value, unless the change is within their deadband
+            db.tags.for_each(i, [&](uint16_t index) {
+                auto &tag = tags[index];
+                if (tag.update(db.data[i])) {
+                    emit(this->*changed)(tag.name, tag.data);
                 }
-            }
+            });
         }
-
-        return true;
     }
 
-    bool S7::poll_inputs() {
-        if (!m_plc_connected) {
-            logging::get_log("main")->error("S7: unable to poll inputs: not connected to the S7");
-            return false;
-        }
+    bool S7::read_process_image(size_t scan_class) {
+        for (const auto &request : m_poll_planner.requests(scan_class)) {
+            PDU pdu;
+            // Zeroed, so daveFreeResults is safe whatever libnodave filled in
+            daveResultSet results{};
 
-        uint64_t inputs = 0;
-        if (int ret = daveReadBytes(m_plc_connection, daveInputs, 0, 0, 6, &inputs); ret != daveResOK) {
-            logging::get_log("main")->error("S7: polling inputs failed with error {0}", std::string(daveStrerror(ret)));
-            return false;
-        }
+            davePrepareReadRequest(m_plc_connection, &pdu);
+            for (const auto &item : request.items) {
+                daveAddVarToReadRequest(&pdu, item.area, item.db, item.start, item.length);
+            }
+
+            if (int ret = daveExecReadRequest(m_plc_connection, &pdu, &results); ret != daveResOK) {
+                logging::main_log()->error("S7: read request with {0} item(s) failed with error {1}", request.items.size(),
+                                           std::string(daveStrerror(ret)));
+                daveFreeResults(&results);
+                return false;
+            }
 
-        if (inputs != m_inputs) {
-            m_inputs = inputs;
+            // A short (or otherwise broken) answer of the PLC fails the whole request
+            if (!results.results || results.numResults != static_cast<int>(request.items.size())) {
+                logging::main_log()->error("S7: read request with {0} item(s) returned {1} result(s)", request.items.size(),
+                                           results.numResults);
+                daveFreeResults(&results);
+                return false;
+            }
 
-            // Iterate over all inputs and see if they have changed..
-            for (auto &input : m_flag_map) {
-                bool new_state = inputs & (1i64 << input.second.address);
-                if (input.second.state != new_state) {
-                    input.second.state = new_state;
-                    // ..and if they did, notify listeners
-                    emit input_changed(input.first, new_state);
+            bool success = true;
+            for (size_t i = 0; i < request.items.size(); i++) {
+                const auto &item = request.items[i];
+                const auto &result = results.results[i];
+
+                if (result.error != daveResOK || result.length < item.length) {
+                    logging::main_log()->error("S7: reading area {0:#x} (DB {1}, start {2}, length {3}) failed with error {4}",
+                                               item.area, item.db, item.start, item.length,
+                                               std::string(daveStrerror(result.error)));
+                    success = false;
+                    continue;
                 }
+
+                std::memcpy(m_process_image.data() + item.offset, result.bytes, item.length);
+            }
+
+            daveFreeResults(&results);
+
+            if (!success) {
+                return false;
             }
         }
 
         return true;
     }
 
-    bool S7::poll_outputs() {
+    void S7::poll() {
         if (!m_plc_connected) {
-            logging::get_log("main")->error("S7: unable to poll outputs: not connected to the S7");
-            return false;
+            logging::main_log()->error("S7: unable to poll: not connected to the S7");
+            return;
         }
 
-        uint64_t outputs = 0;
-        if (int ret = daveReadBytes(m_plc_connection, daveOutputs, 0, 0, 6, &outputs); ret != daveResOK) {
-            logging::get_log("main")->error("S7: polling outputs failed with error {0}", std::string(daveStrerror(ret)));
-            return false;
-        }
+        // Read the areas of all scan classes that are due. Timers may fire a bit early, so a class is also due if it
+        // would be due within half a timer interval.
+        const auto now = std::chrono::steady_clock::now();
+        const auto tolerance = std::chrono::milliseconds(m_poll_timer.interval() / 2);
 
-        if (outputs != m_outputs) {
-            m_outputs = outputs;
+        bool polled = false;
+        for (size_t i = 0; i < m_scan_classes.size(); i++) {
+            if (!m_scan_classes[i].due(now, tolerance)) {
+                continue;
+            }
 
-            // Iterate over all outputs and see if they have changed..
-            for (auto &output : m_output_map) {
-                bool new_state = outputs & (1i64 << output.second.address);
-                if (output.second.state != new_state) {
-                    output.second.state = new_state;
-                    // ..and if they did, notify listeners
-                    emit output_changed(output.first, new_state);
-                }
+            // One round trip per request instead of one per area
+            if (!read_process_image(i)) {
+                return;
             }
+            polled = true;
         }
 
-        return true;
-    }
+        if (!polled) {
+            return;
+        }
+
+        m_flag_image.load(m_process_image.data());
+        m_input_image.load(m_process_image.data());
+        m_output_image.load(m_process_image.data());
+
+        update_states(m_flag_image, m_flag_diff, m_flag_tags, &S7::flag_changed);
+        update_states(m_input_image, m_input_diff, m_input_tags, &S7::input_changed);
+        update_states(m_output_image, m_output_diff, m_output_tags, &S7::output_changed);
 
-    void S7::poll_dbwords() {
         for (auto &db : m_db_datawords) {
-            bool changed = false;
+            update_db(db, m_process_image.data() + db.offset, m_dbword_tags, &S7::dbword_changed);
+        }
 
-            std::vector<uint16_t> data(db.length);
-            if (auto ret = daveReadBytes(m_plc_connection, daveDB, db.address, 0, db.length * 2, data.data()); ret != daveResOK) {
-                logging::get_log("main")->error("S7: polling dbwords failed with error {0}", std::string(daveStrerror(ret)));
-                return;
-            }
+        for (auto &db : m_db_datadwords) {
+            update_db(db, m_process_image.data() + db.offset, m_dbdword_tags, &S7::dbdword_changed);
+        }
 
-            // Search for changed data
-            for (size_t i = 0; i < db.length; i++) {
-                data[i] = util::convert_endian(data[i]);
-                if (data[i] != db.data[i]) {
-                    db.data[i] = data[i];
-                    changed = true;
-                }
+        publish_snapshot();
+    }
+
+    void S7::publish_snapshot() {
+        // Reuse a snapshot no reader holds anymore. Only the pool itself references it then, and as it is not the current
+        // snapshot nobody can get hold of it again. Its buffers already have the right size, so nothing is allocated.
+        std::shared_ptr<Snapshot> snapshot;
+        for (const auto &pooled : m_snapshot_pool) {
+            if (pooled.use_count() == 1) {
+                // use_count is a relaxed load. Readers drop their reference with a release decrement, the fence makes their
+                // reads of the snapshot happen before we overwrite it.
+                std::atomic_thread_fence(std::memory_order_acquire);
+                snapshot = pooled;
+                break;
             }
+        }
 
-            if (changed) {
-                // Search for the corresponding entry in m_dbword_map and change the value
-                for (auto &dbmap : m_dbword_map) {
-                    if (dbmap.second.address_db == db.address) {
-                        int address_data = dbmap.second.address_data / 2;
-                        if (dbmap.second.data != data[address_data]) {
-                            dbmap.second.data = data[address_data];
-
-                            // Notify listeners about the changed dbword
-                            emit dbword_changed(dbmap.second.name, dbmap.second.data);
-                        }
-                    }
-                }
+        if (!snapshot) {
+            snapshot = std::make_shared<Snapshot>();
+            if (m_snapshot_pool.size() < static_cast<size_t>(S7_SNAPSHOT_POOL_SIZE)) {
+                m_snapshot_pool.push_back(snapshot);
             }
         }
+
+        snapshot->version = ++m_snapshot_version;
+        snapshot->timestamp = std::chrono::steady_clock::now();
+
+        snapshot->flags = m_flag_image.words();
+        snapshot->inputs = m_input_image.words();
+        snapshot->outputs = m_output_image.words();
+
+        snapshot->datawords.resize(m_db_datawords.size());
+        for (size_t i = 0; i < m_db_datawords.size(); i++) {
+            snapshot->datawords[i] = m_db_datawords[i].data;
+        }
+
+        snapshot->datadwords.resize(m_db_datadwords.size());
+        for (size_t i = 0; i < m_db_datadwords.size(); i++) {
+            snapshot->datadwords[i] = m_db_datadwords[i].data;
+        }
+
+        std::atomic_store(&m_snapshot, std::shared_ptr<const Snapshot>(std::move(snapshot)));
     }
 
-    void S7::poll_dbdwords() {
-        for (auto &db : m_db_datadwords) {
-            bool changed = false;
+    void S7::schedule_write_flush() {
+        // A flush is already pending, it will pick up this write as well
+        if (m_write_flush_scheduled.exchange(true)) {
+            return;
+        }
 
-            std::vector<uint32_t> data(db.length);
-            if (auto ret = daveReadBytes(m_plc_connection, daveDB, db.address, 0, db.length * 4, data.data()); ret != daveResOK) {
-                logging::get_log("main")->error("S7: polling dbdwords failed with error {0}", std::string(daveStrerror(ret)));
-                return;
+        if (!m_poll_thread.isRunning()) {
+            flush_writes();
+            return;
+        }
+
+        // Writes that are queued until the timer fires are merged into the same request(s)
+        run_on_poll_thread([this]() { QTimer::singleShot(m_write_window, this, &S7::flush_writes); });
+    }
+
+    void S7::flush_writes() {
+        // Reset first: writes queued from now on need another flush unless they are taken below
+        m_write_flush_scheduled = false;
+
+        if (!m_plc_connected) {
+            logging::main_log()->error("S7: unable to write: not connected to the S7");
+            m_write_queue.cancel();
+            return;
+        }
+
+        for (auto &request : m_write_queue.take(m_pdu_size, S7_MAX_WRITE_ITEMS)) {
+            PDU pdu;
+            daveResultSet results{};
+
+            davePrepareWriteRequest(m_plc_connection, &pdu);
+            for (auto &item : request.items) {
+                if (item.bit) {
+                    daveAddBitVarToWriteRequest(&pdu, item.area, item.db, item.start, 1, item.data.data());
+                } else {
+                    daveAddVarToWriteRequest(&pdu, item.area, item.db, item.start, static_cast<int>(item.data.size()),
+                                             item.data.data());
+                }
             }
 
-            // Search for changed data
-            for (size_t i = 0; i < db.length; i++) {
-                data[i] = util::convert_endian(data[i]);
-                if (data[i] != db.data[i]) {
-                    db.data[i] = data[i];
-                    changed = true;
+            if (int ret = daveExecWriteRequest(m_plc_connection, &pdu, &results); ret != daveResOK) {
+                logging::main_log()->error("S7: write request with {0} item(s) failed with error {1}", request.items.size(),
+                                           std::string(daveStrerror(ret)));
+                for (auto &item : request.items) {
+                    item.complete(false);
                 }
+                daveFreeResults(&results);
+                continue;
             }
 
-            if (changed) {
-                // Search for the corresponding entry in m_dbdword_map and change the value
-                for (auto &dbmap : m_dbdword_map) {
-                    if (dbmap.second.address_db == db.address) {
-                        int address_data = dbmap.second.address_data / 4;
-                        if (dbmap.second.data != data[address_data]) {
-                            dbmap.second.data = data[address_data];
-
-                            // Notify listeners about the changed dbdword
-                            emit dbdword_changed(dbmap.second.name, dbmap.second.data);
-                        }
-                    }
+            if (!results.results || results.numResults != static_cast<int>(request.items.size())) {
+                logging::main_log()->error("S7: write request with {0} item(s) returned {1} result(s)", request.items.size(),
+                                           results.numResults);
+                for (auto &item : request.items) {
+                    item.complete(false);
                 }
+                daveFreeResults(&results);
+                continue;
             }
+
+            for (size_t i = 0; i < request.items.size(); i++) {
+                auto &item = request.items[i];
+                const int error = results.results[i].error;
+
+                if (error != daveResOK) {
+                    logging::main_log()->error("S7: writing area {0:#x} (DB {1}, {2} {3}) failed with error {4}", item.area,
+                                               item.db, item.bit ? "bit" : "byte", item.start,
+                                               std::string(daveStrerror(error)));
+                }
+                item.complete(error == daveResOK);
+            }
+
+            daveFreeResults(&results);
         }
     }
 
-    void S7::poll() {
-        // TODO: remove this for production!
-        m_poll_timer.stop();
-        logging::get_log("main")->debug("S7 poll timer stopped (remove this)");
-
-        if (!m_plc_connected) {
-            logging::get_log("main")->error("S7: unable to poll: not connected to the S7");
+    void S7::run_on_poll_thread(std::function<void()> func) {
+        if (!m_poll_thread.isRunning() || QThread::currentThread() == &m_poll_thread) {
+            func();
             return;
         }
 
-        poll_flags();
-        poll_inputs();
-        poll_outputs();
-
-        poll_dbwords();
-        poll_dbdwords();
+        QMetaObject::invokeMethod(this, std::move(func), Qt::QueuedConnection);
     }
 }  // namespace PLC
\ No newline at end of file
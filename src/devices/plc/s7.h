@@ -1,7 +1,14 @@
 #pragma once
 
+#include "bit_diff.h"
+#include "bit_image.h"
 #include "db.h"
+#include "poll_planner.h"
+#include "scan_class.h"
+#include "snapshot.h"
 #include "state.h"
+#include "tag.h"
+#include "write_queue.h"
 
 #include "config/segment.h"
 #include "devices/connector/connector.h"
@@ -11,7 +18,14 @@
 
 #include "nodave_wrapper.h"
 
+#include <array>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <optional>
+
 #include <QObject>
+#include <QThread>
 #include <QTimer>
 
 // TODO: implement name to enum value
@@ -58,6 +72,13 @@ namespace PLC {
     // The S7 class provides an interface to the S7 PLC by Siemens currently used. It is a more or less direct conversion from
     // the old software and needs a major revamp. For example, DBword and DBDataword (and their dword-variants) should be merged,
     // there is no need to keep them seperated.
+    //
+    // Once started, all communication with the PLC happens on a dedicated poll thread, so a slow reply never blocks the
+    // caller. init, connect and disconnect have to be called while the S7 is not started. After every poll cycle a new
+    // Snapshot is published; the getters read from the latest snapshot and may be called from any thread. The setters
+    // may be called from any thread as well. They only queue the write, the poll thread flushes all writes queued within
+    // the write window in as few multi-variable write requests as possible. The returned future is set once the write
+    // was acknowledged by the PLC (or failed).
     class S7 : public QObject {
         Q_OBJECT
     public:
@@ -75,19 +96,36 @@ namespace PLC {
         void start();
         void stop();
 
-        void set_dbword(std::string name, uint16_t data);
-        void set_dbdword(std::string name, uint32_t data);
-        uint16_t get_dbword(std::string name);
-        uint32_t get_dbdword(std::string name);
-
-        void set_flag(std::string name, bool state);
-        void set_output(std::string name, bool state);
-        bool get_flag(std::string name);
-        bool get_input(std::string name);
-        bool get_output(std::string name);
-
-        void set_io(std::string name, bool state);
-        bool get_io(std::string name);
+        // Resolves the name of a tag from the config to a handle, std::nullopt if there is no such tag. The tag overloads
+        // below index the tag tables directly, so callers that access a value repeatedly should resolve the name once and
+        // keep the tag.
+        std::optional<Tag> find_tag(Area area, const std::string &name) const;
+
+        std::future<bool> set_dbword(const std::string &name, uint16_t data);
+        std::future<bool> set_dbword(Tag tag, uint16_t data);
+        std::future<bool> set_dbdword(const std::string &name, uint32_t data);
+        std::future<bool> set_dbdword(Tag tag, uint32_t data);
+        uint16_t get_dbword(const std::string &name);
+        uint16_t get_dbword(Tag tag);
+        uint32_t get_dbdword(const std::string &name);
+        uint32_t get_dbdword(Tag tag);
+
+        std::future<bool> set_flag(const std::string &name, bool state);
+        std::future<bool> set_flag(Tag tag, bool state);
+        std::future<bool> set_output(const std::string &name, bool state);
+        std::future<bool> set_output(Tag tag, bool state);
+        bool get_flag(const std::string &name);
+        bool get_flag(Tag tag);
+        bool get_input(const std::string &name);
+        bool get_input(Tag tag);
+        bool get_output(const std::string &name);
+        bool get_output(Tag tag);
+
+        void set_io(const std::string &name, bool state);
+        bool get_io(const std::string &name);
+
+        // Returns the snapshot of the last completed poll cycle
+        std::shared_ptr<const Snapshot> get_snapshot() const;
 
     signals:
         void flag_changed(std::string name, bool state);
@@ -98,14 +136,51 @@ namespace PLC {
         void dbdword_changed(std::string name, uint32_t data);
 
     private:
-        bool poll_flags();
-        bool poll_inputs();
-        bool poll_outputs();
-        void poll_dbwords();
-        void poll_dbdwords();
+        // Loading of the tags from the config. Every tag is appended to its tag table and its name is added to
+        // m_tag_index.
+        std::optional<TagSettings> parse_tag(const std::string &name, const std::string &value, Area area) const;
+        bool add_tag_name(const std::string &name, Area area, size_t index);
+        void load_states(std::shared_ptr<config::Segment> settings, const std::string &key, const std::string &ranges_key,
+                         Area area, std::vector<State> &tags, BitDiff &diff, BitImage &image);
+        template <typename T>
+        void load_db_tags(std::shared_ptr<config::Segment> settings, const std::string &key, Area area, std::vector<DB<T>> &tags,
+                          std::vector<DBVector<T>> &dbs);
+
+        // Returns the index of the scan class with the shorter interval
+        size_t faster_scan_class(size_t a, size_t b) const;
+
+        size_t tag_count(Area area) const;
+
+        // Returns true if tag is a valid handle into the tag table of area. Logs an error otherwise.
+        bool check_tag(Tag tag, Area area) const;
+
+        // Compare the new data with the current state and notify listeners about changes
+        void update_states(const BitImage &image, const BitDiff &diff, std::vector<State> &tags,
+                           void (S7::*changed)(std::string, bool));
+        template <typename T>
+        void update_db(DBVector<T> &db, const uint8_t *data, std::vector<DB<T>> &tags, void (S7::*changed)(std::string, T));
+
+        // Builds the list of memory areas read in every poll cycle. The actual read requests are planned in connect(), once
+        // the PDU size is known.
+        void build_poll_plan();
+
+        // Reads all areas of a scan class into the process image. Returns false if any of the requests failed.
+        bool read_process_image(size_t scan_class);
 
         void poll();
 
+        // Copies the current state into a new snapshot and makes it visible to readers
+        void publish_snapshot();
+
+        // Flushes the write queue on the poll thread after the write window, unless a flush is already pending
+        void schedule_write_flush();
+
+        // Sends all queued writes to the PLC
+        void flush_writes();
+
+        // Executes func on the poll thread (or directly if we are already on it or the thread was not started yet)
+        void run_on_poll_thread(std::function<void()> func);
+
         struct {
             Nodave::speed speed = Nodave::speed::undefined;
             Nodave::protocol protocol = Nodave::protocol::undefined;
@@ -117,21 +192,54 @@ namespace PLC {
         daveConnection *m_plc_connection = nullptr;
         daveInterface *m_plc_interface = nullptr;
 
-        bool m_plc_connected = false;
+        std::atomic<bool> m_plc_connected{false};
+
+        // Current and previous state of all bytes of the digital areas that are read in a poll cycle
+        BitImage m_flag_image;
+        BitImage m_input_image;
+        BitImage m_output_image;
+
+        // Tag tables, indexed by Tag::index. They are only resized in init, afterwards only the current values change (on
+        // the poll thread).
+        std::vector<State> m_flag_tags;
+        std::vector<State> m_input_tags;
+        std::vector<State> m_output_tags;
+        std::vector<DBword> m_dbword_tags;
+        std::vector<DBdword> m_dbdword_tags;
 
-        uint64_t m_flags = 0;
-        uint64_t m_inputs = 0;
-        uint64_t m_outputs = 0;
+        // Bit to tag tables of the digital areas, used to find the tags of changed bits after a poll
+        BitDiff m_flag_diff;
+        BitDiff m_input_diff;
+        BitDiff m_output_diff;
 
-        std::unordered_map<std::string, State> m_flag_map;
-        std::unordered_map<std::string, State> m_input_map;
-        std::unordered_map<std::string, State> m_output_map;
+        // Maps the names of the tags to their index in the tag table, one map per area
+        std::array<std::unordered_map<std::string, uint16_t>, AREA_COUNT> m_tag_index;
 
         std::vector<DBDataword> m_db_datawords;
         std::vector<DBDatadword> m_db_datadwords;
-        std::unordered_map<std::string, DBword> m_dbword_map;
-        std::unordered_map<std::string, DBdword> m_dbdword_map;
+
+        // Scan classes, the first one is the default class polled at the poll interval
+        std::vector<ScanClass> m_scan_classes;
+
+        // All areas read in a poll cycle, grouped by scan class into as few multi-variable read requests as the PDU size allows
+        PollPlanner m_poll_planner;
+        std::vector<uint8_t> m_process_image;
+
+        // Writes queued by the setters. Writes arriving within m_write_window ms are sent together.
+        WriteQueue m_write_queue;
+        std::atomic<bool> m_write_flush_scheduled{false};
+        int m_write_window = S7_DEFAULT_WRITE_WINDOW;
+        int m_pdu_size = S7_DEFAULT_PDU_SIZE;
 
         QTimer m_poll_timer;
+        QThread m_poll_thread;
+
+        // Only accessed via std::atomic_load/std::atomic_store. They are not lock-free, the standard library guards them with
+        // an internal lock, which is only held to copy the pointer and the reference count.
+        std::shared_ptr<const Snapshot> m_snapshot;
+        uint64_t m_snapshot_version = 0;
+
+        // Snapshots for reuse by publish_snapshot, only accessed on the poll thread
+        std::vector<std::shared_ptr<Snapshot>> m_snapshot_pool;
     };
 }  // namespace PLC
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+namespace PLC {
+    // A scan class is a group of tags polled at the same interval, e.g. a fast class for interlocks and pressures and a
+    // slow one for counters and temperatures. Every memory area is polled at the interval of the fastest class among its
+    // tags.
+    struct ScanClass {
+        std::string name;
+        int interval = 1000;  // ms
+
+        std::chrono::steady_clock::time_point next_poll;
+
+        // Returns true if the class is due at now (or within tolerance, timers may fire a bit early) and schedules its next
+        // poll. The phase is kept; polls that were missed entirely are skipped.
+        bool due(std::chrono::steady_clock::time_point now, std::chrono::steady_clock::duration tolerance) {
+            if (now + tolerance < next_poll) {
+                return false;
+            }
+
+            const auto period = std::chrono::milliseconds(interval);
+            next_poll += period;
+            if (next_poll <= now) {
+                next_poll = now + period;
+            }
+            return true;
+        }
+    };
+
+    // Settings of a single tag as given in the config: "<address>[, <scan class>[, <deadband>]]"
+    struct TagSettings {
+        std::pair<int, int> address;  // byte and bit for digital areas, data block and byte for data blocks
+
+        size_t scan_class = 0;  // index into S7::m_scan_classes, 0 is the default class
+
+        // Changes of data block values are only reported if the value differs by more than the deadband from the last
+        // reported one
+        uint32_t deadband = 0;
+    };
+}  // namespace PLC
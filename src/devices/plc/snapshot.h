@@ -0,0 +1,24 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace PLC {
+    // Snapshot is an immutable copy of everything read from the PLC in one poll cycle. The S7 publishes a new snapshot after
+    // every completed cycle; readers hold on to the shared_ptr for as long as they need a consistent view of the process.
+    struct Snapshot {
+        // Incremented with every published snapshot, so readers can tell if anything was polled since their last look
+        uint64_t version = 0;
+        std::chrono::steady_clock::time_point timestamp;
+
+        // Bit images of the digital areas, see State::bit and test_bit
+        std::vector<uint64_t> flags;
+        std::vector<uint64_t> inputs;
+        std::vector<uint64_t> outputs;
+
+        // Same order as the data blocks in S7 (see DBword::index and DBdword::index)
+        std::vector<std::vector<uint16_t>> datawords;
+        std::vector<std::vector<uint32_t>> datadwords;
+    };
+}  // namespace PLC
@@ -1,8 +1,16 @@
 #pragma once
 
+#include <cstddef>
+#include <string>
+
 namespace PLC {
     struct State {
-        int address;
+        int address;  // byte * 8 + bit
         bool state;
+
+        std::string name;
+
+        // Position of the bit in the bit image of its area
+        size_t bit = 0;
     };
-}  // namespace PLC
\ No newline at end of file
+}  // namespace PLC
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace PLC {
+    // Memory areas of the S7 that tags can refer to
+    enum class Area : uint8_t { Flag, Input, Output, DBword, DBdword };
+    constexpr size_t AREA_COUNT = 5;
+
+    // Returns the name of the area as used in log messages
+    inline std::string get_name(Area area) {
+        switch (area) {
+        case Area::Flag:
+            return "flag";
+        case Area::Input:
+            return "input";
+        case Area::Output:
+            return "output";
+        case Area::DBword:
+            return "DBword";
+        case Area::DBdword:
+            return "DBdword";
+        }
+
+        return "unknown";
+    }
+
+    // Tag is a handle to a flag, input, output or data block value of the S7. It is resolved once from the name used in the
+    // config (see S7::find_tag) and then indexes the tag tables of the S7 directly, so accessing a value by tag does not
+    // involve any string handling.
+    struct Tag {
+        Area area = Area::Flag;
+        uint16_t index = 0;
+    };
+}  // namespace PLC
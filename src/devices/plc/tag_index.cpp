@@ -0,0 +1,40 @@
+#include "tag_index.h"
+
+#include <algorithm>
+
+namespace PLC {
+    void TagIndex::clear() {
+        m_entries.clear();
+        m_first.clear();
+        m_tags.clear();
+    }
+
+    void TagIndex::add(size_t position, uint16_t tag) { m_entries.emplace_back(position, tag); }
+
+    void TagIndex::build() {
+        m_first.clear();
+        m_tags.clear();
+
+        if (m_entries.empty()) {
+            return;
+        }
+
+        // Sorting by position groups the tags of every position together
+        std::stable_sort(m_entries.begin(), m_entries.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+
+        const size_t positions = m_entries.back().first + 1;
+        m_first.assign(positions + 1, 0);
+        m_tags.reserve(m_entries.size());
+
+        // Count the tags per position..
+        for (const auto &entry : m_entries) {
+            m_first[entry.first + 1]++;
+            m_tags.push_back(entry.second);
+        }
+
+        // ..and turn the counts into indices
+        for (size_t position = 0; position < positions; position++) {
+            m_first[position + 1] += m_first[position];
+        }
+    }
+}  // namespace PLC
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace PLC {
+    // TagIndex maps positions (bits of a bit image, words of a data block) to the tags located there. The tags of all
+    // positions are kept in one dense table: m_first[position] is the index of the first tag of the position in m_tags,
+    // m_first[position + 1] the index after its last one. Looking up the tags of a position therefore costs two array
+    // accesses, independent of the number of tags.
+    class TagIndex {
+    public:
+        // Removes all entries
+        void clear();
+
+        // Adds tag at position. A position may have more than one tag. Call build() after all tags are added.
+        void add(size_t position, uint16_t tag);
+
+        // Builds the table from all added entries
+        void build();
+
+        // Number of positions covered by the table (highest position with a tag + 1)
+        size_t size() const noexcept { return m_first.empty() ? 0 : m_first.size() - 1; }
+
+        // Calls func(tag) for every tag at position
+        template <typename F>
+        void for_each(size_t position, F &&func) const {
+            if (position >= size()) {
+                return;
+            }
+
+            for (uint32_t i = m_first[position]; i < m_first[position + 1]; i++) {
+                func(m_tags[i]);
+            }
+        }
+
+    private:
+        std::vector<std::pair<size_t, uint16_t>> m_entries;
+
+        std::vector<uint32_t> m_first;
+        std::vector<uint16_t> m_tags;
+    };
+}  // namespace PLC
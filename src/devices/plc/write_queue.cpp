@@ -0,0 +1,130 @@
+#include "write_queue.h"
+
+namespace PLC {
+    namespace {
+        bool same_address(const WriteItem &a, const WriteItem &b) {
+            return a.area == b.area && a.db == b.db && a.start == b.start && a.bit == b.bit && a.data.size() == b.data.size();
+        }
+
+        // Bits are only written to the digital areas and bytes only to data blocks, so only byte writes can overlap
+        bool overlaps(const WriteItem &a, const WriteItem &b) {
+            if (a.area != b.area || a.db != b.db || a.bit || b.bit) {
+                return false;
+            }
+            return a.start < b.start + static_cast<int>(b.data.size()) && b.start < a.start + static_cast<int>(a.data.size());
+        }
+    }  // namespace
+
+    void WriteItem::complete(bool success) {
+        for (auto &completion : completions) {
+            completion.set_value(success);
+        }
+        completions.clear();
+    }
+
+    std::future<bool> WriteQueue::write_bit(int area, int bit, bool state) {
+        WriteItem item;
+        item.area = area;
+        item.start = bit;
+        item.bit = true;
+        item.data = {static_cast<uint8_t>(state ? 1 : 0)};
+
+        // Bits never overlap
+        return std::move(*queue(std::move(item)));
+    }
+
+    std::optional<std::future<bool>> WriteQueue::write_bytes(int area, int db, int start, std::vector<uint8_t> data) {
+        WriteItem item;
+        item.area = area;
+        item.db = db;
+        item.start = start;
+        item.data = std::move(data);
+
+        return queue(std::move(item));
+    }
+
+    std::optional<std::future<bool>> WriteQueue::queue(WriteItem item) {
+        std::promise<bool> completion;
+        auto future = completion.get_future();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // Only the last write is replaced, merging with an older one would move the new value before the writes in between
+        if (!m_items.empty() && same_address(m_items.back(), item)) {
+            m_items.back().data = std::move(item.data);
+            m_items.back().completions.push_back(std::move(completion));
+            return future;
+        }
+
+        for (const auto &queued : m_items) {
+            if (overlaps(queued, item) && !same_address(queued, item)) {
+                return std::nullopt;
+            }
+        }
+
+        item.completions.push_back(std::move(completion));
+        m_items.push_back(std::move(item));
+
+        return future;
+    }
+
+    bool WriteQueue::empty() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_items.empty();
+    }
+
+    std::vector<WriteRequest> WriteQueue::take(int pdu_size, int max_items) {
+        std::vector<WriteItem> items;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            items.swap(m_items);
+        }
+
+        std::vector<WriteRequest> requests;
+
+        int request_size = REQUEST_HEADER_SIZE;
+        int response_size = RESPONSE_HEADER_SIZE;
+
+        for (auto &item : items) {
+            // Data of all items but the last one is padded to an even length
+            const int length = static_cast<int>(item.data.size());
+            const int item_request_size = REQUEST_ITEM_SIZE + REQUEST_DATA_SIZE + length + (length & 1);
+
+            if (REQUEST_HEADER_SIZE + item_request_size > pdu_size || max_items < 1) {
+                item.complete(false);
+                continue;
+            }
+
+            if (requests.empty() || static_cast<int>(requests.back().items.size()) >= max_items
+                || request_size + item_request_size > pdu_size || response_size + RESPONSE_ITEM_SIZE > pdu_size) {
+                requests.emplace_back();
+                request_size = REQUEST_HEADER_SIZE;
+                response_size = RESPONSE_HEADER_SIZE;
+            }
+
+            requests.back().items.push_back(std::move(item));
+            request_size += item_request_size;
+            response_size += RESPONSE_ITEM_SIZE;
+        }
+
+        return requests;
+    }
+
+    void WriteQueue::cancel() {
+        std::vector<WriteItem> items;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            items.swap(m_items);
+        }
+
+        for (auto &item : items) {
+            item.complete(false);
+        }
+    }
+
+    std::future<bool> make_ready_future(bool value) {
+        std::promise<bool> promise;
+        promise.set_value(value);
+        return promise.get_future();
+    }
+}  // namespace PLC
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace PLC {
+    // WriteItem is a single variable written to the PLC. Consecutive writes to the same address that are queued before the
+    // next flush are merged into one item; all of them are completed with the result of that item.
+    struct WriteItem {
+        int area = 0;      // daveFlags, daveOutputs or daveDB
+        int db = 0;        // number of the data block, 0 for all other areas
+        int start = 0;     // bit address (byte * 8 + bit) for bit writes, byte address otherwise
+        bool bit = false;  // true for a single bit, false for a number of bytes
+
+        // Value to write: one byte (0 or 1) for bit writes, the bytes in PLC byte order otherwise
+        std::vector<uint8_t> data;
+
+        std::vector<std::promise<bool>> completions;
+
+        // Fulfils the futures of all writes merged into this item
+        void complete(bool success);
+    };
+
+    // WriteRequest is a group of items that is transferred in a single multi-variable write request (i.e. one round trip).
+    struct WriteRequest {
+        std::vector<WriteItem> items;
+    };
+
+    // The WriteQueue collects writes to the PLC from any thread until the poll thread flushes them, so a burst of writes costs
+    // as many round trips as the PDU size requires instead of one (or two, for read-modify-write of bits) per write.
+    //
+    // The writes are sent in the order they were queued, e.g. a setpoint before the bit that enables it. A write replaces the
+    // last queued one if both go to the same address (the last value wins). Writes that overlap a queued write partially
+    // would leave the PLC with an undefined mix of both and are rejected.
+    class WriteQueue {
+    public:
+        // Queues writing a single bit. Returns a future that is set to true once the write succeeded.
+        std::future<bool> write_bit(int area, int bit, bool state);
+
+        // Queues writing data (in PLC byte order) to a data block. Returns a future that is set to true once the write
+        // succeeded, or nullopt if the write was rejected because the bytes overlap those of another queued write. The
+        // future of an accepted write may already be set when this returns, e.g. by a flush on the poll thread.
+        std::optional<std::future<bool>> write_bytes(int area, int db, int start, std::vector<uint8_t> data);
+
+        bool empty() const;
+
+        // Removes all queued writes and groups them into write requests for the given PDU size and maximum number of items
+        // per request. Items that do not fit into a PDU at all are completed with false.
+        std::vector<WriteRequest> take(int pdu_size, int max_items);
+
+        // Completes all queued writes with false, e.g. when the connection was lost
+        void cancel();
+
+        // Sizes of the different parts of S7 write requests and replies in bytes, used to calculate how many items fit into
+        // a single PDU
+        static constexpr int REQUEST_HEADER_SIZE = 12;   // header (10) + function code and item count (2)
+        static constexpr int REQUEST_ITEM_SIZE = 12;     // address specification per item
+        static constexpr int REQUEST_DATA_SIZE = 4;      // return code, transport size and length per item
+        static constexpr int RESPONSE_HEADER_SIZE = 14;  // header (12) + function code and item count (2)
+        static constexpr int RESPONSE_ITEM_SIZE = 1;     // return code per item
+
+    private:
+        // Returns nullopt if item overlaps a queued write
+        std::optional<std::future<bool>> queue(WriteItem item);
+
+        // In the order the writes were queued
+        std::vector<WriteItem> m_items;
+
+        mutable std::mutex m_mutex;
+    };
+
+    // Returns a future that is already set to value, used for writes that fail before they are queued
+    std::future<bool> make_ready_future(bool value);
+}  // namespace PLC
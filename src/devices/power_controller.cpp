@@ -0,0 +1,182 @@
+#include "power_controller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+void PowerController::start(int setpoint) {
+    m_active = true;
+    m_tripped = false;
+    m_bumpless = true;
+
+    m_output = std::max(setpoint, 0);
+    m_sent = setpoint;
+    m_last_step.reset();
+    m_over_limit_since.reset();
+}
+
+void PowerController::set_target(double target) {
+    m_target = std::max(target, 0.0);
+    if (m_mode == Mode::Setpoint) {
+        m_target = std::min(m_target, static_cast<double>(m_settings.max_setpoint));
+    }
+}
+
+void PowerController::set_mode(Mode mode) {
+    if (mode == m_mode) {
+        return;
+    }
+
+    m_mode = mode;
+    m_bumpless = true;
+}
+
+std::optional<int> PowerController::update(Clock::time_point now, const Measurement &measurement) {
+    if (!m_active) {
+        return std::nullopt;
+    }
+
+    if (check_trip(now, measurement.reflected_power)) {
+        return std::nullopt;
+    }
+
+    // Run at the fixed rate of the settings, independent of the cycle time of the caller
+    if (m_last_step && now < m_next_step) {
+        return std::nullopt;
+    }
+
+    const double dt = m_last_step ? std::chrono::duration<double>(now - *m_last_step).count() : 0.0;
+    // Keep the phase of the steps unless the caller fell behind by a whole period
+    m_next_step = m_last_step ? m_next_step + m_settings.period : now + m_settings.period;
+    if (m_next_step <= now) {
+        m_next_step = now + m_settings.period;
+    }
+    m_last_step = now;
+
+    if (m_mode == Mode::Setpoint) {
+        if (std::exchange(m_bumpless, false)) {
+            m_reference = m_output;
+        }
+
+        advance_ramp(dt);
+        m_output = m_reference;
+    } else {
+        const bool fresh = measurement.feedback >= 0 && measurement.feedback_time > m_feedback_time;
+
+        if (m_bumpless) {
+            // The reference starts at the first measurement and the integrator at the current output, so nothing jumps
+            if (!fresh) {
+                return std::nullopt;
+            }
+
+            m_bumpless = false;
+            m_reference = measurement.feedback;
+            m_integral = m_output;
+            m_feedback = measurement.feedback;
+            m_feedback_time = measurement.feedback_time;
+        }
+
+        advance_ramp(dt);
+
+        // Without a new measurement the loop holds its output, integrating stale values would only wind it up
+        if (!fresh) {
+            return std::nullopt;
+        }
+
+        const double feedback = measurement.feedback;
+        const double feedback_dt = std::chrono::duration<double>(measurement.feedback_time - m_feedback_time).count();
+        m_feedback_time = measurement.feedback_time;
+
+        const double error = m_reference - feedback;
+        // The derivative acts on the measurement, so changes of the reference do not kick the output
+        const double derivative = feedback_dt > 0 ? -(feedback - m_feedback) / feedback_dt : 0.0;
+        m_feedback = feedback;
+
+        double integral = m_integral + m_settings.ki * error * feedback_dt;
+        double output = integral + m_settings.kp * error + m_settings.kd * derivative;
+
+        // Stop integrating while the output is saturated in the direction of the error (anti windup)
+        if (output > m_settings.max_setpoint) {
+            output = m_settings.max_setpoint;
+            if (error > 0) {
+                integral = m_integral;
+            }
+        } else if (output < 0) {
+            output = 0;
+            if (error < 0) {
+                integral = m_integral;
+            }
+        }
+
+        m_integral = integral;
+        m_output = output;
+    }
+
+    const int setpoint = static_cast<int>(std::lround(m_output));
+    // The end of a ramp is always sent, even if it is closer than the resolution
+    const bool ramp_done = m_mode == Mode::Setpoint && m_reference == m_target;
+
+    if (setpoint == m_sent || (std::abs(setpoint - m_sent) < m_settings.resolution && !ramp_done && m_sent >= 0)) {
+        return std::nullopt;
+    }
+
+    m_sent = setpoint;
+    return setpoint;
+}
+
+bool PowerController::supervise(Clock::time_point now, int reflected_power) {
+    // update checks it while control is active
+    if (m_active) {
+        return false;
+    }
+
+    return check_trip(now, reflected_power);
+}
+
+void PowerController::advance_ramp(double dt) {
+    const double difference = m_target - m_reference;
+
+    if (m_settings.ramp == Ramp::Linear) {
+        const double step = m_settings.ramp_rate * dt;
+        if (m_settings.ramp_rate <= 0 || std::abs(difference) <= step) {
+            m_reference = m_target;
+        } else {
+            m_reference += difference > 0 ? step : -step;
+        }
+        return;
+    }
+
+    const double time_constant = std::chrono::duration<double>(m_settings.ramp_time).count();
+    if (time_constant <= 0) {
+        m_reference = m_target;
+        return;
+    }
+
+    m_reference += difference * (1.0 - std::exp(-dt / time_constant));
+    // An exponential ramp never arrives, finish it once the rest is below what the generator can resolve
+    if (std::abs(m_target - m_reference) < 0.5 * std::max(m_settings.resolution, 1)) {
+        m_reference = m_target;
+    }
+}
+
+bool PowerController::check_trip(Clock::time_point now, int reflected_power) {
+    if (m_settings.reflected_limit <= 0 || reflected_power <= m_settings.reflected_limit) {
+        m_over_limit_since.reset();
+        return false;
+    }
+
+    if (!m_over_limit_since) {
+        m_over_limit_since = now;
+    }
+
+    if (now - *m_over_limit_since < m_settings.trip_time) {
+        return false;
+    }
+
+    m_tripped = true;
+    m_active = false;
+    m_output = 0;
+    // Each trip is reported once
+    m_over_limit_since.reset();
+    return true;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+#include "app_config.h"
+
+// PowerController computes the power setpoint of an RF generator. Instead of jumping to a new target it ramps a reference
+// towards it, either linearly at a fixed rate or exponentially with a time constant, and either sends the reference as the
+// setpoint (Setpoint mode) or regulates the forward power or the external feedback (the DC bias) to the reference with a PID
+// loop.
+//
+// update is meant to be called every cycle of the controller and runs a control step at the fixed rate of the settings. A
+// setpoint is only returned if it moved by at least the resolution of the generator since the last one that was sent, so the
+// serial link is not flooded with commands that do not change anything. Starting control and switching modes is bumpless:
+// the reference starts at the measured value and the integrator at the current setpoint.
+//
+// If the reflected power stays above the limit for longer than the trip time, control stops and is_tripped returns true;
+// the owner has to turn off the output. While control is not active (e.g. a recipe sets the power directly) the owner
+// calls supervise instead of update, so the trip guards those setpoints as well.
+//
+// Like TelemetrySampler it does not do any I/O or timing on its own and is not thread safe.
+class PowerController {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Mode : uint8_t {
+        Setpoint,          // the reference is sent as setpoint, no feedback
+        ForwardPower,      // regulate the forward power
+        ExternalFeedback,  // regulate the external feedback, i.e. the DC bias
+    };
+
+    enum class Ramp : uint8_t { Linear, Exponential };
+
+    struct Settings {
+        Clock::duration period = std::chrono::milliseconds(1000 / POWER_CONTROL_DEFAULT_RATE);
+
+        Ramp ramp = Ramp::Linear;
+        // Linear ramps: change of the reference per second, 0 jumps to the target
+        double ramp_rate = POWER_CONTROL_DEFAULT_RAMP_RATE;
+        // Exponential ramps: time constant
+        Clock::duration ramp_time = std::chrono::milliseconds(POWER_CONTROL_DEFAULT_RAMP_TIME);
+
+        // PID gains, the integral and derivative gains are per second
+        double kp = 0.5;
+        double ki = 2.0;
+        double kd = 0.0;
+
+        // Smallest setpoint change sent to the generator
+        int resolution = 1;
+        int max_setpoint = POWER_CONTROL_DEFAULT_MAX_POWER;
+
+        // Reflected power that trips the control if exceeded for trip_time, 0 disables the trip
+        int reflected_limit = 0;
+        Clock::duration trip_time = std::chrono::milliseconds(POWER_CONTROL_DEFAULT_TRIP_TIME);
+    };
+
+    struct Measurement {
+        // The regulated value (forward power or external feedback, depending on the mode), -1 if unknown
+        int feedback = -1;
+        // Time the feedback was received, a control step only runs for new values
+        Clock::time_point feedback_time{};
+        int reflected_power = -1;
+    };
+
+    void set_settings(const Settings &settings) { m_settings = settings; }
+    const Settings &get_settings() const { return m_settings; }
+
+    // Starts control from the setpoint the generator currently has. Clears a trip.
+    void start(int setpoint);
+    void stop() { m_active = false; }
+    bool is_active() const { return m_active; }
+
+    // Target of the ramp, in the units of the mode
+    void set_target(double target);
+    double get_target() const { return m_target; }
+    // The ramped value the controller currently aims for
+    double get_reference() const { return m_reference; }
+
+    // Switches the regulated value. The ramp restarts at the measured value of the new mode, so the setpoint does not jump.
+    void set_mode(Mode mode);
+    Mode get_mode() const { return m_mode; }
+
+    bool is_tripped() const { return m_tripped; }
+
+    // Runs a control step if one is due. Returns the setpoint to send, or nothing if it did not change by at least the
+    // resolution.
+    std::optional<int> update(Clock::time_point now, const Measurement &measurement);
+
+    // Checks the reflected power while control is not active. Returns true if it tripped, the trip time restarts after it.
+    bool supervise(Clock::time_point now, int reflected_power);
+
+private:
+    // Moves the reference towards the target for a step of dt seconds
+    void advance_ramp(double dt);
+
+    // Checks the reflected power, returns true if the control tripped
+    bool check_trip(Clock::time_point now, int reflected_power);
+
+    Settings m_settings;
+
+    Mode m_mode = Mode::Setpoint;
+    bool m_active = false;
+    bool m_tripped = false;
+    // The reference and the integrator are initialized with the next measurement
+    bool m_bumpless = false;
+
+    double m_target = 0;
+    double m_reference = 0;
+    double m_output = 0;
+    double m_integral = 0;
+    // The setpoint last sent to the generator
+    int m_sent = -1;
+
+    std::optional<Clock::time_point> m_last_step;
+    Clock::time_point m_next_step;
+
+    // Time and value of the last feedback used by the PID loop
+    Clock::time_point m_feedback_time{};
+    double m_feedback = 0;
+
+    std::optional<Clock::time_point> m_over_limit_since;
+};
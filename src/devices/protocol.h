@@ -0,0 +1,193 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Descriptor tables for device protocols. Every command of a protocol is one constexpr row that describes the payload of the
+// request and the layout of the reply, i.e. which values are found where, how they are scaled and which field of the
+// parameter struct (Target) they are stored in. Table builds a lookup index from the rows at compile time and decode handles
+// all replies generically, so supporting a new command means adding a row instead of another case with hand written parsing.
+namespace protocol {
+    enum class Encoding : uint8_t {
+        None,
+        UInt8,
+        UInt16LE,  // unsigned 16 bit, least significant byte first
+        Decimal    // ASCII decimal number
+    };
+
+    // Number of bytes a value takes in a binary encoding, 0 for Decimal and None
+    constexpr size_t encoded_size(Encoding encoding) {
+        switch (encoding) {
+        case Encoding::UInt8:
+            return 1;
+        case Encoding::UInt16LE:
+            return 2;
+        default:
+            return 0;
+        }
+    }
+
+    // A value in a reply
+    template <typename Target>
+    struct Field {
+        Encoding encoding = Encoding::None;
+        // Byte offset in the reply data for binary encodings, index of the space separated token for Decimal
+        uint8_t position = 0;
+        // The decoded value is divided by divisor before it is stored in target
+        int divisor = 1;
+        int Target::*target = nullptr;
+    };
+
+    constexpr size_t MAX_FIELDS = 3;
+
+    // Converts a command enum to the id used in the table
+    template <typename E>
+    constexpr uint8_t id(E command) {
+        return static_cast<uint8_t>(command);
+    }
+
+    template <typename Target>
+    struct Command {
+        // Command byte of binary protocols. ASCII protocols use it as the key for find(id) only.
+        uint8_t id = 0;
+        const char *name = "";
+        // Payload of the request. ASCII protocols send text instead, where "{0}" is replaced by the value.
+        Encoding request = Encoding::None;
+        const char *text = "";
+
+        std::array<Field<Target>, MAX_FIELDS> reply{};
+
+        constexpr bool has_reply() const { return reply[0].encoding != Encoding::None; }
+    };
+
+    template <typename Target, size_t N>
+    class Table {
+    public:
+        constexpr explicit Table(const std::array<Command<Target>, N> &commands) : m_commands(commands) {
+            for (auto &index : m_index) {
+                index = NONE;
+            }
+            for (size_t i = 0; i < N; i++) {
+                m_index[commands[i].id] = static_cast<uint8_t>(i);
+            }
+        }
+
+        static_assert(N < 255, "a protocol table has at most 254 commands");
+
+        constexpr const Command<Target> *find(uint8_t id) const {
+            return m_index[id] == NONE ? nullptr : &m_commands[m_index[id]];
+        }
+
+        // Finds the command whose request text is text, e.g. the echo of a command sent to an ASCII device. "{0}" in the
+        // request text matches any (non-empty) value.
+        const Command<Target> *find(std::string_view text) const {
+            for (const auto &command : m_commands) {
+                std::string_view pattern = command.text;
+                if (pattern.empty()) {
+                    continue;
+                }
+
+                const auto placeholder = pattern.find("{0}");
+                if (placeholder == std::string_view::npos) {
+                    if (pattern == text) {
+                        return &command;
+                    }
+                    continue;
+                }
+
+                const auto prefix = pattern.substr(0, placeholder);
+                const auto suffix = pattern.substr(placeholder + 3);
+                if (text.size() > prefix.size() + suffix.size() && text.substr(0, prefix.size()) == prefix
+                    && text.substr(text.size() - suffix.size()) == suffix) {
+                    return &command;
+                }
+            }
+
+            return nullptr;
+        }
+
+        const std::array<Command<Target>, N> &commands() const { return m_commands; }
+
+    private:
+        static constexpr uint8_t NONE = 0xFF;
+
+        std::array<Command<Target>, N> m_commands;
+        std::array<uint8_t, 256> m_index{};
+    };
+
+    // Returns the index-th token of text separated by (any number of) spaces, or an empty view if there are fewer
+    inline std::string_view find_token(std::string_view text, size_t index) {
+        size_t start = 0;
+        for (;;) {
+            start = text.find_first_not_of(' ', start);
+            if (start == std::string_view::npos) {
+                return {};
+            }
+
+            const size_t end = std::min(text.find(' ', start), text.size());
+            if (index-- == 0) {
+                return text.substr(start, end - start);
+            }
+            start = end;
+        }
+    }
+
+    // Decodes a single value from the reply data, returns false if data is too short or the value can not be parsed
+    template <typename Target>
+    bool decode_value(const Field<Target> &field, std::string_view data, int &value) {
+        if (field.encoding == Encoding::Decimal) {
+            auto token = find_token(data, field.position);
+            if (token.empty()) {
+                return false;
+            }
+
+            return std::from_chars(token.data(), token.data() + token.size(), value).ec == std::errc{};
+        }
+
+        const size_t size = encoded_size(field.encoding);
+        if (size == 0 || data.size() < field.position + size) {
+            return false;
+        }
+
+        value = 0;
+        for (size_t i = 0; i < size; i++) {
+            value |= static_cast<uint8_t>(data[field.position + i]) << (8 * i);
+        }
+        return true;
+    }
+
+    // Decodes all reply fields of command from data into target. Nothing is stored and false is returned if data is too short
+    // or a value can not be parsed.
+    template <typename Target>
+    bool decode(const Command<Target> &command, std::string_view data, Target &target) {
+        std::array<int, MAX_FIELDS> values{};
+
+        size_t count = 0;
+        for (; count < MAX_FIELDS && command.reply[count].encoding != Encoding::None; count++) {
+            if (!decode_value(command.reply[count], data, values[count])) {
+                return false;
+            }
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            const auto &field = command.reply[i];
+            if (field.target) {
+                target.*field.target = values[i] / field.divisor;
+            }
+        }
+
+        return true;
+    }
+
+    // Appends the binary request payload of command for value to out, which needs a push_back(char)
+    template <typename Target, typename Out>
+    void encode(const Command<Target> &command, int value, Out &out) {
+        for (size_t i = 0; i < encoded_size(command.request); i++) {
+            out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
+    }
+}  // namespace protocol
@@ -0,0 +1,384 @@
+#include "rf_generator.h"
+
+#include <algorithm>
+
+namespace {
+    constexpr size_t field_index(int RFGenerator::Parameters::*field) {
+        for (size_t i = 0; i < RFGenerator::PARAMETER_FIELDS.size(); i++) {
+            if (RFGenerator::PARAMETER_FIELDS[i] == field) {
+                return i;
+            }
+        }
+        return RFGenerator::PARAMETER_FIELDS.size();
+    }
+}  // namespace
+
+RFGenerator::RFGenerator() : RFGenerator(nullptr) {}
+
+RFGenerator::RFGenerator(std::unique_ptr<BaseConnector> &&connector) : Device(std::move(connector)) {
+    m_telemetry.set_min_interval(std::chrono::milliseconds(1000 / TELEMETRY_DEFAULT_MAX_RATE));
+
+    m_publish_timer.setSingleShot(true);
+    QObject::connect(&m_publish_timer, &QTimer::timeout, this, &RFGenerator::publish_telemetry);
+
+    m_sampler.set_rate(TELEMETRY_DEFAULT_SAMPLE_RATE);
+    m_sampler.set_reply_timeout(std::chrono::milliseconds(TELEMETRY_REPLY_TIMEOUT));
+
+    m_sample_timer.setSingleShot(true);
+    QObject::connect(&m_sample_timer, &QTimer::timeout, this, &RFGenerator::sample_telemetry);
+}
+
+RFGenerator::ParameterTelemetry RFGenerator::get_telemetry() {
+    std::scoped_lock<std::mutex> lock(m_telemetry_mutex);
+    return m_telemetry;
+}
+
+RFGenerator::Parameters RFGenerator::get_parameters() {
+    std::scoped_lock<std::mutex> lock(m_telemetry_mutex);
+
+    Parameters parameters;
+    for (size_t i = 0; i < PARAMETER_FIELDS.size(); i++) {
+        parameters.*PARAMETER_FIELDS[i] = m_telemetry.get(i).value;
+    }
+    return parameters;
+}
+
+void RFGenerator::set_telemetry_rate(int rate) {
+    if (rate < 0) {
+        logging::main_log()->warn("RFGenerator: ignoring negative telemetry rate {0}", rate);
+        return;
+    }
+
+    std::scoped_lock<std::mutex> lock(m_telemetry_mutex);
+    m_telemetry.set_min_interval(rate == 0 ? std::chrono::milliseconds(0) : std::chrono::milliseconds(1000 / rate));
+}
+
+void RFGenerator::set_sample_rate(int rate) {
+    if (rate < 0) {
+        logging::main_log()->warn("RFGenerator: ignoring negative sample rate {0}", rate);
+        return;
+    }
+
+    m_sampler.set_rate(rate);
+    schedule_sampling();
+}
+
+void RFGenerator::init_telemetry(const config::Segment &settings) {
+    if (auto rate = settings.get<int>("telemetryrate")) {
+        set_telemetry_rate(*rate);
+    }
+    if (auto rate = settings.get<int>("samplerate")) {
+        set_sample_rate(*rate);
+    }
+}
+
+void RFGenerator::init_power_control(const config::Segment &settings) {
+    auto control = m_power_controller.get_settings();
+
+    if (auto rate = settings.get<int>("controlrate")) {
+        if (*rate < 1) {
+            logging::main_log()->warn("RFGenerator: ignoring invalid power control rate {0}", *rate);
+        } else {
+            control.period = std::chrono::milliseconds(1000 / *rate);
+        }
+    }
+
+    if (auto ramp = settings.get<std::string>("ramp")) {
+        if (*ramp == "linear") {
+            control.ramp = PowerController::Ramp::Linear;
+        } else if (*ramp == "exponential") {
+            control.ramp = PowerController::Ramp::Exponential;
+        } else {
+            logging::main_log()->warn("RFGenerator: ignoring unknown ramp '{0}'", *ramp);
+        }
+    }
+
+    control.ramp_rate = settings.get<double>("ramprate").value_or(control.ramp_rate);
+    if (auto time = settings.get<int>("ramptime")) {
+        control.ramp_time = std::chrono::milliseconds(*time);
+    }
+
+    control.kp = settings.get<double>("kp").value_or(control.kp);
+    control.ki = settings.get<double>("ki").value_or(control.ki);
+    control.kd = settings.get<double>("kd").value_or(control.kd);
+
+    control.resolution = std::max(settings.get<int>("resolution").value_or(control.resolution), 1);
+    control.max_setpoint = settings.get<int>("maxpower").value_or(control.max_setpoint);
+    control.reflected_limit = settings.get<int>("reflectedlimit").value_or(control.reflected_limit);
+    if (auto time = settings.get<int>("triptime")) {
+        control.trip_time = std::chrono::milliseconds(*time);
+    }
+
+    m_power_controller.set_settings(control);
+}
+
+void RFGenerator::ramp_power(int target) {
+    if (target < 0) {
+        logging::main_log()->warn("RFGenerator: ramp_power called with negative target of {0}", target);
+        return;
+    }
+
+    if (!m_power_controller.is_active()) {
+        m_power_controller.start(get_parameters().setpoint);
+    }
+    m_power_controller.set_target(target);
+}
+
+void RFGenerator::set_power_control_mode(PowerController::Mode mode) { m_power_controller.set_mode(mode); }
+
+void RFGenerator::set_power_control(const PowerController::Settings &settings) { m_power_controller.set_settings(settings); }
+
+void RFGenerator::stop_power_control() { m_power_controller.stop(); }
+
+void RFGenerator::init_match_tuning(const config::Segment &settings) {
+    auto tuning = m_tuner.get_settings();
+
+    tuning.initial_step = std::max(settings.get<int>("tunestep").value_or(tuning.initial_step), 1);
+    tuning.target_reflected = settings.get<double>("tunetarget").value_or(tuning.target_reflected);
+    tuning.max_evaluations = settings.get<int>("tunemaxsteps").value_or(tuning.max_evaluations);
+    if (auto time = settings.get<int>("tunesettletime")) {
+        m_settle_time = std::chrono::milliseconds(std::max(*time, 0));
+    }
+
+    m_tuner.set_settings(tuning);
+}
+
+void RFGenerator::tune_match(int port) {
+    const auto parameters = get_parameters();
+    const auto range = get_capacitor_range();
+
+    auto tuning = m_tuner.get_settings();
+    tuning.min_position = range.min;
+    tuning.max_position = range.max;
+    m_tuner.set_settings(tuning);
+
+    m_tuning_port = port;
+    m_tuning_power = std::max(parameters.setpoint, 0);
+
+    // Without a match for this setup, start where the capacitors are now or in the middle if that is not known yet
+    auto cached = m_match_cache.lookup(port, m_tuning_power);
+    MatchTuner::Position seed{(range.min + range.max) / 2, (range.min + range.max) / 2};
+    if (cached) {
+        seed = *cached;
+    } else if (parameters.load_cap_position >= 0 && parameters.tune_cap_position >= 0) {
+        seed = {parameters.load_cap_position * range.scale, parameters.tune_cap_position * range.scale};
+    }
+
+    logging::main_log()->debug("RFGenerator: device #{0} tuning for port {1} at {2}W, {3} start at {4}/{5}", m_id, port,
+                               m_tuning_power, cached ? "warm" : "cold", seed.load, seed.tune);
+
+    set_matchnetwork_mode(MatchnetworkMode::Manual);
+    m_tuner.start(seed, cached.has_value());
+    move_capacitors(m_tuner.get_position());
+}
+
+void RFGenerator::update() {
+    update_power_control();
+    update_tuning();
+}
+
+void RFGenerator::update_power_control() {
+    const auto now = PowerController::Clock::now();
+
+    if (!m_power_controller.is_active()) {
+        // Setpoints sent directly (e.g. by a recipe) are guarded by the trip as well
+        int reflected_power = -1;
+        {
+            std::scoped_lock<std::mutex> lock(m_telemetry_mutex);
+            reflected_power = m_telemetry.get(field_index(&Parameters::reflected_power)).value;
+        }
+
+        if (m_power_controller.supervise(now, reflected_power)) {
+            handle_trip(reflected_power);
+        }
+        return;
+    }
+
+    const auto mode = m_power_controller.get_mode();
+
+    PowerController::Measurement measurement;
+    {
+        std::scoped_lock<std::mutex> lock(m_telemetry_mutex);
+
+        if (mode != PowerController::Mode::Setpoint) {
+            const auto field = field_index(mode == PowerController::Mode::ForwardPower ? &Parameters::forward_power
+                                                                                       : &Parameters::external_feedback);
+            measurement.feedback = m_telemetry.get(field).value;
+            measurement.feedback_time = m_telemetry.get(field).timestamp;
+        }
+        measurement.reflected_power = m_telemetry.get(field_index(&Parameters::reflected_power)).value;
+    }
+
+    auto setpoint = m_power_controller.update(now, measurement);
+
+    if (m_power_controller.is_tripped()) {
+        handle_trip(measurement.reflected_power);
+        return;
+    }
+
+    if (setpoint) {
+        set_target_power(*setpoint);
+    }
+}
+
+void RFGenerator::handle_trip(int reflected_power) {
+    logging::main_log()->error("RFGenerator: device #{0} reflected power of {1}W exceeded the limit, output off", m_id,
+                               reflected_power);
+    output_off();
+    // Without output the reflected power is 0 everywhere, tuning on would only find nonsense
+    m_tuner.stop();
+    emit power_tripped(m_id, reflected_power);
+}
+
+void RFGenerator::update_tuning() {
+    if (!m_tuner.is_running()) {
+        return;
+    }
+
+    ParameterTelemetry::Sample reflected;
+    {
+        std::scoped_lock<std::mutex> lock(m_telemetry_mutex);
+        reflected = m_telemetry.get(field_index(&Parameters::reflected_power));
+    }
+
+    if (reflected.value < 0 || reflected.timestamp < m_tuning_settled) {
+        return;
+    }
+
+    m_tuner.report(reflected.value);
+    if (m_tuner.is_running()) {
+        move_capacitors(m_tuner.get_position());
+        return;
+    }
+
+    const auto best = m_tuner.get_best();
+    move_capacitors(best);
+    m_match_cache.store(m_tuning_port, m_tuning_power, best);
+
+    logging::main_log()->debug("RFGenerator: device #{0} matched at {1}/{2} with {3}W reflected after {4} steps", m_id,
+                               best.load, best.tune, m_tuner.get_best_reflected(), m_tuner.get_evaluations());
+    emit match_tuned(m_id, best.load, best.tune, static_cast<int>(m_tuner.get_best_reflected()));
+}
+
+void RFGenerator::move_capacitors(MatchTuner::Position position) {
+    set_load_capacitor_position(position.load);
+    set_tune_capacitor_position(position.tune);
+    m_tuning_settled = ParameterTelemetry::Clock::now() + m_settle_time;
+}
+
+void RFGenerator::report_parameter(int Parameters::*field, int value) {
+    auto it = std::find(PARAMETER_FIELDS.begin(), PARAMETER_FIELDS.end(), field);
+    if (it == PARAMETER_FIELDS.end()) {
+        return;
+    }
+
+    std::scoped_lock<std::mutex> lock(m_telemetry_mutex);
+    m_telemetry.update(it - PARAMETER_FIELDS.begin(), value, ParameterTelemetry::Clock::now());
+}
+
+void RFGenerator::telemetry_received(uint8_t command) {
+    // Replies to other queries would skew the round trip time
+    auto it = std::find(m_sampled_commands.begin(), m_sampled_commands.end(), command);
+    if (it != m_sampled_commands.end()) {
+        m_sampled_commands.erase(it);
+        m_sampler.on_reply(TelemetrySampler::Clock::now());
+        // The next burst may be due now that the last one was answered
+        schedule_sampling();
+    }
+
+    publish_telemetry();
+}
+
+void RFGenerator::telemetry_failed(std::optional<uint8_t> command) {
+    auto it = command ? std::find(m_sampled_commands.begin(), m_sampled_commands.end(), *command) : m_sampled_commands.begin();
+    if (it != m_sampled_commands.end()) {
+        m_sampled_commands.erase(it);
+        m_sampler.on_failure(TelemetrySampler::Clock::now());
+        schedule_sampling();
+    }
+}
+
+void RFGenerator::command_sent(uint8_t command) {
+    if (m_sampling) {
+        m_sampled_commands.push_back(command);
+    }
+}
+
+std::vector<RFGenerator::TelemetryQuery> RFGenerator::telemetry_queries() {
+    return {
+        {[this]() { query_forward_power(); }, 1, true},
+        {[this]() { query_reflected_power(); }, 1, true},
+        {[this]() { query_capacitor_positions(); }, 1, false},
+        {[this]() { query_external_feedback(); }, 1, false},
+    };
+}
+
+void RFGenerator::handle_connected() {
+    // The queries can't be collected in the constructor since telemetry_queries is virtual
+    if (m_telemetry_queries.empty()) {
+        m_telemetry_queries = telemetry_queries();
+        for (const auto &query : m_telemetry_queries) {
+            m_sampler.add_query(query.replies, query.every_burst);
+        }
+    }
+
+    schedule_sampling();
+}
+
+void RFGenerator::sample_telemetry() {
+    // Sampling is started again by handle_connected
+    if (!m_connector || !m_connector->is_connected()) {
+        return;
+    }
+
+    const auto burst = m_sampler.next_burst(TelemetrySampler::Clock::now());
+    if (!burst.empty()) {
+        // Replies of the last burst that did not arrive until now are not waited for anymore
+        m_sampled_commands.clear();
+
+        m_sampling = true;
+        for (auto index : burst) {
+            m_telemetry_queries[index].send();
+        }
+        m_sampling = false;
+    }
+
+    schedule_sampling();
+}
+
+void RFGenerator::schedule_sampling() {
+    auto due = m_sampler.next_due();
+    if (!due || m_telemetry_queries.empty()) {
+        m_sample_timer.stop();
+        return;
+    }
+
+    auto delay = std::chrono::ceil<std::chrono::milliseconds>(*due - TelemetrySampler::Clock::now());
+    m_sample_timer.start(std::max(0, static_cast<int>(delay.count())));
+}
+
+void RFGenerator::publish_telemetry() {
+    // Values reported while the publish timer is running are coalesced into its update
+    if (m_publish_timer.isActive()) {
+        return;
+    }
+
+    uint32_t changed = 0;
+    std::optional<ParameterTelemetry::Clock::time_point> next;
+
+    {
+        std::scoped_lock<std::mutex> lock(m_telemetry_mutex);
+
+        changed = m_telemetry.publish(ParameterTelemetry::Clock::now());
+        next = m_telemetry.next_publish();
+    }
+
+    if (changed != 0) {
+        emit update_parameters(m_id, changed);
+    }
+
+    if (next) {
+        auto delay = std::chrono::ceil<std::chrono::milliseconds>(*next - ParameterTelemetry::Clock::now());
+        m_publish_timer.start(std::max(0, static_cast<int>(delay.count())));
+    }
+}
@@ -1,22 +1,67 @@
 #pragma once
 
 #include "device.h"
+#include "match_tuner.h"
+#include "power_controller.h"
+#include "rf_parameters.h"
+#include "telemetry.h"
+#include "telemetry_sampler.h"
+
+#include <array>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include <QTimer>
 
 class RFGenerator : public Device {
     Q_OBJECT
 public:
-    RFGenerator() = default;
-    RFGenerator(std::unique_ptr<BaseConnector> &&connector) : Device(std::move(connector)){};
+    RFGenerator();
+    RFGenerator(std::unique_ptr<BaseConnector> &&connector);
     virtual ~RFGenerator() = default;
 
     RFGenerator(const RFGenerator &) = delete;
     RFGenerator &operator=(const RFGenerator &) = delete;
 
+    // Parameters reported by the generator, -1 if not received yet
+    using Parameters = RFParameters;
+
+    // The fields of Parameters in the order they are indexed in the telemetry and in the changed mask of update_parameters
+    static constexpr std::array<int Parameters::*, 7> PARAMETER_FIELDS = {
+        &Parameters::external_feedback, &Parameters::forward_power,     &Parameters::reflected_power, &Parameters::setpoint,
+        &Parameters::load_cap_position, &Parameters::tune_cap_position, &Parameters::fault_status};
+
+    using ParameterTelemetry = Telemetry<PARAMETER_FIELDS.size()>;
+
+    // Returns a copy of the latest parameters with the time each one was received
+    ParameterTelemetry get_telemetry();
+    // Returns the latest parameters, -1 for parameters that were not received yet
+    Parameters get_parameters();
+
+    // Maximum number of update_parameters signals per second, changes in between are coalesced. 0 disables the limit.
+    void set_telemetry_rate(int rate);
+
+    // Number of query bursts per second sent to keep the parameters up to date (see TelemetrySampler), 0 stops sampling.
+    // Sampling runs while the generator is connected.
+    void set_sample_rate(int rate);
+
     // power control
     virtual void output_on() = 0;
     virtual void output_off() = 0;
     virtual void set_target_power(int power) = 0;
 
+    // Ramps the power to target instead of setting it right away, in W or in the units of the external feedback, depending
+    // on the mode of the power control (see PowerController). The control runs in update, i.e. in the cycle of the
+    // controller, until stop_power_control is called or it trips.
+    void ramp_power(int target);
+    // Switches the regulated value, bumpless if the control is running
+    void set_power_control_mode(PowerController::Mode mode);
+    void set_power_control(const PowerController::Settings &settings);
+    void stop_power_control();
+    bool is_power_control_tripped() const { return m_power_controller.is_tripped(); }
+
     // matching network control
     virtual void set_load_capacitor_position(int /*position*/){};
     virtual void set_tune_capacitor_position(int /*position*/){};
@@ -25,6 +70,22 @@ public:
     // Sets the behavior of the matching network to either automatic matching or manual matching.
     virtual void set_matchnetwork_mode(MatchnetworkMode /*mode*/){};  // manual, automatic, ...
 
+    // Range of the positions of both capacitors as sent with set_load/tune_capacitor_position
+    struct CapacitorRange {
+        int min = 0;
+        int max = 100;
+        // Reported positions times scale are in the units of the range
+        int scale = 1;
+    };
+    virtual CapacitorRange get_capacitor_range() const { return {}; }
+
+    // Tunes the matching network in manual mode to the least reflected power (see MatchTuner). The search starts at the
+    // positions that matched last time for the port of the RF switch and the current power, if there are any. Tuning runs in
+    // update and needs the output to be on.
+    void tune_match(int port);
+    void stop_tuning() { m_tuner.stop(); }
+    bool is_tuning() const { return m_tuner.is_running(); }
+
     // matching network queries
     virtual void query_capacitor_positions(){};
     virtual void query_external_feedback(){};
@@ -32,5 +93,99 @@ public:
     virtual void query_reflected_power(){};
 
 signals:
-    void update_parameters(device_id id);
+    // Emitted when parameters were received, changed is a mask of the changed fields (bit i for PARAMETER_FIELDS[i])
+    void update_parameters(device_id id, uint32_t changed);
+
+    // Emitted when the output was turned off because the reflected power exceeded its limit, with or without active power
+    // control
+    void power_tripped(device_id id, int reflected_power);
+
+    // Emitted when tune_match found the positions with the least reflected power
+    void match_tuned(device_id id, int load_position, int tune_position, int reflected_power);
+
+protected:
+    // Store a parameter received from the generator. Receivers are notified with the next telemetry_received.
+    void report_parameter(int Parameters::*field, int value);
+
+    // Call after all values of a reply to command were reported, so they are published together. Also lets the sampler
+    // measure how long the generator takes to answer, if command was one of its queries.
+    void telemetry_received(uint8_t command);
+
+    // Call if the generator rejected command or its reply could not be used, so the sampler does not wait for the reply
+    // until the burst times out. Without a command (the reply could not be matched to one) the oldest query of the sampler
+    // still waiting for its reply is counted as failed, the generators answer in the order the commands were sent.
+    void telemetry_failed(std::optional<uint8_t> command);
+
+    // Call with the id of every command sent, so replies to the queries of the sampler can be told apart from replies to
+    // queries sent by someone else (e.g. tune_match or the user interface)
+    void command_sent(uint8_t command);
+
+    // Reads the telemetry settings from the device settings: "telemetryrate" (see set_telemetry_rate) and "samplerate" (see
+    // set_sample_rate)
+    void init_telemetry(const config::Segment &settings);
+
+    // Reads the power control settings from the device settings: "controlrate" (Hz), "ramp" ("linear" or "exponential"),
+    // "ramprate" (W/s), "ramptime" (ms), "kp", "ki", "kd", "resolution", "maxpower", "reflectedlimit" (W) and "triptime" (ms)
+    void init_power_control(const config::Segment &settings);
+
+    // Reads the tuning settings from the device settings: "tunestep" (initial step of the search), "tunesettletime" (ms the
+    // capacitors need to settle after moving), "tunetarget" (W of reflected power that are good enough) and "tunemaxsteps"
+    void init_match_tuning(const config::Segment &settings);
+
+    // A query used by the telemetry sampler
+    struct TelemetryQuery {
+        std::function<void()> send;
+        // Number of replies the query is answered with
+        int replies = 1;
+        // Send it in every burst instead of round robin with the other queries
+        bool every_burst = false;
+    };
+
+    // Returns the queries the sampler cycles through. By default forward and reflected power are queried in every burst
+    // and the capacitor positions and the external feedback in turns. Override it if a generator can query several
+    // parameters at once.
+    virtual std::vector<TelemetryQuery> telemetry_queries();
+
+    // overrides from Device
+    void handle_connected() override;
+    void update() override;
+
+private:
+    // Emits update_parameters for the changed parameters, or schedules it if the minimum interval did not pass yet
+    void publish_telemetry();
+
+    // Sends the next burst of queries if it is due and restarts the sample timer
+    void sample_telemetry();
+    void schedule_sampling();
+
+    void update_power_control();
+    // Turns the output off after the reflected power exceeded its limit
+    void handle_trip(int reflected_power);
+    void update_tuning();
+
+    // Moves the capacitors to position, the reflected power is measured again once they settled
+    void move_capacitors(MatchTuner::Position position);
+
+    std::mutex m_telemetry_mutex;
+    ParameterTelemetry m_telemetry;
+    QTimer m_publish_timer{this};
+
+    // Only used from the thread of the generator
+    TelemetrySampler m_sampler;
+    std::vector<TelemetryQuery> m_telemetry_queries;
+    // True while the queries of a burst are sent, and the commands of the burst whose replies did not arrive yet
+    bool m_sampling = false;
+    std::vector<uint8_t> m_sampled_commands;
+    QTimer m_sample_timer{this};
+
+    // Only used from the thread of the generator
+    PowerController m_power_controller;
+
+    MatchTuner m_tuner;
+    MatchCache m_match_cache{MATCH_CACHE_POWER_STEP};
+    int m_tuning_port = 0;
+    int m_tuning_power = 0;
+    std::chrono::milliseconds m_settle_time{MATCH_SETTLE_TIME};
+    // Reflected power measured before this time was measured while the capacitors were moving
+    ParameterTelemetry::Clock::time_point m_tuning_settled;
 };
@@ -0,0 +1,13 @@
+#pragma once
+
+// Parameters reported by an RF generator, -1 if not received yet. The protocol tables of the generators (see
+// cesar_protocol.h and kjl_protocol.h) decode the replies into it.
+struct RFParameters {
+    int external_feedback = -1;
+    int forward_power = -1;
+    int reflected_power = -1;
+    int setpoint = -1;
+    int load_cap_position = -1;
+    int tune_cap_position = -1;
+    int fault_status = -1;
+};
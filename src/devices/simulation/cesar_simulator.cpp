@@ -0,0 +1,148 @@
+#include "cesar_simulator.h"
+
+namespace simulation {
+    namespace {
+        // The command ids, see CesarGenerator::Commands
+        enum Commands : uint8_t {
+            OutputOff = 1,
+            OutputOn = 2,
+            SetPowerSetPoint = 8,
+            SetMatchNetworkControl = 13,
+            SelectActiveControlMode = 14,
+            MoveLoadCapPosition = 112,
+            MoveTuneCapPosition = 122,
+            ReportSetPointAndRegulationMode = 164,
+            ReportForwardPower = 165,
+            ReportReflectedPower = 166,
+            ReportExternalFeedback = 168,
+            ReportCapacitorPositions = 175,
+            ReportFaultStatusRegister = 223,
+        };
+
+        int decode_uint16(std::string_view data) {
+            if (data.size() < 2) {
+                return 0;
+            }
+            return static_cast<uint8_t>(data[0]) | static_cast<uint8_t>(data[1]) << 8;
+        }
+
+        void append_uint16(std::string &out, int value) {
+            out += static_cast<char>(value & 0xFF);
+            out += static_cast<char>((value >> 8) & 0xFF);
+        }
+    }  // namespace
+
+    std::string CesarSimulator::receive(std::string_view data) {
+        std::string replies;
+
+        if (!m_reader.push(data.data(), data.size())) {
+            replies += static_cast<char>(framing::CesarFramer::NACK);
+        }
+
+        m_reader.for_each_frame([&](std::string_view frame, bool valid) {
+            // ACK or NACK of the device for a reply, nothing is resent
+            if (frame.size() == 1) {
+                return;
+            }
+
+            if (!valid || reject()) {
+                replies += static_cast<char>(framing::CesarFramer::NACK);
+                return;
+            }
+            replies += static_cast<char>(framing::CesarFramer::ACK);
+
+            const uint8_t header = frame[0];
+            const size_t offset = framing::CesarFramer::data_offset(header);
+            m_address = header >> 3;
+
+            replies += handle_command(frame[1], frame.substr(offset, frame.size() - offset - 1));
+        });
+
+        return replies;
+    }
+
+    std::string CesarSimulator::handle_command(uint8_t command, std::string_view data) {
+        // Command status response, 0 means accepted
+        uint8_t csr = 0;
+
+        switch (command) {
+        case OutputOff:
+            m_plasma.output = false;
+            break;
+        case OutputOn:
+            m_plasma.output = true;
+            break;
+        case SetPowerSetPoint:
+            m_plasma.setpoint = decode_uint16(data);
+            break;
+        case SetMatchNetworkControl:
+            m_automatic_match = !data.empty() && data[0] == 1;
+            break;
+        case SelectActiveControlMode:
+            break;
+        case MoveLoadCapPosition:
+        case MoveTuneCapPosition: {
+            const int position = decode_uint16(data);
+            if (m_automatic_match || position < 40 || position > 960) {
+                csr = 1;
+            } else {
+                (command == MoveLoadCapPosition ? m_plasma.load : m_plasma.tune) = position / 1000.0;
+            }
+            break;
+        }
+
+        case ReportSetPointAndRegulationMode: {
+            std::string reply;
+            append_uint16(reply, m_plasma.setpoint);
+            reply += '\x06';
+            return make_packet(command, reply);
+        }
+        case ReportForwardPower:
+            return make_packet(command, m_plasma.forward_power());
+        case ReportReflectedPower:
+            // Automatic matching keeps the generator matched
+            return make_packet(command, m_automatic_match ? 0 : m_plasma.reflected_power());
+        case ReportExternalFeedback:
+            return make_packet(command, m_plasma.dc_bias());
+        case ReportCapacitorPositions: {
+            std::string reply;
+            append_uint16(reply, static_cast<int>((m_automatic_match ? m_plasma.match_load : m_plasma.load) * 1000));
+            append_uint16(reply, static_cast<int>((m_automatic_match ? m_plasma.match_tune : m_plasma.tune) * 1000));
+            return make_packet(command, reply);
+        }
+        case ReportFaultStatusRegister:
+            return make_packet(command, 0);
+
+        default:
+            // Unknown command
+            csr = 99;
+            break;
+        }
+
+        return make_packet(command, std::string(1, static_cast<char>(csr)));
+    }
+
+    std::string CesarSimulator::make_packet(uint8_t command, std::string_view data) const {
+        std::string packet;
+        packet += static_cast<char>((m_address << 3) | (data.size() > 6 ? 7 : data.size()));
+        packet += static_cast<char>(command);
+        if (data.size() > 6) {
+            packet += static_cast<char>(data.size());
+        }
+        packet += data;
+
+        char checksum = 0;
+        for (char c : packet) {
+            checksum ^= c;
+        }
+        packet += checksum;
+
+        return packet;
+    }
+
+    std::string CesarSimulator::make_packet(uint8_t command, int value) const {
+        std::string data;
+        append_uint16(data, value);
+        return make_packet(command, data);
+    }
+}  // namespace simulation
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "simulator.h"
+
+#include "app_config.h"
+#include "devices/framer.h"
+
+namespace simulation {
+    // Simulates a Cesar generator: every valid packet is acknowledged, set commands are answered with a command status
+    // response and report commands with their values. Corrupted packets (and rejected ones, see the NACK rate) are answered
+    // with a NACK. Capacitor positions are set and reported in 0.1% steps.
+    class CesarSimulator : public Simulator {
+    public:
+        std::string receive(std::string_view data) override;
+        void reset() override { m_reader.clear(); }
+
+        const Plasma &get_plasma() const { return m_plasma; }
+
+    private:
+        // Returns the reply to a command, data is everything between the command and the checksum
+        std::string handle_command(uint8_t command, std::string_view data);
+
+        // Builds a packet with header, command, data and checksum
+        std::string make_packet(uint8_t command, std::string_view data) const;
+        std::string make_packet(uint8_t command, int value) const;
+
+        framing::FrameReader<framing::CesarFramer> m_reader{DEVICE_RECEIVE_BUFFER_SIZE};
+
+        Plasma m_plasma;
+        bool m_automatic_match = true;
+        // Address of the last request, replies are sent from it
+        uint8_t m_address = 0;
+    };
+}  // namespace simulation
@@ -0,0 +1,26 @@
+#include "hofi_simulator.h"
+
+namespace simulation {
+    std::string HofiSimulator::receive(std::string_view data) {
+        std::string replies;
+
+        m_reader.push(data.data(), data.size());
+        m_reader.for_each_frame([&](std::string_view command, bool) {
+            constexpr std::string_view select = "HOFIPORT";
+
+            if (reject()) {
+                replies += std::string("NAK\0", 4);
+            } else if (command == "HOFISTATU") {
+                replies += "STA";
+                replies += static_cast<char>(m_port);
+            } else if (command.substr(0, select.size()) == select && command.back() >= '1' && command.back() <= '5') {
+                // Selecting a port is not answered, the driver asks for the status afterwards
+                m_port = command.back() - '0';
+            } else {
+                replies += std::string("NAK\0", 4);
+            }
+        });
+
+        return replies;
+    }
+}  // namespace simulation
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "simulator.h"
+
+#include "app_config.h"
+#include "devices/framer.h"
+
+namespace simulation {
+    // Simulates a Hofi RF switch. It understands "HOFIPORT<n>", which selects port n (1 to 5), and "HOFISTATU", which is
+    // answered with a status of four bytes with the selected port in the last one. Rejected and unknown commands are answered
+    // with "NAK" and a zero byte, which the switch driver does not accept as a port.
+    class HofiSimulator : public Simulator {
+    public:
+        std::string receive(std::string_view data) override;
+        void reset() override { m_reader.clear(); }
+
+        int get_port() const { return m_port; }
+
+    private:
+        static constexpr size_t COMMAND_LENGTH = 9;
+        framing::FrameReader<framing::FixedLengthFramer> m_reader{DEVICE_RECEIVE_BUFFER_SIZE,
+                                                                  framing::FixedLengthFramer(COMMAND_LENGTH)};
+
+        int m_port = 1;
+    };
+}  // namespace simulation
@@ -0,0 +1,86 @@
+#include "kjl_simulator.h"
+
+#include <charconv>
+
+#include "spdlog/fmt/fmt.h"
+
+namespace simulation {
+    namespace {
+        // Parses the number in front of suffix, e.g. "120.0 W" with suffix ".0 W"
+        std::optional<int> parse_value(std::string_view command, std::string_view suffix) {
+            if (command.size() <= suffix.size() || command.substr(command.size() - suffix.size()) != suffix) {
+                return std::nullopt;
+            }
+
+            const auto number = command.substr(0, command.size() - suffix.size());
+            int value = 0;
+            const auto result = std::from_chars(number.data(), number.data() + number.size(), value);
+            if (result.ec != std::errc() || result.ptr != number.data() + number.size()) {
+                return std::nullopt;
+            }
+            return value;
+        }
+    }  // namespace
+
+    std::string KJLSimulator::receive(std::string_view data) {
+        std::string replies;
+
+        m_reader.push(data.data(), data.size());
+        m_reader.for_each_frame([&](std::string_view frame, bool) {
+            const auto command = frame.substr(0, frame.size() - 1);
+
+            std::optional<std::string> answer;
+            if (!reject()) {
+                answer = handle_command(command);
+            }
+
+            replies += command;
+            replies += '\r';
+            replies += answer.value_or("N");
+            replies += '\r';
+        });
+
+        return replies;
+    }
+
+    std::optional<std::string> KJLSimulator::handle_command(std::string_view command) {
+        if (command == "G") {
+            m_plasma.output = true;
+            return "";
+        } else if (command == "S") {
+            m_plasma.output = false;
+            return "";
+        } else if (command == "LPS") {
+            return std::to_string(static_cast<int>(m_plasma.load * 100));
+        } else if (command == "TPS") {
+            return std::to_string(static_cast<int>(m_plasma.tune * 100));
+        } else if (command == "0?") {
+            return std::to_string(m_plasma.dc_bias());
+        } else if (command == "W?") {
+            return std::to_string(m_plasma.forward_power());
+        } else if (command == "R?") {
+            return std::to_string(m_plasma.reflected_power());
+        } else if (command == "Q") {
+            return fmt::format("0000000 {0:04} {1:04} {2:03} 0600", m_plasma.setpoint, m_plasma.forward_power(),
+                               m_plasma.reflected_power());
+        }
+
+        if (auto power = parse_value(command, ".0 W")) {
+            m_plasma.setpoint = *power;
+            return "";
+        }
+
+        for (auto [suffix, position] : {std::pair{" MPL", &m_plasma.load}, std::pair{" MPT", &m_plasma.tune}}) {
+            if (auto value = parse_value(command, suffix)) {
+                if (*value < 0 || *value > 100) {
+                    return std::nullopt;
+                }
+
+                *position = *value / 100.0;
+                return "";
+            }
+        }
+
+        return std::nullopt;
+    }
+}  // namespace simulation
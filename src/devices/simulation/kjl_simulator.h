@@ -0,0 +1,28 @@
+#pragma once
+
+#include <optional>
+
+#include "simulator.h"
+
+#include "app_config.h"
+#include "devices/framer.h"
+
+namespace simulation {
+    // Simulates a KJL generator in echo mode: every command ("<text><cr>") is answered with "<text><cr><answer><cr>", where
+    // the answer is "N" for rejected and unknown commands. Capacitor positions are set and reported in %.
+    class KJLSimulator : public Simulator {
+    public:
+        std::string receive(std::string_view data) override;
+        void reset() override { m_reader.clear(); }
+
+        const Plasma &get_plasma() const { return m_plasma; }
+
+    private:
+        // Returns the answer to a command, std::nullopt for unknown ones
+        std::optional<std::string> handle_command(std::string_view command);
+
+        framing::FrameReader<framing::DelimitedFramer> m_reader{DEVICE_RECEIVE_BUFFER_SIZE, framing::DelimitedFramer('\r', 1)};
+
+        Plasma m_plasma;
+    };
+}  // namespace simulation
@@ -0,0 +1,16 @@
+#include "simulator.h"
+
+// Kept apart from simulator.cpp, so the simulators can be used without the config
+namespace simulation {
+    LinkSettings LinkSettings::from(const config::Segment &settings) {
+        LinkSettings link;
+
+        link.latency = std::chrono::microseconds(std::max(settings.get<int>("latency").value_or(0), 0));
+        link.jitter = std::chrono::microseconds(std::max(settings.get<int>("jitter").value_or(0), 0));
+        link.corruption_rate = std::clamp(settings.get<double>("corruption").value_or(0), 0.0, 1.0);
+        link.nack_rate = std::clamp(settings.get<double>("nack").value_or(0), 0.0, 1.0);
+        link.seed = static_cast<uint32_t>(settings.get<int>("seed").value_or(0));
+
+        return link;
+    }
+}  // namespace simulation
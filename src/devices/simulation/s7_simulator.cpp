@@ -0,0 +1,283 @@
+#include "s7_simulator.h"
+
+#include <optional>
+
+namespace simulation {
+    namespace {
+        constexpr size_t TPKT_HEADER = 4;
+        constexpr size_t JOB_HEADER = 10;
+        constexpr size_t ITEM_SIZE = 12;
+
+        // COTP PDU types
+        constexpr uint8_t CONNECTION_REQUEST = 0xE0;
+        constexpr uint8_t CONNECTION_CONFIRM = 0xD0;
+        constexpr uint8_t DATA = 0xF0;
+
+        // S7 functions
+        constexpr uint8_t SETUP_COMMUNICATION = 0xF0;
+        constexpr uint8_t READ_VAR = 0x04;
+        constexpr uint8_t WRITE_VAR = 0x05;
+
+        // Item return codes
+        constexpr uint8_t SUCCESS = 0xFF;
+        constexpr uint8_t OBJECT_DOES_NOT_EXIST = 0x0A;
+
+        // Transport sizes of requests and of data
+        constexpr uint8_t REQUEST_BIT = 0x01;
+        constexpr uint8_t REQUEST_WORD = 0x04;
+        constexpr uint8_t REQUEST_DWORD = 0x06;
+        constexpr uint8_t DATA_BIT = 0x03;
+        constexpr uint8_t DATA_BYTES = 0x04;
+        constexpr uint8_t DATA_OCTETS = 0x09;
+
+        uint16_t get_uint16(std::string_view data, size_t offset) {
+            return static_cast<uint16_t>(static_cast<uint8_t>(data[offset]) << 8 | static_cast<uint8_t>(data[offset + 1]));
+        }
+
+        void append_uint16(std::string &out, size_t value) {
+            out += static_cast<char>((value >> 8) & 0xFF);
+            out += static_cast<char>(value & 0xFF);
+        }
+
+        std::string make_tpkt(std::string_view payload) {
+            std::string packet{'\x03', '\x00'};
+            append_uint16(packet, TPKT_HEADER + payload.size());
+            packet += payload;
+            return packet;
+        }
+
+        // An item of a read or write request
+        struct Item {
+            uint8_t transport_size = 0;
+            uint16_t length = 0;
+            uint16_t db = 0;
+            uint8_t area = 0;
+            // Address in bits
+            uint32_t address = 0;
+
+            size_t size_in_bytes() const {
+                switch (transport_size) {
+                case REQUEST_BIT:
+                    return 1;
+                case REQUEST_WORD:
+                    return length * 2u;
+                case REQUEST_DWORD:
+                    return length * 4u;
+                default:
+                    return length;
+                }
+            }
+        };
+
+        std::optional<Item> parse_item(std::string_view parameters, size_t index) {
+            const size_t offset = 2 + index * ITEM_SIZE;
+            if (parameters.size() < offset + ITEM_SIZE || static_cast<uint8_t>(parameters[offset]) != 0x12) {
+                return std::nullopt;
+            }
+
+            Item item;
+            item.transport_size = parameters[offset + 3];
+            item.length = get_uint16(parameters, offset + 4);
+            item.db = get_uint16(parameters, offset + 6);
+            item.area = parameters[offset + 8];
+            item.address = static_cast<uint32_t>(static_cast<uint8_t>(parameters[offset + 9])) << 16
+                           | get_uint16(parameters, offset + 10);
+            return item;
+        }
+    }  // namespace
+
+    std::string S7Simulator::receive(std::string_view data) {
+        std::string replies;
+        m_buffer += data;
+
+        while (m_buffer.size() >= TPKT_HEADER) {
+            const size_t length = get_uint16(m_buffer, 2);
+            if (m_buffer[0] != '\x03' || length < TPKT_HEADER + 3) {
+                // Not a TPKT packet, the stream can not be synchronized again
+                m_buffer.clear();
+                break;
+            }
+
+            if (m_buffer.size() < length) {
+                break;
+            }
+
+            replies += handle_packet(std::string_view(m_buffer).substr(0, length));
+            m_buffer.erase(0, length);
+        }
+
+        return replies;
+    }
+
+    void S7Simulator::write(Area area, int db, size_t start, const std::vector<uint8_t> &data) {
+        auto &bytes = memory(area, db, start + data.size());
+        std::copy(data.begin(), data.end(), bytes.begin() + start);
+    }
+
+    std::vector<uint8_t> S7Simulator::read(Area area, int db, size_t start, size_t length) {
+        const auto &bytes = memory(area, db, start + length);
+        return {bytes.begin() + start, bytes.begin() + start + length};
+    }
+
+    std::string S7Simulator::handle_packet(std::string_view packet) {
+        const auto cotp = packet.substr(TPKT_HEADER);
+        const size_t cotp_length = static_cast<uint8_t>(cotp[0]);
+        const uint8_t type = cotp[1];
+
+        if (type == CONNECTION_REQUEST && cotp.size() >= 7) {
+            // Confirm with the source reference of the request as destination and echo its parameters (the TSAPs)
+            std::string confirm{static_cast<char>(cotp_length), static_cast<char>(CONNECTION_CONFIRM), cotp[4], cotp[5],
+                                '\x00', '\x01', '\x00'};
+            confirm += cotp.substr(7, std::min(cotp_length + 1, cotp.size()) - 7);
+            return make_tpkt(confirm);
+        }
+
+        if (type == DATA && cotp.size() > cotp_length + 1) {
+            auto reply = handle_job(cotp.substr(cotp_length + 1));
+            if (reply.empty()) {
+                return {};
+            }
+            return make_tpkt(std::string{'\x02', static_cast<char>(DATA), '\x80'} + reply);
+        }
+
+        return {};
+    }
+
+    std::string S7Simulator::handle_job(std::string_view job) {
+        if (job.size() < JOB_HEADER || static_cast<uint8_t>(job[0]) != 0x32 || job[1] != 1) {
+            return {};
+        }
+
+        const size_t parameter_length = get_uint16(job, 6);
+        const size_t data_length = get_uint16(job, 8);
+        if (job.size() < JOB_HEADER + parameter_length + data_length || parameter_length < 2) {
+            return {};
+        }
+
+        const auto parameters = job.substr(JOB_HEADER, parameter_length);
+        const auto items = job.substr(JOB_HEADER + parameter_length, data_length);
+
+        std::string reply_parameters;
+        std::string reply_data;
+        uint8_t error_class = 0;
+
+        switch (static_cast<uint8_t>(parameters[0])) {
+        case SETUP_COMMUNICATION: {
+            const uint16_t requested = parameters.size() >= 8 ? get_uint16(parameters, 6) : MAX_PDU_SIZE;
+            reply_parameters = std::string(parameters.substr(0, 6));
+            append_uint16(reply_parameters, std::min(requested, MAX_PDU_SIZE));
+            break;
+        }
+        case READ_VAR:
+            reply_parameters = read_items(parameters, reply_data);
+            break;
+        case WRITE_VAR:
+            reply_parameters = write_items(parameters, items, reply_data);
+            break;
+        default:
+            // Function not supported
+            error_class = 0x84;
+            break;
+        }
+
+        // Ack_Data with the PDU reference of the job
+        std::string reply{'\x32', '\x03', '\x00', '\x00', job[4], job[5]};
+        append_uint16(reply, reply_parameters.size());
+        append_uint16(reply, reply_data.size());
+        reply += static_cast<char>(error_class);
+        reply += '\x00';
+
+        return reply + reply_parameters + reply_data;
+    }
+
+    std::string S7Simulator::read_items(std::string_view parameters, std::string &data) {
+        const uint8_t count = parameters[1];
+
+        for (uint8_t i = 0; i < count; i++) {
+            const auto item = parse_item(parameters, i);
+
+            // Every item but the last is padded to an even length
+            if (data.size() % 2 != 0) {
+                data += '\x00';
+            }
+
+            if (!item || reject()) {
+                data += std::string{static_cast<char>(OBJECT_DOES_NOT_EXIST), '\x00', '\x00', '\x00'};
+                continue;
+            }
+
+            const int db = item->area == DB ? item->db : 0;
+            const size_t start = item->address / 8;
+
+            if (item->transport_size == REQUEST_BIT) {
+                const auto &bytes = memory(item->area, db, start + 1);
+                data += std::string{static_cast<char>(SUCCESS), static_cast<char>(DATA_BIT), '\x00', '\x01'};
+                data += static_cast<char>((bytes[start] >> (item->address % 8)) & 1);
+                continue;
+            }
+
+            const size_t length = item->size_in_bytes();
+            const auto &bytes = memory(item->area, db, start + length);
+            data += static_cast<char>(SUCCESS);
+            data += static_cast<char>(DATA_BYTES);
+            append_uint16(data, length * 8);
+            data.append(reinterpret_cast<const char *>(bytes.data() + start), length);
+        }
+
+        return {static_cast<char>(READ_VAR), static_cast<char>(count)};
+    }
+
+    std::string S7Simulator::write_items(std::string_view parameters, std::string_view items, std::string &data) {
+        const uint8_t count = parameters[1];
+        size_t offset = 0;
+
+        for (uint8_t i = 0; i < count; i++) {
+            const auto item = parse_item(parameters, i);
+
+            if (offset % 2 != 0) {
+                offset++;
+            }
+            if (!item || items.size() < offset + 4) {
+                data += static_cast<char>(OBJECT_DOES_NOT_EXIST);
+                continue;
+            }
+
+            // The length of the data is given in bits, except for octet strings
+            const uint8_t transport_size = items[offset + 1];
+            size_t length = get_uint16(items, offset + 2);
+            if (transport_size != DATA_OCTETS) {
+                length = (length + 7) / 8;
+            }
+
+            const auto value = items.substr(offset + 4, length);
+            offset += 4 + length;
+
+            if (value.size() < length || reject()) {
+                data += static_cast<char>(OBJECT_DOES_NOT_EXIST);
+                continue;
+            }
+
+            const int db = item->area == DB ? item->db : 0;
+            const size_t start = item->address / 8;
+            auto &bytes = memory(item->area, db, start + length);
+
+            if (transport_size == DATA_BIT) {
+                const uint8_t mask = static_cast<uint8_t>(1 << (item->address % 8));
+                bytes[start] = static_cast<uint8_t>(value[0] ? bytes[start] | mask : bytes[start] & ~mask);
+            } else {
+                std::copy(value.begin(), value.end(), bytes.begin() + start);
+            }
+            data += static_cast<char>(SUCCESS);
+        }
+
+        return {static_cast<char>(WRITE_VAR), static_cast<char>(count)};
+    }
+
+    std::vector<uint8_t> &S7Simulator::memory(uint8_t area, int db, size_t size) {
+        auto &bytes = m_memory[{area, db}];
+        if (bytes.size() < size) {
+            bytes.resize(size);
+        }
+        return bytes;
+    }
+}  // namespace simulation
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "simulator.h"
+
+namespace simulation {
+    // Stands in for an S7 PLC reached over ISO on TCP (RFC 1006), as used by libnodave: TPKT packets with a COTP header,
+    // carrying S7 jobs. It accepts the connection request, negotiates the PDU size and answers read and write requests from
+    // its own memory, which grows as it is accessed. Rejected items (see the NACK rate) are answered with the return code for
+    // an object that does not exist.
+    //
+    // Since libnodave needs a socket of its own, the simulator is reached through a SimulatorServer instead of a
+    // LoopbackConnector.
+    class S7Simulator : public Simulator {
+    public:
+        enum Area : uint8_t { Inputs = 0x81, Outputs = 0x82, Flags = 0x83, DB = 0x84 };
+
+        std::string receive(std::string_view data) override;
+        void reset() override { m_buffer.clear(); }
+
+        // Direct access to the memory, db is only used for the DB area
+        void write(Area area, int db, size_t start, const std::vector<uint8_t> &data);
+        std::vector<uint8_t> read(Area area, int db, size_t start, size_t length);
+
+        // PDU size the simulator agrees to at most
+        static constexpr uint16_t MAX_PDU_SIZE = 240;
+
+    private:
+        // Returns the reply to a TPKT packet, packet includes the TPKT header
+        std::string handle_packet(std::string_view packet);
+        // Returns the reply to an S7 job
+        std::string handle_job(std::string_view job);
+
+        std::string read_items(std::string_view parameters, std::string &data);
+        std::string write_items(std::string_view parameters, std::string_view items, std::string &data);
+
+        std::vector<uint8_t> &memory(uint8_t area, int db, size_t size);
+
+        std::string m_buffer;
+        std::map<std::pair<uint8_t, int>, std::vector<uint8_t>> m_memory;
+    };
+}  // namespace simulation
@@ -0,0 +1,72 @@
+#include "simulator.h"
+
+#include "cesar_simulator.h"
+#include "hofi_simulator.h"
+#include "kjl_simulator.h"
+#include "s7_simulator.h"
+
+namespace simulation {
+    void Simulator::set_nack_rate(double rate, uint32_t seed) {
+        m_random.seed(seed);
+        m_nack = std::bernoulli_distribution(std::clamp(rate, 0.0, 1.0));
+    }
+
+    Link::Link(const LinkSettings &settings)
+        : m_settings(settings),
+          m_random(settings.seed),
+          m_jitter(0, settings.jitter.count()),
+          m_corruption(std::clamp(settings.corruption_rate, 0.0, 1.0)) {}
+
+    void Link::send(std::string data, Clock::time_point now) {
+        if (data.empty()) {
+            return;
+        }
+
+        if (m_corruption(m_random)) {
+            std::uniform_int_distribution<size_t> bit(0, data.size() * 8 - 1);
+            const auto index = bit(m_random);
+            data[index / 8] = static_cast<char>(data[index / 8] ^ (1 << (index % 8)));
+            m_corrupted++;
+        }
+
+        const auto delay = m_settings.latency + std::chrono::microseconds(m_settings.jitter.count() > 0 ? m_jitter(m_random) : 0);
+        // Data never overtakes data sent before it
+        auto time = now + delay;
+        if (!m_queue.empty()) {
+            time = std::max(time, m_queue.back().first);
+        }
+
+        m_queue.emplace_back(time, std::move(data));
+    }
+
+    std::optional<Link::Clock::time_point> Link::next_delivery() const {
+        if (m_queue.empty()) {
+            return std::nullopt;
+        }
+        return m_queue.front().first;
+    }
+
+    std::optional<int> Link::timer_interval(Clock::time_point now) const {
+        auto next = next_delivery();
+        if (!next) {
+            return std::nullopt;
+        }
+
+        const auto delay = std::chrono::floor<std::chrono::milliseconds>(*next - now);
+        return std::max(0, static_cast<int>(delay.count()));
+    }
+
+    std::unique_ptr<Simulator> make_simulator(std::string_view type) {
+        if (type == "cesar") {
+            return std::make_unique<CesarSimulator>();
+        } else if (type == "kjl") {
+            return std::make_unique<KJLSimulator>();
+        } else if (type == "hofi") {
+            return std::make_unique<HofiSimulator>();
+        } else if (type == "s7") {
+            return std::make_unique<S7Simulator>();
+        }
+
+        return nullptr;
+    }
+}  // namespace simulation
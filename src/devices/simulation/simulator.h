@@ -0,0 +1,130 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "config/segment.h"
+
+// Simulators stand in for the hardware, so the drivers can be run and measured without it. A simulator gets the bytes a device
+// writes and returns the bytes the real hardware would answer; it knows nothing about timing. The connection in between is
+// simulated by a Link, which delays and corrupts the replies. Both are plain C++ without Qt, LoopbackConnector and
+// SimulatorServer connect them to the drivers.
+namespace simulation {
+    // Timing and faults of a simulated connection
+    struct LinkSettings {
+        // Time until a reply arrives, plus a uniformly distributed extra delay of up to jitter
+        std::chrono::microseconds latency{0};
+        std::chrono::microseconds jitter{0};
+        // Probability that a reply arrives with a flipped bit
+        double corruption_rate = 0;
+        // Probability that a request is rejected with the negative reply of the protocol
+        double nack_rate = 0;
+        // Seed of the random numbers, so runs can be reproduced
+        uint32_t seed = 0;
+
+        // Reads "latency" (us), "jitter" (us), "corruption", "nack" and "seed" from settings
+        static LinkSettings from(const config::Segment &settings);
+    };
+
+    class Simulator {
+    public:
+        virtual ~Simulator() = default;
+
+        // Handles the data written by the device and returns the replies, empty if there are none (yet). Requests may be
+        // split across calls like on a real connection.
+        virtual std::string receive(std::string_view data) = 0;
+
+        // Forgets partially received requests, called when the connection is (re)opened
+        virtual void reset() {}
+
+        void set_nack_rate(double rate, uint32_t seed);
+
+    protected:
+        // Returns true if the current request is to be rejected, according to the NACK rate
+        bool reject() { return m_nack(m_random); }
+
+    private:
+        std::mt19937 m_random;
+        std::bernoulli_distribution m_nack{0};
+    };
+
+    // Link delays and corrupts the replies of a simulator on their way to the device. Replies keep their order, like on a
+    // serial line.
+    class Link {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        explicit Link(const LinkSettings &settings = {});
+
+        // Sends data at now, it is corrupted according to the corruption rate and delivered after the latency and jitter
+        void send(std::string data, Clock::time_point now);
+
+        // Calls func(data) for all data that arrived by now
+        template <typename F>
+        void deliver(Clock::time_point now, F &&func) {
+            while (!m_queue.empty() && m_queue.front().first <= now) {
+                func(m_queue.front().second);
+                m_queue.pop_front();
+            }
+        }
+
+        // Time the next data arrives, empty if nothing is on its way
+        std::optional<Clock::time_point> next_delivery() const;
+
+        // Interval in ms of the (single shot) timer that delivers the next data, empty if nothing is on its way. Qt timers
+        // only resolve whole milliseconds, so the timer fires at the last whole millisecond before the data arrives and then
+        // with an interval of 0, i.e. whenever the event loop is idle, until it arrived. That keeps latencies below 1ms
+        // (and the jitter) to the microsecond, at the cost of a busy event loop for less than a millisecond per reply.
+        std::optional<int> timer_interval(Clock::time_point now) const;
+
+        void clear() { m_queue.clear(); }
+
+        const LinkSettings &get_settings() const { return m_settings; }
+
+        // Number of replies corrupted so far
+        uint64_t corrupted() const { return m_corrupted; }
+
+    private:
+        LinkSettings m_settings;
+        std::mt19937 m_random;
+        std::uniform_int_distribution<int64_t> m_jitter;
+        std::bernoulli_distribution m_corruption;
+
+        std::deque<std::pair<Clock::time_point, std::string>> m_queue;
+        uint64_t m_corrupted = 0;
+    };
+
+    // The RF part every generator simulator shares: forward power follows the setpoint while the output is on, the reflected
+    // power grows with the distance of the capacitors from the match and the DC bias follows the delivered power.
+    struct Plasma {
+        bool output = false;
+        int setpoint = 0;
+        // Capacitor positions as fractions of their range
+        double load = 0.5;
+        double tune = 0.5;
+
+        // Positions with no reflected power
+        double match_load = 0.37;
+        double match_tune = 0.62;
+
+        int forward_power() const { return output ? setpoint : 0; }
+
+        int reflected_power() const {
+            const double mismatch = (load - match_load) * (load - match_load) + 2 * (tune - match_tune) * (tune - match_tune);
+            return static_cast<int>(forward_power() * std::min(mismatch * 4, 1.0));
+        }
+
+        int dc_bias() const { return (forward_power() - reflected_power()) / 2; }
+    };
+
+    // Creates the simulator of a device type: "cesar", "kjl", "hofi" or "s7". Returns nullptr for unknown types.
+    std::unique_ptr<Simulator> make_simulator(std::string_view type);
+}  // namespace simulation
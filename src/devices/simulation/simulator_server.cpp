@@ -0,0 +1,79 @@
+#include "simulator_server.h"
+
+#include "logging/logging.h"
+
+namespace simulation {
+    SimulatorServer::SimulatorServer(std::unique_ptr<Simulator> simulator, const LinkSettings &link)
+        : m_simulator(std::move(simulator)), m_link(link) {
+        m_simulator->set_nack_rate(link.nack_rate, link.seed);
+
+        m_delivery_timer.setSingleShot(true);
+        m_delivery_timer.setTimerType(Qt::PreciseTimer);
+        QObject::connect(&m_delivery_timer, &QTimer::timeout, this, &SimulatorServer::deliver);
+
+        QObject::connect(&m_server, &QTcpServer::newConnection, this, &SimulatorServer::handle_new_connection);
+    }
+
+    bool SimulatorServer::listen(uint16_t port) {
+        if (!m_server.listen(QHostAddress::LocalHost, port)) {
+            logging::main_log()->error("SimulatorServer: unable to listen on port {0}: {1}", port,
+                                       m_server.errorString().toStdString());
+            return false;
+        }
+
+        logging::main_log()->debug("SimulatorServer: listening on port {0}", get_port());
+        return true;
+    }
+
+    void SimulatorServer::handle_new_connection() {
+        auto *client = m_server.nextPendingConnection();
+        if (!client) {
+            return;
+        }
+
+        if (m_client) {
+            m_client->disconnect(this);
+            m_client->deleteLater();
+        }
+
+        m_client = client;
+        m_simulator->reset();
+        m_link.clear();
+        m_delivery_timer.stop();
+
+        QObject::connect(m_client, &QTcpSocket::readyRead, this, &SimulatorServer::handle_ready_read);
+        QObject::connect(m_client, &QTcpSocket::disconnected, this, [this, client]() {
+            if (m_client == client) {
+                m_client = nullptr;
+                m_link.clear();
+            }
+            client->deleteLater();
+        });
+    }
+
+    void SimulatorServer::handle_ready_read() {
+        if (!m_client) {
+            return;
+        }
+
+        const auto data = m_client->readAll();
+        m_link.send(m_simulator->receive(std::string_view(data.constData(), data.size())), Link::Clock::now());
+
+        if (!m_delivery_timer.isActive()) {
+            deliver();
+        }
+    }
+
+    void SimulatorServer::deliver() {
+        m_link.deliver(Link::Clock::now(), [this](const std::string &reply) {
+            if (m_client) {
+                m_client->write(reply.data(), static_cast<qint64>(reply.size()));
+            }
+        });
+
+        auto interval = m_link.timer_interval(Link::Clock::now());
+        if (interval) {
+            m_delivery_timer.start(*interval);
+        }
+    }
+}  // namespace simulation
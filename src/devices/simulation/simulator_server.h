@@ -0,0 +1,44 @@
+#pragma once
+
+#include <memory>
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+#include "simulator.h"
+
+namespace simulation {
+    // SimulatorServer serves a simulator on a TCP port of the local host, for drivers that need a socket of their own instead
+    // of a connector (the S7, whose socket is used by libnodave). The replies travel over a Link like with the
+    // LoopbackConnector. Only one client is served at a time, a new one replaces it.
+    class SimulatorServer : public QObject {
+        Q_OBJECT
+    public:
+        SimulatorServer(std::unique_ptr<Simulator> simulator, const LinkSettings &link = {});
+
+        SimulatorServer(const SimulatorServer &) = delete;
+        SimulatorServer &operator=(const SimulatorServer &) = delete;
+
+        // Starts listening, port 0 picks a free port (see get_port)
+        bool listen(uint16_t port);
+        uint16_t get_port() const { return m_server.serverPort(); }
+
+    private:
+        void handle_new_connection();
+        void handle_ready_read();
+
+        // Sends the replies that arrived to the client and restarts the timer for the next one
+        void deliver();
+
+        std::unique_ptr<Simulator> m_simulator;
+        Link m_link;
+
+        QTcpServer m_server;
+        QTcpSocket *m_client = nullptr;
+
+        // Fires when the next reply arrives
+        QTimer m_delivery_timer{this};
+    };
+}  // namespace simulation
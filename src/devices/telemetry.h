@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+// Telemetry keeps the latest value of each of N fields reported by a device together with the time it was received, so
+// readers can tell how fresh a value is. Changed fields are collected until they are published; publishing is rate limited,
+// so values that arrive in quick succession are coalesced into a single update instead of flooding the receivers.
+template <size_t N>
+class Telemetry {
+public:
+    static_assert(N <= 32, "changed fields are tracked in a 32 bit mask");
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Sample {
+        int value = -1;
+        // Time the value was received, the epoch of the clock if it was never received
+        Clock::time_point timestamp{};
+    };
+
+    void update(size_t field, int value, Clock::time_point now) {
+        m_samples[field] = {value, now};
+        m_changed |= uint32_t{1} << field;
+    }
+
+    const Sample &get(size_t field) const { return m_samples[field]; }
+
+    // Returns true if the field was received and is not older than max_age
+    bool is_fresh(size_t field, Clock::time_point now, Clock::duration max_age) const {
+        const auto &sample = m_samples[field];
+        return sample.timestamp != Clock::time_point{} && now - sample.timestamp <= max_age;
+    }
+
+    // Minimum time between two publishes, 0 publishes every change right away
+    void set_min_interval(Clock::duration interval) { m_min_interval = interval; }
+    Clock::duration get_min_interval() const { return m_min_interval; }
+
+    // Returns the mask of fields that changed since the last publish and starts a new interval, or 0 if nothing changed or
+    // the minimum interval did not pass yet (see next_publish)
+    uint32_t publish(Clock::time_point now) {
+        if (m_changed == 0 || (m_published && now < m_last_publish + m_min_interval)) {
+            return 0;
+        }
+
+        m_published = true;
+        m_last_publish = now;
+        return std::exchange(m_changed, 0);
+    }
+
+    // Time at which the pending changes can be published, empty if nothing changed
+    std::optional<Clock::time_point> next_publish() const {
+        if (m_changed == 0) {
+            return std::nullopt;
+        }
+        return m_published ? m_last_publish + m_min_interval : Clock::time_point{};
+    }
+
+private:
+    std::array<Sample, N> m_samples;
+
+    uint32_t m_changed = 0;
+    bool m_published = false;
+    Clock::time_point m_last_publish;
+    Clock::duration m_min_interval{};
+};
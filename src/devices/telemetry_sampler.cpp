@@ -0,0 +1,109 @@
+#include "telemetry_sampler.h"
+
+#include <algorithm>
+
+size_t TelemetrySampler::add_query(int replies, bool every_burst) {
+    m_queries.push_back({std::max(replies, 0), every_burst});
+    return m_queries.size() - 1;
+}
+
+void TelemetrySampler::clear_queries() {
+    m_queries.clear();
+    m_next_query = 0;
+    m_outstanding = 0;
+}
+
+void TelemetrySampler::set_rate(int rate) { m_rate = std::max(rate, 0); }
+
+std::vector<size_t> TelemetrySampler::next_burst(Clock::time_point now) {
+    std::vector<size_t> burst;
+
+    const auto due = next_due();
+    if (!due || now < *due || m_queries.empty()) {
+        return burst;
+    }
+
+    // Queries of every burst first, then the next one of the others
+    for (size_t i = 0; i < m_queries.size(); i++) {
+        if (m_queries[i].every_burst) {
+            burst.push_back(i);
+        }
+    }
+    for (size_t i = 0; i < m_queries.size(); i++) {
+        const size_t index = (m_next_query + i) % m_queries.size();
+        if (!m_queries[index].every_burst) {
+            burst.push_back(index);
+            m_next_query = index + 1;
+            break;
+        }
+    }
+
+    m_burst_replies = 0;
+    for (auto index : burst) {
+        m_burst_replies += m_queries[index].replies;
+    }
+
+    m_started = true;
+    m_burst_start = now;
+    m_last_event = now;
+    m_outstanding = m_burst_replies;
+
+    return burst;
+}
+
+void TelemetrySampler::on_reply(Clock::time_point now) {
+    if (m_outstanding == 0) {
+        // Not a reply to a query of the sampler
+        return;
+    }
+    m_outstanding--;
+
+    // The replies of a burst arrive one after the other, so the time since the previous one is the time the device took
+    // to answer this query. Smoothed like the round trip time of TCP (RFC 6298).
+    const auto sample = now - m_last_event;
+    m_last_event = now;
+
+    if (m_round_trip_time == Clock::duration::zero()) {
+        m_round_trip_time = sample;
+    } else {
+        m_round_trip_time += (sample - m_round_trip_time) / 8;
+    }
+}
+
+void TelemetrySampler::on_failure(Clock::time_point now) {
+    if (m_outstanding == 0) {
+        return;
+    }
+    m_outstanding--;
+
+    // Error replies are usually answered faster than queries, they would make the round trip time too short. The next
+    // reply is still measured from here, since the device was busy with this query until now.
+    m_last_event = now;
+}
+
+std::optional<TelemetrySampler::Clock::time_point> TelemetrySampler::next_due() const {
+    if (m_rate == 0) {
+        return std::nullopt;
+    }
+
+    if (!m_started) {
+        return Clock::time_point{};
+    }
+
+    if (m_outstanding > 0) {
+        // Wait for the rest of the burst, or give up on it after the timeout
+        return std::max(m_burst_start + interval(), m_burst_start + m_reply_timeout);
+    }
+
+    return m_burst_start + interval();
+}
+
+TelemetrySampler::Clock::duration TelemetrySampler::interval() const {
+    if (m_rate == 0) {
+        return Clock::duration::zero();
+    }
+
+    const Clock::duration target = std::chrono::duration_cast<Clock::duration>(std::chrono::seconds(1)) / m_rate;
+
+    return std::max(target, m_round_trip_time * m_burst_replies);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+// TelemetrySampler schedules the queries that keep the telemetry of a device up to date. Queries are sent in bursts at a
+// target rate: queries marked as every_burst (e.g. forward and reflected power) are part of every burst, the others are
+// added one per burst, round robin.
+//
+// The sampler measures how long the device takes to answer a query and stretches the interval between bursts if a burst
+// would take longer than the target interval, so a slow serial link is never flooded with queries. A new burst is only
+// started once all replies of the previous one arrived (or timed out).
+//
+// Like TransactionEngine it does not do any I/O or timing on its own and is not thread safe.
+class TelemetrySampler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Adds a query that is answered with the given number of replies, returns the index used in next_burst
+    size_t add_query(int replies, bool every_burst);
+    void clear_queries();
+
+    // Target number of bursts per second, 0 disables sampling
+    void set_rate(int rate);
+    int get_rate() const { return m_rate; }
+
+    // Time after which the replies of a burst are considered lost
+    void set_reply_timeout(Clock::duration timeout) { m_reply_timeout = timeout; }
+
+    // Returns the queries to send now and starts a new burst, or nothing if the next burst is not due yet
+    std::vector<size_t> next_burst(Clock::time_point now);
+
+    // A reply to one of the queries arrived
+    void on_reply(Clock::time_point now);
+    // One of the queries was answered but the reply is unusable (e.g. the device rejected the query). It completes the
+    // query like on_reply, but is not used for the round trip time.
+    void on_failure(Clock::time_point now);
+
+    // Time of the next burst, or the time the current burst times out if replies are outstanding. Empty if sampling is
+    // disabled.
+    std::optional<Clock::time_point> next_due() const;
+
+    // Smoothed time the device takes to answer a single query, 0 until the first reply arrived
+    Clock::duration round_trip_time() const { return m_round_trip_time; }
+
+    // Interval between bursts after adapting it to the round trip time
+    Clock::duration interval() const;
+
+private:
+    struct Query {
+        int replies = 1;
+        bool every_burst = false;
+    };
+    std::vector<Query> m_queries;
+
+    int m_rate = 0;
+    Clock::duration m_reply_timeout = std::chrono::seconds(1);
+
+    // Index of the query added to the next burst round robin
+    size_t m_next_query = 0;
+    // Number of replies of the last burst
+    int m_burst_replies = 0;
+
+    bool m_started = false;
+    Clock::time_point m_burst_start;
+    // Time of the last reply (or the start of the burst), used to measure the time of each reply
+    Clock::time_point m_last_event;
+    int m_outstanding = 0;
+
+    Clock::duration m_round_trip_time{};
+};
@@ -0,0 +1,143 @@
+#include "transaction_engine.h"
+
+#include <algorithm>
+
+TransactionEngine::TransactionEngine(size_t window, Clock::duration ack_timeout, Clock::duration reply_timeout,
+                                     int max_attempts)
+    : m_window(std::max<size_t>(window, 1)),
+      m_ack_timeout(ack_timeout),
+      m_reply_timeout(reply_timeout),
+      m_max_attempts(std::max(max_attempts, 1)) {}
+
+void TransactionEngine::set_window(size_t window) { m_window = std::max<size_t>(window, 1); }
+
+void TransactionEngine::submit(uint8_t command, std::string frame, bool expects_reply, Priority priority,
+                               Clock::time_point now) {
+    Transaction transaction;
+    transaction.command = command;
+    transaction.frame = std::move(frame);
+    transaction.expects_reply = expects_reply;
+    m_queue[static_cast<size_t>(priority)].push_back(std::move(transaction));
+
+    fill_window(now);
+}
+
+void TransactionEngine::acknowledge(Clock::time_point now) {
+    if (!m_in_flight.empty()) {
+        auto transaction = std::move(m_in_flight.front());
+        m_in_flight.pop_front();
+
+        if (transaction.expects_reply) {
+            transaction.deadline = now + m_reply_timeout;
+            m_awaiting_reply.push_back(std::move(transaction));
+        }
+    }
+
+    fill_window(now);
+}
+
+void TransactionEngine::reject(Clock::time_point now) {
+    if (!m_in_flight.empty()) {
+        auto transaction = std::move(m_in_flight.front());
+        m_in_flight.pop_front();
+
+        if (transaction.attempts >= m_max_attempts) {
+            fail(transaction, "rejected");
+        } else {
+            // Sent again after all other outstanding commands, so it has to be acknowledged after them as well
+            transmit(transaction, now);
+            m_in_flight.push_back(std::move(transaction));
+        }
+    }
+
+    fill_window(now);
+}
+
+bool TransactionEngine::correlate(uint8_t command) {
+    auto it = std::find_if(m_awaiting_reply.begin(), m_awaiting_reply.end(),
+                           [command](const Transaction &transaction) { return transaction.command == command; });
+    if (it == m_awaiting_reply.end()) {
+        return false;
+    }
+
+    m_awaiting_reply.erase(it);
+    return true;
+}
+
+void TransactionEngine::expire(Clock::time_point now) {
+    // Resend the commands that were not acknowledged in time. Each one is moved to the back, so the order of the
+    // outstanding commands matches the order of the acknowledgements again.
+    const size_t count = m_in_flight.size();
+    for (size_t i = 0; i < count; i++) {
+        auto transaction = std::move(m_in_flight.front());
+        m_in_flight.pop_front();
+
+        if (transaction.deadline > now) {
+            m_in_flight.push_back(std::move(transaction));
+        } else if (transaction.attempts >= m_max_attempts) {
+            fail(transaction, "not acknowledged");
+        } else {
+            transmit(transaction, now);
+            m_in_flight.push_back(std::move(transaction));
+        }
+    }
+
+    auto expired = std::stable_partition(m_awaiting_reply.begin(), m_awaiting_reply.end(),
+                                         [now](const Transaction &transaction) { return transaction.deadline > now; });
+    std::for_each(expired, m_awaiting_reply.end(), [this](const Transaction &transaction) { fail(transaction, "no reply"); });
+    m_awaiting_reply.erase(expired, m_awaiting_reply.end());
+
+    fill_window(now);
+}
+
+std::optional<TransactionEngine::Clock::time_point> TransactionEngine::next_deadline() const {
+    std::optional<Clock::time_point> deadline;
+
+    for (const auto *transactions : {&m_in_flight, &m_awaiting_reply}) {
+        for (const auto &transaction : *transactions) {
+            if (!deadline || transaction.deadline < *deadline) {
+                deadline = transaction.deadline;
+            }
+        }
+    }
+
+    return deadline;
+}
+
+void TransactionEngine::clear() {
+    m_queue[0].clear();
+    m_queue[1].clear();
+    m_in_flight.clear();
+    m_awaiting_reply.clear();
+}
+
+void TransactionEngine::fill_window(Clock::time_point now) {
+    while (m_in_flight.size() < m_window) {
+        auto &queue = !m_queue[static_cast<size_t>(Priority::High)].empty() ? m_queue[static_cast<size_t>(Priority::High)]
+                                                                            : m_queue[static_cast<size_t>(Priority::Normal)];
+        if (queue.empty()) {
+            break;
+        }
+
+        auto transaction = std::move(queue.front());
+        queue.pop_front();
+
+        transmit(transaction, now);
+        m_in_flight.push_back(std::move(transaction));
+    }
+}
+
+void TransactionEngine::transmit(Transaction &transaction, Clock::time_point now) {
+    transaction.attempts++;
+    transaction.deadline = now + m_ack_timeout;
+
+    if (m_send) {
+        m_send(transaction.frame);
+    }
+}
+
+void TransactionEngine::fail(const Transaction &transaction, const char *reason) {
+    if (m_fail) {
+        m_fail(transaction, reason);
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <string>
+
+// TransactionEngine keeps track of commands sent to a device with a request/response protocol: commands are sent as soon as
+// the send window has room, acknowledged or rejected (which resends them) in the order they were sent, retried when they time
+// out and given up after a number of attempts. Replies that arrive after the acknowledgement are correlated to their command
+// by the command id.
+//
+// High priority commands (e.g. turning an output off) are sent before any queued normal commands, so they never wait behind
+// a batch of status queries.
+//
+// The engine does not do any I/O or timing on its own: frames are sent with the send function and the owner calls expire
+// whenever next_deadline is reached. It is not thread safe.
+class TransactionEngine {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Priority : uint8_t { Normal, High };
+
+    struct Transaction {
+        uint8_t command = 0;
+        std::string frame;
+        bool expects_reply = false;
+
+        // Number of times the frame was sent
+        int attempts = 0;
+        // Time by which the acknowledgement (or reply, once acknowledged) has to arrive
+        Clock::time_point deadline;
+    };
+
+    using SendFunction = std::function<void(const std::string &frame)>;
+    // Called with transactions that are given up, reason is a short description for log messages
+    using FailFunction = std::function<void(const Transaction &transaction, const char *reason)>;
+
+    // window is the number of commands that may be sent before the first one was acknowledged, max_attempts the number of
+    // times a command is sent before it is given up
+    TransactionEngine(size_t window, Clock::duration ack_timeout, Clock::duration reply_timeout, int max_attempts);
+
+    void set_send_function(SendFunction send) { m_send = std::move(send); }
+    void set_fail_function(FailFunction fail) { m_fail = std::move(fail); }
+
+    void set_window(size_t window);
+
+    // Queues a command. It is sent right away if the window has room.
+    void submit(uint8_t command, std::string frame, bool expects_reply, Priority priority, Clock::time_point now);
+
+    // The oldest unacknowledged command was acknowledged (ACK) or rejected by the device (NACK, i.e. it has to be resent)
+    void acknowledge(Clock::time_point now);
+    void reject(Clock::time_point now);
+
+    // A reply to command arrived. Returns false if no acknowledged command was waiting for it.
+    bool correlate(uint8_t command);
+
+    // Resends commands whose acknowledgement timed out and gives up replies that did not arrive in time
+    void expire(Clock::time_point now);
+
+    // Earliest time expire has to be called, empty if nothing is outstanding
+    std::optional<Clock::time_point> next_deadline() const;
+
+    // Drops all queued and outstanding commands without reporting them, e.g. when the connection was lost
+    void clear();
+
+    size_t queued() const { return m_queue[0].size() + m_queue[1].size(); }
+    size_t in_flight() const { return m_in_flight.size(); }
+    size_t awaiting_reply() const { return m_awaiting_reply.size(); }
+
+private:
+    // Sends queued commands until the window is full
+    void fill_window(Clock::time_point now);
+    void transmit(Transaction &transaction, Clock::time_point now);
+    void fail(const Transaction &transaction, const char *reason);
+
+    size_t m_window;
+    Clock::duration m_ack_timeout;
+    Clock::duration m_reply_timeout;
+    int m_max_attempts;
+
+    SendFunction m_send;
+    FailFunction m_fail;
+
+    // Commands not sent yet, indexed by Priority
+    std::deque<Transaction> m_queue[2];
+    // Commands sent but not acknowledged yet, in the order they were sent
+    std::deque<Transaction> m_in_flight;
+    // Acknowledged commands waiting for their reply
+    std::deque<Transaction> m_awaiting_reply;
+};
@@ -0,0 +1,227 @@
+#include "chunk.h"
+
+#include <cstring>
+
+#include "util/bits.h"
+
+namespace historian {
+    namespace {
+        // Largest encoding of a sample: a varint of 64 bits and a value with control bits, leading zeros and length
+        constexpr size_t MAX_SAMPLE_SIZE = 10 + 10;
+
+        uint64_t zigzag(int64_t value) { return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63); }
+        int64_t unzigzag(uint64_t value) { return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1); }
+
+        void write_varint(std::vector<uint8_t> &out, uint64_t value) {
+            while (value >= 0x80) {
+                out.push_back(static_cast<uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<uint8_t>(value));
+        }
+
+        uint64_t to_bits(double value) {
+            uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return bits;
+        }
+    }  // namespace
+
+    void BitWriter::write(uint64_t bits, int count) {
+        while (count > 0) {
+            if (m_used == 8) {
+                m_data.push_back(0);
+                m_used = 0;
+            }
+
+            // The next n bits of the value, starting with the most significant one
+            const int free = 8 - m_used;
+            const int n = std::min(free, count);
+            const auto part = static_cast<uint8_t>((bits >> (count - n)) & ((1u << n) - 1));
+
+            m_data.back() |= static_cast<uint8_t>(part << (free - n));
+            m_used += n;
+            count -= n;
+        }
+    }
+
+    void BitWriter::clear() {
+        m_data.clear();
+        m_used = 8;
+    }
+
+    bool BitReader::read(int count, uint64_t &bits) {
+        if (m_position + count > m_size * 8) {
+            return false;
+        }
+
+        bits = 0;
+        while (count > 0) {
+            const int used = static_cast<int>(m_position % 8);
+            const int n = std::min(8 - used, count);
+            const uint8_t byte = m_data[m_position / 8];
+
+            bits = (bits << n) | ((byte >> (8 - used - n)) & ((1u << n) - 1));
+            m_position += n;
+            count -= n;
+        }
+
+        return true;
+    }
+
+    bool ChunkEncoder::append(int64_t time, double value) {
+        if (m_count > 0 && size() + MAX_SAMPLE_SIZE > m_capacity) {
+            return false;
+        }
+
+        const uint64_t bits = to_bits(value);
+
+        if (m_count == 0) {
+            write_varint(m_times, zigzag(time));
+            m_values.write(bits, 64);
+
+            m_first_time = time;
+        } else {
+            const int64_t delta = time - m_time;
+            write_varint(m_times, zigzag(m_count == 1 ? delta : delta - m_delta));
+            m_delta = delta;
+
+            const uint64_t xor_value = bits ^ m_value;
+            if (xor_value == 0) {
+                m_values.write(0, 1);
+            } else {
+                const int leading = util::count_leading_zeros(xor_value);
+                const int trailing = util::count_trailing_zeros(xor_value);
+
+                if (m_leading >= 0 && leading >= m_leading && trailing >= m_trailing) {
+                    // Fits into the meaningful bits of the last value
+                    m_values.write(0b10, 2);
+                    m_values.write(xor_value >> m_trailing, 64 - m_leading - m_trailing);
+                } else {
+                    const int length = 64 - leading - trailing;
+                    m_values.write(0b11, 2);
+                    m_values.write(static_cast<uint64_t>(leading), 6);
+                    m_values.write(static_cast<uint64_t>(length - 1), 6);
+                    m_values.write(xor_value >> trailing, length);
+
+                    m_leading = leading;
+                    m_trailing = trailing;
+                }
+            }
+        }
+
+        m_time = time;
+        m_value = bits;
+        m_count++;
+
+        return true;
+    }
+
+    void ChunkEncoder::clear() {
+        m_times.clear();
+        m_values.clear();
+
+        m_count = 0;
+        m_first_time = 0;
+        m_time = 0;
+        m_delta = 0;
+
+        m_value = 0;
+        m_leading = -1;
+        m_trailing = 0;
+    }
+
+    bool ChunkDecoder::next(int64_t &time, double &value) {
+        if (m_index >= m_count || !read_time(time) || !read_value(value)) {
+            return false;
+        }
+
+        m_index++;
+        return true;
+    }
+
+    bool ChunkDecoder::read_time(int64_t &time) {
+        uint64_t raw = 0;
+        for (int shift = 0;; shift += 7) {
+            if (m_time_position >= m_time_size || shift > 63) {
+                return false;
+            }
+
+            const uint8_t byte = m_times[m_time_position++];
+            raw |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                break;
+            }
+        }
+
+        const int64_t stored = unzigzag(raw);
+        if (m_index == 0) {
+            m_time = stored;
+        } else {
+            m_delta = m_index == 1 ? stored : m_delta + stored;
+            m_time += m_delta;
+        }
+
+        time = m_time;
+        return true;
+    }
+
+    bool ChunkDecoder::read_value(double &value) {
+        uint64_t bits = 0;
+
+        if (m_index == 0) {
+            if (!m_values.read(64, bits)) {
+                return false;
+            }
+            m_value = bits;
+        } else {
+            if (!m_values.read(1, bits)) {
+                return false;
+            }
+
+            if (bits) {
+                uint64_t new_window = 0;
+                if (!m_values.read(1, new_window)) {
+                    return false;
+                }
+
+                if (new_window) {
+                    uint64_t leading = 0;
+                    uint64_t length = 0;
+                    if (!m_values.read(6, leading) || !m_values.read(6, length)) {
+                        return false;
+                    }
+
+                    m_leading = static_cast<int>(leading);
+                    m_trailing = 64 - m_leading - static_cast<int>(length + 1);
+                    if (m_trailing < 0) {
+                        return false;
+                    }
+                }
+
+                if (!m_values.read(64 - m_leading - m_trailing, bits)) {
+                    return false;
+                }
+                m_value ^= bits << m_trailing;
+            }
+        }
+
+        std::memcpy(&value, &m_value, sizeof(value));
+        return true;
+    }
+
+    void ChunkIndex::add(const ChunkInfo &chunk) {
+        if (m_chunks.size() <= chunk.tag) {
+            m_chunks.resize(chunk.tag + 1u);
+        }
+        m_chunks[chunk.tag].push_back(chunk);
+    }
+
+    size_t ChunkIndex::size() const {
+        size_t size = 0;
+        for (const auto &chunks : m_chunks) {
+            size += chunks.size();
+        }
+        return size;
+    }
+}  // namespace historian
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Samples of a tag are stored in chunks. A chunk is columnar, all timestamps come first and all values after them, and both
+// columns are compressed:
+// - Timestamps (us since the epoch) are stored as the change of the distance to the previous sample (delta of delta) in
+//   zigzag varints, so samples taken at a fixed period need a single byte each.
+// - Values are XORed with the previous one and only the bits between the leading and trailing zeros of the result are
+//   stored (as in the Gorilla paper), so an unchanged value takes a single bit.
+//
+// Like the rest of the historian, except for Historian itself, the classes are not thread safe.
+namespace historian {
+    // Appends values of up to 64 bits to a byte buffer, most significant bit first
+    class BitWriter {
+    public:
+        void write(uint64_t bits, int count);
+
+        const std::vector<uint8_t> &data() const { return m_data; }
+        void clear();
+
+    private:
+        std::vector<uint8_t> m_data;
+        // Number of bits used in the last byte
+        int m_used = 8;
+    };
+
+    class BitReader {
+    public:
+        BitReader(const uint8_t *data, size_t size) : m_data(data), m_size(size) {}
+
+        // Returns false if there are less than count bits left
+        bool read(int count, uint64_t &bits);
+
+    private:
+        const uint8_t *m_data;
+        size_t m_size;
+        // Position in bits
+        size_t m_position = 0;
+    };
+
+    class ChunkEncoder {
+    public:
+        // capacity is the maximum size of the encoded chunk in bytes
+        explicit ChunkEncoder(size_t capacity) : m_capacity(capacity) {}
+
+        // Appends a sample, times have to be ascending. Returns false if the chunk is full, the sample is not appended then.
+        bool append(int64_t time, double value);
+
+        void clear();
+
+        bool empty() const { return m_count == 0; }
+        uint32_t count() const { return m_count; }
+        int64_t first_time() const { return m_first_time; }
+        int64_t last_time() const { return m_time; }
+
+        const std::vector<uint8_t> &times() const { return m_times; }
+        const std::vector<uint8_t> &values() const { return m_values.data(); }
+        size_t size() const { return m_times.size() + m_values.data().size(); }
+
+    private:
+        size_t m_capacity;
+
+        std::vector<uint8_t> m_times;
+        BitWriter m_values;
+
+        uint32_t m_count = 0;
+        int64_t m_first_time = 0;
+        int64_t m_time = 0;
+        int64_t m_delta = 0;
+
+        uint64_t m_value = 0;
+        // Leading and trailing zeros of the last stored XOR, values whose XOR fits in between reuse them
+        int m_leading = -1;
+        int m_trailing = 0;
+    };
+
+    // Decodes count samples from the columns written by ChunkEncoder
+    class ChunkDecoder {
+    public:
+        ChunkDecoder(const uint8_t *times, size_t time_size, const uint8_t *values, size_t value_size, uint32_t count)
+            : m_times(times), m_time_size(time_size), m_values(values, value_size), m_count(count) {}
+
+        // Returns false after the last sample or if the chunk is corrupted
+        bool next(int64_t &time, double &value);
+
+    private:
+        bool read_time(int64_t &time);
+        bool read_value(double &value);
+
+        const uint8_t *m_times;
+        size_t m_time_size;
+        size_t m_time_position = 0;
+        BitReader m_values;
+
+        uint32_t m_count;
+        uint32_t m_index = 0;
+
+        int64_t m_time = 0;
+        int64_t m_delta = 0;
+
+        uint64_t m_value = 0;
+        int m_leading = 0;
+        int m_trailing = 0;
+    };
+
+    // A chunk of a tag, where to find it and the time range it covers
+    struct ChunkInfo {
+        uint16_t tag = 0;
+        uint32_t count = 0;
+        int64_t first_time = 0;
+        int64_t last_time = 0;
+        // Offset of the chunk in its segment file
+        uint64_t offset = 0;
+    };
+
+    // ChunkIndex finds the chunks of a tag that overlap a time range. The chunks of a tag are added in time order, so the
+    // first one is found with a binary search.
+    class ChunkIndex {
+    public:
+        void add(const ChunkInfo &chunk);
+        void clear() { m_chunks.clear(); }
+
+        // Calls func(chunk) for every chunk of tag that has samples in [from, to], in time order
+        template <typename F>
+        void find(uint16_t tag, int64_t from, int64_t to, F &&func) const {
+            if (tag >= m_chunks.size()) {
+                return;
+            }
+
+            const auto &chunks = m_chunks[tag];
+            auto it = std::lower_bound(chunks.begin(), chunks.end(), from,
+                                       [](const ChunkInfo &chunk, int64_t time) { return chunk.last_time < time; });
+            for (; it != chunks.end() && it->first_time <= to; ++it) {
+                func(*it);
+            }
+        }
+
+        // Calls func(chunk) for all chunks, ordered by tag and time
+        template <typename F>
+        void for_each(F &&func) const {
+            for (const auto &chunks : m_chunks) {
+                std::for_each(chunks.begin(), chunks.end(), func);
+            }
+        }
+
+        size_t size() const;
+
+    private:
+        // Chunks by tag
+        std::vector<std::vector<ChunkInfo>> m_chunks;
+    };
+}  // namespace historian
@@ -0,0 +1,349 @@
+#include "historian.h"
+
+#include <array>
+#include <cctype>
+
+#include <QDateTime>
+#include <QDir>
+
+#include "devices/plc/s7.h"
+#include "devices/rf_generator.h"
+#include "logging/logging.h"
+
+namespace historian {
+    namespace {
+        // Names of the parameters of RFGenerator::PARAMETER_FIELDS, in the same order
+        constexpr std::array<const char *, RFGenerator::PARAMETER_FIELDS.size()> PARAMETER_NAMES = {
+            "external_feedback", "forward_power", "reflected_power", "setpoint", "load_cap_position", "tune_cap_position",
+            "fault_status"};
+
+        // Run names end up in file names
+        std::string file_name(const std::string &run) {
+            std::string name = run.empty() ? "run"s : run;
+            for (auto &c : name) {
+                if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_') {
+                    c = '_';
+                }
+            }
+            return name;
+        }
+    }  // namespace
+
+    Historian::Historian() {
+        m_flush_timer.setInterval(HISTORIAN_DEFAULT_FLUSH_INTERVAL);
+        QObject::connect(&m_flush_timer, &QTimer::timeout, this, &Historian::flush);
+
+        m_thread.setObjectName("Historian thread");
+    }
+
+    Historian::~Historian() { stop(); }
+
+    void Historian::init(std::shared_ptr<config::Segment> settings) {
+        if (!settings) {
+            return;
+        }
+
+        run_on_thread(
+            [this, settings]() {
+                if (m_recording) {
+                    logging::main_log()->error("Historian: settings can not be changed while recording");
+                    return;
+                }
+
+                m_enabled = settings->get<bool>("enabled").value_or(true);
+                m_path = settings->get<std::string>("path").value_or(HISTORIAN_DEFAULT_PATH);
+
+                if (auto size = settings->get<int>("segmentsize")) {
+                    if (*size < 1) {
+                        logging::main_log()->warn("Historian: ignoring invalid segment size of {0}MB", *size);
+                    } else {
+                        m_segment_size = static_cast<uint64_t>(*size) * 1024 * 1024;
+                    }
+                }
+
+                if (auto interval = settings->get<int>("flushinterval")) {
+                    if (*interval < 1) {
+                        logging::main_log()->warn("Historian: ignoring invalid flush interval of {0}ms", *interval);
+                    } else {
+                        m_flush_timer.setInterval(*interval);
+                    }
+                }
+            },
+            Qt::BlockingQueuedConnection);
+    }
+
+    void Historian::add_generator(RFGenerator *generator, const std::string &name) {
+        if (!generator) {
+            return;
+        }
+
+        run_on_thread(
+            [this, generator, name]() {
+                std::vector<uint16_t> tags;
+                for (const auto *parameter : PARAMETER_NAMES) {
+                    tags.push_back(get_tag(name + "." + parameter));
+                }
+
+                // The signal only tells which parameters changed, the samples are read from the telemetry of the generator
+                QObject::connect(generator, &RFGenerator::update_parameters, this,
+                                 [this, generator, tags](device_id, uint32_t changed) {
+                                     record_parameters(generator, tags, changed);
+                                 });
+                m_sources.push_back(generator);
+            },
+            Qt::BlockingQueuedConnection);
+    }
+
+    void Historian::add_plc(PLC::S7 *plc) {
+        if (!plc) {
+            return;
+        }
+
+        run_on_thread(
+            [this, plc]() {
+                // Connected directly, so the samples are timestamped when the PLC emits them and not when we get to them
+                auto connect_state = [this, plc](auto signal, std::string prefix) {
+                    QObject::connect(
+                        plc, signal, this,
+                        [this, prefix](std::string name, bool state) {
+                            const auto now = Clock::now();
+                            run_on_thread([this, tag = prefix + name, now, state]() { record_plc(tag, now, state); });
+                        },
+                        Qt::DirectConnection);
+                };
+                connect_state(&PLC::S7::flag_changed, "flag."s);
+                connect_state(&PLC::S7::input_changed, "input."s);
+                connect_state(&PLC::S7::output_changed, "output."s);
+
+                QObject::connect(
+                    plc, &PLC::S7::dbword_changed, this,
+                    [this](std::string name, uint16_t data) {
+                        const auto now = Clock::now();
+                        run_on_thread([this, tag = "db." + name, now, data]() { record_plc(tag, now, data); });
+                    },
+                    Qt::DirectConnection);
+                QObject::connect(
+                    plc, &PLC::S7::dbdword_changed, this,
+                    [this](std::string name, uint32_t data) {
+                        const auto now = Clock::now();
+                        run_on_thread([this, tag = "db." + name, now, data]() { record_plc(tag, now, data); });
+                    },
+                    Qt::DirectConnection);
+
+                m_sources.push_back(plc);
+            },
+            Qt::BlockingQueuedConnection);
+    }
+
+    void Historian::start(const std::string &run) {
+        if (!m_enabled) {
+            return;
+        }
+
+        if (m_recording) {
+            start_run(run);
+            return;
+        }
+
+        if (!m_thread.isRunning()) {
+            m_flush_timer.moveToThread(&m_thread);
+            moveToThread(&m_thread);
+
+            m_thread.start();
+        }
+
+        run_on_thread([this, run]() {
+            if (m_recording) {
+                return;
+            }
+
+            m_system_epoch = std::chrono::system_clock::now();
+            m_steady_epoch = Clock::now();
+
+            m_run = run;
+            if (open_segment()) {
+                m_flush_timer.start();
+                m_recording = true;
+            }
+        });
+    }
+
+    void Historian::start_run(const std::string &run) {
+        run_on_thread([this, run]() {
+            if (!m_recording) {
+                return;
+            }
+
+            close_segment();
+
+            m_run = run;
+            if (!open_segment()) {
+                m_flush_timer.stop();
+                m_recording = false;
+            }
+        });
+    }
+
+    void Historian::stop() {
+        QThread *caller = QThread::currentThread();
+        run_on_thread(
+            [this, caller]() {
+                m_flush_timer.stop();
+                close_segment();
+                m_recording = false;
+
+                for (auto *source : m_sources) {
+                    QObject::disconnect(source, nullptr, this, nullptr);
+                }
+                m_sources.clear();
+
+                // Only the thread an object lives in can move it, hand it back so start can move it to the thread again
+                m_flush_timer.moveToThread(caller);
+                moveToThread(caller);
+            },
+            Qt::BlockingQueuedConnection);
+
+        // The thread must not outlive the event loop of the application, e.g. when the historian is destroyed on exit
+        if (m_thread.isRunning() && caller != &m_thread) {
+            m_thread.quit();
+            m_thread.wait();
+        }
+    }
+
+    void Historian::record(uint16_t tag, int64_t time, double value) {
+        auto &series = m_series[tag];
+        if (!m_writer.is_open() || time <= series.last_time) {
+            return;
+        }
+        series.last_time = time;
+
+        if (!series.chunk.append(time, value)) {
+            seal(tag);
+            series.chunk.append(time, value);
+
+            roll_if_full();
+        }
+    }
+
+    void Historian::record_parameters(RFGenerator *generator, const std::vector<uint16_t> &tags, uint32_t changed) {
+        if (!m_recording) {
+            return;
+        }
+
+        // Changes that were coalesced before publishing are lost, only the latest sample of a parameter is recorded
+        const auto telemetry = generator->get_telemetry();
+        for (size_t i = 0; i < tags.size(); i++) {
+            if (changed & (uint32_t{1} << i)) {
+                const auto &sample = telemetry.get(i);
+                if (sample.timestamp != Clock::time_point{}) {
+                    record(tags[i], to_time(sample.timestamp), sample.value);
+                }
+            }
+        }
+    }
+
+    void Historian::record_plc(const std::string &name, Clock::time_point time, double value) {
+        if (m_recording) {
+            record(get_tag(name), to_time(time), value);
+        }
+    }
+
+    void Historian::seal(uint16_t tag) {
+        auto &series = m_series[tag];
+        if (series.chunk.empty()) {
+            return;
+        }
+
+        if (!series.defined) {
+            series.defined = m_writer.write_tag(tag, series.name);
+        }
+
+        if (!m_writer.write_chunk(tag, series.chunk)) {
+            logging::main_log()->error("Historian: dropped {0} samples of '{1}'", series.chunk.count(), series.name);
+        }
+        series.chunk.clear();
+    }
+
+    void Historian::flush() {
+        for (size_t tag = 0; tag < m_series.size(); tag++) {
+            seal(static_cast<uint16_t>(tag));
+        }
+
+        roll_if_full();
+    }
+
+    void Historian::roll_if_full() {
+        if (m_writer.size() < m_segment_size) {
+            return;
+        }
+
+        close_segment();
+        if (!open_segment()) {
+            m_flush_timer.stop();
+            m_recording = false;
+        }
+    }
+
+    bool Historian::open_segment() {
+        if (!QDir().mkpath(QString::fromStdString(m_path))) {
+            logging::main_log()->error("Historian: unable to create the directory '{0}'", m_path);
+            return false;
+        }
+
+        // Segments of the same run are told apart by the time they were started at
+        const auto time = QDateTime::currentDateTime().toString("yyyyMMdd-HHmmsszzz").toStdString();
+        const auto path = QDir(QString::fromStdString(m_path))
+                              .filePath(QString::fromStdString(time + "-" + file_name(m_run) + ".hist"))
+                              .toStdString();
+
+        if (!m_writer.open(path, m_run, to_time(Clock::now()))) {
+            return false;
+        }
+
+        logging::main_log()->info("Historian: recording run '{0}' to '{1}'", m_run, path);
+        return true;
+    }
+
+    void Historian::close_segment() {
+        if (!m_writer.is_open()) {
+            return;
+        }
+
+        for (size_t tag = 0; tag < m_series.size(); tag++) {
+            seal(static_cast<uint16_t>(tag));
+        }
+        m_writer.close();
+
+        for (auto &series : m_series) {
+            series.defined = false;
+        }
+    }
+
+    uint16_t Historian::get_tag(const std::string &name) {
+        auto it = m_tags.find(name);
+        if (it != m_tags.end()) {
+            return it->second;
+        }
+
+        const auto tag = static_cast<uint16_t>(m_series.size());
+        m_series.emplace_back();
+        m_series.back().name = name;
+        m_tags.emplace(name, tag);
+
+        return tag;
+    }
+
+    int64_t Historian::to_time(Clock::time_point time) const {
+        const auto since_epoch = m_system_epoch.time_since_epoch() + (time - m_steady_epoch);
+        return std::chrono::duration_cast<std::chrono::microseconds>(since_epoch).count();
+    }
+
+    void Historian::run_on_thread(std::function<void()> func, Qt::ConnectionType type) {
+        if (!m_thread.isRunning() || QThread::currentThread() == &m_thread) {
+            func();
+            return;
+        }
+
+        QMetaObject::invokeMethod(this, std::move(func), type);
+    }
+}  // namespace historian
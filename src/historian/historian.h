@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+
+#include "app_config.h"
+#include "chunk.h"
+#include "config/segment.h"
+#include "segment.h"
+
+class RFGenerator;
+namespace PLC {
+    class S7;
+}
+
+namespace historian {
+    // Historian records the process values into segment files, one or more per run (see SegmentWriter). Every value is a tag
+    // with a series of timestamped samples: the parameters of the RF generators as "<device>.<parameter>" and the flags,
+    // inputs, outputs and DB values of the PLC as "flag.<name>", "input.<name>", "output.<name>" and "db.<name>" with their
+    // names in the PLC config. PLC values are only sampled when they change.
+    //
+    // Recording happens on a dedicated thread, so the sources only pay for a queued call. Samples are collected in a chunk
+    // per tag, a chunk is written to the segment once it is full or the flush interval passed. Generator samples carry the
+    // time the generator received them, PLC samples the time the PLC emitted the change.
+    //
+    // All functions may be called from any thread, they are executed on the historian thread once it was started.
+    class Historian : public QObject {
+        Q_OBJECT
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        Historian();
+        ~Historian();
+
+        Historian(const Historian &) = delete;
+        Historian &operator=(const Historian &) = delete;
+
+        // Reads "enabled", "path" (directory of the segment files), "segmentsize" (MB) and "flushinterval" (ms)
+        void init(std::shared_ptr<config::Segment> settings);
+
+        bool is_enabled() const { return m_enabled; }
+        bool is_recording() const { return m_recording; }
+
+        void add_generator(RFGenerator *generator, const std::string &name);
+        void add_plc(PLC::S7 *plc);
+
+        // Opens the segment of the first run and starts recording
+        void start(const std::string &run);
+        // Writes the pending chunks and continues recording into a new segment for run
+        void start_run(const std::string &run);
+        // Writes the pending chunks, closes the segment, disconnects from all sources and stops the historian thread
+        void stop();
+
+    private:
+        struct Series {
+            std::string name;
+            ChunkEncoder chunk{HISTORIAN_CHUNK_SIZE};
+            // The tag was defined in the current segment
+            bool defined = false;
+            // Time of the last sample, later samples with the same or an earlier time are dropped
+            int64_t last_time = INT64_MIN;
+        };
+
+        // Everything below runs on the historian thread
+        void record(uint16_t tag, int64_t time, double value);
+        void record_parameters(RFGenerator *generator, const std::vector<uint16_t> &tags, uint32_t changed);
+        void record_plc(const std::string &name, Clock::time_point time, double value);
+
+        // Writes the chunk of a tag to the segment
+        void seal(uint16_t tag);
+        // Writes the chunks of all tags
+        void flush();
+        // Continues the run in a new segment if the current one got too large
+        void roll_if_full();
+
+        bool open_segment();
+        void close_segment();
+
+        // Returns the id of the tag with name, adding it if it is new
+        uint16_t get_tag(const std::string &name);
+
+        // Time in us since the epoch for a time of the steady clock
+        int64_t to_time(Clock::time_point time) const;
+
+        void run_on_thread(std::function<void()> func, Qt::ConnectionType type = Qt::QueuedConnection);
+
+        std::atomic<bool> m_enabled{true};
+        std::string m_path = HISTORIAN_DEFAULT_PATH;
+        uint64_t m_segment_size = uint64_t{HISTORIAN_DEFAULT_SEGMENT_SIZE} * 1024 * 1024;
+
+        std::atomic<bool> m_recording{false};
+        std::string m_run;
+
+        // A pair of times of the system and the steady clock taken at the same moment, to convert between them
+        std::chrono::system_clock::time_point m_system_epoch;
+        Clock::time_point m_steady_epoch;
+
+        std::vector<Series> m_series;
+        std::unordered_map<std::string, uint16_t> m_tags;
+
+        SegmentWriter m_writer;
+
+        // Objects our slots are connected to
+        std::vector<QObject *> m_sources;
+
+        QThread m_thread;
+        QTimer m_flush_timer;
+    };
+}  // namespace historian
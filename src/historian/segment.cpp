@@ -0,0 +1,345 @@
+#include "segment.h"
+
+#include <cstring>
+
+#include "app_config.h"
+#include "logging/logging.h"
+
+namespace historian {
+    namespace {
+        constexpr char MAGIC[8] = "WTHIST1";
+        constexpr uint32_t VERSION = 1;
+        constexpr uint32_t RECORD_MAGIC = 0x43455257;  // "WREC"
+
+        enum RecordType : uint8_t { Tag = 1, Chunk = 2, Index = 3 };
+
+        struct FileHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t reserved;
+            int64_t start_time;
+            // Offset of the index record, 0 while the segment is written
+            uint64_t index_offset;
+            char run[32];
+        };
+        static_assert(sizeof(FileHeader) == 64, "the file header takes 64 bytes");
+
+        struct RecordHeader {
+            uint32_t magic;
+            uint8_t type;
+            uint8_t reserved;
+            uint16_t tag;
+            // Size of the payload, the next record starts at the next multiple of 8 after it
+            uint32_t size;
+            // Chunks: the number of samples and the time range, Index: the number of tags
+            uint32_t count;
+            int64_t first_time;
+            int64_t last_time;
+            // Chunks: size of the time column, the value column follows it
+            uint32_t time_size;
+            uint32_t reserved2;
+        };
+        static_assert(sizeof(RecordHeader) == 40, "a record header takes 40 bytes");
+
+        // An entry of the index record, it follows the names of all tags (a 16 bit length and the characters each)
+        struct IndexEntry {
+            uint16_t tag;
+            uint16_t reserved;
+            uint32_t count;
+            int64_t first_time;
+            int64_t last_time;
+            uint64_t offset;
+        };
+        static_assert(sizeof(IndexEntry) == 32, "an index entry takes 32 bytes");
+
+        constexpr uint64_t padded(uint64_t size) { return (size + 7) & ~uint64_t{7}; }
+
+        template <typename T>
+        void append(std::vector<uint8_t> &out, const T &value) {
+            const auto *bytes = reinterpret_cast<const uint8_t *>(&value);
+            out.insert(out.end(), bytes, bytes + sizeof(T));
+        }
+
+        // Reads a T at offset, returns false if it does not fit into size
+        template <typename T>
+        bool read(const uchar *data, uint64_t size, uint64_t offset, T &value) {
+            if (offset + sizeof(T) > size) {
+                return false;
+            }
+            std::memcpy(&value, data + offset, sizeof(T));
+            return true;
+        }
+    }  // namespace
+
+    bool SegmentWriter::open(const std::string &path, const std::string &run, int64_t start_time) {
+        close();
+
+        m_file.setFileName(QString::fromStdString(path));
+        if (!m_file.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+            logging::main_log()->error("Historian: unable to create the segment '{0}': {1}", path,
+                                       m_file.errorString().toStdString());
+            return false;
+        }
+
+        if (!reserve(sizeof(FileHeader))) {
+            m_file.close();
+            return false;
+        }
+
+        FileHeader header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.start_time = start_time;
+        std::strncpy(header.run, run.c_str(), sizeof(header.run) - 1);
+
+        std::memcpy(m_map, &header, sizeof(header));
+        m_size = sizeof(header);
+
+        return true;
+    }
+
+    void SegmentWriter::close() {
+        if (!m_map) {
+            return;
+        }
+
+        // Names of all tags followed by all chunks
+        std::vector<uint8_t> index;
+        for (const auto &name : m_tags) {
+            append(index, static_cast<uint16_t>(name.size()));
+            index.insert(index.end(), name.begin(), name.end());
+        }
+        m_index.for_each([&index](const ChunkInfo &chunk) {
+            append(index, IndexEntry{chunk.tag, 0, chunk.count, chunk.first_time, chunk.last_time, chunk.offset});
+        });
+
+        const uint64_t index_offset = m_size;
+        ChunkInfo info;
+        info.count = static_cast<uint32_t>(m_tags.size());
+        if (write_record(RecordType::Index, 0, info, 0, {{index.data(), index.size()}})) {
+            std::memcpy(m_map + offsetof(FileHeader, index_offset), &index_offset, sizeof(index_offset));
+        }
+
+        m_file.unmap(m_map);
+        m_map = nullptr;
+        m_capacity = 0;
+
+        // The file was grown in steps
+        m_file.resize(static_cast<qint64>(m_size));
+        m_file.close();
+
+        m_size = 0;
+        m_tags.clear();
+        m_index.clear();
+    }
+
+    bool SegmentWriter::write_tag(uint16_t tag, const std::string &name) {
+        if (m_tags.size() <= tag) {
+            m_tags.resize(tag + 1u);
+        }
+        m_tags[tag] = name.substr(0, UINT16_MAX);
+
+        return write_record(RecordType::Tag, tag, {}, 0, {{m_tags[tag].data(), m_tags[tag].size()}});
+    }
+
+    bool SegmentWriter::write_chunk(uint16_t tag, const ChunkEncoder &chunk) {
+        if (chunk.empty()) {
+            return true;
+        }
+
+        const ChunkInfo info{tag, chunk.count(), chunk.first_time(), chunk.last_time(), m_size};
+        const auto &times = chunk.times();
+        const auto &values = chunk.values();
+
+        if (!write_record(RecordType::Chunk, tag, info, static_cast<uint32_t>(times.size()),
+                          {{times.data(), times.size()}, {values.data(), values.size()}})) {
+            return false;
+        }
+
+        m_index.add(info);
+        return true;
+    }
+
+    bool SegmentWriter::write_record(uint8_t type, uint16_t tag, const ChunkInfo &info, uint32_t time_size,
+                                     std::initializer_list<std::pair<const void *, size_t>> parts) {
+        uint64_t size = 0;
+        for (const auto &part : parts) {
+            size += part.second;
+        }
+
+        if (!m_map || size > UINT32_MAX || !reserve(sizeof(RecordHeader) + padded(size))) {
+            return false;
+        }
+
+        uchar *payload = m_map + m_size + sizeof(RecordHeader);
+        for (const auto &part : parts) {
+            std::memcpy(payload, part.first, part.second);
+            payload += part.second;
+        }
+        std::memset(payload, 0, padded(size) - size);
+
+        RecordHeader header{};
+        header.magic = RECORD_MAGIC;
+        header.type = type;
+        header.tag = tag;
+        header.size = static_cast<uint32_t>(size);
+        header.count = info.count;
+        header.first_time = info.first_time;
+        header.last_time = info.last_time;
+        header.time_size = time_size;
+        std::memcpy(m_map + m_size, &header, sizeof(header));
+
+        m_size += sizeof(RecordHeader) + padded(size);
+        return true;
+    }
+
+    bool SegmentWriter::reserve(uint64_t size) {
+        if (m_size + size <= m_capacity) {
+            return true;
+        }
+
+        if (m_map) {
+            m_file.unmap(m_map);
+            m_map = nullptr;
+        }
+
+        const uint64_t growth = HISTORIAN_FILE_GROWTH;
+        m_capacity = (m_size + size + growth - 1) / growth * growth;
+
+        if (!m_file.resize(static_cast<qint64>(m_capacity))
+            || !(m_map = m_file.map(0, static_cast<qint64>(m_capacity)))) {
+            logging::main_log()->error("Historian: unable to grow the segment '{0}' to {1} bytes: {2}",
+                                       m_file.fileName().toStdString(), m_capacity, m_file.errorString().toStdString());
+            m_capacity = 0;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool SegmentReader::open(const std::string &path) {
+        close();
+
+        m_file.setFileName(QString::fromStdString(path));
+        if (!m_file.open(QIODevice::ReadOnly)) {
+            logging::main_log()->error("Historian: unable to open the segment '{0}': {1}", path,
+                                       m_file.errorString().toStdString());
+            return false;
+        }
+
+        m_size = static_cast<uint64_t>(m_file.size());
+
+        FileHeader header{};
+        if (m_size < sizeof(header) || !(m_map = m_file.map(0, m_file.size()))) {
+            logging::main_log()->error("Historian: unable to map the segment '{0}'", path);
+            close();
+            return false;
+        }
+
+        std::memcpy(&header, m_map, sizeof(header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) {
+            logging::main_log()->error("Historian: '{0}' is not a segment of version {1}", path, VERSION);
+            close();
+            return false;
+        }
+
+        m_run.assign(header.run, strnlen(header.run, sizeof(header.run)));
+        m_start_time = header.start_time;
+
+        if (header.index_offset == 0 || !read_index(header.index_offset)) {
+            logging::main_log()->warn("Historian: segment '{0}' was not closed, rebuilding its index", path);
+            scan();
+        }
+
+        m_end_time = m_start_time;
+        m_index.for_each([this](const ChunkInfo &chunk) { m_end_time = std::max(m_end_time, chunk.last_time); });
+
+        return true;
+    }
+
+    void SegmentReader::close() {
+        if (m_map) {
+            m_file.unmap(const_cast<uchar *>(m_map));
+            m_map = nullptr;
+        }
+        m_file.close();
+
+        m_size = 0;
+        m_tags.clear();
+        m_index.clear();
+    }
+
+    std::optional<uint16_t> SegmentReader::find_tag(const std::string &name) const {
+        auto it = std::find(m_tags.begin(), m_tags.end(), name);
+        if (it == m_tags.end()) {
+            return std::nullopt;
+        }
+        return static_cast<uint16_t>(it - m_tags.begin());
+    }
+
+    bool SegmentReader::read_index(uint64_t offset) {
+        RecordHeader header{};
+        if (!read(m_map, m_size, offset, header) || header.magic != RECORD_MAGIC || header.type != RecordType::Index
+            || offset + sizeof(header) + header.size > m_size) {
+            return false;
+        }
+
+        uint64_t position = offset + sizeof(header);
+        const uint64_t end = position + header.size;
+
+        std::vector<std::string> tags(header.count);
+        for (auto &tag : tags) {
+            uint16_t length = 0;
+            if (!read(m_map, end, position, length) || position + sizeof(length) + length > end) {
+                return false;
+            }
+            tag.assign(reinterpret_cast<const char *>(m_map + position + sizeof(length)), length);
+            position += sizeof(length) + length;
+        }
+
+        ChunkIndex index;
+        for (IndexEntry entry{}; read(m_map, end, position, entry); position += sizeof(entry)) {
+            index.add({entry.tag, entry.count, entry.first_time, entry.last_time, entry.offset});
+        }
+
+        m_tags = std::move(tags);
+        m_index = std::move(index);
+        return true;
+    }
+
+    void SegmentReader::scan() {
+        m_tags.clear();
+        m_index.clear();
+
+        RecordHeader header{};
+        for (uint64_t offset = sizeof(FileHeader); read(m_map, m_size, offset, header);
+             offset += sizeof(header) + padded(header.size)) {
+            if (header.magic != RECORD_MAGIC || offset + sizeof(header) + header.size > m_size) {
+                // The end of the data, the rest was reserved for the next records
+                break;
+            }
+
+            if (header.type == RecordType::Tag) {
+                if (m_tags.size() <= header.tag) {
+                    m_tags.resize(header.tag + 1u);
+                }
+                m_tags[header.tag].assign(reinterpret_cast<const char *>(m_map + offset + sizeof(header)), header.size);
+            } else if (header.type == RecordType::Chunk) {
+                m_index.add({header.tag, header.count, header.first_time, header.last_time, offset});
+            }
+        }
+    }
+
+    ChunkDecoder SegmentReader::make_decoder(const ChunkInfo &chunk) const {
+        RecordHeader header{};
+        if (!read(m_map, m_size, chunk.offset, header) || header.magic != RECORD_MAGIC || header.type != RecordType::Chunk
+            || chunk.offset + sizeof(header) + header.size > m_size || header.time_size > header.size) {
+            logging::main_log()->warn("Historian: corrupted chunk at offset {0} of '{1}'", chunk.offset,
+                                      m_file.fileName().toStdString());
+            return {nullptr, 0, nullptr, 0, 0};
+        }
+
+        const uchar *times = m_map + chunk.offset + sizeof(header);
+        return {times, header.time_size, times + header.time_size, header.size - header.time_size, header.count};
+    }
+}  // namespace historian
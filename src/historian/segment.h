@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <QFile>
+
+#include "chunk.h"
+
+// A segment file holds the samples of one run (or a part of it, long runs are split into several segments):
+// - A header of 64 bytes with the magic "WTHIST1", the version, the start time of the segment in us since the epoch, the
+//   offset of the index (0 until the segment is closed) and the name of the run.
+// - Records, each starting at a multiple of 8 bytes with a header of 40 bytes (see the .cpp): the definition of a tag (its
+//   id and name), the chunks of the tags (see ChunkEncoder) and, once the segment is closed, the index with all tags and
+//   chunks.
+//
+// The writer maps the file into memory and grows it in steps of HISTORIAN_FILE_GROWTH, so appending a chunk is a memcpy
+// and the operating system writes the pages in the background. A record header is written after its payload, so a
+// segment that was never closed (e.g. after a crash) is still read up to its last complete record.
+namespace historian {
+    class SegmentWriter {
+    public:
+        SegmentWriter() = default;
+        SegmentWriter(const SegmentWriter &) = delete;
+        SegmentWriter &operator=(const SegmentWriter &) = delete;
+        ~SegmentWriter() { close(); }
+
+        // Creates the segment file, overwriting an existing one
+        bool open(const std::string &path, const std::string &run, int64_t start_time);
+        // Writes the index and truncates the file to the used size
+        void close();
+
+        bool is_open() const { return m_map != nullptr; }
+
+        // Defines the name of tag. Tags are numbered densely from 0 and defined before their first chunk.
+        bool write_tag(uint16_t tag, const std::string &name);
+        bool write_chunk(uint16_t tag, const ChunkEncoder &chunk);
+
+        // Bytes written so far
+        uint64_t size() const { return m_size; }
+
+    private:
+        // Appends a record with the given payload parts, the header is written last
+        bool write_record(uint8_t type, uint16_t tag, const ChunkInfo &info, uint32_t time_size,
+                          std::initializer_list<std::pair<const void *, size_t>> parts);
+
+        // Makes sure size more bytes fit into the mapping, grows the file if they don't
+        bool reserve(uint64_t size);
+
+        QFile m_file;
+        uchar *m_map = nullptr;
+        uint64_t m_capacity = 0;
+        uint64_t m_size = 0;
+
+        std::vector<std::string> m_tags;
+        ChunkIndex m_index;
+    };
+
+    // SegmentReader maps a segment file and answers queries by tag and time range from its index. The index of a segment
+    // that was not closed is rebuilt from its records.
+    class SegmentReader {
+    public:
+        SegmentReader() = default;
+        SegmentReader(const SegmentReader &) = delete;
+        SegmentReader &operator=(const SegmentReader &) = delete;
+        ~SegmentReader() { close(); }
+
+        bool open(const std::string &path);
+        void close();
+
+        const std::string &get_run() const { return m_run; }
+        int64_t get_start_time() const { return m_start_time; }
+        // Time of the last sample in the segment, the start time if it has none
+        int64_t get_end_time() const { return m_end_time; }
+
+        const std::vector<std::string> &get_tags() const { return m_tags; }
+        std::optional<uint16_t> find_tag(const std::string &name) const;
+
+        const ChunkIndex &get_index() const { return m_index; }
+
+        // Calls func(time, value) for every sample of tag in [from, to] in time order, returns the number of samples
+        template <typename F>
+        size_t query(uint16_t tag, int64_t from, int64_t to, F &&func) const {
+            size_t count = 0;
+
+            m_index.find(tag, from, to, [&](const ChunkInfo &chunk) {
+                auto decoder = make_decoder(chunk);
+
+                int64_t time = 0;
+                double value = 0;
+                while (decoder.next(time, value) && time <= to) {
+                    if (time >= from) {
+                        func(time, value);
+                        count++;
+                    }
+                }
+            });
+
+            return count;
+        }
+
+    private:
+        // Reads the index record at offset, returns false if it is missing or corrupted
+        bool read_index(uint64_t offset);
+        // Rebuilds the index from the records
+        void scan();
+
+        ChunkDecoder make_decoder(const ChunkInfo &chunk) const;
+
+        QFile m_file;
+        const uchar *m_map = nullptr;
+        uint64_t m_size = 0;
+
+        std::string m_run;
+        int64_t m_start_time = 0;
+        int64_t m_end_time = 0;
+
+        std::vector<std::string> m_tags;
+        ChunkIndex m_index;
+    };
+}  // namespace historian
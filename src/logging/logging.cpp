@@ -1,19 +1,90 @@
 #include "logging.h"
 
+#include <chrono>
+
+#include "spdlog/async.h"
+#include "spdlog/sinks/rotating_file_sink.h"
 #include "spdlog/sinks/stdout_color_sinks.h"
-#include "spdlog/sinks/basic_file_sink.h"
+
+#include "app_config.h"
 
 namespace logging {
+    namespace {
+        // Set once by init, before any other thread logs
+        log main_logger;
+    }  // namespace
+
     void init() {
         std::vector<spdlog::sink_ptr> sinks;
         sinks.push_back(std::make_shared<spdlog::sinks::stdout_color_sink_mt>());
-        //sinks.push_back(std::make_shared<spdlog::sinks::basic_file_sink_mt>("log.txt"));
 
-        auto main_logger = std::make_shared<spdlog::logger>("main", std::begin(sinks), std::end(sinks));
-        main_logger->set_level(spdlog::level::trace);
+        // spdlog reports errors with exceptions; without a file we still log to the console
+        std::string file_error;
+        try {
+            sinks.push_back(std::make_shared<spdlog::sinks::rotating_file_sink_mt>(LOG_FILE, LOG_MAX_FILE_SIZE, LOG_MAX_FILES));
+        } catch (const spdlog::spdlog_ex &e) {
+            file_error = e.what();
+        }
+
+        if (LOG_ASYNC) {
+            // A single worker keeps the messages in order
+            spdlog::init_thread_pool(LOG_QUEUE_SIZE, 1);
+            main_logger = std::make_shared<spdlog::async_logger>(
+                "main", std::begin(sinks), std::end(sinks), spdlog::thread_pool(), spdlog::async_overflow_policy::overrun_oldest);
+        } else {
+            main_logger = std::make_shared<spdlog::logger>("main", std::begin(sinks), std::end(sinks));
+        }
+
+        main_logger->set_level(spdlog::level::from_str(LOG_DEFAULT_LEVEL));
+        main_logger->flush_on(spdlog::level::warn);
 
         spdlog::register_logger(main_logger);
+        spdlog::flush_every(std::chrono::seconds(LOG_FLUSH_INTERVAL));
+
+        if (!file_error.empty()) {
+            main_logger->error("Logging: unable to open the log file '{0}': {1}", LOG_FILE, file_error);
+        }
+    }
+
+    void init_quiet() { main_logger = std::make_shared<spdlog::logger>("main"); }
+
+    void set_level(const std::string &name) {
+        // from_str returns off for unknown names
+        const auto level = spdlog::level::from_str(name);
+        if (level == spdlog::level::off && name != "off") {
+            main_logger->warn("Logging: unknown log level '{0}', keeping '{1}'", name,
+                              spdlog::level::to_string_view(main_logger->level()));
+            return;
+        }
+
+        main_logger->set_level(level);
+    }
+
+    void shutdown() {
+        if (!main_logger) {
+            spdlog::shutdown();
+            return;
+        }
+
+        // Stopping the thread pool writes the queued messages
+        main_logger->flush();
+        auto sinks = main_logger->sinks();
+        const auto level = main_logger->level();
+        spdlog::shutdown();
+
+        // Destructors of statics (e.g. the watchtower) may still log, their messages are written right away
+        main_logger = std::make_shared<spdlog::logger>("main", std::begin(sinks), std::end(sinks));
+        main_logger->set_level(level);
+        main_logger->flush_on(level);
+    }
+
+    log get_log(const std::string &name) {
+        // The main logger is by far the most used one, the registry of spdlog takes a lock for every lookup
+        if (main_logger && name == "main") {
+            return main_logger;
+        }
+        return spdlog::get(name);
     }
 
-    log get_log(const std::string &name) { return spdlog::get(name); }
+    const log &main_log() { return main_logger; }
 }  // namespace logging
@@ -1,10 +1,65 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+
 #include "spdlog/spdlog.h"
 
 namespace logging {
     using log = std::shared_ptr<spdlog::logger>;
 
+    // Sets up the main logger with a console and a rotating file sink. Unless LOG_ASYNC is false, messages are formatted
+    // by the caller and written by a background thread (see LOG_QUEUE_SIZE).
     void init();
+
+    // Sets up the main logger without any sinks, for code that runs outside of the application (e.g. the unit tests)
+    void init_quiet();
+
+    // Sets the level of the main logger by name (see LOG_DEFAULT_LEVEL), unknown names are logged and ignored
+    void set_level(const std::string &name);
+
+    // Writes the queued messages and stops the background threads of spdlog. Call it once all threads that log are stopped,
+    // messages logged afterwards (e.g. by destructors of statics) are written synchronously.
+    void shutdown();
+
     log get_log(const std::string &name);
+
+    // The main logger, nullptr before init. Unlike get_log("main") it neither looks up the logger nor copies the pointer,
+    // so use it in code that logs per packet.
+    const log &main_log();
+
+    // Formats bytes as hex digits when the message is formatted, so a message with a disabled level costs nothing and an
+    // enabled one does not allocate a converted copy. The bytes have to outlive the log call.
+    struct Hex {
+        const uint8_t *data;
+        size_t size;
+    };
+
+    // Works for QByteArray, std::string(_view) and the like
+    template <typename Bytes>
+    Hex hex(const Bytes &bytes) {
+        return {reinterpret_cast<const uint8_t *>(bytes.data()), static_cast<size_t>(bytes.size())};
+    }
 }  // namespace logging
+
+namespace fmt {
+    template <>
+    struct formatter<logging::Hex> {
+        template <typename ParseContext>
+        constexpr auto parse(ParseContext &ctx) {
+            return ctx.begin();
+        }
+
+        template <typename FormatContext>
+        auto format(const logging::Hex &hex, FormatContext &ctx) const {
+            constexpr const char *digits = "0123456789abcdef";
+
+            auto out = ctx.out();
+            for (size_t i = 0; i < hex.size; i++) {
+                *out++ = digits[hex.data[i] >> 4];
+                *out++ = digits[hex.data[i] & 0xF];
+            }
+            return out;
+        }
+    };
+}  // namespace fmt
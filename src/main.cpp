@@ -1,25 +1,58 @@
 #include <iostream>
+#include <string_view>
 
 #include <QApplication>
 
 #include "config/config.h"
 #include "logging/logging.h"
 #include "mainwindow.h"
+#include "replay.h"
 #include "stacktrace.h"
+#include "watchtower.h"
 
 int main(int argc, char *argv[]) {
     try {
         logging::init();
         config::init();
 
-        QApplication app(argc, argv);
-        MainWindow window;
+        if (auto main_config = config::get_config("main")) {
+            if (auto level = main_config->get<std::string>("logging.level")) {
+                logging::set_level(*level);
+            }
+        }
+
+        if (argc > 1 && std::string_view(argv[1]) == "--replay") {
+            const int result = run_replay(argc, argv);
+            logging::shutdown();
+            return result;
+        }
+
+        int result = 0;
+        {
+            QApplication app(argc, argv);
+            MainWindow window;
+
+            window.show();
 
-        window.show();
+            // Simulated hardware has to be up before the devices connect to it
+            Watchtower::instance().start_simulators();
 
-        // If cleanup code is needed, connect to the QCoreApplication::aboutToQuit signal
+            // Recipes and the historian refer to the PLC, so it is loaded first
+            Watchtower::instance().load_plc();
 
-        return app.exec();
+            if (Watchtower::instance().load_devices(DEVICES_CONFIG_FILE)) {
+                Watchtower::instance().start();
+            }
+
+            // The devices have to be stopped while the event loop still exists
+            QObject::connect(&app, &QCoreApplication::aboutToQuit, []() { Watchtower::instance().shutdown(); });
+
+            result = app.exec();
+        }
+
+        // The window and the application are destroyed and the watchtower is shut down
+        logging::shutdown();
+        return result;
 
     } catch (const std::exception &e) {
         std::string msg{"Unhandled exception: "};
@@ -33,7 +66,13 @@ int main(int argc, char *argv[]) {
         }
         msg += '\n';
 
-        spdlog::get("main")->critical(msg);
+        // The exception may come from setting up the logger
+        if (logging::main_log()) {
+            logging::main_log()->critical(msg);
+            logging::shutdown();
+        } else {
+            std::cerr << msg;
+        }
     }
 
     std::cin.get();
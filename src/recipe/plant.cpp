@@ -0,0 +1,58 @@
+#include "plant.h"
+
+#include "devices/plc/s7.h"
+#include "devices/rf_generator.h"
+#include "devices/rf_switch.h"
+
+namespace recipe {
+    void DevicePlant::set_state(PLC::Tag tag, bool state) {
+        if (tag.area == PLC::Area::Output) {
+            m_plc->set_output(tag, state);
+        } else {
+            m_plc->set_flag(tag, state);
+        }
+    }
+
+    void DevicePlant::set_word(PLC::Tag tag, uint32_t value) {
+        if (tag.area == PLC::Area::DBdword) {
+            m_plc->set_dbdword(tag, value);
+        } else {
+            m_plc->set_dbword(tag, static_cast<uint16_t>(value));
+        }
+    }
+
+    bool DevicePlant::get_state(PLC::Tag tag) {
+        switch (tag.area) {
+        case PLC::Area::Input:
+            return m_plc->get_input(tag);
+        case PLC::Area::Output:
+            return m_plc->get_output(tag);
+        default:
+            return m_plc->get_flag(tag);
+        }
+    }
+
+    int64_t DevicePlant::get_word(PLC::Tag tag) {
+        return tag.area == PLC::Area::DBdword ? m_plc->get_dbdword(tag) : m_plc->get_dbword(tag);
+    }
+
+    void DevicePlant::set_port(RFSwitch *rf_switch, int port) { rf_switch->set_port(static_cast<int8_t>(port)); }
+
+    void DevicePlant::set_power(RFGenerator *generator, int power) { generator->set_target_power(power); }
+
+    int DevicePlant::get_setpoint(RFGenerator *generator) { return generator->get_parameters().setpoint; }
+
+    void DevicePlant::set_output(RFGenerator *generator, bool on) {
+        if (on) {
+            generator->output_on();
+        } else {
+            generator->output_off();
+        }
+    }
+
+    void DevicePlant::tune_match(RFGenerator *generator, int port) { generator->tune_match(port); }
+
+    void DevicePlant::stop_tuning(RFGenerator *generator) { generator->stop_tuning(); }
+
+    bool DevicePlant::is_tuning(RFGenerator *generator) { return generator->is_tuning(); }
+}  // namespace recipe
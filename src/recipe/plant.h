@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+
+#include "devices/plc/tag.h"
+
+class RFGenerator;
+class RFSwitch;
+
+namespace PLC {
+    class S7;
+}
+
+namespace recipe {
+    // Plant carries out the steps of a program on the hardware. RecipeRunner only talks to the generators, the switches
+    // and the PLC through it, so the runner does not depend on the devices and can be tested on its own. The handles are
+    // the ones resolved by compile.
+    class Plant {
+    public:
+        virtual ~Plant() = default;
+
+        // Writes a flag or an output
+        virtual void set_state(PLC::Tag tag, bool state) = 0;
+        // Writes a DBword or DBdword, DBwords are truncated to 16 bits
+        virtual void set_word(PLC::Tag tag, uint32_t value) = 0;
+        // Reads a flag, an input or an output
+        virtual bool get_state(PLC::Tag tag) = 0;
+        // Reads a DBword or DBdword
+        virtual int64_t get_word(PLC::Tag tag) = 0;
+
+        virtual void set_port(RFSwitch *rf_switch, int port) = 0;
+
+        virtual void set_power(RFGenerator *generator, int power) = 0;
+        // Returns the setpoint reported by the generator, -1 if it has not reported one yet
+        virtual int get_setpoint(RFGenerator *generator) = 0;
+        virtual void set_output(RFGenerator *generator, bool on) = 0;
+        virtual void tune_match(RFGenerator *generator, int port) = 0;
+        virtual void stop_tuning(RFGenerator *generator) = 0;
+        virtual bool is_tuning(RFGenerator *generator) = 0;
+    };
+
+    // DevicePlant forwards the steps to the devices and the S7. The generators and switches are called in the controller
+    // thread (see RecipeRunner), the S7 accepts calls from any thread.
+    class DevicePlant : public Plant {
+    public:
+        // The PLC the tags refer to, nullptr if there is none. Programs with PLC tags only compile with a PLC.
+        void set_plc(PLC::S7 *plc) { m_plc = plc; }
+
+        void set_state(PLC::Tag tag, bool state) override;
+        void set_word(PLC::Tag tag, uint32_t value) override;
+        bool get_state(PLC::Tag tag) override;
+        int64_t get_word(PLC::Tag tag) override;
+
+        void set_port(RFSwitch *rf_switch, int port) override;
+
+        void set_power(RFGenerator *generator, int power) override;
+        int get_setpoint(RFGenerator *generator) override;
+        void set_output(RFGenerator *generator, bool on) override;
+        void tune_match(RFGenerator *generator, int port) override;
+        void stop_tuning(RFGenerator *generator) override;
+        bool is_tuning(RFGenerator *generator) override;
+
+    private:
+        PLC::S7 *m_plc = nullptr;
+    };
+}  // namespace recipe
@@ -0,0 +1,244 @@
+#include "recipe.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <limits>
+#include <string_view>
+#include <utility>
+
+#include "logging/logging.h"
+
+namespace recipe {
+    namespace {
+        // What a step needs besides its action
+        enum Needs : uint8_t {
+            None = 0,
+            Generator = 0b1,
+            Switch = 0b10,
+            FlagTag = 0b100,   // a flag, input or output, see Action::areas
+            WordTag = 0b1000,  // a DBword or DBdword
+            Value = 0b10000,
+            Target = 0b100000,
+            Duration = 0b1000000,
+        };
+
+        struct Action {
+            std::string_view name;
+            OpCode op;
+            uint8_t needs;
+            // Areas the tag is searched in, in this order
+            std::array<std::optional<PLC::Area>, 3> areas{};
+        };
+
+        // clang-format off
+        constexpr std::array<Action, 14> ACTIONS{{
+            {"wait", OpCode::Wait, Duration},
+            {"setflag", OpCode::SetFlag, FlagTag | Value, {PLC::Area::Flag}},
+            {"setoutput", OpCode::SetOutput, FlagTag | Value, {PLC::Area::Output}},
+            {"setword", OpCode::SetWord, WordTag | Value, {PLC::Area::DBword}},
+            {"setdword", OpCode::SetDword, WordTag | Value, {PLC::Area::DBdword}},
+            {"waitstate", OpCode::WaitState, FlagTag | Value, {PLC::Area::Flag, PLC::Area::Input, PLC::Area::Output}},
+            {"waitbelow", OpCode::WaitBelow, WordTag | Value, {PLC::Area::DBword, PLC::Area::DBdword}},
+            {"waitabove", OpCode::WaitAbove, WordTag | Value, {PLC::Area::DBword, PLC::Area::DBdword}},
+            {"selectport", OpCode::SelectPort, Switch | Value},
+            {"setpower", OpCode::SetPower, Generator | Value},
+            {"ramp", OpCode::Ramp, Generator | Target | Duration},
+            {"outputon", OpCode::OutputOn, Generator},
+            {"outputoff", OpCode::OutputOff, Generator},
+            {"match", OpCode::Match, Generator | Value},
+        }};
+        // clang-format on
+
+        const Action *find_action(std::string_view name) {
+            auto it = std::find_if(ACTIONS.begin(), ACTIONS.end(), [name](const Action &a) { return a.name == name; });
+            return it == ACTIONS.end() ? nullptr : &*it;
+        }
+
+        // Returns the number of a step segment ("step12" is 12), std::nullopt for other names
+        std::optional<int> step_number(const std::string &name) {
+            constexpr std::string_view prefix = "step";
+            if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0) {
+                return std::nullopt;
+            }
+
+            int number = 0;
+            for (size_t i = prefix.size(); i < name.size(); i++) {
+                if (!std::isdigit(static_cast<unsigned char>(name[i]))) {
+                    return std::nullopt;
+                }
+
+                // Numbers that do not fit into an int are no step numbers either
+                const int digit = name[i] - '0';
+                if (number > (std::numeric_limits<int>::max() - digit) / 10) {
+                    return std::nullopt;
+                }
+                number = number * 10 + digit;
+            }
+            return number;
+        }
+
+        // Compiles a single step, returns false (and logs why) if it is invalid
+        bool compile_step(config::Segment &segment, const std::string &name, const Context &context, Step &step) {
+            auto log = logging::main_log();
+
+            auto action_name = segment.get<std::string>("action");
+            if (!action_name) {
+                log->error("Recipe: {0} has no action", name);
+                return false;
+            }
+
+            const auto *action = find_action(*action_name);
+            if (!action) {
+                log->error("Recipe: {0} has the unknown action '{1}'", name, *action_name);
+                return false;
+            }
+            step.op = action->op;
+
+            bool valid = true;
+
+            if (action->needs & Generator) {
+                auto device_name = segment.get<std::string>("device");
+                if (device_name && context.find_generator) {
+                    step.generator = context.find_generator(*device_name);
+                }
+
+                if (!step.generator) {
+                    log->error("Recipe: {0} ({1}) needs an RF generator, got '{2}'", name, action->name,
+                               device_name.value_or(""));
+                    valid = false;
+                }
+            }
+
+            if (action->needs & Switch) {
+                auto device_name = segment.get<std::string>("device");
+                if (device_name && context.find_switch) {
+                    step.rf_switch = context.find_switch(*device_name);
+                }
+
+                if (!step.rf_switch) {
+                    log->error("Recipe: {0} ({1}) needs an RF switch, got '{2}'", name, action->name, device_name.value_or(""));
+                    valid = false;
+                }
+            }
+
+            if (action->needs & (FlagTag | WordTag)) {
+                auto tag_name = segment.get<std::string>("tag");
+                std::optional<PLC::Tag> tag;
+
+                if (!context.find_tag) {
+                    log->error("Recipe: {0} ({1}) needs the PLC, which is not available", name, action->name);
+                    valid = false;
+                } else if (tag_name) {
+                    for (const auto &area : action->areas) {
+                        if (area && (tag = context.find_tag(*area, *tag_name))) {
+                            break;
+                        }
+                    }
+
+                    if (!tag) {
+                        log->error("Recipe: {0} ({1}): unknown tag '{2}'", name, action->name, *tag_name);
+                        valid = false;
+                    }
+                } else {
+                    log->error("Recipe: {0} ({1}) needs a tag", name, action->name);
+                    valid = false;
+                }
+
+                if (tag) {
+                    step.tag = *tag;
+                }
+            }
+
+            auto value = segment.get<int>("value");
+            if (action->needs & Value) {
+                if (!value) {
+                    log->error("Recipe: {0} ({1}) needs a value", name, action->name);
+                    valid = false;
+                } else {
+                    step.value = *value;
+                }
+            }
+
+            if (action->needs & Target) {
+                auto target = segment.get<int>("to");
+                if (!target) {
+                    log->error("Recipe: {0} ({1}) needs a target value (to)", name, action->name);
+                    valid = false;
+                } else {
+                    step.target = *target;
+                    // The ramp starts at the current setpoint unless a start value is given
+                    step.value = segment.get<int>("from").value_or(-1);
+                }
+            }
+
+            // The waits for a condition and match take an optional timeout
+            auto duration = segment.get<int>((action->needs & Duration) ? "duration" : "timeout");
+            if ((action->needs & Duration) && (!duration || *duration < 0)) {
+                log->error("Recipe: {0} ({1}) needs a positive duration in ms", name, action->name);
+                valid = false;
+            } else if (duration) {
+                step.duration = std::chrono::milliseconds(std::max(*duration, 0));
+            }
+
+            return valid;
+        }
+    }  // namespace
+
+    const char *get_name(OpCode op) {
+        for (const auto &action : ACTIONS) {
+            if (action.op == op) {
+                return action.name.data();
+            }
+        }
+        return "unknown";
+    }
+
+    std::optional<Program> compile(config::Segment &recipe, const Context &context) {
+        Program program;
+        program.name = recipe.get<std::string>("name").value_or("");
+        program.description = recipe.get<std::string>("description").value_or("");
+
+        std::vector<std::pair<int, std::shared_ptr<config::Segment>>> segments;
+        for (auto &segment : recipe.get_children()) {
+            if (auto number = step_number(segment->get_name())) {
+                segments.emplace_back(*number, segment);
+            } else {
+                logging::main_log()->warn("Recipe '{0}': ignoring segment '{1}'", program.name, segment->get_name());
+            }
+        }
+        std::sort(segments.begin(), segments.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+
+        if (segments.empty()) {
+            logging::main_log()->error("Recipe '{0}' has no steps", program.name);
+            return std::nullopt;
+        }
+
+        // Check all steps, so every error is reported at once
+        bool valid = true;
+        for (size_t i = 0; i < segments.size(); i++) {
+            if (i > 0 && segments[i].first == segments[i - 1].first) {
+                logging::main_log()->error("Recipe '{0}': step number {1} is used twice", program.name, segments[i].first);
+                valid = false;
+            }
+
+            Step step;
+            const auto name = segments[i].second->get_name();
+            valid &= compile_step(*segments[i].second, name, context, step);
+
+            if (step.generator
+                && std::find(program.generators.begin(), program.generators.end(), step.generator) == program.generators.end()) {
+                program.generators.push_back(step.generator);
+            }
+
+            program.steps.push_back(step);
+            program.step_names.push_back(name);
+        }
+
+        if (!valid) {
+            return std::nullopt;
+        }
+
+        return program;
+    }
+}  // namespace recipe
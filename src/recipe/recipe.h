@@ -0,0 +1,91 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "config/segment.h"
+#include "devices/plc/tag.h"
+
+class RFGenerator;
+class RFSwitch;
+
+// A recipe describes a sputter run (pump down, gas flows, target selection, RF ramps, shutter timing, ...) as a list of steps
+// in the config format:
+//
+//     name = "Ti 200W"
+//     [step1]
+//     action = "setoutput"
+//     tag = "shutter"
+//     value = 1
+//     [step2]
+//     action = "wait"
+//     duration = 500
+//
+// Steps are executed in the order of their number. compile turns the recipe into a Program, a flat array of steps whose
+// devices and PLC tags are already resolved to handles. All validation happens there, so executing a step (see RecipeRunner)
+// does not involve any string lookups or allocations.
+namespace recipe {
+    enum class OpCode : uint8_t {
+        Wait,        // wait for duration
+        SetFlag,     // set the flag tag to value
+        SetOutput,   // set the output tag to value
+        SetWord,     // write value to the DBword tag
+        SetDword,    // write value to the DBdword tag
+        WaitState,   // wait until the flag, input or output tag equals value
+        WaitBelow,   // wait until the DB(d)word tag is below value, e.g. the pressure while pumping down
+        WaitAbove,   // wait until the DB(d)word tag is above value
+        SelectPort,  // select port value of the RF switch, i.e. the target
+        SetPower,    // set the target power of the generator to value
+        Ramp,        // ramp the target power of the generator from value (-1 for the current setpoint) to target in duration
+        OutputOn,    // turn the output of the generator on
+        OutputOff,   // turn the output of the generator off
+        Match,       // tune the matching network of the generator for port value and wait until it is matched
+    };
+
+    // Returns the name of the action as used in the recipe
+    const char *get_name(OpCode op);
+
+    struct Step {
+        OpCode op = OpCode::Wait;
+
+        // Handles, only the ones used by op are set
+        RFGenerator *generator = nullptr;
+        RFSwitch *rf_switch = nullptr;
+        PLC::Tag tag;
+
+        int value = 0;
+        int target = 0;
+
+        // Duration of Wait and Ramp, timeout of the waits for a condition and of Match (0 waits forever)
+        std::chrono::milliseconds duration{0};
+    };
+
+    struct Program {
+        std::string name;
+        std::string description;
+
+        std::vector<Step> steps;
+        // Name of the segment of each step, only used for messages
+        std::vector<std::string> step_names;
+
+        // All generators used by the program, their outputs are turned off if the program fails or is aborted
+        std::vector<RFGenerator *> generators;
+    };
+
+    // Resolves the names used in a recipe
+    struct Context {
+        // Return nullptr if there is no device with the name or it is of another type
+        std::function<RFGenerator *(const std::string &)> find_generator;
+        std::function<RFSwitch *(const std::string &)> find_switch;
+        // Returns std::nullopt if the PLC has no such tag in the area. Not set without a PLC, recipes using PLC tags then
+        // fail to compile.
+        std::function<std::optional<PLC::Tag>(PLC::Area, const std::string &)> find_tag;
+    };
+
+    // Compiles the recipe. Returns std::nullopt (and logs all errors found) if the recipe is invalid.
+    std::optional<Program> compile(config::Segment &recipe, const Context &context);
+}  // namespace recipe
@@ -0,0 +1,201 @@
+#include "recipe_runner.h"
+
+#include <algorithm>
+
+#include "logging/logging.h"
+
+namespace recipe {
+    RecipeRunner::RecipeRunner(Plant &plant) : m_plant(plant) {}
+
+    bool RecipeRunner::load(Program program) {
+        std::scoped_lock<std::mutex> lock(m_mutex);
+
+        if (m_status == Status::Running || m_start_requested) {
+            logging::main_log()->error("RecipeRunner: unable to load recipe '{0}' while '{1}' is running", program.name,
+                                       m_program.name);
+            return false;
+        }
+
+        m_program = std::move(program);
+        m_status = Status::Idle;
+        m_step = 0;
+        return true;
+    }
+
+    bool RecipeRunner::start() {
+        std::scoped_lock<std::mutex> lock(m_mutex);
+
+        if (m_program.steps.empty()) {
+            logging::main_log()->error("RecipeRunner: start called without a recipe");
+            return false;
+        }
+
+        if (m_status == Status::Running) {
+            logging::main_log()->error("RecipeRunner: recipe '{0}' is already running", m_program.name);
+            return false;
+        }
+
+        m_abort_requested = false;
+        m_start_requested = true;
+        return true;
+    }
+
+    void RecipeRunner::abort() { m_abort_requested = true; }
+
+    void RecipeRunner::tick(Clock::time_point now) {
+        std::scoped_lock<std::mutex> lock(m_mutex);
+
+        if (m_abort_requested.exchange(false)) {
+            m_start_requested = false;
+
+            if (m_status == Status::Running) {
+                logging::main_log()->warn("RecipeRunner: recipe '{0}' aborted in {1}", m_program.name,
+                                          m_program.step_names[m_step]);
+                stop(Status::Aborted);
+            }
+        }
+
+        if (m_start_requested.exchange(false)) {
+            logging::main_log()->info("RecipeRunner: starting recipe '{0}'", m_program.name);
+
+            m_status = Status::Running;
+            m_step = 0;
+            m_step_start = now;
+            m_step_entered = false;
+        }
+
+        while (m_status == Status::Running) {
+            if (m_step == m_program.steps.size()) {
+                logging::main_log()->info("RecipeRunner: recipe '{0}' finished", m_program.name);
+                m_status = Status::Finished;
+                break;
+            }
+
+            Clock::time_point end;
+            if (!execute(m_program.steps[m_step], now, end)) {
+                break;
+            }
+
+            // The next step starts when this one was scheduled to end, not when the tick noticed it
+            m_step++;
+            m_step_start = end;
+            m_step_entered = false;
+        }
+    }
+
+    bool RecipeRunner::execute(const Step &step, Clock::time_point now, Clock::time_point &end) {
+        const bool entered = std::exchange(m_step_entered, true);
+        const auto elapsed = now - m_step_start;
+
+        // Instant steps are complete when they started
+        end = m_step_start;
+
+        switch (step.op) {
+        case OpCode::Wait:
+            end = m_step_start + step.duration;
+            return elapsed >= step.duration;
+
+        case OpCode::SetFlag:
+        case OpCode::SetOutput:
+            m_plant.set_state(step.tag, step.value != 0);
+            return true;
+
+        case OpCode::SetWord:
+        case OpCode::SetDword:
+            m_plant.set_word(step.tag, static_cast<uint32_t>(step.value));
+            return true;
+
+        case OpCode::WaitState:
+        case OpCode::WaitBelow:
+        case OpCode::WaitAbove: {
+            bool reached = false;
+            if (step.op == OpCode::WaitState) {
+                reached = m_plant.get_state(step.tag) == (step.value != 0);
+            } else if (step.op == OpCode::WaitBelow) {
+                reached = m_plant.get_word(step.tag) < step.value;
+            } else {
+                reached = m_plant.get_word(step.tag) > step.value;
+            }
+
+            if (reached) {
+                end = now;
+                return true;
+            }
+
+            if (step.duration.count() > 0 && elapsed >= step.duration) {
+                logging::main_log()->error("RecipeRunner: recipe '{0}' failed, {1} ({2}) timed out after {3}ms",
+                                           m_program.name, m_program.step_names[m_step], get_name(step.op),
+                                           step.duration.count());
+                stop(Status::Failed);
+            }
+            return false;
+        }
+
+        case OpCode::SelectPort:
+            m_plant.set_port(step.rf_switch, step.value);
+            return true;
+
+        case OpCode::SetPower:
+            m_plant.set_power(step.generator, step.value);
+            return true;
+
+        case OpCode::Ramp: {
+            if (!entered) {
+                m_ramp_from = step.value >= 0 ? step.value : std::max(m_plant.get_setpoint(step.generator), 0);
+                m_last_setpoint = -1;
+            }
+
+            int setpoint = step.target;
+            if (elapsed < step.duration) {
+                setpoint = m_ramp_from + static_cast<int>((static_cast<int64_t>(step.target) - m_ramp_from) * elapsed.count()
+                                                          / std::chrono::duration_cast<Clock::duration>(step.duration).count());
+            }
+
+            // Only send changes, a slow ramp would otherwise repeat the same setpoint every cycle
+            if (setpoint != m_last_setpoint) {
+                m_plant.set_power(step.generator, setpoint);
+                m_last_setpoint = setpoint;
+            }
+
+            end = m_step_start + step.duration;
+            return elapsed >= step.duration;
+        }
+
+        case OpCode::OutputOn:
+            m_plant.set_output(step.generator, true);
+            return true;
+
+        case OpCode::OutputOff:
+            m_plant.set_output(step.generator, false);
+            return true;
+
+        case OpCode::Match:
+            if (!entered) {
+                m_plant.tune_match(step.generator, step.value);
+            }
+
+            if (!m_plant.is_tuning(step.generator)) {
+                end = now;
+                return true;
+            }
+
+            if (step.duration.count() > 0 && elapsed >= step.duration) {
+                logging::main_log()->error("RecipeRunner: recipe '{0}' failed, {1} (match) timed out after {2}ms",
+                                           m_program.name, m_program.step_names[m_step], step.duration.count());
+                stop(Status::Failed);
+            }
+            return false;
+        }
+
+        return true;
+    }
+
+    void RecipeRunner::stop(Status status) {
+        for (auto *generator : m_program.generators) {
+            m_plant.stop_tuning(generator);
+            m_plant.set_output(generator, false);
+        }
+
+        m_status = status;
+    }
+}  // namespace recipe
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+#include "plant.h"
+#include "recipe.h"
+
+namespace recipe {
+    // RecipeRunner executes a compiled Program. It is driven by tick, which the controller calls once per cycle (see
+    // Controller::add_task), so all device calls happen in the controller thread. load, start and abort may be called from
+    // any thread; start and abort only take effect with the next tick. The steps are carried out through the plant.
+    //
+    // Steps are timed against the scheduled end of the previous step instead of the time of the tick that noticed it, so a
+    // sequence of waits does not accumulate the cycle time as error. Steps that complete immediately (e.g. setting a flag)
+    // are all executed within the same tick.
+    class RecipeRunner {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        enum class Status : uint8_t { Idle, Running, Finished, Failed, Aborted };
+
+        explicit RecipeRunner(Plant &plant);
+
+        // Replaces the program. Fails if a program is running.
+        bool load(Program program);
+
+        // Starts the loaded program with the next tick
+        bool start();
+        // Stops the running program with the next tick and turns off the outputs of its generators
+        void abort();
+
+        void tick(Clock::time_point now);
+
+        Status get_status() const { return m_status; }
+        // Index of the running step
+        size_t get_step() const { return m_step; }
+
+    private:
+        // Executes the current step, returns true once it is complete and sets end to the time it completed
+        bool execute(const Step &step, Clock::time_point now, Clock::time_point &end);
+
+        // Stops the program, the tuning and the outputs of its generators
+        void stop(Status status);
+
+        Plant &m_plant;
+
+        std::mutex m_mutex;
+        Program m_program;
+
+        std::atomic<Status> m_status{Status::Idle};
+        std::atomic<size_t> m_step{0};
+        std::atomic<bool> m_start_requested{false};
+        std::atomic<bool> m_abort_requested{false};
+
+        // Start of the current step and whether it was entered already
+        Clock::time_point m_step_start;
+        bool m_step_entered = false;
+
+        // Start value of a ramp and the last setpoint sent, so unchanged setpoints are not sent again
+        int m_ramp_from = 0;
+        int m_last_setpoint = -1;
+    };
+}  // namespace recipe
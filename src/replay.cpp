@@ -0,0 +1,91 @@
+#include "replay.h"
+
+#include <iostream>
+#include <string>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+
+#include "devices/connector/replay_connector.h"
+#include "devices/device_factory.h"
+#include "logging/logging.h"
+
+int run_replay(int argc, char *argv[]) {
+    if (argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " --replay <device type> <capture file> [speed]\n";
+        return 1;
+    }
+
+    QCoreApplication app(argc, argv);
+
+    const std::string type = argv[2];
+    const std::string path = argv[3];
+
+    double speed = 1.0;
+    if (argc > 4) {
+        try {
+            speed = std::stod(argv[4]);
+        } catch (const std::exception &) {
+            speed = -1;
+        }
+        if (speed < 0) {
+            std::cerr << "Invalid speed '" << argv[4] << "'\n";
+            return 1;
+        }
+    }
+
+    auto connector = std::make_unique<ReplayConnector>();
+    if (!connector->load(path)) {
+        return 1;
+    }
+    connector->set_speed(speed);
+
+    // The connector belongs to the device, the signals are connected before handing it over
+    QObject::connect(connector.get(), &ReplayConnector::replay_finished, &app, &QCoreApplication::quit, Qt::QueuedConnection);
+    const ReplayConnector *replay = connector.get();
+
+    auto device = make_device(type);
+    if (!device) {
+        return 1;
+    }
+    device->set_connector(std::move(connector));
+
+    // Every parameter update is reported, the replay only listens to the generator and the queries it sends are discarded
+    auto settings = std::make_shared<config::Segment>("replay");
+    settings->set("telemetryrate", 0);
+    settings->set("samplerate", 0);
+    device->init(settings);
+
+    size_t updates = 0;
+    auto *generator = dynamic_cast<RFGenerator *>(device.get());
+    if (generator) {
+        QObject::connect(generator, &RFGenerator::update_parameters, [&updates](device_id, uint32_t) { updates++; });
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    device->connect_async();
+    app.exec();
+
+    const auto elapsed = timer.nsecsElapsed();
+    device->disconnect();
+
+    const double seconds = static_cast<double>(elapsed) / 1e9;
+    std::cout << fmt::format("Replayed {0} frames ({1} bytes) of '{2}' in {3:.3f}s, {4:.0f} frames/s, {5:.2f} MB/s\n",
+                             replay->get_replayed(), replay->get_replayed_bytes(), path, seconds,
+                             static_cast<double>(replay->get_replayed()) / seconds,
+                             static_cast<double>(replay->get_replayed_bytes()) / seconds / (1024 * 1024));
+
+    if (generator) {
+        const auto parameters = generator->get_parameters();
+        std::cout << fmt::format("{0} parameter updates, last parameters:\n\tforward power: {1}\n\treflected power: {2}"
+                                 "\n\tsetpoint: {3}\n\texternal feedback: {4}\n\tload capacitor: {5}\n\ttune capacitor: {6}"
+                                 "\n\tfault status: {7}\n",
+                                 updates, parameters.forward_power, parameters.reflected_power, parameters.setpoint,
+                                 parameters.external_feedback, parameters.load_cap_position, parameters.tune_cap_position,
+                                 parameters.fault_status);
+    }
+
+    return 0;
+}
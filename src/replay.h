@@ -0,0 +1,10 @@
+#pragma once
+
+// Replays a capture of a device link (see capture::CaptureRing) through the driver of a device and prints how fast the driver
+// parsed it and the parameters it ended up with. Runs instead of the user interface when the application is started with
+//
+//     sputterautomation --replay <device type> <capture file> [speed]
+//
+// The device type is the one of the device manifest (see make_device). A speed of 1 (the default) replays the frames at the
+// pace they were captured, 0 as fast as the driver takes them. Returns the exit code of the application.
+int run_replay(int argc, char *argv[]);
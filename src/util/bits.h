@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace util {
+    // Returns the number of trailing zero bits of value, i.e. the index of the lowest set bit. value must not be 0.
+    // (std::countr_zero is C++20)
+    inline int count_trailing_zeros(uint64_t value) {
+#ifdef _MSC_VER
+        unsigned long index = 0;
+        _BitScanForward64(&index, value);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(value);
+#endif
+    }
+
+    // Returns the number of leading zero bits of value. value must not be 0.
+    inline int count_leading_zeros(uint64_t value) {
+#ifdef _MSC_VER
+        unsigned long index = 0;
+        _BitScanReverse64(&index, value);
+        return 63 - static_cast<int>(index);
+#else
+        return __builtin_clzll(value);
+#endif
+    }
+
+    // Calls func(bit) for every set bit in word, starting with the lowest one
+    template <typename F>
+    void for_each_set_bit(uint64_t word, F &&func) {
+        while (word) {
+            func(count_trailing_zeros(word));
+            // Clear the lowest set bit
+            word &= word - 1;
+        }
+    }
+}  // namespace util
@@ -0,0 +1,45 @@
+#include "byteswap.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define UTIL_BYTESWAP_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace util {
+    void load_big_endian(uint16_t *dst, const uint8_t *src, size_t count) {
+        size_t i = 0;
+
+#ifdef UTIL_BYTESWAP_SSE2
+        // Swap the two bytes of 8 words at once
+        for (; i + 8 <= count; i += 8) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 2));
+            v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), v);
+        }
+#endif
+
+        for (; i < count; i++) {
+            dst[i] = static_cast<uint16_t>((src[i * 2] << 8) | src[i * 2 + 1]);
+        }
+    }
+
+    void load_big_endian(uint32_t *dst, const uint8_t *src, size_t count) {
+        size_t i = 0;
+
+#ifdef UTIL_BYTESWAP_SSE2
+        // Swap the bytes of each word, then the words of each dword (4 dwords at once)
+        for (; i + 4 <= count; i += 4) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4));
+            v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+            v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+            v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), v);
+        }
+#endif
+
+        for (; i < count; i++) {
+            const uint8_t *p = src + i * 4;
+            dst[i] = (uint32_t{p[0]} << 24) | (uint32_t{p[1]} << 16) | (uint32_t{p[2]} << 8) | uint32_t{p[3]};
+        }
+    }
+}  // namespace util
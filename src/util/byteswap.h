@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace util {
+    // Convert count big endian values (as sent by the PLC) from src to the host byte order in dst. src does not have to be
+    // aligned. On x86/x64 16 bytes are converted at a time with SSE2, the rest is converted one value at a time.
+    void load_big_endian(uint16_t *dst, const uint8_t *src, size_t count);
+    void load_big_endian(uint32_t *dst, const uint8_t *src, size_t count);
+}  // namespace util
@@ -0,0 +1,58 @@
+#include "ring_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace util {
+    RingBuffer::RingBuffer(size_t capacity) : m_data(capacity) {}
+
+    bool RingBuffer::push(const char *data, size_t length) {
+        if (length > free()) {
+            return false;
+        }
+
+        size_t tail = m_head + m_size;
+        if (tail >= m_data.size()) {
+            tail -= m_data.size();
+        }
+
+        // Copy up to the end of the storage, then the rest to the start
+        const size_t first = std::min(length, m_data.size() - tail);
+        std::memcpy(m_data.data() + tail, data, first);
+        std::memcpy(m_data.data(), data + first, length - first);
+
+        m_size += length;
+        return true;
+    }
+
+    void RingBuffer::consume(size_t count) {
+        count = std::min(count, m_size);
+
+        m_head += count;
+        if (m_head >= m_data.size()) {
+            m_head -= m_data.size();
+        }
+        m_size -= count;
+
+        // Start at the beginning again when empty, so the next packets are less likely to wrap
+        if (m_size == 0) {
+            m_head = 0;
+        }
+    }
+
+    void RingBuffer::clear() {
+        m_head = 0;
+        m_size = 0;
+    }
+
+    std::string_view RingBuffer::view(size_t length) {
+        length = std::min(length, m_size);
+
+        if (m_head + length > m_data.size()) {
+            std::rotate(m_data.begin(), m_data.begin() + m_head, m_data.end());
+            m_head = 0;
+        }
+
+        return {m_data.data() + m_head, length};
+    }
+}  // namespace util
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace util {
+    // RingBuffer is a byte queue with a fixed capacity, used to buffer data received from devices. Appending and consuming
+    // data never allocates or moves the buffered bytes (unlike QByteArray::mid/remove), so handling a stream of packets is
+    // linear in the number of bytes received.
+    class RingBuffer {
+    public:
+        explicit RingBuffer(size_t capacity);
+
+        size_t size() const { return m_size; }
+        size_t capacity() const { return m_data.size(); }
+        size_t free() const { return m_data.size() - m_size; }
+        bool empty() const { return m_size == 0; }
+
+        // Appends length bytes. Returns false and appends nothing if there is not enough free space.
+        bool push(const char *data, size_t length);
+
+        // Returns the byte at index (counted from the oldest buffered byte), index must be smaller than size()
+        char operator[](size_t index) const {
+            size_t position = m_head + index;
+            if (position >= m_data.size()) {
+                position -= m_data.size();
+            }
+            return m_data[position];
+        }
+
+        // Removes the oldest count bytes
+        void consume(size_t count);
+        void clear();
+
+        // Returns a view of the oldest length bytes. If they wrap around the end of the storage, the buffered data is moved
+        // to the start first, so only a packet straddling the end ever gets copied. The view is valid until the next call to
+        // push or view.
+        std::string_view view(size_t length);
+
+    private:
+        std::vector<char> m_data;
+        size_t m_head = 0;  // index of the oldest byte
+        size_t m_size = 0;
+    };
+}  // namespace util
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace util {
+    // SPSCQueue is a bounded lock-free queue for exactly one producer thread and one consumer thread, used to pass data
+    // between the I/O thread of a connector and the thread of its device. Neither side ever blocks or takes a lock: a full
+    // queue makes try_push fail and an empty one makes try_pop fail, the caller decides what to do about it.
+    //
+    // The capacity is rounded up to a power of two. The producer only writes m_tail and the consumer only writes m_head,
+    // both are kept on separate cache lines together with a cached copy of the other index, so the indices owned by the other
+    // thread are only read when the cached copy says the queue is full (or empty).
+    template <typename T>
+    class SPSCQueue {
+    public:
+        explicit SPSCQueue(size_t capacity) : m_slots(round_up(capacity)), m_mask(m_slots.size() - 1) {}
+
+        SPSCQueue(const SPSCQueue &) = delete;
+        SPSCQueue &operator=(const SPSCQueue &) = delete;
+
+        size_t capacity() const { return m_slots.size(); }
+
+        // Producer only. Returns false and leaves value untouched if the queue is full.
+        bool try_push(T &&value) {
+            const size_t tail = m_tail.load(std::memory_order_relaxed);
+            if (tail - m_head_cache == m_slots.size()) {
+                m_head_cache = m_head.load(std::memory_order_acquire);
+                if (tail - m_head_cache == m_slots.size()) {
+                    return false;
+                }
+            }
+
+            m_slots[tail & m_mask] = std::move(value);
+            m_tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool try_push(const T &value) {
+            T copy = value;
+            return try_push(std::move(copy));
+        }
+
+        // Consumer only. Returns false if the queue is empty.
+        bool try_pop(T &value) {
+            const size_t head = m_head.load(std::memory_order_relaxed);
+            if (head == m_tail_cache) {
+                m_tail_cache = m_tail.load(std::memory_order_acquire);
+                if (head == m_tail_cache) {
+                    return false;
+                }
+            }
+
+            // Moving out leaves an empty value behind, so the slot does not keep the data alive until it is overwritten
+            value = std::move(m_slots[head & m_mask]);
+            m_head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Only exact if neither side is running concurrently
+        bool empty() const { return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire); }
+
+    private:
+        static constexpr size_t CACHE_LINE = 64;
+
+        static size_t round_up(size_t capacity) {
+            size_t size = 1;
+            while (size < capacity) {
+                size <<= 1;
+            }
+            return size;
+        }
+
+        std::vector<T> m_slots;
+        const size_t m_mask;
+
+        // Written by the consumer
+        alignas(CACHE_LINE) std::atomic<size_t> m_head{0};
+        size_t m_tail_cache = 0;
+
+        // Written by the producer
+        alignas(CACHE_LINE) std::atomic<size_t> m_tail{0};
+        size_t m_head_cache = 0;
+    };
+}  // namespace util
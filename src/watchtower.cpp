@@ -0,0 +1,270 @@
+#include "watchtower.h"
+
+#include <algorithm>
+
+#include <QEventLoop>
+#include <QTimer>
+
+#include "config/config.h"
+#include "devices/device_factory.h"
+#include "devices/rf_generator.h"
+#include "devices/rf_switch.h"
+#include "logging/logging.h"
+
+bool Watchtower::load_devices(const std::string &file) {
+    if (m_controller.is_running()) {
+        logging::main_log()->error("Watchtower: devices can not be loaded while the controller is running");
+        return false;
+    }
+
+    if (!config::load(file, "devices")) {
+        logging::main_log()->error("Watchtower: unable to load the devices from '{0}'", file);
+        return false;
+    }
+
+    auto conf = config::get_config("devices");
+    if (!conf) {
+        return false;
+    }
+
+    // Segments are kept in a hash map, sort them so the devices are always updated in the same order
+    auto segments = conf->get_segment()->get_children();
+    std::vector<std::pair<int, std::shared_ptr<config::Segment>>> ordered;
+    for (auto &segment : segments) {
+        ordered.emplace_back(segment->get<int>("order").value_or(0), segment);
+    }
+    std::sort(ordered.begin(), ordered.end(), [](const auto &a, const auto &b) {
+        return std::make_pair(a.first, a.second->get_name()) < std::make_pair(b.first, b.second->get_name());
+    });
+
+    // Devices of an earlier call are already connected and added to the controller
+    const size_t first = m_devices.size();
+    std::vector<std::chrono::milliseconds> timeouts;
+    std::vector<std::chrono::microseconds> budgets;
+
+    for (auto &[order, segment] : ordered) {
+        auto type = segment->get<std::string>("type");
+        if (!type) {
+            logging::main_log()->warn("Watchtower: device '{0}' has no type, skipping it", segment->get_name());
+            continue;
+        }
+
+        auto device = make_device(*type);
+        if (!device) {
+            logging::main_log()->warn("Watchtower: skipping device '{0}'", segment->get_name());
+            continue;
+        }
+
+        device->init(segment);
+
+        timeouts.emplace_back(segment->get<int>("timeout").value_or(DEVICE_DEFAULT_CONNECT_TIMEOUT));
+        budgets.emplace_back(segment->get<int>("budget").value_or(CONTROLLER_DEFAULT_BUDGET));
+
+        logging::main_log()->debug("Watchtower: loaded device '{0}' ({1}) as device #{2}", segment->get_name(), *type,
+                                   device->get_id());
+
+        const device_id id = device->get_id();
+        if (m_devices_by_id.size() <= id) {
+            m_devices_by_id.resize(id + 1, nullptr);
+        }
+        m_devices_by_id[id] = device.get();
+
+        m_devices.push_back(std::move(device));
+        m_names.push_back(segment->get_name());
+    }
+
+    connect_devices(first, timeouts);
+
+    for (size_t i = 0; i < budgets.size(); i++) {
+        m_controller.add_device(m_devices[first + i].get(), budgets[i]);
+    }
+
+    return true;
+}
+
+void Watchtower::start_simulators() {
+    auto conf = config::get_config("main");
+    if (!conf) {
+        return;
+    }
+
+    for (auto &segment : conf->get_segment()->get_children("simulation")) {
+        auto type = segment->get<std::string>("type").value_or("");
+        auto port = segment->get<int>("port");
+
+        auto simulator = simulation::make_simulator(type);
+        if (!simulator || !port) {
+            logging::main_log()->error("Watchtower: simulation {0} needs a valid type and a port, got type '{1}'",
+                                       segment->get_name(), type);
+            continue;
+        }
+
+        auto server = std::make_unique<simulation::SimulatorServer>(std::move(simulator),
+                                                                    simulation::LinkSettings::from(*segment));
+        if (server->listen(static_cast<uint16_t>(*port))) {
+            m_simulator_servers.push_back(std::move(server));
+        }
+    }
+}
+
+bool Watchtower::load_plc() {
+    if (m_plc) {
+        logging::main_log()->error("Watchtower: the PLC is already loaded");
+        return false;
+    }
+
+    auto conf = config::get_config("main");
+    auto settings = conf ? conf->get_segment("plc") : nullptr;
+    if (!settings || !settings->get<std::string>("interface")) {
+        logging::main_log()->info("Watchtower: no PLC configured, running without it");
+        return false;
+    }
+
+    auto plc = std::make_unique<PLC::S7>();
+    plc->init(settings);
+    if (!plc->connect()) {
+        logging::main_log()->error("Watchtower: unable to connect to the PLC, running without it");
+        return false;
+    }
+
+    plc->start();
+    m_plc = std::move(plc);
+    m_plant.set_plc(m_plc.get());
+    return true;
+}
+
+bool Watchtower::load_recipe(const std::string &file) {
+    if (!config::load(file, file)) {
+        logging::main_log()->error("Watchtower: unable to load the recipe '{0}'", file);
+        return false;
+    }
+
+    auto conf = config::get_config(file);
+    if (!conf) {
+        return false;
+    }
+
+    recipe::Context context;
+    context.find_generator = [this](const std::string &name) { return dynamic_cast<RFGenerator *>(find_device(name)); };
+    context.find_switch = [this](const std::string &name) { return dynamic_cast<RFSwitch *>(find_device(name)); };
+    if (m_plc) {
+        context.find_tag = [this](PLC::Area area, const std::string &name) { return m_plc->find_tag(area, name); };
+    }
+
+    auto program = recipe::compile(*conf->get_segment(), context);
+    if (!program) {
+        logging::main_log()->error("Watchtower: recipe '{0}' is invalid", file);
+        return false;
+    }
+
+    if (!m_recipe_runner.load(std::move(*program))) {
+        return false;
+    }
+
+    m_historian.start_run(file);
+    return true;
+}
+
+void Watchtower::start() {
+    if (auto conf = config::get_config("main")) {
+        m_controller.init(conf->get_segment("controller"));
+        m_historian.init(conf->get_segment("historian"));
+    }
+
+    m_controller.clear_tasks();
+    m_controller.add_task([this](CycleScheduler::Clock::time_point now) { m_recipe_runner.tick(now); });
+
+    m_controller.start();
+
+    start_historian();
+}
+
+void Watchtower::shutdown() {
+    m_controller.stop();
+    m_historian.stop();
+    m_controller.clear_devices();
+    m_controller.clear_tasks();
+
+    m_devices_by_id.clear();
+    m_names.clear();
+    m_devices.clear();
+
+    // Stops the poll thread
+    m_plant.set_plc(nullptr);
+    m_plc.reset();
+
+    m_simulator_servers.clear();
+}
+
+Device *Watchtower::get_device(device_id id) const { return id < m_devices_by_id.size() ? m_devices_by_id[id] : nullptr; }
+
+Device *Watchtower::find_device(const std::string &name) const {
+    auto it = std::find(m_names.begin(), m_names.end(), name);
+    if (it == m_names.end()) {
+        return nullptr;
+    }
+
+    return m_devices[static_cast<size_t>(it - m_names.begin())].get();
+}
+
+void Watchtower::start_historian() {
+    if (!m_historian.is_enabled() || m_historian.is_recording()) {
+        return;
+    }
+
+    for (size_t i = 0; i < m_devices.size(); i++) {
+        if (auto *generator = dynamic_cast<RFGenerator *>(m_devices[i].get())) {
+            m_historian.add_generator(generator, m_names[i]);
+        }
+    }
+    m_historian.add_plc(m_plc.get());
+
+    // Until a recipe is loaded
+    m_historian.start("startup");
+}
+
+void Watchtower::connect_devices(size_t first, const std::vector<std::chrono::milliseconds> &timeouts) {
+    using Clock = std::chrono::steady_clock;
+
+    if (timeouts.empty()) {
+        return;
+    }
+
+    // Every connector connects in its own I/O thread, so the attempts run concurrently
+    const auto start = Clock::now();
+    for (size_t i = 0; i < timeouts.size(); i++) {
+        m_devices[first + i]->connect_async();
+    }
+
+    QEventLoop loop;
+
+    // Quits the loop once every device is either connected or its timeout passed
+    auto check = [&]() {
+        const auto elapsed = Clock::now() - start;
+        for (size_t i = 0; i < timeouts.size(); i++) {
+            const auto &device = m_devices[first + i];
+            if (device->get_connection_state() != BaseConnector::ConnectionState::Connected && elapsed < timeouts[i]) {
+                return;
+            }
+        }
+        loop.quit();
+    };
+
+    for (size_t i = 0; i < timeouts.size(); i++) {
+        QObject::connect(m_devices[first + i].get(), &Device::connection_status_changed, &loop, check);
+        QTimer::singleShot(static_cast<int>(timeouts[i].count()), &loop, check);
+    }
+
+    loop.exec();
+
+    for (size_t i = 0; i < timeouts.size(); i++) {
+        if (m_devices[first + i]->get_connection_state() != BaseConnector::ConnectionState::Connected) {
+            logging::main_log()->warn("Watchtower: device '{0}' did not connect within {1}ms, retrying in the background",
+                                      m_names[first + i], timeouts[i].count());
+        }
+    }
+
+    logging::main_log()->debug(
+        "Watchtower: connecting {0} device(s) took {1}ms", timeouts.size(),
+        std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count());
+}
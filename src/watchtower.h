@@ -1,7 +1,21 @@
 #pragma once
 
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include <QObject>
 
+#include "controller.h"
+#include "devices/device.h"
+#include "devices/plc/s7.h"
+#include "devices/simulation/simulator_server.h"
+#include "historian/historian.h"
+#include "recipe/recipe_runner.h"
+
+// Watchtower owns all devices and the controller that drives them. Devices are loaded from the device manifest and can be
+// looked up by their id (in constant time) or by the name of their segment in the manifest.
 class Watchtower : public QObject {
     Q_OBJECT
 private:
@@ -10,7 +24,7 @@ private:
     Watchtower &operator=(const Watchtower &) = delete;
 
 public:
-    ~Watchtower() = default;
+    ~Watchtower() { shutdown(); }
 
     // Thread-safe as of C++11 (§6.7 [stmt.dcl] p4)
     static Watchtower &instance() noexcept {
@@ -18,9 +32,80 @@ public:
         return wt;
     }
 
-    void load_devices(const std::string &file);
+    // Creates and initializes the devices described in the manifest file, one segment per device with its "type" (see
+    // make_device), the device settings, optionally its "budget" in us (see Controller::add_device) and its connect
+    // "timeout" in ms. The devices are added to the controller ordered by their "order" setting (0 if not set) and their
+    // name, which is the order they are updated in.
+    //
+    // All devices are connected at the same time, each in the I/O thread of its connector. load_devices waits until every
+    // device is connected or its timeout passed, so a cold start takes at most the longest timeout instead of the sum of
+    // all of them. Devices that are not connected by then keep trying in the background. Devices loaded by an earlier call
+    // are kept.
+    bool load_devices(const std::string &file);
+
+    // Starts a SimulatorServer for every child of the "simulation" segment of the main config, with the "type" of the
+    // simulator (see simulation::make_simulator), its "port" and the link settings (see simulation::LinkSettings). The
+    // servers only listen, the settings of the devices are not changed: to run without the hardware, set the "address" and
+    // "port" of the ethernet connection of a device (or of the "connection" of the "plc" segment for the S7) to 127.0.0.1
+    // and the port of the server. Serial devices can use a loopback connector instead, which runs the simulator in place.
+    void start_simulators();
+
+    // Compiles the recipe in file (see recipe::compile) against the loaded devices and the PLC and loads it into the recipe
+    // runner. Returns false if the recipe is invalid or another recipe is running. The historian continues recording in a
+    // new segment named after the recipe.
+    bool load_recipe(const std::string &file);
+
+    // Creates the PLC from the "plc" segment of the main config (see PLC::S7::init), connects it and starts polling. Without
+    // the segment, or if the PLC does not connect, recipes that use PLC tags fail to compile and the historian records
+    // only the RF generators. Has to be called before start and load_recipe.
+    bool load_plc();
+
+    // The PLC recipes refer to for their tags, nullptr if none was loaded
+    PLC::S7 *get_plc() const { return m_plc.get(); }
+
+    // Starts the cycle of the controller, its settings are read from the "controller" segment of the main config. The
+    // recipe runner is ticked once per cycle. The historian records the RF generators and the PLC with the settings of the
+    // "historian" segment (see historian::Historian::init).
+    void start();
+
+    // Stops the controller and the historian and destroys all devices and the PLC
+    void shutdown();
+
+    Controller &get_controller() { return m_controller; }
+    recipe::RecipeRunner &get_recipe_runner() { return m_recipe_runner; }
+    historian::Historian &get_historian() { return m_historian; }
+
+    // Returns the device with the given id, nullptr if there is none
+    Device *get_device(device_id id) const;
+    // Returns the device loaded from the manifest segment with the given name, nullptr if there is none
+    Device *find_device(const std::string &name) const;
+
+    const std::vector<std::unique_ptr<Device>> &get_devices() const { return m_devices; }
 
 private:
+    // Starts connecting the devices from index first on, one per timeout, and waits until each of them is connected or its
+    // timeout passed
+    void connect_devices(size_t first, const std::vector<std::chrono::milliseconds> &timeouts);
+
+    // Subscribes the historian to the RF generators and the PLC and starts recording, unless it is disabled or recording
+    void start_historian();
+
+    // Declared before the controller, so the controller is stopped before the devices are destroyed
+    std::vector<std::unique_ptr<Device>> m_devices;
+    // Name of the manifest segment of each device in m_devices
+    std::vector<std::string> m_names;
+    // The devices indexed by their id. Ids are handed out sequentially, so the vector stays small.
+    std::vector<Device *> m_devices_by_id;
+
+    std::vector<std::unique_ptr<simulation::SimulatorServer>> m_simulator_servers;
+
+    // Declared before the recipe runner and the historian, which refer to it
+    std::unique_ptr<PLC::S7> m_plc;
+    recipe::DevicePlant m_plant;
+    recipe::RecipeRunner m_recipe_runner{m_plant};
 
+    // Declared after the devices, so it is destroyed before them
+    historian::Historian m_historian;
 
-};
\ No newline at end of file
+    Controller m_controller;
+};
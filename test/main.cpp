@@ -1,7 +1,12 @@
 #include "gtest/gtest.h"
 
+#include "logging/logging.h"
+
 int main(int argc, char *argv[]) {
     ::testing::InitGoogleTest(&argc, argv);
+
+    // Some of the tested code logs its errors
+    logging::init_quiet();
     
     return RUN_ALL_TESTS();
 }
@@ -0,0 +1,858 @@
+#include "gtest/gtest.h"
+
+#include "cycle_scheduler.h"
+#include "devices/connector/capture.h"
+#include "devices/framer.h"
+#include "devices/match_tuner.h"
+#include "devices/power_controller.h"
+#include "devices/protocol.h"
+#include "devices/simulation/cesar_simulator.h"
+#include "devices/simulation/hofi_simulator.h"
+#include "devices/simulation/kjl_simulator.h"
+#include "devices/simulation/s7_simulator.h"
+#include "devices/telemetry.h"
+#include "devices/telemetry_sampler.h"
+#include "devices/transaction_engine.h"
+
+#include <string>
+#include <vector>
+
+// Devices
+// transaction_engine.h
+
+namespace {
+    using namespace std::chrono_literals;
+
+    // Records everything the engine sends or gives up
+    struct EngineLog {
+        std::vector<std::string> sent;
+        std::vector<std::string> failed;
+
+        void attach(TransactionEngine &engine) {
+            engine.set_send_function([this](const std::string &frame) { sent.push_back(frame); });
+            engine.set_fail_function(
+                [this](const TransactionEngine::Transaction &transaction, const char *) { failed.push_back(transaction.frame); });
+        }
+    };
+}  // namespace
+
+TEST(TransactionEngine, SendAfterAcknowledge) {
+    TransactionEngine engine(1, 100ms, 500ms, 3);
+    EngineLog log;
+    log.attach(engine);
+
+    const auto now = TransactionEngine::Clock::now();
+    engine.submit(1, "a", false, TransactionEngine::Priority::Normal, now);
+    engine.submit(2, "b", false, TransactionEngine::Priority::Normal, now);
+    EXPECT_EQ(log.sent, (std::vector<std::string>{"a"}));
+    EXPECT_EQ(engine.in_flight(), 1u);
+    EXPECT_EQ(engine.queued(), 1u);
+
+    engine.acknowledge(now);
+    EXPECT_EQ(log.sent, (std::vector<std::string>{"a", "b"}));
+
+    engine.acknowledge(now);
+    EXPECT_EQ(engine.in_flight(), 0u);
+    EXPECT_FALSE(engine.next_deadline());
+}
+
+TEST(TransactionEngine, PriorityLane) {
+    TransactionEngine engine(1, 100ms, 500ms, 3);
+    EngineLog log;
+    log.attach(engine);
+
+    const auto now = TransactionEngine::Clock::now();
+    engine.submit(165, "query1", true, TransactionEngine::Priority::Normal, now);
+    engine.submit(166, "query2", true, TransactionEngine::Priority::Normal, now);
+    engine.submit(1, "off", false, TransactionEngine::Priority::High, now);
+
+    // The high priority command overtakes the queued query, but not the one that was already sent
+    engine.acknowledge(now);
+    engine.acknowledge(now);
+    EXPECT_EQ(log.sent, (std::vector<std::string>{"query1", "off", "query2"}));
+}
+
+TEST(TransactionEngine, RetriesAndTimeouts) {
+    TransactionEngine engine(1, 100ms, 500ms, 3);
+    EngineLog log;
+    log.attach(engine);
+
+    auto now = TransactionEngine::Clock::now();
+    engine.submit(8, "set", false, TransactionEngine::Priority::Normal, now);
+    engine.reject(now);
+    EXPECT_EQ(log.sent.size(), 2u);
+
+    // Not due yet
+    engine.expire(now + 50ms);
+    EXPECT_EQ(log.sent.size(), 2u);
+    ASSERT_TRUE(engine.next_deadline());
+    EXPECT_EQ(*engine.next_deadline(), now + 100ms);
+
+    engine.expire(now + 100ms);
+    EXPECT_EQ(log.sent.size(), 3u);
+    EXPECT_TRUE(log.failed.empty());
+
+    // Third attempt used up
+    engine.reject(now + 100ms);
+    EXPECT_EQ(log.failed, (std::vector<std::string>{"set"}));
+    EXPECT_EQ(engine.in_flight(), 0u);
+}
+
+TEST(TransactionEngine, CorrelateReplies) {
+    TransactionEngine engine(2, 100ms, 500ms, 3);
+    EngineLog log;
+    log.attach(engine);
+
+    const auto now = TransactionEngine::Clock::now();
+    engine.submit(165, "forward", true, TransactionEngine::Priority::Normal, now);
+    engine.submit(166, "reflected", true, TransactionEngine::Priority::Normal, now);
+    EXPECT_EQ(engine.in_flight(), 2u);
+
+    engine.acknowledge(now);
+    engine.acknowledge(now);
+    EXPECT_EQ(engine.awaiting_reply(), 2u);
+
+    // Replies may arrive in any order
+    EXPECT_TRUE(engine.correlate(166));
+    EXPECT_FALSE(engine.correlate(166));
+    EXPECT_EQ(engine.awaiting_reply(), 1u);
+
+    engine.expire(now + 500ms);
+    EXPECT_EQ(log.failed, (std::vector<std::string>{"forward"}));
+    EXPECT_EQ(engine.awaiting_reply(), 0u);
+}
+
+// framer.h
+
+namespace {
+    // Collects all frames the reader finds in data
+    template <typename Framer>
+    std::vector<std::pair<std::string, bool>> read_frames(framing::FrameReader<Framer> &reader, const std::string &data) {
+        std::vector<std::pair<std::string, bool>> frames;
+
+        EXPECT_TRUE(reader.push(data.data(), data.size()));
+        reader.for_each_frame([&](std::string_view frame, bool valid) { frames.emplace_back(std::string(frame), valid); });
+
+        return frames;
+    }
+}  // namespace
+
+TEST(Framer, Cesar) {
+    framing::FrameReader<framing::CesarFramer> reader(64);
+
+    // ACK, then a reply to command 0xA5 with two bytes of data and a packet with a broken checksum
+    const std::string reply{'\x02', '\xA5', '\x10', '\x20', static_cast<char>(0x02 ^ 0xA5 ^ 0x10 ^ 0x20)};
+    const std::string corrupted{'\x01', '\x01', '\x00', '\x55'};
+
+    auto frames = read_frames(reader, "\x06" + reply + corrupted + reply.substr(0, 3));
+    ASSERT_EQ(frames.size(), 3u);
+    EXPECT_EQ(frames[0], std::make_pair(std::string("\x06"), true));
+    EXPECT_EQ(frames[1], std::make_pair(reply, true));
+    EXPECT_FALSE(frames[2].second);
+
+    // The rest of the last packet
+    frames = read_frames(reader, reply.substr(3));
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0], std::make_pair(reply, true));
+    EXPECT_EQ(reader.size(), 0u);
+
+    // Data length in an extra byte
+    std::string extended{'\x07', '\xAF', '\x08', '1', '2', '3', '4', '5', '6', '7', '8', '\0'};
+    for (size_t i = 0; i + 1 < extended.size(); i++) {
+        extended.back() ^= extended[i];
+    }
+    frames = read_frames(reader, extended);
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0], std::make_pair(extended, true));
+    EXPECT_EQ(framing::CesarFramer::data_offset(extended[0]), 3u);
+
+    // Packets we build are read back unchanged
+    for (const auto &command : {std::string("\xA5"), std::string("\x08\x2C\x01"), std::string("\x70" "1234567")}) {
+        const auto packet = framing::CesarFramer::make_packet(3, command);
+        EXPECT_EQ(static_cast<uint8_t>(packet[0]) >> 3, 3);
+        frames = read_frames(reader, packet);
+        ASSERT_EQ(frames.size(), 1u);
+        EXPECT_EQ(frames[0], std::make_pair(packet, true));
+    }
+}
+
+TEST(Framer, Delimited) {
+    framing::FrameReader<framing::DelimitedFramer> reader(16, framing::DelimitedFramer('\r', 2));
+
+    auto frames = read_frames(reader, "W?\r0100");
+    EXPECT_TRUE(frames.empty());
+
+    frames = read_frames(reader, "\rG\r\rR?");
+    ASSERT_EQ(frames.size(), 2u);
+    EXPECT_EQ(frames[0].first, "W?\r0100\r");
+    EXPECT_EQ(frames[1].first, "G\r\r");
+
+    // Wraps around the end of the buffer
+    frames = read_frames(reader, "\r0002\rS\r");
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0].first, "R?\r0002\r");
+    EXPECT_EQ(reader.size(), 2u);
+}
+
+TEST(Framer, FixedLengthAndOverflow) {
+    framing::FrameReader<framing::FixedLengthFramer> reader(8, framing::FixedLengthFramer(4));
+
+    auto frames = read_frames(reader, "abcdefgh");
+    ASSERT_EQ(frames.size(), 2u);
+    EXPECT_EQ(frames[1].first, "efgh");
+
+    frames = read_frames(reader, "ij");
+    EXPECT_TRUE(frames.empty());
+    EXPECT_EQ(reader.size(), 2u);
+
+    // Does not fit, the buffered data is discarded
+    EXPECT_FALSE(reader.push("0123456789", 10));
+    EXPECT_EQ(reader.size(), 8u);
+}
+
+// protocol.h
+
+namespace {
+    struct TestParameters {
+        int power = -1;
+        int load = -1;
+        int tune = -1;
+    };
+
+    using TestCommand = protocol::Command<TestParameters>;
+
+    // clang-format off
+    constexpr protocol::Table TEST_TABLE{std::array<TestCommand, 4>{{
+        {8, "SetPower", protocol::Encoding::UInt16LE},
+        {165, "ReportPower", protocol::Encoding::None, "P?",
+            {{{protocol::Encoding::UInt16LE, 0, 1, &TestParameters::power}}}},
+        {175, "ReportPositions", protocol::Encoding::None, "{0} MP",
+            {{{protocol::Encoding::UInt16LE, 0, 10, &TestParameters::load},
+              {protocol::Encoding::UInt16LE, 2, 10, &TestParameters::tune}}}},
+        {3, "Status", protocol::Encoding::None, "Q",
+            {{{protocol::Encoding::Decimal, 1, 1, &TestParameters::power}}}},
+    }}};
+    // clang-format on
+
+    static_assert(TEST_TABLE.find(175) != nullptr && TEST_TABLE.find(9) == nullptr, "lookup at compile time");
+}  // namespace
+
+TEST(Protocol, Find) {
+    ASSERT_NE(TEST_TABLE.find(165), nullptr);
+    EXPECT_STREQ(TEST_TABLE.find(165)->name, "ReportPower");
+    EXPECT_EQ(TEST_TABLE.find(0), nullptr);
+
+    EXPECT_EQ(TEST_TABLE.find("P?"), TEST_TABLE.find(165));
+    EXPECT_EQ(TEST_TABLE.find("120 MP"), TEST_TABLE.find(175));
+    EXPECT_EQ(TEST_TABLE.find(" MP"), nullptr);  // the value is missing
+    EXPECT_EQ(TEST_TABLE.find("X"), nullptr);
+}
+
+TEST(Protocol, DecodeBinary) {
+    TestParameters parameters;
+
+    // Values above 0x7F must not be sign extended
+    EXPECT_TRUE(protocol::decode(*TEST_TABLE.find(165), std::string_view("\xF4\x01", 2), parameters));
+    EXPECT_EQ(parameters.power, 500);
+
+    EXPECT_TRUE(protocol::decode(*TEST_TABLE.find(175), std::string_view("\x88\x13\xD0\x07", 4), parameters));
+    EXPECT_EQ(parameters.load, 500);
+    EXPECT_EQ(parameters.tune, 200);
+
+    // Too short, nothing is stored
+    EXPECT_FALSE(protocol::decode(*TEST_TABLE.find(175), std::string_view("\x00\x00\x00", 3), parameters));
+    EXPECT_EQ(parameters.load, 500);
+}
+
+TEST(Protocol, DecodeDecimalAndEncode) {
+    TestParameters parameters;
+
+    EXPECT_TRUE(protocol::decode(*TEST_TABLE.find(3), "0010000  0300 0290 010 0600", parameters));
+    EXPECT_EQ(parameters.power, 300);
+    EXPECT_FALSE(protocol::decode(*TEST_TABLE.find(3), "0010000", parameters));
+    EXPECT_FALSE(protocol::decode(*TEST_TABLE.find(3), "0010000 abc", parameters));
+
+    std::string payload;
+    protocol::encode(*TEST_TABLE.find(8), 0x1234, payload);
+    EXPECT_EQ(payload, std::string("\x34\x12"));
+}
+
+// telemetry.h
+
+TEST(Telemetry, Freshness) {
+    Telemetry<3> telemetry;
+    const auto now = Telemetry<3>::Clock::now();
+
+    EXPECT_EQ(telemetry.get(1).value, -1);
+    EXPECT_FALSE(telemetry.is_fresh(1, now, 1s));
+
+    telemetry.update(1, 250, now);
+    EXPECT_EQ(telemetry.get(1).value, 250);
+    EXPECT_TRUE(telemetry.is_fresh(1, now + 1s, 1s));
+    EXPECT_FALSE(telemetry.is_fresh(1, now + 2s, 1s));
+    EXPECT_FALSE(telemetry.is_fresh(0, now, 1s));
+}
+
+TEST(Telemetry, RateLimitedPublish) {
+    Telemetry<3> telemetry;
+    telemetry.set_min_interval(100ms);
+    const auto now = Telemetry<3>::Clock::now();
+
+    EXPECT_FALSE(telemetry.next_publish());
+    EXPECT_EQ(telemetry.publish(now), 0u);
+
+    // The first change is published right away
+    telemetry.update(0, 1, now);
+    EXPECT_EQ(telemetry.publish(now), 0b1u);
+
+    // Changes within the interval are coalesced
+    telemetry.update(1, 2, now + 10ms);
+    telemetry.update(2, 3, now + 20ms);
+    telemetry.update(1, 4, now + 30ms);
+    EXPECT_EQ(telemetry.publish(now + 30ms), 0u);
+    ASSERT_TRUE(telemetry.next_publish());
+    EXPECT_EQ(*telemetry.next_publish(), now + 100ms);
+
+    EXPECT_EQ(telemetry.publish(now + 100ms), 0b110u);
+    EXPECT_EQ(telemetry.get(1).value, 4);
+    EXPECT_FALSE(telemetry.next_publish());
+}
+
+// telemetry_sampler.h
+
+TEST(TelemetrySampler, RoundRobinBursts) {
+    TelemetrySampler sampler;
+    sampler.add_query(1, true);
+    sampler.add_query(2, false);
+    sampler.add_query(1, false);
+    EXPECT_FALSE(sampler.next_due());
+
+    sampler.set_rate(10);
+    auto now = TelemetrySampler::Clock::now();
+
+    EXPECT_EQ(sampler.next_burst(now), (std::vector<size_t>{0, 1}));
+    // Not answered yet
+    EXPECT_TRUE(sampler.next_burst(now + 100ms).empty());
+
+    sampler.on_reply(now + 10ms);
+    sampler.on_reply(now + 20ms);
+    sampler.on_reply(now + 30ms);
+    EXPECT_EQ(sampler.round_trip_time(), 10ms);
+
+    EXPECT_TRUE(sampler.next_burst(now + 50ms).empty());
+    EXPECT_EQ(sampler.next_burst(now + 100ms), (std::vector<size_t>{0, 2}));
+    now += 100ms;
+
+    // Replies are lost, the next burst starts after the reply timeout
+    sampler.set_reply_timeout(500ms);
+    ASSERT_TRUE(sampler.next_due());
+    EXPECT_EQ(*sampler.next_due(), now + 500ms);
+    EXPECT_EQ(sampler.next_burst(now + 500ms), (std::vector<size_t>{0, 1}));
+}
+
+TEST(TelemetrySampler, AdaptToRoundTripTime) {
+    TelemetrySampler sampler;
+    sampler.add_query(1, true);
+    sampler.add_query(1, true);
+    sampler.set_rate(20);
+
+    auto now = TelemetrySampler::Clock::now();
+    ASSERT_EQ(sampler.next_burst(now).size(), 2u);
+    EXPECT_EQ(sampler.interval(), 50ms);
+
+    // Each query takes 40ms, so a burst needs 80ms instead of the 50ms of the target rate
+    sampler.on_reply(now + 40ms);
+    sampler.on_reply(now + 80ms);
+    EXPECT_EQ(sampler.interval(), 80ms);
+    EXPECT_TRUE(sampler.next_burst(now + 50ms).empty());
+    EXPECT_EQ(sampler.next_burst(now + 80ms).size(), 2u);
+}
+
+TEST(TelemetrySampler, RejectedQuery) {
+    TelemetrySampler sampler;
+    sampler.add_query(1, true);
+    sampler.add_query(1, true);
+    sampler.set_rate(10);
+    sampler.set_reply_timeout(500ms);
+
+    auto now = TelemetrySampler::Clock::now();
+    ASSERT_EQ(sampler.next_burst(now).size(), 2u);
+    sampler.on_reply(now + 20ms);
+    EXPECT_EQ(sampler.round_trip_time(), 20ms);
+
+    // The second query is rejected, the burst is complete without waiting for the reply timeout and the round trip time
+    // is not changed
+    sampler.on_failure(now + 22ms);
+    EXPECT_EQ(sampler.round_trip_time(), 20ms);
+    ASSERT_TRUE(sampler.next_due());
+    EXPECT_EQ(*sampler.next_due(), now + 100ms);
+    EXPECT_EQ(sampler.next_burst(now + 100ms).size(), 2u);
+    now += 100ms;
+
+    // A reply after a rejected query is measured from the rejection
+    sampler.on_failure(now + 5ms);
+    sampler.on_reply(now + 25ms);
+    EXPECT_EQ(sampler.round_trip_time(), 20ms);
+}
+
+// power_controller.h
+
+TEST(PowerController, LinearRamp) {
+    PowerController controller;
+    PowerController::Settings settings;
+    settings.period = 50ms;
+    settings.ramp_rate = 100;
+    settings.resolution = 5;
+    controller.set_settings(settings);
+
+    const auto now = PowerController::Clock::now();
+    controller.start(0);
+    controller.set_target(12);
+
+    EXPECT_FALSE(controller.update(now, {}));
+    // Not due yet
+    EXPECT_FALSE(controller.update(now + 10ms, {}));
+    EXPECT_EQ(controller.update(now + 50ms, {}), 5);
+    EXPECT_EQ(controller.update(now + 100ms, {}), 10);
+    // The end of the ramp is sent although it is closer than the resolution
+    EXPECT_EQ(controller.update(now + 150ms, {}), 12);
+    EXPECT_FALSE(controller.update(now + 200ms, {}));
+}
+
+TEST(PowerController, OnlyResolutionSteps) {
+    PowerController controller;
+    PowerController::Settings settings;
+    settings.period = 50ms;
+    settings.ramp_rate = 40;
+    settings.resolution = 5;
+    controller.set_settings(settings);
+
+    const auto now = PowerController::Clock::now();
+    controller.start(0);
+    controller.set_target(100);
+
+    EXPECT_FALSE(controller.update(now, {}));
+    EXPECT_FALSE(controller.update(now + 50ms, {}));
+    EXPECT_FALSE(controller.update(now + 100ms, {}));
+    EXPECT_EQ(controller.update(now + 150ms, {}), 6);
+    EXPECT_DOUBLE_EQ(controller.get_reference(), 6);
+}
+
+TEST(PowerController, BumplessClosedLoop) {
+    PowerController controller;
+    PowerController::Settings settings;
+    settings.period = 50ms;
+    settings.ramp_rate = 100;
+    settings.kp = 0.5;
+    settings.ki = 0;
+    controller.set_settings(settings);
+
+    const auto now = PowerController::Clock::now();
+    controller.start(100);
+    controller.set_mode(PowerController::Mode::ForwardPower);
+    controller.set_target(120);
+
+    // The reference starts at the measured 90W, so the output stays at the setpoint the generator has
+    EXPECT_FALSE(controller.update(now, {90, now, -1}));
+    EXPECT_DOUBLE_EQ(controller.get_reference(), 90);
+
+    // The ramp goes on without a new measurement, the output is held
+    EXPECT_FALSE(controller.update(now + 50ms, {90, now, -1}));
+    EXPECT_DOUBLE_EQ(controller.get_reference(), 95);
+
+    EXPECT_EQ(controller.update(now + 100ms, {92, now + 100ms, -1}), 104);
+}
+
+TEST(PowerController, ReflectedPowerTrip) {
+    PowerController controller;
+    PowerController::Settings settings;
+    settings.period = 1ms;
+    settings.reflected_limit = 20;
+    settings.trip_time = 100ms;
+    controller.set_settings(settings);
+
+    const auto now = PowerController::Clock::now();
+    controller.start(50);
+    controller.set_target(50);
+
+    controller.update(now, {-1, {}, 30});
+    // Dropping below the limit restarts the trip time
+    controller.update(now + 50ms, {-1, {}, 10});
+    controller.update(now + 100ms, {-1, {}, 30});
+    controller.update(now + 199ms, {-1, {}, 30});
+    EXPECT_FALSE(controller.is_tripped());
+
+    controller.update(now + 200ms, {-1, {}, 30});
+    EXPECT_TRUE(controller.is_tripped());
+    EXPECT_FALSE(controller.is_active());
+
+    controller.start(0);
+    EXPECT_FALSE(controller.is_tripped());
+}
+
+TEST(PowerController, TripWithoutControl) {
+    PowerController controller;
+    PowerController::Settings settings;
+    settings.reflected_limit = 20;
+    settings.trip_time = 100ms;
+    controller.set_settings(settings);
+
+    // The power is set directly, e.g. by a recipe
+    const auto now = PowerController::Clock::now();
+    EXPECT_FALSE(controller.supervise(now, 30));
+    EXPECT_FALSE(controller.supervise(now + 99ms, 30));
+    EXPECT_TRUE(controller.supervise(now + 100ms, 30));
+    EXPECT_TRUE(controller.is_tripped());
+
+    // The trip is reported once, then the trip time starts over
+    EXPECT_FALSE(controller.supervise(now + 101ms, 30));
+    EXPECT_TRUE(controller.supervise(now + 201ms, 30));
+
+    // While control is active, update checks the reflected power
+    controller.start(50);
+    EXPECT_FALSE(controller.supervise(now + 400ms, 30));
+    EXPECT_FALSE(controller.is_tripped());
+}
+
+// match_tuner.h
+
+namespace {
+    // Runs the tuner on a reflected power with its minimum at (37, 62), returns the number of evaluations
+    int run_tuner(MatchTuner &tuner) {
+        while (tuner.is_running()) {
+            const auto position = tuner.get_position();
+            const double load = position.load - 37;
+            const double tune = position.tune - 62;
+            tuner.report(5 + 0.1 * load * load + 0.2 * tune * tune);
+        }
+        return tuner.get_evaluations();
+    }
+}  // namespace
+
+TEST(MatchTuner, FindMinimum) {
+    MatchTuner tuner;
+    tuner.start({50, 50}, false);
+    const int cold = run_tuner(tuner);
+
+    EXPECT_NEAR(tuner.get_best().load, 37, 1);
+    EXPECT_NEAR(tuner.get_best().tune, 62, 1);
+    EXPECT_LE(cold, tuner.get_settings().max_evaluations + 2);
+
+    // A warm start next to the match needs fewer measurements
+    tuner.start({38, 61}, true);
+    EXPECT_LT(run_tuner(tuner), cold);
+    EXPECT_NEAR(tuner.get_best().load, 37, 1);
+    EXPECT_NEAR(tuner.get_best().tune, 62, 1);
+}
+
+TEST(MatchTuner, StayInRangeAndStopAtTarget) {
+    MatchTuner tuner;
+    MatchTuner::Settings settings;
+    settings.target_reflected = 6;
+    tuner.set_settings(settings);
+
+    tuner.start({100, 100}, false);
+    while (tuner.is_running()) {
+        const auto position = tuner.get_position();
+        ASSERT_GE(position.load, 0);
+        ASSERT_LE(position.load, 100);
+        ASSERT_GE(position.tune, 0);
+        ASSERT_LE(position.tune, 100);
+
+        const double load = position.load - 37;
+        const double tune = position.tune - 62;
+        tuner.report(5 + 0.1 * load * load + 0.2 * tune * tune);
+    }
+    EXPECT_LE(tuner.get_best_reflected(), 6);
+}
+
+TEST(MatchCache, NearestPower) {
+    MatchCache cache(10);
+    EXPECT_FALSE(cache.lookup(1, 100));
+
+    cache.store(1, 100, {10, 20});
+    cache.store(1, 204, {30, 40});
+    cache.store(2, 150, {50, 60});
+
+    EXPECT_EQ(cache.lookup(1, 98)->load, 10);
+    EXPECT_EQ(cache.lookup(1, 140)->load, 10);
+    EXPECT_EQ(cache.lookup(1, 160)->load, 30);
+    EXPECT_EQ(cache.lookup(1, 1000)->load, 30);
+    EXPECT_EQ(cache.lookup(2, 0)->load, 50);
+    EXPECT_FALSE(cache.lookup(3, 100));
+
+    // Newer results replace older ones
+    cache.store(1, 102, {11, 21});
+    EXPECT_EQ(cache.lookup(1, 100)->load, 11);
+    EXPECT_EQ(cache.size(), 3u);
+}
+
+// Simulation
+// simulation/simulator.h
+
+TEST(Link, LatencyAndOrder) {
+    simulation::LinkSettings settings;
+    settings.latency = 1ms;
+    settings.jitter = 5ms;
+    simulation::Link link(settings);
+
+    const auto start = simulation::Link::Clock::now();
+    for (int i = 0; i < 10; i++) {
+        link.send(std::to_string(i), start);
+    }
+
+    std::string delivered;
+    link.deliver(start + 999us, [&](const std::string &data) { delivered += data; });
+    EXPECT_TRUE(delivered.empty());
+    ASSERT_TRUE(link.next_delivery());
+    EXPECT_GE(*link.next_delivery(), start + 1ms);
+
+    // Jitter never reorders the data
+    link.deliver(start + 6ms, [&](const std::string &data) { delivered += data; });
+    EXPECT_EQ(delivered, "0123456789");
+    EXPECT_FALSE(link.next_delivery());
+}
+
+TEST(Link, TimerInterval) {
+    simulation::LinkSettings settings;
+    settings.latency = 2500us;
+    simulation::Link link(settings);
+
+    const auto start = simulation::Link::Clock::now();
+    EXPECT_FALSE(link.timer_interval(start));
+
+    // The timer fires at the last whole millisecond before the reply and then polls until it arrived
+    link.send("A", start);
+    EXPECT_EQ(link.timer_interval(start), 2);
+    EXPECT_EQ(link.timer_interval(start + 2ms), 0);
+    EXPECT_EQ(link.timer_interval(start + 3ms), 0);
+
+    std::string delivered;
+    link.deliver(start + 2499us, [&](const std::string &data) { delivered += data; });
+    EXPECT_TRUE(delivered.empty());
+    link.deliver(start + 2500us, [&](const std::string &data) { delivered += data; });
+    EXPECT_EQ(delivered, "A");
+}
+
+TEST(Link, Corruption) {
+    simulation::LinkSettings settings;
+    settings.corruption_rate = 1;
+    simulation::Link link(settings);
+
+    const auto start = simulation::Link::Clock::now();
+    link.send("ABCD", start);
+    link.deliver(start, [](const std::string &data) {
+        // Exactly one bit differs
+        int bits = 0;
+        for (size_t i = 0; i < data.size(); i++) {
+            for (int value = data[i] ^ "ABCD"[i]; value; value &= value - 1) {
+                bits++;
+            }
+        }
+        EXPECT_EQ(bits, 1);
+    });
+    EXPECT_EQ(link.corrupted(), 1u);
+}
+
+namespace {
+    // Builds a Cesar packet for address 1
+    std::string cesar_packet(uint8_t command, const std::string &data) {
+        std::string packet{static_cast<char>(1 << 3 | data.size()), static_cast<char>(command)};
+        packet += data;
+
+        char checksum = 0;
+        for (char c : packet) {
+            checksum ^= c;
+        }
+        return packet + checksum;
+    }
+}  // namespace
+
+TEST(Simulator, Cesar) {
+    simulation::CesarSimulator simulator;
+
+    // Set the setpoint to 300 W (split across two writes) and switch the output on
+    const auto setpoint = cesar_packet(8, {'\x2C', '\x01'});
+    EXPECT_EQ(simulator.receive(setpoint.substr(0, 2)), "");
+    EXPECT_EQ(simulator.receive(setpoint.substr(2)), "\x06" + cesar_packet(8, std::string(1, '\0')));
+    simulator.receive(cesar_packet(2, ""));
+    EXPECT_EQ(simulator.get_plasma().forward_power(), 300);
+
+    EXPECT_EQ(simulator.receive(cesar_packet(165, "")), "\x06" + cesar_packet(165, {'\x2C', '\x01'}));
+
+    // The capacitors can only be moved in manual mode
+    const auto move_load = cesar_packet(112, {'\x64', '\x00'});
+    EXPECT_EQ(simulator.receive(move_load), "\x06" + cesar_packet(112, "\x01"));
+    simulator.receive(cesar_packet(13, std::string(1, '\0')));
+    EXPECT_EQ(simulator.receive(move_load), "\x06" + cesar_packet(112, std::string(1, '\0')));
+    EXPECT_DOUBLE_EQ(simulator.get_plasma().load, 0.1);
+    EXPECT_GT(simulator.get_plasma().reflected_power(), 0);
+
+    // Broken checksum
+    auto corrupted = cesar_packet(165, "");
+    corrupted.back() ^= 1;
+    EXPECT_EQ(simulator.receive(corrupted), "\x15");
+
+    simulator.set_nack_rate(1, 0);
+    EXPECT_EQ(simulator.receive(cesar_packet(165, "")), "\x15");
+}
+
+TEST(Simulator, KJLAndHofi) {
+    simulation::KJLSimulator kjl;
+    EXPECT_EQ(kjl.receive("250.0 W\r"), "250.0 W\r\r");
+    EXPECT_EQ(kjl.receive("G\rW?\r"), "G\r\rW?\r250\r");
+    EXPECT_EQ(kjl.receive("XYZ\r"), "XYZ\rN\r");
+
+    simulation::HofiSimulator hofi;
+    EXPECT_EQ(hofi.receive("HOFIPORT3"), "");
+    EXPECT_EQ(hofi.get_port(), 3);
+    EXPECT_EQ(hofi.receive("HOFISTATU"), std::string("STA\x03"));
+    EXPECT_EQ(hofi.receive("HOFIPORT9"), std::string("NAK\0", 4));
+}
+
+TEST(Simulator, S7) {
+    simulation::S7Simulator simulator;
+
+    // Connection request with the TSAPs as parameters
+    const std::string request{'\x03', '\x00', '\x00', '\x16', '\x11', '\xE0', '\x00', '\x00', '\x00', '\x01', '\x00',
+                              '\xC1', '\x02', '\x01', '\x00', '\xC2', '\x02', '\x01', '\x02', '\xC0', '\x01', '\x09'};
+    const auto confirm = simulator.receive(request);
+    ASSERT_EQ(confirm.size(), request.size());
+    EXPECT_EQ(static_cast<uint8_t>(confirm[5]), 0xD0);
+    EXPECT_EQ(confirm.substr(11), request.substr(11));
+
+    // Setup communication asking for a PDU size of 960
+    const std::string header{'\x03', '\x00', '\x00', '\x19', '\x02', '\xF0', '\x80'};
+    const std::string setup{'\x32', '\x01', '\x00', '\x00', '\x00', '\x01', '\x00', '\x08', '\x00', '\x00',
+                            '\xF0', '\x00', '\x00', '\x01', '\x00', '\x01', '\x03', '\xC0'};
+    auto reply = simulator.receive(header + setup);
+    ASSERT_EQ(reply.size(), 27u);
+    EXPECT_EQ(static_cast<uint8_t>(reply[8]), 0x03);
+    EXPECT_EQ(static_cast<uint8_t>(reply[25]) << 8 | static_cast<uint8_t>(reply[26]), simulation::S7Simulator::MAX_PDU_SIZE);
+
+    // Read 4 bytes from DB 1 at byte 2
+    simulator.write(simulation::S7Simulator::DB, 1, 2, {1, 2, 3, 4});
+    const std::string read{'\x03', '\x00', '\x00', '\x1F', '\x02', '\xF0', '\x80', '\x32', '\x01', '\x00', '\x00', '\x00',
+                           '\x02', '\x00', '\x0E', '\x00', '\x00', '\x04', '\x01', '\x12', '\x0A', '\x10', '\x02', '\x00',
+                           '\x04', '\x00', '\x01', '\x84', '\x00', '\x00', '\x10'};
+    reply = simulator.receive(read);
+    ASSERT_EQ(reply.size(), 29u);
+    EXPECT_EQ(reply.substr(19, 2), std::string("\x04\x01"));
+    EXPECT_EQ(reply.substr(21), std::string("\xFF\x04\x00\x20\x01\x02\x03\x04", 8));
+
+    // Rejected items return an error code instead of the data
+    simulator.set_nack_rate(1, 0);
+    reply = simulator.receive(read);
+    ASSERT_EQ(reply.size(), 25u);
+    EXPECT_EQ(static_cast<uint8_t>(reply[21]), 0x0A);
+}
+
+// capture.h
+
+namespace {
+    // Returns the frames of the capture as "<i|o><time>:<data>"
+    std::vector<std::string> captured(const capture::CaptureRing &ring) {
+        std::vector<std::string> frames;
+        ring.for_each([&](const capture::Frame &frame) {
+            frames.push_back((frame.direction == capture::Direction::Inbound ? "i" : "o") + std::to_string(frame.time) + ":"
+                             + std::string(frame.data));
+        });
+        return frames;
+    }
+}  // namespace
+
+TEST(Capture, AppendAndReopen) {
+    std::vector<uint8_t> buffer(1024);
+    capture::CaptureRing ring;
+    ASSERT_TRUE(ring.create(buffer.data(), buffer.size(), "serial", 1234));
+
+    EXPECT_TRUE(ring.append(capture::Direction::Outbound, 10, "\x02\xA5", 2));
+    EXPECT_TRUE(ring.append(capture::Direction::Inbound, 25, "\x06", 1));
+    EXPECT_TRUE(ring.append(capture::Direction::Inbound, 40, "", 0));
+    EXPECT_EQ(captured(ring), (std::vector<std::string>{"o10:\x02\xA5", "i25:\x06", "i40:"}));
+
+    // The capture is complete in the buffer after every append
+    capture::CaptureRing reopened;
+    ASSERT_TRUE(reopened.open(buffer.data(), buffer.size()));
+    EXPECT_EQ(reopened.get_type(), "serial");
+    EXPECT_EQ(reopened.get_start_time(), 1234);
+    EXPECT_EQ(reopened.get_count(), 3u);
+    EXPECT_EQ(captured(reopened), captured(ring));
+
+    buffer[0] = 'X';
+    EXPECT_FALSE(reopened.open(buffer.data(), buffer.size()));
+}
+
+TEST(Capture, Wrap) {
+    // Room for 6 records of 16 bytes of data
+    std::vector<uint8_t> buffer(capture::CaptureRing::HEADER_SIZE + 6 * 32);
+    capture::CaptureRing ring;
+    ASSERT_TRUE(ring.create(buffer.data(), buffer.size(), "ethernet", 0));
+
+    const std::string data(16, 'x');
+    for (int i = 0; i < 20; i++) {
+        EXPECT_TRUE(ring.append(capture::Direction::Inbound, i, data.data(), data.size()));
+    }
+    EXPECT_EQ(ring.get_count(), 6u);
+    EXPECT_EQ(ring.get_total(), 20u);
+
+    std::vector<int64_t> times;
+    ring.for_each([&](const capture::Frame &frame) { times.push_back(frame.time); });
+    EXPECT_EQ(times, (std::vector<int64_t>{14, 15, 16, 17, 18, 19}));
+
+    // A larger frame does not fit before the end, the ring continues at its start and drops the frames it overwrites
+    const std::string large(120, 'y');
+    EXPECT_TRUE(ring.append(capture::Direction::Outbound, 20, large.data(), large.size()));
+    EXPECT_TRUE(ring.append(capture::Direction::Inbound, 21, data.data(), data.size()));
+    EXPECT_EQ(captured(ring), (std::vector<std::string>{"o20:" + large, "i21:" + data}));
+
+    // Frames larger than the ring are rejected
+    const std::string huge(6 * 32, 'z');
+    EXPECT_FALSE(ring.append(capture::Direction::Inbound, 22, huge.data(), huge.size()));
+    EXPECT_EQ(ring.get_total(), 22u);
+}
+
+// Controller
+// cycle_scheduler.h
+
+TEST(CycleScheduler, DriftCorrection) {
+    CycleScheduler scheduler(10ms);
+    const auto start = CycleScheduler::Clock::now();
+    scheduler.start(start);
+
+    // A late cycle does not shift the ones after it
+    scheduler.begin_cycle(start + 3ms);
+    EXPECT_TRUE(scheduler.end_cycle(start + 5ms));
+    EXPECT_EQ(scheduler.next_start(), start + 10ms);
+
+    scheduler.begin_cycle(start + 11ms);
+    EXPECT_TRUE(scheduler.end_cycle(start + 12ms));
+    EXPECT_EQ(scheduler.next_start(), start + 20ms);
+
+    const auto &statistics = scheduler.statistics();
+    EXPECT_EQ(statistics.cycles, 2u);
+    EXPECT_EQ(statistics.overruns, 0u);
+    EXPECT_EQ(statistics.min_jitter, 1ms);
+    EXPECT_EQ(statistics.max_jitter, 3ms);
+    EXPECT_EQ(statistics.mean_jitter(), 2ms);
+    EXPECT_EQ(statistics.max_execution, 5ms);
+}
+
+TEST(CycleScheduler, Overrun) {
+    CycleScheduler scheduler(10ms);
+    const auto start = CycleScheduler::Clock::now();
+    scheduler.start(start);
+
+    // The cycle took 25ms, the cycles due at 10ms and 20ms are skipped and the phase is kept
+    scheduler.begin_cycle(start);
+    EXPECT_FALSE(scheduler.end_cycle(start + 25ms));
+    EXPECT_EQ(scheduler.next_start(), start + 30ms);
+
+    const auto &statistics = scheduler.statistics();
+    EXPECT_EQ(statistics.overruns, 1u);
+    EXPECT_EQ(statistics.skipped, 2u);
+    EXPECT_EQ(statistics.max_execution, 25ms);
+
+    scheduler.reset_statistics();
+    EXPECT_EQ(scheduler.statistics().cycles, 0u);
+}
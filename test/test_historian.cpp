@@ -0,0 +1,137 @@
+#include "gtest/gtest.h"
+
+#include "historian/chunk.h"
+
+#include <cmath>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+// Historian
+// chunk.h
+
+namespace {
+    using Samples = std::vector<std::pair<int64_t, double>>;
+
+    Samples decode(const historian::ChunkEncoder &chunk) {
+        historian::ChunkDecoder decoder(chunk.times().data(), chunk.times().size(), chunk.values().data(),
+                                        chunk.values().size(), chunk.count());
+
+        Samples samples;
+        int64_t time = 0;
+        double value = 0;
+        while (decoder.next(time, value)) {
+            samples.emplace_back(time, value);
+        }
+        return samples;
+    }
+}  // namespace
+
+TEST(Bits, WriteAndRead) {
+    historian::BitWriter writer;
+    writer.write(0b101, 3);
+    writer.write(0xABCDEF, 24);
+    writer.write(1, 1);
+    writer.write(0x123456789ABCDEF0, 64);
+    EXPECT_EQ(writer.data().size(), 12u);
+
+    historian::BitReader reader(writer.data().data(), writer.data().size());
+    uint64_t bits = 0;
+    ASSERT_TRUE(reader.read(3, bits));
+    EXPECT_EQ(bits, 0b101u);
+    ASSERT_TRUE(reader.read(24, bits));
+    EXPECT_EQ(bits, 0xABCDEFu);
+    ASSERT_TRUE(reader.read(1, bits));
+    EXPECT_EQ(bits, 1u);
+    ASSERT_TRUE(reader.read(64, bits));
+    EXPECT_EQ(bits, 0x123456789ABCDEF0u);
+    EXPECT_FALSE(reader.read(5, bits));
+}
+
+TEST(Chunk, RegularSamples) {
+    historian::ChunkEncoder chunk(4096);
+
+    // A constant value sampled at a fixed period, like a setpoint
+    Samples samples;
+    for (int i = 0; i < 1000; i++) {
+        samples.emplace_back(1'600'000'000'000'000 + i * 10'000, 500.0);
+        ASSERT_TRUE(chunk.append(samples.back().first, samples.back().second));
+    }
+
+    EXPECT_EQ(chunk.count(), 1000u);
+    EXPECT_EQ(chunk.first_time(), samples.front().first);
+    EXPECT_EQ(chunk.last_time(), samples.back().first);
+    // A byte per time and a bit per value after the first sample
+    EXPECT_LT(chunk.size(), 1200u);
+
+    EXPECT_EQ(decode(chunk), samples);
+}
+
+TEST(Chunk, ChangingSamples) {
+    historian::ChunkEncoder chunk(1 << 20);
+
+    // Jittering times, negative times and values that change in all sorts of ways
+    Samples samples = {{-5, 0.0}, {0, -0.0}, {3, 1.0}, {1000, 1.5}, {1001, 1e300}, {50'000, -2.25}, {50'001, NAN}};
+    for (int i = 0; i < 500; i++) {
+        samples.emplace_back(100'000 + i * 1000 + (i % 7) * 13, std::sin(i * 0.1) * 300 + (i % 3));
+    }
+
+    for (auto &[time, value] : samples) {
+        ASSERT_TRUE(chunk.append(time, value));
+    }
+
+    auto decoded = decode(chunk);
+    ASSERT_EQ(decoded.size(), samples.size());
+    for (size_t i = 0; i < samples.size(); i++) {
+        EXPECT_EQ(decoded[i].first, samples[i].first);
+        // Compare the bits, so NAN and -0.0 are checked as well
+        EXPECT_EQ(std::memcmp(&decoded[i].second, &samples[i].second, sizeof(double)), 0) << i;
+    }
+}
+
+TEST(Chunk, Full) {
+    historian::ChunkEncoder chunk(64);
+
+    int count = 0;
+    while (chunk.append(count * 1'000'003, count * 1.1)) {
+        count++;
+    }
+
+    EXPECT_GT(count, 1);
+    EXPECT_EQ(chunk.count(), static_cast<uint32_t>(count));
+    EXPECT_LE(chunk.size(), 64u);
+    EXPECT_EQ(decode(chunk).size(), static_cast<size_t>(count));
+
+    chunk.clear();
+    EXPECT_TRUE(chunk.empty());
+    EXPECT_TRUE(chunk.append(5, 1.0));
+    EXPECT_EQ(decode(chunk), (Samples{{5, 1.0}}));
+}
+
+TEST(ChunkIndex, Find) {
+    historian::ChunkIndex index;
+    for (uint16_t tag = 0; tag < 2; tag++) {
+        for (int i = 0; i < 10; i++) {
+            index.add({tag, 100, i * 100, i * 100 + 90, static_cast<uint64_t>(tag * 1000 + i)});
+        }
+    }
+    EXPECT_EQ(index.size(), 20u);
+
+    std::vector<uint64_t> found;
+    auto collect = [&found](const historian::ChunkInfo &chunk) { found.push_back(chunk.offset); };
+
+    index.find(1, 250, 420, collect);
+    EXPECT_EQ(found, (std::vector<uint64_t>{1002, 1003, 1004}));
+
+    // Ranges between two chunks, before the first and after the last one
+    found.clear();
+    index.find(0, 195, 199, collect);
+    index.find(0, -50, -1, collect);
+    index.find(0, 1000, 2000, collect);
+    EXPECT_TRUE(found.empty());
+
+    found.clear();
+    index.find(0, 990, 5000, collect);
+    index.find(2, 0, 5000, collect);
+    EXPECT_EQ(found, (std::vector<uint64_t>{9}));
+}
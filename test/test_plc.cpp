@@ -0,0 +1,428 @@
+#include "gtest/gtest.h"
+
+#include "devices/plc/bit_diff.h"
+#include "devices/plc/bit_image.h"
+#include "devices/plc/db.h"
+#include "devices/plc/poll_planner.h"
+#include "devices/plc/scan_class.h"
+#include "devices/plc/tag_index.h"
+#include "devices/plc/write_queue.h"
+
+#include <vector>
+
+// PLC
+// poll_planner.h
+
+// Area codes as defined by libnodave, repeated here so the tests do not depend on nodave.h
+constexpr int AREA_OUTPUTS = 0x82;
+constexpr int AREA_FLAGS = 0x83;
+constexpr int AREA_DB = 0x84;
+
+TEST(PollPlanner, SingleRequest) {
+    PLC::PollPlanner planner;
+    EXPECT_EQ(planner.add(AREA_FLAGS, 0, 0, 6), 0u);
+    EXPECT_EQ(planner.add(AREA_DB, 1, 0, 3), 6u);
+    EXPECT_EQ(planner.add(AREA_DB, 2, 0, 20), 10u);  // odd length is padded in the buffer
+    EXPECT_EQ(planner.image_size(), 30u);
+
+    ASSERT_TRUE(planner.plan(240, 20));
+    ASSERT_EQ(planner.requests().size(), 1u);
+    EXPECT_EQ(planner.requests()[0].items.size(), 3u);
+}
+
+TEST(PollPlanner, SplitByItemCount) {
+    PLC::PollPlanner planner;
+    for (int i = 0; i < 5; i++) {
+        planner.add(AREA_DB, i + 1, 0, 2);
+    }
+
+    ASSERT_TRUE(planner.plan(240, 2));
+    ASSERT_EQ(planner.requests().size(), 3u);
+    EXPECT_EQ(planner.requests()[0].items.size(), 2u);
+    EXPECT_EQ(planner.requests()[2].items.size(), 1u);
+    EXPECT_EQ(planner.requests()[2].items[0].db, 5);
+}
+
+TEST(PollPlanner, SplitByReplySize) {
+    PLC::PollPlanner planner;
+    planner.add(AREA_DB, 1, 0, 100);
+    planner.add(AREA_DB, 2, 0, 100);
+
+    // A reply with a PDU size of 200 holds 186 bytes of items, which is not enough for two items of 104 bytes each
+    ASSERT_TRUE(planner.plan(200, 20));
+    EXPECT_EQ(planner.requests().size(), 2u);
+
+    ASSERT_TRUE(planner.plan(240, 20));
+    EXPECT_EQ(planner.requests().size(), 1u);
+}
+
+TEST(PollPlanner, ChunkLargeAreas) {
+    PLC::PollPlanner planner;
+    planner.add(AREA_DB, 1, 0, 500);
+
+    ASSERT_TRUE(planner.plan(240, 20));
+
+    // Every chunk carries at most 240 - 14 - 4 = 222 bytes
+    int total = 0;
+    size_t expected_offset = 0;
+    for (const auto &request : planner.requests()) {
+        ASSERT_EQ(request.items.size(), 1u);
+        const auto &item = request.items[0];
+
+        EXPECT_LE(item.length, 222);
+        EXPECT_EQ(item.start, total);
+        EXPECT_EQ(item.offset, expected_offset);
+
+        total += item.length;
+        expected_offset += item.length;
+    }
+    EXPECT_EQ(total, 500);
+    EXPECT_EQ(planner.requests().size(), 3u);
+}
+
+TEST(PollPlanner, Groups) {
+    PLC::PollPlanner planner;
+    planner.add(AREA_FLAGS, 0, 0, 6, 1);
+    planner.add(AREA_DB, 1, 0, 10, 0);
+    EXPECT_EQ(planner.add(AREA_DB, 2, 0, 10, 1), 16u);  // offsets are shared by all groups
+
+    ASSERT_TRUE(planner.plan(240, 20));
+    ASSERT_EQ(planner.group_count(), 2u);
+    ASSERT_EQ(planner.requests(0).size(), 1u);
+    EXPECT_EQ(planner.requests(0)[0].items.size(), 1u);
+    ASSERT_EQ(planner.requests(1).size(), 1u);
+    EXPECT_EQ(planner.requests(1)[0].items.size(), 2u);
+    EXPECT_TRUE(planner.requests(2).empty());
+}
+
+TEST(PollPlanner, PduTooSmall) {
+    PLC::PollPlanner planner;
+    planner.add(AREA_FLAGS, 0, 0, 6);
+
+    EXPECT_FALSE(planner.plan(16, 20));
+}
+
+// bit_diff.h
+
+TEST(BitDiff, OnlyChangedBits) {
+    PLC::BitDiff diff;
+    diff.add(0, 0);
+    diff.add(5, 1);
+    diff.add(47, 2);
+    diff.add(5, 3);  // two tags on the same bit
+    diff.build();
+    EXPECT_EQ(diff.bit_count(), 48u);
+
+    uint64_t previous = 0b100001;
+    uint64_t current = (uint64_t{1} << 47) | 0b1;
+
+    std::vector<std::pair<uint16_t, bool>> changes;
+    diff.diff(&previous, &current, 1, [&](uint16_t tag, bool state) { changes.emplace_back(tag, state); });
+
+    ASSERT_EQ(changes.size(), 3u);
+    EXPECT_EQ(changes[0], std::make_pair(uint16_t{1}, false));
+    EXPECT_EQ(changes[1], std::make_pair(uint16_t{3}, false));
+    EXPECT_EQ(changes[2], std::make_pair(uint16_t{2}, true));
+}
+
+TEST(BitDiff, UnsubscribedBitsAndWords) {
+    PLC::BitDiff diff;
+    diff.add(70, 0);
+    diff.build();
+
+    uint64_t previous[2] = {0, 0};
+    uint64_t current[2] = {~uint64_t{0}, uint64_t{1} << 6};
+
+    int calls = 0;
+    diff.diff(previous, current, 2, [&](uint16_t tag, bool state) {
+        EXPECT_EQ(tag, 0);
+        EXPECT_TRUE(state);
+        calls++;
+    });
+    EXPECT_EQ(calls, 1);
+}
+
+// scan_class.h
+
+TEST(ScanClass, DueEveryInterval) {
+    using namespace std::chrono_literals;
+
+    // A class of 100ms polled by a timer of 100ms, which may fire up to half an interval early
+    PLC::ScanClass scan_class{"fast", 100, {}};
+    const auto start = std::chrono::steady_clock::now();
+
+    EXPECT_TRUE(scan_class.due(start, 50ms));
+    EXPECT_FALSE(scan_class.due(start + 20ms, 50ms));
+
+    // The second tick polls again, even if the timer fired a bit early
+    EXPECT_TRUE(scan_class.due(start + 98ms, 50ms));
+    EXPECT_TRUE(scan_class.due(start + 200ms, 50ms));
+    EXPECT_EQ(scan_class.next_poll, start + 300ms);
+
+    // Missed polls are skipped instead of being caught up one after another
+    EXPECT_TRUE(scan_class.due(start + 650ms, 50ms));
+    EXPECT_FALSE(scan_class.due(start + 660ms, 50ms));
+    EXPECT_EQ(scan_class.next_poll, start + 750ms);
+}
+
+TEST(ScanClass, SlowClassesSkipTicks) {
+    using namespace std::chrono_literals;
+
+    // A class of 1s polled by the timer of a 250ms class
+    PLC::ScanClass scan_class{"slow", 1000, {}};
+    const auto start = std::chrono::steady_clock::now();
+
+    int polls = 0;
+    for (int tick = 0; tick < 8; tick++) {
+        polls += scan_class.due(start + tick * 250ms, 125ms) ? 1 : 0;
+    }
+    EXPECT_EQ(polls, 2);
+}
+
+// write_queue.h
+
+TEST(WriteQueue, MergeWritesToSameAddress) {
+    PLC::WriteQueue queue;
+    auto first = queue.write_bit(AREA_FLAGS, 3, true);
+    auto second = queue.write_bit(AREA_FLAGS, 3, false);
+    auto other = queue.write_bit(AREA_OUTPUTS, 3, true);
+    auto word = queue.write_bytes(AREA_DB, 1, 4, {0x12, 0x34});
+    EXPECT_FALSE(queue.empty());
+
+    auto requests = queue.take(240, 20);
+    EXPECT_TRUE(queue.empty());
+    ASSERT_EQ(requests.size(), 1u);
+    ASSERT_EQ(requests[0].items.size(), 3u);
+
+    for (auto &item : requests[0].items) {
+        if (item.area == AREA_FLAGS) {
+            // The last write wins
+            ASSERT_EQ(item.data.size(), 1u);
+            EXPECT_EQ(item.data[0], 0);
+            EXPECT_EQ(item.completions.size(), 2u);
+        }
+        item.complete(item.area != AREA_OUTPUTS);
+    }
+
+    EXPECT_TRUE(first.get());
+    EXPECT_TRUE(second.get());
+    EXPECT_FALSE(other.get());
+    ASSERT_TRUE(word);
+    EXPECT_TRUE(word->get());
+}
+
+TEST(WriteQueue, SplitByItemCountAndSize) {
+    PLC::WriteQueue queue;
+    for (int i = 0; i < 5; i++) {
+        queue.write_bit(AREA_FLAGS, i, true);
+    }
+
+    auto requests = queue.take(240, 2);
+    ASSERT_EQ(requests.size(), 3u);
+    EXPECT_EQ(requests[2].items.size(), 1u);
+
+    // 12 bytes of header and 4 items of 12 + 4 + 2 bytes each
+    for (int i = 0; i < 5; i++) {
+        queue.write_bytes(AREA_DB, 1, i * 2, {0, 0});
+    }
+    requests = queue.take(12 + 4 * 18, 20);
+    ASSERT_EQ(requests.size(), 2u);
+    EXPECT_EQ(requests[0].items.size(), 4u);
+}
+
+TEST(WriteQueue, KeepOrder) {
+    PLC::WriteQueue queue;
+    queue.write_bytes(AREA_DB, 2, 10, {0, 42});
+    queue.write_bit(AREA_FLAGS, 7, true);
+    queue.write_bytes(AREA_DB, 1, 0, {0, 1});
+    queue.write_bytes(AREA_DB, 2, 10, {0, 43});
+
+    // The value is written before the bit that enables it. The last write goes to the address of the first one, but
+    // merging them would move it before the bit, so it is written separately.
+    auto requests = queue.take(240, 20);
+    ASSERT_EQ(requests.size(), 1u);
+    const auto &items = requests[0].items;
+    ASSERT_EQ(items.size(), 4u);
+    EXPECT_EQ(items[0].start, 10);
+    EXPECT_EQ(items[0].data[1], 42);
+    EXPECT_EQ(items[1].area, AREA_FLAGS);
+    EXPECT_EQ(items[2].db, 1);
+    EXPECT_EQ(items[3].start, 10);
+    EXPECT_EQ(items[3].data[1], 43);
+
+    for (auto &item : requests[0].items) {
+        item.complete(true);
+    }
+}
+
+TEST(WriteQueue, RejectOverlappingWrites) {
+    PLC::WriteQueue queue;
+    auto dword = queue.write_bytes(AREA_DB, 1, 4, {1, 2, 3, 4});
+    auto overlapping = queue.write_bytes(AREA_DB, 1, 6, {5, 6});
+    auto longer = queue.write_bytes(AREA_DB, 1, 4, {1, 2, 3, 4, 5, 6});
+    auto adjacent = queue.write_bytes(AREA_DB, 1, 8, {7, 8});
+    auto other_db = queue.write_bytes(AREA_DB, 2, 6, {5, 6});
+
+    // Rejected right away, without being queued
+    EXPECT_FALSE(overlapping);
+    EXPECT_FALSE(longer);
+    ASSERT_TRUE(dword && adjacent && other_db);
+
+    auto requests = queue.take(240, 20);
+    ASSERT_EQ(requests.size(), 1u);
+    EXPECT_EQ(requests[0].items.size(), 3u);
+    for (auto &item : requests[0].items) {
+        item.complete(true);
+    }
+
+    EXPECT_TRUE(dword->get());
+    EXPECT_TRUE(adjacent->get());
+    EXPECT_TRUE(other_db->get());
+}
+
+TEST(WriteQueue, WriteCompletedBeforeCheck) {
+    PLC::WriteQueue queue;
+    auto word = queue.write_bytes(AREA_DB, 1, 4, {0x12, 0x34});
+
+    // A flush on the poll thread completes the write before the caller looks at the result
+    auto requests = queue.take(240, 20);
+    ASSERT_EQ(requests.size(), 1u);
+    requests[0].items[0].complete(true);
+
+    ASSERT_TRUE(word);
+    ASSERT_EQ(word->wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    EXPECT_TRUE(word->get());
+}
+
+TEST(WriteQueue, CancelAndOversizedItems) {
+    PLC::WriteQueue queue;
+    auto cancelled = queue.write_bit(AREA_FLAGS, 0, true);
+    queue.cancel();
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(cancelled.get());
+
+    auto oversized = queue.write_bytes(AREA_DB, 1, 0, std::vector<uint8_t>(100));
+    EXPECT_TRUE(queue.take(64, 20).empty());
+    ASSERT_TRUE(oversized);
+    EXPECT_FALSE(oversized->get());
+}
+
+// bit_image.h
+
+TEST(BitImage, ParseRanges) {
+    auto ranges = PLC::BitImage::parse_ranges("0-5, 20-27,30");
+    ASSERT_TRUE(ranges);
+    ASSERT_EQ(ranges->size(), 3u);
+    EXPECT_EQ((*ranges)[0], std::make_pair(0, 6));
+    EXPECT_EQ((*ranges)[1], std::make_pair(20, 8));
+    EXPECT_EQ((*ranges)[2], std::make_pair(30, 1));
+
+    EXPECT_FALSE(PLC::BitImage::parse_ranges("5-0"));
+    EXPECT_FALSE(PLC::BitImage::parse_ranges("0-5,,8"));
+    EXPECT_FALSE(PLC::BitImage::parse_ranges("a-b"));
+}
+
+TEST(BitImage, DisjointRanges) {
+    PLC::BitImage image;
+    ASSERT_TRUE(image.add_range(0, 6));
+    ASSERT_TRUE(image.add_range(100, 10));
+    EXPECT_FALSE(image.add_range(4, 4));  // overlaps the first range
+    EXPECT_FALSE(image.add_range(8, 0));
+
+    // One word for the first range, two for the second one
+    EXPECT_EQ(image.word_count(), 3u);
+
+    EXPECT_EQ(image.find_bit(5 * 8 + 7), 47u);
+    EXPECT_EQ(image.find_bit(100 * 8), 64u);
+    EXPECT_EQ(image.find_bit(109 * 8 + 1), 64u + 9 * 8 + 1);
+    EXPECT_FALSE(image.find_bit(6 * 8));
+    EXPECT_FALSE(image.find_bit(-1));
+
+    EXPECT_EQ(image.find_range(3 * 8), 0u);
+    EXPECT_EQ(image.find_range(105 * 8 + 3), 1u);
+    EXPECT_FALSE(image.find_range(50 * 8));
+}
+
+TEST(BitImage, LoadAndDiff) {
+    PLC::BitImage image;
+    image.add_range(0, 2);
+    image.add_range(20, 9);
+    image.ranges()[0].offset = 0;
+    image.ranges()[1].offset = 2;
+
+    PLC::BitDiff diff;
+    diff.add(*image.find_bit(1 * 8 + 2), 0);
+    diff.add(*image.find_bit(28 * 8 + 7), 1);
+    diff.build();
+
+    std::vector<uint8_t> process_image(11, 0);
+    process_image[1] = 0b100;
+    process_image[10] = 0x80;
+    image.load(process_image.data());
+
+    EXPECT_TRUE(PLC::test_bit(image.words(), *image.find_bit(1 * 8 + 2)));
+    EXPECT_TRUE(PLC::test_bit(image.words(), *image.find_bit(28 * 8 + 7)));
+    EXPECT_FALSE(PLC::test_bit(image.previous_words(), *image.find_bit(28 * 8 + 7)));
+
+    std::vector<uint16_t> changed;
+    diff.diff(image.previous_words().data(), image.words().data(), image.word_count(),
+              [&](uint16_t tag, bool state) {
+                  EXPECT_TRUE(state);
+                  changed.push_back(tag);
+              });
+    EXPECT_EQ(changed, (std::vector<uint16_t>{0, 1}));
+
+    // Nothing changed in the second poll
+    image.load(process_image.data());
+    changed.clear();
+    diff.diff(image.previous_words().data(), image.words().data(), image.word_count(),
+              [&](uint16_t tag, bool) { changed.push_back(tag); });
+    EXPECT_TRUE(changed.empty());
+}
+
+// tag_index.h
+
+TEST(TagIndex, TagsPerPosition) {
+    PLC::TagIndex index;
+    index.add(4, 0);
+    index.add(1, 1);
+    index.add(4, 2);
+    index.build();
+    EXPECT_EQ(index.size(), 5u);
+
+    std::vector<uint16_t> tags;
+    index.for_each(4, [&](uint16_t tag) { tags.push_back(tag); });
+    EXPECT_EQ(tags, (std::vector<uint16_t>{0, 2}));
+
+    tags.clear();
+    index.for_each(0, [&](uint16_t tag) { tags.push_back(tag); });
+    index.for_each(100, [&](uint16_t tag) { tags.push_back(tag); });
+    EXPECT_TRUE(tags.empty());
+}
+
+// db.h
+
+TEST(DB, Deadband) {
+    PLC::DBword tag;
+    tag.data = 100;
+    tag.deadband = 5;
+
+    // Changes within the deadband of the last reported value are not reported, even if two polls differ by more
+    EXPECT_FALSE(tag.update(105));
+    EXPECT_FALSE(tag.update(95));
+    EXPECT_EQ(tag.data, 100);
+
+    // Changes beyond it are reported in both directions
+    EXPECT_TRUE(tag.update(106));
+    EXPECT_EQ(tag.data, 106);
+    EXPECT_FALSE(tag.update(101));
+    EXPECT_TRUE(tag.update(100));
+    EXPECT_EQ(tag.data, 100);
+
+    // Without a deadband every change is reported
+    PLC::DBdword dword;
+    EXPECT_FALSE(dword.update(0));
+    EXPECT_TRUE(dword.update(1));
+    EXPECT_TRUE(dword.update(0xFFFFFFFF));
+    EXPECT_TRUE(dword.update(0));
+}
@@ -0,0 +1,208 @@
+#include "gtest/gtest.h"
+
+#include "recipe/plant.h"
+#include "recipe/recipe.h"
+#include "recipe/recipe_runner.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Recipe
+// recipe.h
+
+namespace {
+    using namespace std::chrono_literals;
+
+    // A recipe segment, each step is given as "step<n>" and its settings
+    std::shared_ptr<config::Segment> make_recipe(const std::vector<std::pair<std::string, std::string>> &settings) {
+        auto recipe = std::make_shared<config::Segment>("recipe");
+        recipe->set<std::string>("name", "test");
+        for (const auto &[key, value] : settings) {
+            recipe->set<std::string>(key, value);
+        }
+        return recipe;
+    }
+
+    // A PLC with the flag "valve", the output "shutter" and the DBword "pressure"
+    recipe::Context plc_context() {
+        recipe::Context context;
+        context.find_tag = [](PLC::Area area, const std::string &name) -> std::optional<PLC::Tag> {
+            if ((area == PLC::Area::Flag && name == "valve") || (area == PLC::Area::Output && name == "shutter")
+                || (area == PLC::Area::DBword && name == "pressure")) {
+                return PLC::Tag{area, 0};
+            }
+            return std::nullopt;
+        };
+        return context;
+    }
+
+    // Records the PLC writes and answers the reads with the given values, there are no generators or switches
+    struct FakePlant : recipe::Plant {
+        std::vector<std::pair<PLC::Area, int64_t>> writes;
+        bool state = false;
+        int64_t word = 0;
+
+        void set_state(PLC::Tag tag, bool value) override { writes.emplace_back(tag.area, value); }
+        void set_word(PLC::Tag tag, uint32_t value) override { writes.emplace_back(tag.area, value); }
+        bool get_state(PLC::Tag) override { return state; }
+        int64_t get_word(PLC::Tag) override { return word; }
+
+        void set_port(RFSwitch *, int) override {}
+
+        void set_power(RFGenerator *, int) override {}
+        int get_setpoint(RFGenerator *) override { return -1; }
+        void set_output(RFGenerator *, bool) override {}
+        void tune_match(RFGenerator *, int) override {}
+        void stop_tuning(RFGenerator *) override {}
+        bool is_tuning(RFGenerator *) override { return false; }
+    };
+}  // namespace
+
+TEST(Recipe, CompileInStepOrder) {
+    auto recipe = make_recipe({{"step10.action", "wait"},
+                               {"step10.duration", "300"},
+                               {"step2.action", "wait"},
+                               {"step2.duration", "200"},
+                               {"notes.text", "ignored"}});
+
+    auto program = recipe::compile(*recipe, recipe::Context{});
+    ASSERT_TRUE(program);
+    EXPECT_EQ(program->name, "test");
+    ASSERT_EQ(program->steps.size(), 2u);
+    EXPECT_EQ(program->step_names, (std::vector<std::string>{"step2", "step10"}));
+    EXPECT_EQ(program->steps[0].duration, 200ms);
+    EXPECT_EQ(program->steps[1].duration, 300ms);
+}
+
+TEST(Recipe, RejectInvalidSteps) {
+    // Unknown action, missing duration and a step number used twice
+    EXPECT_FALSE(recipe::compile(*make_recipe({{"step1.action", "jump"}}), recipe::Context{}));
+    EXPECT_FALSE(recipe::compile(*make_recipe({{"step1.action", "wait"}}), recipe::Context{}));
+    EXPECT_FALSE(recipe::compile(*make_recipe({{"step1.action", "wait"},
+                                               {"step1.duration", "1"},
+                                               {"step01.action", "wait"},
+                                               {"step01.duration", "1"}}),
+                                 recipe::Context{}));
+
+    // Generators and PLC tags that can not be resolved
+    EXPECT_FALSE(recipe::compile(*make_recipe({{"step1.action", "outputon"}, {"step1.device", "rf1"}}), recipe::Context{}));
+    EXPECT_FALSE(recipe::compile(*make_recipe({{"step1.action", "setflag"}, {"step1.tag", "valve"}, {"step1.value", "1"}}),
+                                 recipe::Context{}));
+    EXPECT_FALSE(recipe::compile(*make_recipe({{"step1.action", "setflag"}, {"step1.tag", "shutter"}, {"step1.value", "1"}}),
+                                 plc_context()));
+}
+
+TEST(Recipe, StepNumberOverflow) {
+    // The number does not fit into an int, so the segment is no step
+    auto recipe = make_recipe({{"step1.action", "wait"},
+                               {"step1.duration", "1"},
+                               {"step99999999999.action", "wait"},
+                               {"step99999999999.duration", "1"}});
+
+    auto program = recipe::compile(*recipe, recipe::Context{});
+    ASSERT_TRUE(program);
+    EXPECT_EQ(program->step_names, (std::vector<std::string>{"step1"}));
+}
+
+TEST(Recipe, ResolveTags) {
+    auto recipe = make_recipe({{"step1.action", "waitstate"},
+                               {"step1.tag", "shutter"},
+                               {"step1.value", "1"},
+                               {"step1.timeout", "50"},
+                               {"step2.action", "waitbelow"},
+                               {"step2.tag", "pressure"},
+                               {"step2.value", "10"}});
+
+    auto program = recipe::compile(*recipe, plc_context());
+    ASSERT_TRUE(program);
+    ASSERT_EQ(program->steps.size(), 2u);
+    EXPECT_EQ(program->steps[0].tag.area, PLC::Area::Output);
+    EXPECT_EQ(program->steps[0].duration, 50ms);
+    EXPECT_EQ(program->steps[1].tag.area, PLC::Area::DBword);
+    EXPECT_EQ(program->steps[1].value, 10);
+}
+
+// recipe_runner.h
+
+TEST(RecipeRunner, WaitsDoNotAccumulateCycleTime) {
+    auto program = recipe::compile(
+        *make_recipe({{"step1.action", "wait"}, {"step1.duration", "100"}, {"step2.action", "wait"}, {"step2.duration", "100"}}),
+        recipe::Context{});
+    ASSERT_TRUE(program);
+
+    FakePlant plant;
+    recipe::RecipeRunner runner(plant);
+    ASSERT_TRUE(runner.load(std::move(*program)));
+    ASSERT_TRUE(runner.start());
+
+    const auto start = recipe::RecipeRunner::Clock::now();
+    runner.tick(start);
+    EXPECT_EQ(runner.get_status(), recipe::RecipeRunner::Status::Running);
+    EXPECT_EQ(runner.get_step(), 0u);
+
+    // The tick is late, the second wait still starts when the first one was scheduled to end
+    runner.tick(start + 130ms);
+    EXPECT_EQ(runner.get_step(), 1u);
+
+    runner.tick(start + 199ms);
+    EXPECT_EQ(runner.get_step(), 1u);
+
+    runner.tick(start + 200ms);
+    EXPECT_EQ(runner.get_status(), recipe::RecipeRunner::Status::Finished);
+}
+
+TEST(RecipeRunner, InstantStepsInOneTick) {
+    auto program = recipe::compile(*make_recipe({{"step1.action", "setflag"},
+                                                 {"step1.tag", "valve"},
+                                                 {"step1.value", "1"},
+                                                 {"step2.action", "setword"},
+                                                 {"step2.tag", "pressure"},
+                                                 {"step2.value", "42"},
+                                                 {"step3.action", "wait"},
+                                                 {"step3.duration", "10"}}),
+                                   plc_context());
+    ASSERT_TRUE(program);
+
+    FakePlant plant;
+    recipe::RecipeRunner runner(plant);
+    ASSERT_TRUE(runner.load(std::move(*program)));
+    ASSERT_TRUE(runner.start());
+
+    runner.tick(recipe::RecipeRunner::Clock::now());
+    EXPECT_EQ(runner.get_step(), 2u);
+    EXPECT_EQ(plant.writes, (std::vector<std::pair<PLC::Area, int64_t>>{{PLC::Area::Flag, 1}, {PLC::Area::DBword, 42}}));
+}
+
+TEST(RecipeRunner, WaitForConditionAndTimeout) {
+    auto make_program = []() {
+        return recipe::compile(*make_recipe({{"step1.action", "waitstate"},
+                                              {"step1.tag", "shutter"},
+                                              {"step1.value", "1"},
+                                              {"step1.timeout", "50"}}),
+                               plc_context());
+    };
+
+    FakePlant plant;
+    recipe::RecipeRunner runner(plant);
+    const auto start = recipe::RecipeRunner::Clock::now();
+
+    // The condition is met before the timeout
+    ASSERT_TRUE(runner.load(std::move(*make_program())));
+    ASSERT_TRUE(runner.start());
+    runner.tick(start);
+    EXPECT_EQ(runner.get_status(), recipe::RecipeRunner::Status::Running);
+    plant.state = true;
+    runner.tick(start + 20ms);
+    EXPECT_EQ(runner.get_status(), recipe::RecipeRunner::Status::Finished);
+
+    // The condition is never met
+    plant.state = false;
+    ASSERT_TRUE(runner.load(std::move(*make_program())));
+    ASSERT_TRUE(runner.start());
+    runner.tick(start);
+    runner.tick(start + 49ms);
+    EXPECT_EQ(runner.get_status(), recipe::RecipeRunner::Status::Running);
+    runner.tick(start + 50ms);
+    EXPECT_EQ(runner.get_status(), recipe::RecipeRunner::Status::Failed);
+}
@@ -1,9 +1,13 @@
 #include "gtest/gtest.h"
 
 #include <string>
+#include <thread>
 
 #include <boost/lexical_cast.hpp>
 
+#include "util/byteswap.h"
+#include "util/ring_buffer.h"
+#include "util/spsc_queue.h"
 #include "util/util.h"
 #include "util/type_conversion.h"
 
@@ -255,3 +259,111 @@ TEST(TypeConversion, ToType) {
     ec = util::to_type<EnumClass>(20).value();
     EXPECT_TRUE(ec == EnumClass::Y);
 }
+
+// Byte order
+// byteswap.h
+
+TEST(ByteSwap, LoadBigEndian16) {
+    // 19 values to cover the vectorized part as well as the rest
+    std::vector<uint8_t> src;
+    for (int i = 0; i < 19; i++) {
+        src.push_back(static_cast<uint8_t>(i));
+        src.push_back(static_cast<uint8_t>(0xA0 + i));
+    }
+
+    std::vector<uint16_t> dst(19);
+    util::load_big_endian(dst.data(), src.data(), dst.size());
+
+    for (int i = 0; i < 19; i++) {
+        EXPECT_EQ(dst[i], (i << 8) | (0xA0 + i));
+    }
+}
+
+TEST(ByteSwap, LoadBigEndian32) {
+    // Start at an odd address to test unaligned loads
+    std::vector<uint8_t> src(1 + 11 * 4);
+    for (size_t i = 1; i < src.size(); i++) {
+        src[i] = static_cast<uint8_t>(i);
+    }
+
+    std::vector<uint32_t> dst(11);
+    util::load_big_endian(dst.data(), src.data() + 1, dst.size());
+
+    for (uint32_t i = 0; i < 11; i++) {
+        const uint32_t b = 1 + i * 4;
+        EXPECT_EQ(dst[i], (b << 24) | ((b + 1) << 16) | ((b + 2) << 8) | (b + 3));
+    }
+}
+
+// Ring buffer
+// ring_buffer.h
+
+TEST(RingBuffer, PushAndConsume) {
+    util::RingBuffer buffer(8);
+    EXPECT_TRUE(buffer.push("abcde", 5));
+    EXPECT_FALSE(buffer.push("fghi", 4));  // does not fit
+    EXPECT_EQ(buffer.size(), 5u);
+    EXPECT_EQ(buffer[1], 'b');
+
+    buffer.consume(3);
+    EXPECT_EQ(buffer.view(2), "de");
+
+    // Wraps around the end of the storage
+    EXPECT_TRUE(buffer.push("fghij", 5));
+    EXPECT_EQ(buffer.size(), 7u);
+    EXPECT_EQ(buffer[6], 'j');
+    EXPECT_EQ(buffer.view(7), "defghij");
+
+    buffer.consume(100);
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_EQ(buffer.free(), 8u);
+}
+
+TEST(SPSCQueue, PushAndPop) {
+    util::SPSCQueue<std::string> queue(3);
+    EXPECT_EQ(queue.capacity(), 4u);  // rounded up to a power of two
+
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.try_push(std::to_string(i)));
+    }
+    EXPECT_FALSE(queue.try_push("full"));
+
+    std::string value;
+    EXPECT_TRUE(queue.try_pop(value));
+    EXPECT_EQ(value, "0");
+
+    // Wraps around the end of the storage
+    EXPECT_TRUE(queue.try_push("4"));
+    for (int i = 1; i < 5; i++) {
+        EXPECT_TRUE(queue.try_pop(value));
+        EXPECT_EQ(value, std::to_string(i));
+    }
+    EXPECT_FALSE(queue.try_pop(value));
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(SPSCQueue, ProducerAndConsumerThreads) {
+    util::SPSCQueue<int> queue(16);
+    constexpr int count = 10000;
+
+    std::thread producer([&queue]() {
+        for (int i = 0; i < count;) {
+            if (queue.try_push(i)) {
+                i++;
+            }
+        }
+    });
+
+    // Every value arrives exactly once and in order
+    int expected = 0;
+    int value = 0;
+    while (expected < count) {
+        if (queue.try_pop(value)) {
+            ASSERT_EQ(value, expected);
+            expected++;
+        }
+    }
+
+    producer.join();
+    EXPECT_TRUE(queue.empty());
+}